@@ -0,0 +1,127 @@
+/***************************************************************
+ *
+ * Copyright (C) 2025, Condor Team, Computer Sciences Department,
+ * University of Wisconsin-Madison, WI.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you
+ * may not use this file except in compliance with the License.  You may
+ * obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ ***************************************************************/
+
+#include "classad/common.h"
+#include "classad/attrName.h"
+
+#include <ctype.h>
+#include <deque>
+#include <mutex>
+#include <shared_mutex>
+#include <string_view>
+#include <unordered_map>
+
+using namespace classad;
+
+namespace {
+
+struct NameTable {
+	std::shared_mutex lock;
+	size_t max_names = 16384;
+		// every spelling seen, keyed by a view of the name in its entry
+	std::unordered_map<std::string_view, const AttrName::Entry *> names;
+		// case-folded name to atom
+	std::unordered_map<std::string, unsigned> atoms;
+		// a deque, so entries never move
+	std::deque<AttrName::Entry> entries;
+};
+
+	// Never destroyed, so that ads in static storage can still be torn
+	// down at exit.
+NameTable &
+Table()
+{
+	static NameTable *table = new NameTable;
+	return *table;
+}
+
+}
+
+const AttrName::Entry AttrName::s_empty = { std::string(), 0 };
+
+const AttrName::Entry *
+AttrName::Intern(const char *name, size_t len)
+{
+	if (len == 0) {
+		return &s_empty;
+	}
+
+	NameTable &table = Table();
+	std::string_view key(name, len);
+	{
+		std::shared_lock<std::shared_mutex> guard(table.lock);
+		auto found = table.names.find(key);
+		if (found != table.names.end()) {
+			return found->second;
+		}
+	}
+
+	std::unique_lock<std::shared_mutex> guard(table.lock);
+	auto found = table.names.find(key);
+	if (found != table.names.end()) {
+		return found->second;
+	}
+	if (table.names.size() >= table.max_names) {
+			// the table is full, the caller owns this one
+		return new Entry{std::string(name, len), 0};
+	}
+
+	std::string folded(name, len);
+	for (char &c : folded) {
+		c = (char)tolower((unsigned char)c);
+	}
+	unsigned atom = table.atoms.emplace(folded, (unsigned)table.atoms.size() + 1).first->second;
+
+	table.entries.push_back(Entry{std::string(name, len), atom});
+	const Entry *entry = &table.entries.back();
+	table.names.emplace(std::string_view(entry->name), entry);
+	return entry;
+}
+
+size_t
+AttrName::NumNames()
+{
+	NameTable &table = Table();
+	std::shared_lock<std::shared_mutex> guard(table.lock);
+	return table.names.size();
+}
+
+size_t
+AttrName::NumAtoms()
+{
+	NameTable &table = Table();
+	std::shared_lock<std::shared_mutex> guard(table.lock);
+	return table.atoms.size();
+}
+
+void
+AttrName::SetMaxInterned(size_t max_names)
+{
+	NameTable &table = Table();
+	std::unique_lock<std::shared_mutex> guard(table.lock);
+	table.max_names = max_names;
+}
+
+size_t
+AttrName::MaxInterned()
+{
+	NameTable &table = Table();
+	std::shared_lock<std::shared_mutex> guard(table.lock);
+	return table.max_names;
+}
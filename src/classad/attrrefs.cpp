@@ -28,7 +28,7 @@ AttributeReference::
 AttributeReference( ExprTree *tree, const std::string &attrname, bool absolut )
 {
 	parentScope = NULL;
-	attributeStr = attrname;
+	attributeStr = AttrName(attrname);
 	expr = tree;
 	absolute = absolut;
 }
@@ -98,7 +98,7 @@ bool AttributeReference::SetComponents( ExprTree *tree, const std::string &attr,
 		if (expr) delete expr;
 		expr = tree;
 	}
-	attributeStr = attr;
+	attributeStr = AttrName(attr);
 	absolute = abs;
 	return true;
 }
@@ -152,7 +152,7 @@ void AttributeReference::
 GetComponents( ExprTree *&tree, std::string &attr, bool &abs ) const
 {
 	tree = expr;
-	attr = attributeStr;
+	attr = attributeStr.str();
 	abs = absolute;
 }
 
@@ -0,0 +1,215 @@
+/***************************************************************
+ *
+ * Copyright (C) 2025, Condor Team, Computer Sciences Department,
+ * University of Wisconsin-Madison, WI.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you
+ * may not use this file except in compliance with the License.  You may
+ * obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ ***************************************************************/
+
+
+#include "classad/common.h"
+#include "classad/exprTree.h"
+#include "classad/binarySink.h"
+#include "classad/classadCache.h"
+#include <string.h>
+
+using std::string;
+using std::vector;
+using std::pair;
+
+
+namespace classad {
+
+ClassAdBinaryNames::
+ClassAdBinaryNames(const char * const *names, size_t count)
+{
+	m_names.reserve(count);
+	for (size_t ix = 0; ix < count; ++ix) {
+		m_names.push_back(names[ix]);
+		// if a name is listed twice, the first one wins
+		m_index.emplace(names[ix], (int)ix);
+	}
+}
+
+int ClassAdBinaryNames::
+Find(const string &name) const
+{
+	auto it = m_index.find(name);
+	return (it == m_index.end()) ? -1 : it->second;
+}
+
+
+ClassAdBinaryUnParser::
+ClassAdBinaryUnParser(const ClassAdBinaryNames *names) : m_names(names)
+{
+}
+
+void ClassAdBinaryUnParser::
+UnparseVarint(string &buffer, uint64_t val)
+{
+	while (val >= 0x80) {
+		buffer += (char)((val & 0x7F) | 0x80);
+		val >>= 7;
+	}
+	buffer += (char)val;
+}
+
+void ClassAdBinaryUnParser::
+UnparseString(string &buffer, const char *str, size_t len)
+{
+	UnparseVarint(buffer, len);
+	buffer.append(str, len);
+}
+
+void ClassAdBinaryUnParser::
+UnparseName(string &buffer, const string &name) const
+{
+	int ix = m_names ? m_names->Find(name) : -1;
+	if (ix >= 0) {
+		UnparseVarint(buffer, (uint64_t)ix + 1);
+	} else {
+		UnparseVarint(buffer, 0);
+		UnparseString(buffer, name);
+	}
+}
+
+// integers are zigzag encoded so that small negative numbers stay small
+static void
+unparseInteger(string &buffer, int64_t val)
+{
+	ClassAdBinaryUnParser::UnparseVarint(buffer, ((uint64_t)val << 1) ^ (uint64_t)(val >> 63));
+}
+
+static void
+unparseReal(string &buffer, double val)
+{
+	uint64_t bits;
+	memcpy(&bits, &val, sizeof(bits));
+	for (int ix = 0; ix < 8; ++ix) {
+		buffer += (char)(bits & 0xFF);
+		bits >>= 8;
+	}
+}
+
+bool ClassAdBinaryUnParser::
+Unparse(string &buffer, const ExprTree *expr)
+{
+	if ( ! expr) {
+		buffer += (char)TAG_NULL;
+		return true;
+	}
+
+	switch (expr->GetKind()) {
+	case ExprTree::ERROR_LITERAL:
+		buffer += (char)TAG_ERROR;
+		return true;
+
+	case ExprTree::UNDEFINED_LITERAL:
+		buffer += (char)TAG_UNDEFINED;
+		return true;
+
+	case ExprTree::BOOLEAN_LITERAL:
+		buffer += (char)(static_cast<const BooleanLiteral *>(expr)->getBool() ? TAG_TRUE : TAG_FALSE);
+		return true;
+
+	case ExprTree::INTEGER_LITERAL:
+		buffer += (char)TAG_INTEGER;
+		unparseInteger(buffer, static_cast<const IntegerLiteral *>(expr)->getInteger());
+		return true;
+
+	case ExprTree::REAL_LITERAL:
+		buffer += (char)TAG_REAL;
+		unparseReal(buffer, static_cast<const RealLiteral *>(expr)->getReal());
+		return true;
+
+	case ExprTree::RELTIME_LITERAL:
+		buffer += (char)TAG_RELTIME;
+		unparseReal(buffer, static_cast<const ReltimeLiteral *>(expr)->getReltime());
+		return true;
+
+	case ExprTree::ABSTIME_LITERAL: {
+		abstime_t atime = static_cast<const AbstimeLiteral *>(expr)->getAbstime();
+		buffer += (char)TAG_ABSTIME;
+		unparseInteger(buffer, (int64_t)atime.secs);
+		unparseInteger(buffer, (int64_t)atime.offset);
+		return true;
+	}
+
+	case ExprTree::STRING_LITERAL:
+		buffer += (char)TAG_STRING;
+		UnparseString(buffer, static_cast<const StringLiteral *>(expr)->getString());
+		return true;
+
+	case ExprTree::ATTRREF_NODE: {
+		ExprTree *scope = nullptr;
+		string attr;
+		bool absolute = false;
+		static_cast<const AttributeReference *>(expr)->GetComponents(scope, attr, absolute);
+		buffer += (char)TAG_ATTRREF;
+		buffer += (char)((absolute ? ATTRREF_ABSOLUTE : 0) | (scope ? ATTRREF_SCOPED : 0));
+		UnparseName(buffer, attr);
+		return scope ? Unparse(buffer, scope) : true;
+	}
+
+	case ExprTree::OP_NODE: {
+		Operation::OpKind op;
+		ExprTree *e1 = nullptr, *e2 = nullptr, *e3 = nullptr;
+		static_cast<const Operation *>(expr)->GetComponents(op, e1, e2, e3);
+		buffer += (char)TAG_OPERATION;
+		buffer += (char)op;
+		return Unparse(buffer, e1) && Unparse(buffer, e2) && Unparse(buffer, e3);
+	}
+
+	case ExprTree::FN_CALL_NODE: {
+		string name;
+		vector<ExprTree*> args;
+		static_cast<const FunctionCall *>(expr)->GetComponents(name, args);
+		buffer += (char)TAG_FNCALL;
+		UnparseName(buffer, name);
+		UnparseVarint(buffer, args.size());
+		for (auto arg : args) {
+			if ( ! Unparse(buffer, arg)) return false;
+		}
+		return true;
+	}
+
+	case ExprTree::CLASSAD_NODE: {
+		const ClassAd *ad = static_cast<const ClassAd *>(expr);
+		buffer += (char)TAG_CLASSAD;
+		UnparseVarint(buffer, ad->size());
+		for (auto it = ad->begin(); it != ad->end(); ++it) {
+			UnparseName(buffer, it->first);
+			if ( ! Unparse(buffer, it->second)) return false;
+		}
+		return true;
+	}
+
+	case ExprTree::EXPR_LIST_NODE: {
+		const ExprList *list = static_cast<const ExprList *>(expr);
+		buffer += (char)TAG_LIST;
+		UnparseVarint(buffer, list->size());
+		for (auto it = list->begin(); it != list->end(); ++it) {
+			if ( ! Unparse(buffer, *it)) return false;
+		}
+		return true;
+	}
+
+	case ExprTree::EXPR_ENVELOPE:
+		return Unparse(buffer, static_cast<const CachedExprEnvelope *>(expr)->get());
+	}
+
+	return false;
+}
+
+} // classad
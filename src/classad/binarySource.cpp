@@ -0,0 +1,292 @@
+/***************************************************************
+ *
+ * Copyright (C) 2025, Condor Team, Computer Sciences Department,
+ * University of Wisconsin-Madison, WI.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you
+ * may not use this file except in compliance with the License.  You may
+ * obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ ***************************************************************/
+
+
+#include "classad/common.h"
+#include "classad/exprTree.h"
+#include "classad/binarySource.h"
+#include <string.h>
+
+using std::string;
+using std::vector;
+
+
+namespace classad {
+
+// the parser for text can't produce trees nested this deeply without
+// running out of stack, so an encoding that claims to be is damaged
+static const int MAX_NESTING = 1000;
+
+typedef ClassAdBinaryUnParser Enc;
+
+ClassAdBinaryParser::
+ClassAdBinaryParser(const ClassAdBinaryNames *names) : m_names(names)
+{
+}
+
+bool ClassAdBinaryParser::
+ParseVarint(const char *&ptr, const char *end, uint64_t &val)
+{
+	val = 0;
+	for (int shift = 0; shift < 64 && ptr < end; shift += 7) {
+		unsigned char ch = (unsigned char)*ptr++;
+		val |= (uint64_t)(ch & 0x7F) << shift;
+		if ( ! (ch & 0x80)) {
+			return true;
+		}
+	}
+	return false;
+}
+
+bool ClassAdBinaryParser::
+ParseString(const char *&ptr, const char *end, string &str)
+{
+	uint64_t len;
+	if ( ! ParseVarint(ptr, end, len) || len > (uint64_t)(end - ptr)) {
+		return false;
+	}
+	str.assign(ptr, (size_t)len);
+	ptr += len;
+	return true;
+}
+
+bool ClassAdBinaryParser::
+ParseName(const char *&ptr, const char *end, string &name) const
+{
+	uint64_t ix;
+	if ( ! ParseVarint(ptr, end, ix)) {
+		return false;
+	}
+	if (ix == 0) {
+		return ParseString(ptr, end, name);
+	}
+	const char *known = m_names ? m_names->Name((size_t)(ix - 1)) : nullptr;
+	if ( ! known) {
+		return false;
+	}
+	name = known;
+	return true;
+}
+
+static bool
+parseInteger(const char *&ptr, const char *end, int64_t &val)
+{
+	uint64_t zz;
+	if ( ! ClassAdBinaryParser::ParseVarint(ptr, end, zz)) {
+		return false;
+	}
+	val = (int64_t)(zz >> 1) ^ -(int64_t)(zz & 1);
+	return true;
+}
+
+static bool
+parseReal(const char *&ptr, const char *end, double &val)
+{
+	if (end - ptr < 8) {
+		return false;
+	}
+	uint64_t bits = 0;
+	for (int ix = 7; ix >= 0; --ix) {
+		bits = (bits << 8) | (unsigned char)ptr[ix];
+	}
+	ptr += 8;
+	memcpy(&val, &bits, sizeof(val));
+	return true;
+}
+
+ExprTree *ClassAdBinaryParser::
+ParseExpression(const char *&ptr, const char *end)
+{
+	const char *p = ptr;
+	ExprTree *tree = nullptr;
+	if ( ! ParseNode(p, end, tree, 0)) {
+		return nullptr;
+	}
+	ptr = p;
+	return tree;
+}
+
+// On success, tree is the node, or NULL for an encoded NULL.
+// On failure, nothing is leaked and tree is NULL.
+bool ClassAdBinaryParser::
+ParseNode(const char *&ptr, const char *end, ExprTree *&tree, int depth)
+{
+	tree = nullptr;
+	if (ptr >= end || depth > MAX_NESTING) {
+		return false;
+	}
+
+	int tag = (unsigned char)*ptr++;
+	switch (tag) {
+	case Enc::TAG_NULL:
+		return true;
+
+	case Enc::TAG_ERROR:
+		tree = Literal::MakeError();
+		return true;
+
+	case Enc::TAG_UNDEFINED:
+		tree = Literal::MakeUndefined();
+		return true;
+
+	case Enc::TAG_FALSE:
+	case Enc::TAG_TRUE:
+		tree = Literal::MakeBool(tag == Enc::TAG_TRUE);
+		return true;
+
+	case Enc::TAG_INTEGER: {
+		int64_t val;
+		if ( ! parseInteger(ptr, end, val)) return false;
+		tree = Literal::MakeInteger(val);
+		return true;
+	}
+
+	case Enc::TAG_REAL: {
+		double val;
+		if ( ! parseReal(ptr, end, val)) return false;
+		tree = Literal::MakeReal(val);
+		return true;
+	}
+
+	case Enc::TAG_RELTIME: {
+		double val;
+		if ( ! parseReal(ptr, end, val)) return false;
+		tree = new ReltimeLiteral(val);
+		return true;
+	}
+
+	case Enc::TAG_ABSTIME: {
+		int64_t secs, offset;
+		if ( ! parseInteger(ptr, end, secs) || ! parseInteger(ptr, end, offset)) return false;
+		abstime_t atime;
+		atime.secs = (time_t)secs;
+		atime.offset = (int)offset;
+		tree = Literal::MakeAbsTime(&atime);
+		return true;
+	}
+
+	case Enc::TAG_STRING: {
+		string str;
+		if ( ! ParseString(ptr, end, str)) return false;
+		tree = Literal::MakeString(str);
+		return true;
+	}
+
+	case Enc::TAG_ATTRREF: {
+		if (ptr >= end) return false;
+		int flags = (unsigned char)*ptr++;
+		string attr;
+		if ( ! ParseName(ptr, end, attr)) return false;
+		ExprTree *scope = nullptr;
+		if (flags & Enc::ATTRREF_SCOPED) {
+			if ( ! ParseNode(ptr, end, scope, depth + 1) || ! scope) {
+				delete scope;
+				return false;
+			}
+		}
+		tree = AttributeReference::MakeAttributeReference(scope, attr, (flags & Enc::ATTRREF_ABSOLUTE) != 0);
+		return true;
+	}
+
+	case Enc::TAG_OPERATION: {
+		if (ptr >= end) return false;
+		int op = (unsigned char)*ptr++;
+		if (op < Operation::__FIRST_OP__ || op > Operation::__LAST_OP__) {
+			return false;
+		}
+		ExprTree *e1 = nullptr, *e2 = nullptr, *e3 = nullptr;
+		if ( ! ParseNode(ptr, end, e1, depth + 1) ||
+			 ! ParseNode(ptr, end, e2, depth + 1) ||
+			 ! ParseNode(ptr, end, e3, depth + 1) || ! e1) {
+			delete e1; delete e2; delete e3;
+			return false;
+		}
+		tree = Operation::MakeOperation((Operation::OpKind)op, e1, e2, e3);
+		return tree != nullptr;
+	}
+
+	case Enc::TAG_FNCALL: {
+		string name;
+		uint64_t argc;
+		if ( ! ParseName(ptr, end, name) || ! ParseVarint(ptr, end, argc) ||
+			argc > (uint64_t)(end - ptr)) {
+			return false;
+		}
+		vector<ExprTree*> args;
+		args.reserve((size_t)argc);
+		for (uint64_t ix = 0; ix < argc; ++ix) {
+			ExprTree *arg = nullptr;
+			if ( ! ParseNode(ptr, end, arg, depth + 1) || ! arg) {
+				for (auto a : args) delete a;
+				return false;
+			}
+			args.push_back(arg);
+		}
+		tree = FunctionCall::MakeFunctionCall(name, args);
+		return tree != nullptr;
+	}
+
+	case Enc::TAG_CLASSAD: {
+		uint64_t count;
+		if ( ! ParseVarint(ptr, end, count) || count > (uint64_t)(end - ptr)) {
+			return false;
+		}
+		ClassAd *ad = new ClassAd();
+		for (uint64_t ix = 0; ix < count; ++ix) {
+			string name;
+			ExprTree *expr = nullptr;
+			if ( ! ParseName(ptr, end, name) || ! ParseNode(ptr, end, expr, depth + 1) || ! expr) {
+				delete ad;
+				return false;
+			}
+			if ( ! ad->Insert(name, expr)) {
+				delete expr;
+				delete ad;
+				return false;
+			}
+		}
+		tree = ad;
+		return true;
+	}
+
+	case Enc::TAG_LIST: {
+		uint64_t count;
+		if ( ! ParseVarint(ptr, end, count) || count > (uint64_t)(end - ptr)) {
+			return false;
+		}
+		vector<ExprTree*> items;
+		items.reserve((size_t)count);
+		for (uint64_t ix = 0; ix < count; ++ix) {
+			ExprTree *item = nullptr;
+			if ( ! ParseNode(ptr, end, item, depth + 1) || ! item) {
+				for (auto i : items) delete i;
+				return false;
+			}
+			items.push_back(item);
+		}
+		tree = ExprList::MakeExprList(items);
+		return tree != nullptr;
+	}
+	}
+
+	// an unknown tag
+	return false;
+}
+
+} // classad
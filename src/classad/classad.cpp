@@ -483,6 +483,32 @@ bool ClassAd::InsertViaCache(const std::string& name, const std::string & rhs, b
 	return Insert(name, tree);
 }
 
+// Insert an attribute value that the caller has already parsed (or decoded)
+// from rhs via the cache if the cache is enabled
+//
+bool ClassAd::InsertViaCache(const std::string& name, const std::string & rhs, ExprTree * tree)
+{
+	if (name.empty() || ! tree) {
+		delete tree;
+		return false;
+	}
+
+	bool use_cache = doExpressionCaching;
+	if (name[0] == '\'' || ! CachedExprEnvelope::cacheable(rhs)) {
+		use_cache = false;
+	}
+
+	if (use_cache) {
+		CachedExprEnvelope * penv = CachedExprEnvelope::check_hit(name, rhs);
+		if (penv) {
+			delete tree;
+			return Insert(name, penv);
+		}
+		tree = CachedExprEnvelope::cache(name, tree, rhs);
+	}
+	return Insert(name, tree);
+}
+
 bool
 ClassAd::Insert(const std::string &str)
 {
@@ -545,6 +571,17 @@ AssignExpr(const std::string &name, const char *value)
 }
 
 bool ClassAd::Insert( const std::string& attrName, ExprTree * tree )
+{
+	return _Insert( attrName, tree );
+}
+
+bool ClassAd::Insert( const AttrName& attrName, ExprTree * tree )
+{
+	return _Insert( attrName, tree );
+}
+
+template <typename Name>
+bool ClassAd::_Insert( const Name& attrName, ExprTree * tree )
 {
 		// sanity checks
 	if( attrName.empty() ) {
@@ -654,6 +691,19 @@ LookupInScope( const std::string &name, const ClassAd *&finalScope ) const
 
 int ClassAd::
 LookupInScope(const std::string &name, ExprTree*& expr, EvalState &state) const
+{
+	return _LookupInScope( name, expr, state );
+}
+
+int ClassAd::
+LookupInScope(const AttrName &name, ExprTree*& expr, EvalState &state) const
+{
+	return _LookupInScope( name, expr, state );
+}
+
+template <typename Name>
+int ClassAd::
+_LookupInScope(const Name &name, ExprTree*& expr, EvalState &state) const
 {
 	const ClassAd *current = this, *superScope;
 
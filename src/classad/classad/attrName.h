@@ -0,0 +1,135 @@
+/***************************************************************
+ *
+ * Copyright (C) 2025, Condor Team, Computer Sciences Department,
+ * University of Wisconsin-Madison, WI.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you
+ * may not use this file except in compliance with the License.  You may
+ * obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ ***************************************************************/
+
+
+#ifndef __CLASSAD_ATTR_NAME_H__
+#define __CLASSAD_ATTR_NAME_H__
+
+#include "classad/common.h"
+#include <string>
+#include <ostream>
+#include <string.h>
+#include <utility>
+
+namespace classad {
+
+/** An interned attribute name.
+	<p>
+	Every distinct spelling of an attribute name is stored exactly once for
+	the life of the process, in a global table, and an AttrName is just a
+	pointer to that copy.  A ClassAd keys its attributes by AttrName, so a
+	million job ads with the same hundred attributes share one copy of each
+	name rather than holding a million, and the key of each attribute takes
+	the space of a pointer.
+	<p>
+	Spellings that differ only in case share an atom, a small integer that
+	is stable for the life of the process, so two AttrNames can be compared
+	for case-insensitive equality without looking at the characters.
+	ClassAd lookups by AttrName use this to skip the string compares that
+	lookups by std::string or char * have to do.
+	<p>
+	The table never shrinks, and names come in from the network, so it is
+	bounded (see SetMaxInterned).  Once it is full, a name that isn't in it
+	gets a private copy that is owned by the AttrName and has no atom, and
+	such names are compared by their characters.  They work the same as
+	interned names, only without the savings.  Looking a name up in the
+	table takes a shared lock, and only adding one to it takes the lock
+	exclusively.  Copying and comparing interned names is lock-free.
+*/
+class AttrName {
+	public:
+		struct Entry {
+			std::string name;	// as spelled when first interned
+			unsigned atom;		// shared by all spellings that differ only in case, 0 if not interned
+		};
+
+			/// The empty name
+		AttrName() : m_entry(&s_empty) {}
+
+			/// Intern a name
+		explicit AttrName(const std::string &name) : m_entry(Intern(name.c_str(), name.size())) {}
+		explicit AttrName(const char *name) : m_entry(Intern(name, strlen(name))) {}
+
+		AttrName(const AttrName &that) : m_entry(that.IsPrivate() ? new Entry(*that.m_entry) : that.m_entry) {}
+		AttrName(AttrName &&that) noexcept : m_entry(that.m_entry) { that.m_entry = &s_empty; }
+		AttrName &operator=(const AttrName &that) {
+			if (this != &that) { AttrName tmp(that); std::swap(m_entry, tmp.m_entry); }
+			return *this;
+		}
+		AttrName &operator=(AttrName &&that) noexcept { std::swap(m_entry, that.m_entry); return *this; }
+		~AttrName() { if (IsPrivate()) { delete m_entry; } }
+
+		const std::string &str() const { return m_entry->name; }
+		operator const std::string &() const { return m_entry->name; }
+		const char *c_str() const { return m_entry->name.c_str(); }
+		size_t size() const { return m_entry->name.size(); }
+		size_t length() const { return m_entry->name.size(); }
+		bool empty() const { return m_entry->name.empty(); }
+		char operator[](size_t i) const { return m_entry->name[i]; }
+		size_t find(const char *s, size_t pos = 0) const { return m_entry->name.find(s, pos); }
+		size_t rfind(const char *s, size_t pos = std::string::npos) const { return m_entry->name.rfind(s, pos); }
+		std::string substr(size_t pos, size_t len = std::string::npos) const { return m_entry->name.substr(pos, len); }
+		int compare(const std::string &s) const { return m_entry->name.compare(s); }
+
+			/// The case-folded id of this name; 0 for the empty name and for names that aren't interned
+		unsigned atom() const { return m_entry->atom; }
+
+			/// True if the name is in the global table
+		bool interned() const { return m_entry->atom != 0; }
+
+			/// True if the names are the same, ignoring case
+		bool SameAs(const AttrName &other) const {
+			if (m_entry->atom && other.m_entry->atom) { return m_entry->atom == other.m_entry->atom; }
+			return strcasecmp(c_str(), other.c_str()) == 0;
+		}
+
+			/// Number of distinct spellings and of atoms interned so far
+		static size_t NumNames();
+		static size_t NumAtoms();
+
+			/// The most spellings that will be interned, names seen after
+			/// that many are not added to the table.  The default is 16384.
+		static void SetMaxInterned(size_t max_names);
+		static size_t MaxInterned();
+
+			// comparisons are case-sensitive, the same as for std::string;
+			// compare against a char * by way of std::string
+		friend bool operator==(const AttrName &a, const AttrName &b) {
+			return a.m_entry == b.m_entry || ((a.IsPrivate() || b.IsPrivate()) && a.str() == b.str());
+		}
+		friend bool operator!=(const AttrName &a, const AttrName &b) { return !(a == b); }
+		friend bool operator==(const AttrName &a, const std::string &b) { return a.str() == b; }
+		friend bool operator!=(const AttrName &a, const std::string &b) { return a.str() != b; }
+		friend bool operator==(const std::string &a, const AttrName &b) { return a == b.str(); }
+		friend bool operator!=(const std::string &a, const AttrName &b) { return a != b.str(); }
+		friend bool operator<(const AttrName &a, const AttrName &b) { return a.str() < b.str(); }
+		friend std::ostream &operator<<(std::ostream &os, const AttrName &a) { return os << a.str(); }
+
+	private:
+		static const Entry *Intern(const char *name, size_t len);
+		static const Entry s_empty;
+
+		bool IsPrivate() const { return m_entry->atom == 0 && m_entry != &s_empty; }
+
+		const Entry *m_entry;
+};
+
+} // classad
+
+#endif//__CLASSAD_ATTR_NAME_H__
@@ -21,6 +21,8 @@
 #ifndef __CLASSAD_ATTRREFS_H__
 #define __CLASSAD_ATTRREFS_H__
 
+#include "classad/attrName.h"
+
 namespace classad {
 
 /// Represents a attribute reference node (like .b) in the expression tree
@@ -113,7 +115,7 @@ class AttributeReference : public ExprTree
 
 		ExprTree	*expr;
 		bool		absolute;
-    	std::string attributeStr;
+    	AttrName	attributeStr;
 };
 
 } // classad
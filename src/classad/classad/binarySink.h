@@ -0,0 +1,133 @@
+/***************************************************************
+ *
+ * Copyright (C) 2025, Condor Team, Computer Sciences Department,
+ * University of Wisconsin-Madison, WI.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you
+ * may not use this file except in compliance with the License.  You may
+ * obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ ***************************************************************/
+
+
+#ifndef __CLASSAD_BINARY_SINK_H__
+#define __CLASSAD_BINARY_SINK_H__
+
+#include "classad/common.h"
+#include "classad/exprTree.h"
+#include <stdint.h>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace classad {
+
+/** A fixed list of names that the binary encoding of an expression refers
+	to by position rather than spelling them out.
+	<p>
+	The writer and the reader of an encoding must use the same list, so a
+	list that is used for anything that outlives the process, like a file,
+	may only ever be appended to.  Names are matched exactly, so that the
+	spelling of a name survives the round trip; a name that is not in the
+	list, or is spelled differently, is simply written out in full.
+*/
+class ClassAdBinaryNames {
+	public:
+		ClassAdBinaryNames(const char * const *names, size_t count);
+
+			/// The position of a name in the list, or -1
+		int Find(const std::string &name) const;
+
+			/// The name at a position in the list, or NULL
+		const char *Name(size_t index) const {
+			return index < m_names.size() ? m_names[index] : nullptr;
+		}
+
+		size_t size() const { return m_names.size(); }
+
+	private:
+		std::vector<const char *> m_names;
+		std::unordered_map<std::string, int> m_index;
+};
+
+/** Converts an expression into a compact binary encoding, which
+	ClassAdBinaryParser turns back into the same tree without having to
+	lex and parse its text.
+	<p>
+	Every node is a tag byte followed by the node's contents.  Integers
+	are written as zigzag varints, reals as their 8 byte IEEE
+	representation, strings as a varint length and the bytes, and names
+	as a varint that is either a position in a ClassAdBinaryNames list or
+	zero followed by the name as a string.  Operators are written as
+	their Operation::OpKind, so the numbering of OpKind is part of the
+	encoding.  Cached expression envelopes are written as the expression
+	they hold.
+*/
+class ClassAdBinaryUnParser
+{
+	public:
+		/// Node tags
+		enum Tag {
+			TAG_ERROR = 0,
+			TAG_UNDEFINED,
+			TAG_FALSE,
+			TAG_TRUE,
+			TAG_INTEGER,
+			TAG_REAL,
+			TAG_STRING,
+			TAG_RELTIME,
+			TAG_ABSTIME,
+			TAG_ATTRREF,
+			TAG_OPERATION,
+			TAG_FNCALL,
+			TAG_CLASSAD,
+			TAG_LIST,
+			TAG_NULL,		// a missing child
+			__TAG_COUNT__
+		};
+
+		/// Flags of an attribute reference
+		enum {
+			ATTRREF_ABSOLUTE = 0x01,	// .attr
+			ATTRREF_SCOPED = 0x02,		// expr.attr; the expr follows the name
+		};
+
+		/** Constructor
+			@param names Names to refer to by position, or NULL to always
+				spell names out.  The list must outlive the unparser.
+		*/
+		explicit ClassAdBinaryUnParser(const ClassAdBinaryNames *names = nullptr);
+
+		/** Append the encoding of an expression to a buffer
+			@param buffer The buffer to append to
+			@param expr The expression to encode; NULL is encoded as such
+			@return false if the expression holds a node that can't be
+				encoded, in which case the buffer holds a partial encoding
+		*/
+		bool Unparse(std::string &buffer, const ExprTree *expr);
+
+		/// Append the encoding of an attribute or function name
+		void UnparseName(std::string &buffer, const std::string &name) const;
+
+		/// Append an unsigned varint, or a string as its length and bytes
+		static void UnparseVarint(std::string &buffer, uint64_t val);
+		static void UnparseString(std::string &buffer, const char *str, size_t len);
+		static void UnparseString(std::string &buffer, const std::string &str) {
+			UnparseString(buffer, str.data(), str.size());
+		}
+
+	private:
+		const ClassAdBinaryNames *m_names;
+};
+
+} // classad
+
+#endif//__CLASSAD_BINARY_SINK_H__
@@ -0,0 +1,69 @@
+/***************************************************************
+ *
+ * Copyright (C) 2025, Condor Team, Computer Sciences Department,
+ * University of Wisconsin-Madison, WI.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you
+ * may not use this file except in compliance with the License.  You may
+ * obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ ***************************************************************/
+
+
+#ifndef __CLASSAD_BINARY_SOURCE_H__
+#define __CLASSAD_BINARY_SOURCE_H__
+
+#include "classad/binarySink.h"
+
+namespace classad {
+
+/** Turns the encoding written by ClassAdBinaryUnParser back into an
+	expression tree.
+	<p>
+	The parser never reads past the end of the buffer it is given, and
+	fails cleanly on encodings that are truncated, malformed, or nested
+	deeper than any parsed expression could be, so it is safe to use on
+	the contents of a file that may have been damaged.
+*/
+class ClassAdBinaryParser
+{
+	public:
+		/** Constructor
+			@param names The list the encoding was written with, or NULL.
+				The list must outlive the parser.
+		*/
+		explicit ClassAdBinaryParser(const ClassAdBinaryNames *names = nullptr);
+
+		/** Decode an expression
+			@param ptr The start of the encoding; on success it is
+				advanced past the end of the encoding
+			@param end The end of the buffer
+			@return The expression, or NULL if the encoding is bad.  An
+				encoded NULL also returns NULL, but advances ptr.
+		*/
+		ExprTree *ParseExpression(const char *&ptr, const char *end);
+
+		/// Decode an attribute or function name
+		bool ParseName(const char *&ptr, const char *end, std::string &name) const;
+
+		/// Decode an unsigned varint, or a string as its length and bytes
+		static bool ParseVarint(const char *&ptr, const char *end, uint64_t &val);
+		static bool ParseString(const char *&ptr, const char *end, std::string &str);
+
+	private:
+		bool ParseNode(const char *&ptr, const char *end, ExprTree *&tree, int depth);
+
+		const ClassAdBinaryNames *m_names;
+};
+
+} // classad
+
+#endif//__CLASSAD_BINARY_SOURCE_H__
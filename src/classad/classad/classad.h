@@ -102,11 +102,15 @@ class ClassAd : public ExprTree
 			@see ExprTree::setParentScope
 		*/
 		bool Insert( const std::string& attrName, ExprTree* expr);   // (ignores cache)
+		bool Insert( const AttrName& attrName, ExprTree* expr);   // (ignores cache)
 		bool InsertLiteral(const std::string& attrName, Literal* lit); // (ignores cache)
 
 		// insert through cache if cache is enabled, otherwise just parse and insert
 		// parsing of the rhs expression is done use old ClassAds syntax
 		bool InsertViaCache(const std::string& attrName, const std::string & rhs, bool lazy=false);
+		// insert an expression that has already been parsed from rhs through the cache if it is enabled.
+		// the ad takes ownership of tree, which is deleted if the cache already holds rhs
+		bool InsertViaCache(const std::string& attrName, const std::string & rhs, ExprTree * tree);
 
 		/** Insert an attribute/value into the ClassAd
 		 *  @param str A string of the form "Attribute = Value"
@@ -832,6 +836,9 @@ class ClassAd : public ExprTree
 		virtual bool _Flatten( EvalState&, Value&, ExprTree*&, int* ) const;
 	
 		int LookupInScope( const std::string&, ExprTree*&, EvalState& ) const;
+		int LookupInScope( const AttrName&, ExprTree*&, EvalState& ) const;
+		template <typename Name> bool _Insert( const Name&, ExprTree* );
+		template <typename Name> int _LookupInScope( const Name&, ExprTree*&, EvalState& ) const;
 		AttrList	  attrList;
 		DirtyAttrList dirtyAttrList;
 		bool          do_dirty_tracking;
@@ -19,6 +19,7 @@
 
 
 #include "classad/exprTree.h"
+#include "classad/attrName.h"
 #include <vector>
 #include <algorithm>
 #include <string>
@@ -42,8 +43,11 @@ class ExprTree;
 // much it is likely to grow, so we can perform a single allocation for the
 // entire map.
 //
-// Therefore, we store the map as a std::vector of pairs of std::string and
-// ExprTree *.  To speed lookup, we sort the strings, first by size (as that's
+// Therefore, we store the map as a std::vector of pairs of AttrName and
+// ExprTree *.  An AttrName is a pointer to an interned copy of the name, so
+// the names themselves are shared by every ad that has them, and looking up
+// by AttrName compares atoms instead of strings wherever it can.  To speed
+// lookup, we sort the names, first by size (as that's
 // fast to lookup), and then lexigraphically, insensitive to case.  If the
 // sender and receiver have the same ordering function, the pairs will arrive
 // in order, so the reciever will not need to shuffle them around in memory,
@@ -58,20 +62,28 @@ struct ClassAdFlatMapOrder {
 	const size_t len = 0;
 	ClassAdFlatMapOrder(const std::string &s) : len(s.size()) {}
 	ClassAdFlatMapOrder(const char *s) : len(strlen(s)) {}
+	ClassAdFlatMapOrder(const AttrName &s) : len(s.size()) {}
 	ClassAdFlatMapOrder()  = default;
 
-	bool operator()(const std::pair<std::string, ExprTree *> &lhs, const std::string &rhs) noexcept {
+	bool operator()(const std::pair<AttrName, ExprTree *> &lhs, const std::string &rhs) noexcept {
 		if (lhs.first.size() < this->len) return true;
 		if (lhs.first.size() > this->len) return false;
 		return strcasecmp(lhs.first.c_str(), rhs.c_str()) < 0;	
 	}
 
-	bool operator()(const std::pair<std::string, ExprTree *> &lhs, const char *rhs) noexcept {
+	bool operator()(const std::pair<AttrName, ExprTree *> &lhs, const char *rhs) noexcept {
 		if (lhs.first.size() < this->len) return true;
 		if (lhs.first.size() > this->len) return false;
 		return strcasecmp(lhs.first.c_str(), rhs) < 0;	
 	}
 
+	bool operator()(const std::pair<AttrName, ExprTree *> &lhs, const AttrName &rhs) noexcept {
+		if (lhs.first.size() < this->len) return true;
+		if (lhs.first.size() > this->len) return false;
+		if (lhs.first.atom() && lhs.first.atom() == rhs.atom()) return false;
+		return strcasecmp(lhs.first.c_str(), rhs.c_str()) < 0;
+	}
+
 	bool operator()(const std::string &lhs, const std::string &rhs) noexcept {
 		if (lhs.size() < rhs.size()) return true;
 		if (lhs.size() > rhs.size()) return false;
@@ -80,20 +92,24 @@ struct ClassAdFlatMapOrder {
 };
 
 // note this needs to be inline for ODR reasons
-inline bool ClassAdFlatMapEqual(const std::pair<std::string, ExprTree *>&lhs, const std::string &rhs) {
+inline bool ClassAdFlatMapEqual(const std::pair<AttrName, ExprTree *>&lhs, const std::string &rhs) {
 	return 0 == strcasecmp(lhs.first.c_str(), rhs.c_str());
 }
 
-inline bool ClassAdFlatMapEqual(const std::pair<std::string, ExprTree *>&lhs, const char *rhs) {
+inline bool ClassAdFlatMapEqual(const std::pair<AttrName, ExprTree *>&lhs, const char *rhs) {
 	return 0 == strcasecmp(lhs.first.c_str(), rhs);
 }
 
+inline bool ClassAdFlatMapEqual(const std::pair<AttrName, ExprTree *>&lhs, const AttrName &rhs) {
+	return lhs.first.SameAs(rhs);
+}
+
 
 class ClassAdFlatMap {
 	public:
 		// Rule of zero for ctors/dtors/assignment/move
 	
-		using keyValue = std::pair<std::string, ExprTree *>;
+		using keyValue = std::pair<AttrName, ExprTree *>;
 		using container = std::vector<keyValue>;
 		using iterator = container::iterator;
 		using const_iterator = container::const_iterator;
@@ -143,7 +159,7 @@ class ClassAdFlatMap {
 			if (lb != end() && ClassAdFlatMapEqual(*lb, key)) {
 				return lb->second;
 			} else {
-				return _theVector.insert(lb, std::make_pair(key, nullptr))->second;
+				return _theVector.insert(lb, keyValue(AttrName(key), nullptr))->second;
 			}
 		}
 
@@ -170,7 +186,7 @@ class ClassAdFlatMap {
 			if (lb != end() && ClassAdFlatMapEqual(*lb, key)) {
 				return std::make_pair(lb, false);
 			} else {
-				iterator newit = _theVector.insert(lb, std::make_pair(key, value));
+				iterator newit = _theVector.insert(lb, keyValue(AttrName(key), value));
 				return std::make_pair(newit, true);
 			}
 		}
@@ -0,0 +1,163 @@
+/***************************************************************
+ *
+ * Copyright (C) 2025, Condor Team, Computer Sciences Department,
+ * University of Wisconsin-Madison, WI.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you
+ * may not use this file except in compliance with the License.  You may
+ * obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ ***************************************************************/
+
+
+#ifndef __CLASSAD_COMPILED_EXPR_H__
+#define __CLASSAD_COMPILED_EXPR_H__
+
+#include "classad/classad.h"
+#include "classad/operators.h"
+
+#include <string>
+#include <vector>
+
+namespace classad {
+
+/** An expression lowered into a flat array of instructions, for
+	expressions that are evaluated over and over again against ads of the
+	same shape, like a job's Requirements and Rank against every slot in
+	the pool, or the periodic policy expressions of every job in the queue.
+	<p>
+	Evaluating a CompiledExpr gives exactly the same result as calling
+	Evaluate() on the tree it was compiled from.  The operators that
+	dominate real policy expressions (comparisons, arithmetic, the logical
+	operators and ?:) are executed directly on unboxed values, so that
+	comparing an attribute against a number or a string literal does not
+	allocate.  Anything else (function calls, lists, nested ads, time
+	values, bitwise operators) is handed to the tree it came from.
+	<p>
+	Attribute references remember where in the ad's attribute list they
+	found their attribute the last time, and check there first, which is
+	almost always a hit when the ads being evaluated against were built
+	the same way.  References through a scope like TARGET or MY resolve
+	the scope once per evaluation rather than once per reference.
+	<p>
+	The compiled form points into the tree it was compiled from, which
+	must outlive it and must not be modified.  A CompiledExpr may not be
+	evaluated by two threads at once.
+*/
+class CompiledExpr {
+	public:
+		CompiledExpr() {}
+		CompiledExpr(const CompiledExpr &) = delete;
+		CompiledExpr &operator=(const CompiledExpr &) = delete;
+
+		/** Compile an expression tree, replacing anything compiled before.
+			@param tree The expression; may be NULL.
+			@return false if tree was NULL.
+		*/
+		bool Compile(const ExprTree *tree);
+
+		/// Forget the compiled expression.
+		void Clear();
+
+		/// The tree this was compiled from, or NULL.
+		const ExprTree *GetTree() const { return m_tree; }
+
+		/** Evaluate, the same as GetTree()->Evaluate(state, val).
+			@return false if the evaluation failed, or nothing is compiled.
+		*/
+		bool Evaluate(EvalState &state, Value &val) const;
+
+		/** Evaluate in the scope of an ad, the same as
+			ad.EvaluateExpr(GetTree(), val, mask).
+		*/
+		bool Evaluate(const ClassAd &ad, Value &val,
+			Value::ValueType mask = Value::ValueType::SAFE_VALUES) const;
+
+		/// Number of instructions, and how many of those defer to the tree.
+		size_t size() const { return m_code.size(); }
+		size_t numFallbacks() const;
+
+	private:
+		enum Opcode {
+			CONSTANT,		// a literal
+			ATTR,			// unscoped reference "name"
+			SCOPED_ATTR,	// "scope.name", where scope is itself a plain reference
+			TREE,			// anything else; evaluated by the original tree
+			UNARY,			// -x, +x, !x
+			BINARY,			// strict comparison and arithmetic, =?= and =!=
+			LOGICAL_AND,
+			LOGICAL_OR,
+			TERNARY,		// x ? y : z
+			ELVIS			// x ?: y
+		};
+
+			// An instruction; children are indices of other instructions,
+			// which always come before their parent.
+		struct Insn {
+			Opcode opcode;
+			Operation::OpKind op;
+			int arg[3];			// child instructions, or a constant/ref index
+			const ExprTree *tree;	// the node this was compiled from
+		};
+
+			// A value on the evaluation stack.  Strings point either into
+			// a literal of some tree or into a Value owned by the caller;
+			// types not handled directly are held in such a Value.
+		struct Cell {
+			Value::ValueType type;
+			union {
+				bool b;
+				long long i;
+				double r;
+				const char *s;
+				const Value *v;
+			};
+		};
+
+		struct Ref {
+			AttrName name;
+			int scope;				// index into m_scopes, or -1
+			mutable size_t hint;	// where we found it last time
+		};
+
+			// scopes are resolved at most once per evaluation, into an
+			// array on the stack; references through any more than this
+			// many distinct scopes are left to the tree
+		static const int MAX_SCOPES = 8;
+		struct Scope {
+			const ExprTree *tree;	// an unscoped AttributeReference
+			std::string name;
+			bool absolute;
+		};
+
+		int CompileNode(const ExprTree *tree);
+		int Emit(Opcode opcode, const ExprTree *tree, int a0 = -1, int a1 = -1, int a2 = -1,
+			Operation::OpKind op = Operation::__NO_OP__);
+
+		bool Run(int pc, EvalState &state, const ClassAd **scopes, Cell &out, Value &store) const;
+		bool RunRef(const Insn &insn, EvalState &state, const ClassAd **scopes, Cell &out, Value &store) const;
+		bool RunTree(const ExprTree *tree, EvalState &state, Cell &out, Value &store) const;
+		static bool FromLiteral(const ExprTree *tree, Cell &out);
+		static void FromValue(const Value &val, Cell &out);
+		static void ToValue(const Cell &cell, Value &val);
+		static void Unary(Operation::OpKind op, const Cell &a, Cell &out, Value &store);
+		static void Binary(Operation::OpKind op, Cell a, Cell b, Cell &out, Value &store);
+
+		const ExprTree *m_tree = nullptr;
+		std::vector<Insn> m_code;
+		std::vector<Cell> m_constants;
+		std::vector<Ref> m_refs;
+		std::vector<Scope> m_scopes;
+};
+
+} // classad
+
+#endif//__CLASSAD_COMPILED_EXPR_H__
@@ -308,6 +308,7 @@ class ReltimeLiteral: public Literal {
 	private:
 		double _theReltime;
 		friend class Literal;
+		friend class ClassAdBinaryParser;
 };
 
 class AbstimeLiteral: public Literal {
@@ -35,8 +35,10 @@
 #include "classad/classad_distribution.h"
 #include "classad/lexerSource.h"
 #include "classad/xmlSink.h"
+#include "classad/binarySource.h"
 #include <fstream>
 #include <iostream>
+#include <chrono>
 #include <ctype.h>
 #include <assert.h>
 
@@ -69,6 +71,9 @@ public:
     bool  check_operator;
     bool  check_collection;
     bool  check_utils;
+    bool  check_attrnames;
+    bool  check_binary;
+    bool  benchmark;
 	void  ParseCommandLine(int argc, char **argv);
 };
 
@@ -101,6 +106,8 @@ static void test_exprlist(const Parameters &parameters, Results &results);
 static void test_value(const Parameters &parameters, Results &results);
 static void test_collection(const Parameters &parameters, Results &results);
 static void test_utils(const Parameters &parameters, Results &results);
+static void test_attrnames(const Parameters &parameters, Results &results);
+static void test_binary(const Parameters &parameters, Results &results);
 static bool check_in_view(ClassAdCollection *collection, string view_name, string classad_name);
 static void print_version(void);
 
@@ -133,6 +140,9 @@ void Parameters::ParseCommandLine(
     check_operator      = false;
     check_collection    = false;
     check_utils         = false;
+    check_attrnames     = false;
+    check_binary        = false;
+    benchmark           = false;
 
 	// Then we parse to see what the user wants. 
 	for (int arg_index = 1; arg_index < argc; arg_index++) {
@@ -180,6 +190,14 @@ void Parameters::ParseCommandLine(
 		} else if (!strcasecmp(argv[arg_index], "-utils")){
             check_utils         = true;
             selected_test       = true;
+		} else if (!strcasecmp(argv[arg_index], "-attrnames")){
+            check_attrnames     = true;
+            selected_test       = true;
+		} else if (!strcasecmp(argv[arg_index], "-binary")){
+            check_binary        = true;
+            selected_test       = true;
+		} else if (!strcasecmp(argv[arg_index], "-benchmark")){
+            benchmark           = true;
 		} else {
             cout << "Unknown argument: " << argv[arg_index] << endl;
             help = true;
@@ -206,6 +224,9 @@ void Parameters::ParseCommandLine(
         cout << "    -operator:   test the Operator class.\n";
         cout << "    -collection: test the Collection class.\n";
         cout << "    -utils:      test little utilities.\n";
+        cout << "    -attrnames:  test interned attribute names.\n";
+        cout << "    -binary:     test the binary expression encoding.\n";
+        cout << "    -benchmark:  also time -attrnames against string keys.\n";
         exit(1);
     }
     if (!selected_test) {
@@ -302,6 +323,12 @@ int main(
     if (parameters.check_all || parameters.check_utils) {
         test_utils(parameters, results);
     }
+    if (parameters.check_all || parameters.check_attrnames) {
+        test_attrnames(parameters, results);
+    }
+    if (parameters.check_all || parameters.check_binary) {
+        test_binary(parameters, results);
+    }
 
     /* ----- Report ----- */
     cout << endl;
@@ -1050,6 +1077,242 @@ static void test_utils(const Parameters &, Results &results)
     return;
 }
 
+/*********************************************************************
+ *
+ * Function: test_attrnames
+ * Purpose:  Test interned attribute names, and with -benchmark, compare
+ *           the memory and lookup time of ClassAd keys against keying
+ *           them by std::string, as ClassAds used to.
+ *
+ *********************************************************************/
+static void test_attrnames(const Parameters &parameters, Results &results)
+{
+    cout << "Testing interned attribute names...\n";
+
+    AttrName req1("Requirements");
+    AttrName req2(string("Requirements"));
+    AttrName req3("REQUIREMENTS");
+    AttrName rank("Rank");
+    TEST("Same spelling interns once", req1 == req2 && req1.c_str() == req2.c_str());
+    TEST("Spellings are kept", req3 != req1 && req3 == "REQUIREMENTS");
+    TEST("Case-folded atoms match", req1.SameAs(req3) && req1.atom() == req3.atom());
+    TEST("Different names differ", !req1.SameAs(rank));
+    TEST("Empty name is atom 0", AttrName().atom() == 0 && AttrName("").empty());
+
+    ClassAdParser parser;
+    ClassAd *ad = parser.ParseClassAd("[ Rank = 3; requirements = Rank > 1; Cmd = \"/bin/sleep\" ]");
+    TEST("Parsed ad", ad != NULL);
+    if ( ! ad) {
+        return;
+    }
+    TEST("Lookup by name", ad->Lookup(req1) != NULL && ad->Lookup(req3) == ad->Lookup("Requirements"));
+    TEST("Lookup missing name", ad->Lookup(AttrName("Missing")) == NULL);
+    TEST("Key keeps first spelling", ad->find("REQUIREMENTS")->first == "requirements");
+
+    ad->Insert(req3, Literal::MakeBool(false));
+    bool b = true;
+    TEST("Insert by name replaces", ad->size() == 3 && ad->EvaluateAttrBool("Requirements", b) && !b);
+
+    ClassAd copy(*ad);
+    TEST("Copies share names", copy.find("Cmd")->first.c_str() == ad->find("Cmd")->first.c_str());
+
+        // once the table is full, new names are private to the AttrName
+    size_t max_interned = AttrName::MaxInterned();
+    AttrName::SetMaxInterned(AttrName::NumNames());
+    AttrName priv1("NotInternedName");
+    AttrName priv2("notinternedname");
+    AttrName priv3(priv1);
+    TEST("Names past the limit are not interned", !priv1.interned() && AttrName("Rank").interned());
+    TEST("Private names compare", priv1 == priv3 && priv1 != priv2 && priv1.SameAs(priv2) && !priv1.SameAs(rank));
+    ad->InsertAttr("NotInternedName", 7);
+    TEST("Private names as keys", ad->Lookup(priv2) != NULL && ad->Lookup("notINTERNEDname") == ad->Lookup(priv1));
+    AttrName::SetMaxInterned(max_interned);
+    delete ad;
+
+    if ( ! parameters.benchmark) {
+        return;
+    }
+
+        // a job ad with the usual sort of attribute names, many of them too
+        // long to fit in a std::string without a heap allocation
+    static const char * const names[] = {
+        "AccountingGroup", "Args", "BufferBlockSize", "BufferSize", "ClusterId",
+        "Cmd", "CommittedSlotTime", "CommittedTime", "CompletionDate",
+        "CondorPlatform", "CondorVersion", "CoreSize", "CumulativeSlotTime",
+        "CurrentHosts", "DiskUsage", "EnteredCurrentStatus", "Environment",
+        "Err", "ExecutableSize", "ExitBySignal", "ExitStatus", "GlobalJobId",
+        "ImageSize", "In", "Iwd", "JobCurrentStartDate", "JobLeaseDuration",
+        "JobNotification", "JobPrio", "JobRunCount", "JobStatus",
+        "JobUniverse", "LastJobStatus", "LastSuspensionTime", "LeaveJobInQueue",
+        "MaxHosts", "MinHosts", "MyType", "NumCkpts", "NumJobStarts",
+        "NumRestarts", "NumSystemHolds", "OnExitHold", "OnExitRemove", "Out",
+        "Owner", "PeriodicHold", "PeriodicRelease", "PeriodicRemove", "ProcId",
+        "QDate", "Rank", "ReleaseReason", "RemoteSysCpu", "RemoteUserCpu",
+        "RemoteWallClockTime", "RequestCpus", "RequestDisk", "RequestMemory",
+        "Requirements", "RootDir", "ShouldTransferFiles", "StreamErr",
+        "StreamOut", "TargetType", "TotalSuspensions", "TransferIn",
+        "User", "WantRemoteIO", "WhenToTransferOutput",
+    };
+    const size_t num_names = sizeof(names) / sizeof(names[0]);
+    const int num_ads = 20000;
+    const int lookups = 50;
+
+    vector<ClassAd *> ads;
+    for (int i = 0; i < num_ads; i++) {
+        ClassAd *job = new ClassAd;
+        for (size_t n = 0; n < num_names; n++) {
+            job->InsertAttr(names[n], (long long)(i + n));
+        }
+        ads.push_back(job);
+    }
+
+        // what the keys cost now, and what they cost as std::strings,
+        // counting any heap allocation a std::string needs for its name
+    size_t interned_bytes = num_names * sizeof(std::pair<AttrName, ExprTree *>);
+    size_t string_bytes = num_names * sizeof(std::pair<string, ExprTree *>);
+    size_t sso = string().capacity();
+    for (size_t n = 0; n < num_names; n++) {
+        if (strlen(names[n]) > sso) {
+            string_bytes += strlen(names[n]) + 1;
+        }
+    }
+    cout << "    " << num_names << " attributes per ad, " << AttrName::NumNames()
+         << " names interned in total\n";
+    cout << "    key bytes per ad: " << string_bytes << " as std::string, "
+         << interned_bytes << " as AttrName\n";
+
+    vector<string> string_keys(names, names + num_names);
+    vector<AttrName> interned_keys;
+    for (size_t n = 0; n < num_names; n++) {
+        interned_keys.emplace_back(names[n]);
+    }
+
+    size_t found = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (int l = 0; l < lookups; l++) {
+        for (ClassAd *job : ads) {
+            for (const string &key : string_keys) {
+                if (job->Lookup(key)) found++;
+            }
+        }
+    }
+    auto middle = std::chrono::steady_clock::now();
+    for (int l = 0; l < lookups; l++) {
+        for (ClassAd *job : ads) {
+            for (const AttrName &key : interned_keys) {
+                if (job->Lookup(key)) found++;
+            }
+        }
+    }
+    auto end = std::chrono::steady_clock::now();
+
+    double total = (double)num_ads * lookups * num_names;
+    double by_string = std::chrono::duration<double, std::nano>(middle - start).count() / total;
+    double by_name = std::chrono::duration<double, std::nano>(end - middle).count() / total;
+    TEST("Benchmark found every attribute", found == 2 * (size_t)total);
+    cout << "    ns per Lookup: " << by_string << " by std::string, "
+         << by_name << " by AttrName\n";
+
+    for (ClassAd *job : ads) {
+        delete job;
+    }
+    return;
+}
+
+/*********************************************************************
+ *
+ * Function: test_binary
+ * Purpose:  Test that expressions survive a trip through the binary
+ *           encoding, and that damaged encodings are rejected.
+ *
+ *********************************************************************/
+static void test_binary(const Parameters &, Results &results)
+{
+    cout << "Testing binary expression encoding...\n";
+
+    static const char * const known[] = { "Owner", "JobStatus", "RequestMemory", "strcat" };
+    ClassAdBinaryNames names(known, sizeof(known) / sizeof(known[0]));
+    TEST("Names are found by position", names.Find("JobStatus") == 1 && names.Name(3) != NULL);
+    TEST("Names match exactly", names.Find("owner") == -1 && names.Name(4) == NULL);
+
+    static const char * const exprs[] = {
+        "error", "undefined", "true", "false", "0", "-1", "9223372036854775807",
+        "-9223372036854775807", "3.25", "-1e300", "\"\"", "\"a \\\"quoted\\\" string\"",
+        "Owner == \"alice\" && JobStatus =!= 2",
+        "MY.RequestMemory > TARGET.Memory * 2 ? -x : (y ?: z)",
+        ".absolute + ~(1 << 3) >>> 1 - !false",
+        "strcat(Owner, \"-\", string(JobStatus))[0]",
+        "{ 1, \"two\", { 3.0 }, [ a = 1; b = a + 1 ] }.b",
+        "[ x = 1; y = { x, \"x\" }; z = [ w = parent.x ] ]",
+        "absTime(\"2024-01-02T03:04:05+02:00\") - relTime(\"1+00:00:01\")",
+    };
+    ClassAdParser parser;
+    ClassAdUnParser unparser;
+    for (const char *text : exprs) {
+        ExprTree *tree = parser.ParseExpression(text);
+        if ( ! tree) {
+            TEST("Parse expression for binary encoding", false);
+            continue;
+        }
+        ClassAd scope;
+        Value val;
+        tree->SetParentScope(&scope);
+        if (tree->Evaluate(val)) {
+                // round trip literals of every type, including times
+            ExprTree *lit = Literal::MakeLiteral(val);
+            if (lit) {
+                string buf;
+                ClassAdBinaryUnParser(&names).Unparse(buf, lit);
+                const char *ptr = buf.data();
+                ExprTree *copy = ClassAdBinaryParser(&names).ParseExpression(ptr, buf.data() + buf.size());
+                TEST("Literal survives binary encoding", copy && copy->SameAs(lit) && ptr == buf.data() + buf.size());
+                delete copy;
+                delete lit;
+            }
+        }
+
+        string with_names, without_names;
+        TEST("Expression encodes", ClassAdBinaryUnParser(&names).Unparse(with_names, tree) &&
+             ClassAdBinaryUnParser().Unparse(without_names, tree));
+        TEST("Known names are shorter", with_names.size() <= without_names.size());
+
+        string expected, actual;
+        unparser.Unparse(expected, tree);
+        const char *ptr = with_names.data();
+        const char *end = ptr + with_names.size();
+        ExprTree *copy = ClassAdBinaryParser(&names).ParseExpression(ptr, end);
+        if (copy) unparser.Unparse(actual, copy);
+        TEST("Expression survives binary encoding", copy && ptr == end && actual == expected && copy->SameAs(tree));
+        delete copy;
+
+            // every proper prefix of an encoding is bad
+        bool rejected = true;
+        for (size_t len = 0; len < with_names.size(); ++len) {
+            ptr = with_names.data();
+            ExprTree *part = ClassAdBinaryParser(&names).ParseExpression(ptr, ptr + len);
+            if (part) { rejected = false; delete part; }
+        }
+        TEST("Truncated encoding is rejected", rejected);
+
+            // the position of a known name can't be read without the list
+        ptr = with_names.data();
+        ExprTree *unnamed = ClassAdBinaryParser().ParseExpression(ptr, end);
+        TEST("Encoding needs its names", unnamed == NULL || with_names == without_names);
+        delete unnamed;
+        delete tree;
+    }
+
+    string bad("\xFF");
+    const char *ptr = bad.data();
+    TEST("Unknown tag is rejected", ClassAdBinaryParser().ParseExpression(ptr, ptr + bad.size()) == NULL);
+    string deep;
+    for (int i = 0; i < 5000; ++i) { deep += (char)ClassAdBinaryUnParser::TAG_LIST; deep += (char)1; }
+    deep += (char)ClassAdBinaryUnParser::TAG_TRUE;
+    ptr = deep.data();
+    TEST("Deep nesting is rejected", ClassAdBinaryParser().ParseExpression(ptr, ptr + deep.size()) == NULL);
+    return;
+}
+
 /*********************************************************************
  *
  * Function: print_version
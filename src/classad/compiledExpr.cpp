@@ -0,0 +1,797 @@
+/***************************************************************
+ *
+ * Copyright (C) 2025, Condor Team, Computer Sciences Department,
+ * University of Wisconsin-Madison, WI.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you
+ * may not use this file except in compliance with the License.  You may
+ * obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ ***************************************************************/
+
+#include "classad/common.h"
+#include "classad/compiledExpr.h"
+#include "classad/classadCache.h"
+#include "classad/literals.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+// Everything in here must give exactly the same answer as the
+// corresponding code in operators.cpp and attrrefs.cpp; the comments
+// point at what is being mirrored.
+
+namespace classad {
+
+	// marks a scope that didn't evaluate to an ad this time around
+static const ClassAd *const UNRESOLVED_SCOPE = reinterpret_cast<const ClassAd *>(&UNRESOLVED_SCOPE);
+
+static inline bool
+IsCoreType(Value::ValueType type)
+{
+	switch (type) {
+	case Value::ERROR_VALUE:
+	case Value::UNDEFINED_VALUE:
+	case Value::BOOLEAN_VALUE:
+	case Value::INTEGER_VALUE:
+	case Value::REAL_VALUE:
+	case Value::STRING_VALUE:
+		return true;
+	default:
+		return false;
+	}
+}
+
+	// Value::IsBooleanValueEquiv()
+template <class CellT>
+static inline bool
+BooleanEquiv(const CellT &c, bool &b)
+{
+	switch (c.type) {
+	case Value::BOOLEAN_VALUE: b = c.b; return true;
+	case Value::INTEGER_VALUE: b = c.i != 0; return true;
+	case Value::REAL_VALUE: b = c.r != 0; return true;
+	default: return false;
+	}
+}
+
+	// Operation::compareIntegers() and friends
+template <class T>
+static inline bool
+Compare(Operation::OpKind op, T x, T y)
+{
+	switch (op) {
+	case Operation::LESS_THAN_OP:        return x < y;
+	case Operation::LESS_OR_EQUAL_OP:    return x <= y;
+	case Operation::EQUAL_OP:            return x == y;
+	case Operation::META_EQUAL_OP:       return x == y;
+	case Operation::NOT_EQUAL_OP:        return x != y;
+	case Operation::META_NOT_EQUAL_OP:   return x != y;
+	case Operation::GREATER_THAN_OP:     return x > y;
+	case Operation::GREATER_OR_EQUAL_OP: return x >= y;
+	default:
+		CLASSAD_EXCEPT("Should not get here");
+		return false;
+	}
+}
+
+
+bool CompiledExpr::
+Compile(const ExprTree *tree)
+{
+	Clear();
+	if ( ! tree) {
+		return false;
+	}
+	m_tree = tree;
+	CompileNode(tree);
+	return true;
+}
+
+
+void CompiledExpr::
+Clear()
+{
+	m_tree = nullptr;
+	m_code.clear();
+	m_constants.clear();
+	m_refs.clear();
+	m_scopes.clear();
+}
+
+
+size_t CompiledExpr::
+numFallbacks() const
+{
+	return std::count_if(m_code.begin(), m_code.end(),
+		[](const Insn &insn) { return insn.opcode == TREE; });
+}
+
+
+int CompiledExpr::
+Emit(Opcode opcode, const ExprTree *tree, int a0, int a1, int a2, Operation::OpKind op)
+{
+	Insn insn;
+	insn.opcode = opcode;
+	insn.op = op;
+	insn.arg[0] = a0;
+	insn.arg[1] = a1;
+	insn.arg[2] = a2;
+	insn.tree = tree;
+	m_code.push_back(insn);
+	return (int)m_code.size() - 1;
+}
+
+
+int CompiledExpr::
+CompileNode(const ExprTree *tree)
+{
+	ExprTree::NodeKind kind = tree->GetKind();
+
+	if (kind == ExprTree::EXPR_ENVELOPE) {
+		const ExprTree *inner = static_cast<const CachedExprEnvelope *>(tree)->get();
+		return inner ? CompileNode(inner) : Emit(TREE, tree);
+	}
+
+	Cell constant;
+	if (FromLiteral(tree, constant)) {
+		m_constants.push_back(constant);
+		return Emit(CONSTANT, tree, (int)m_constants.size() - 1);
+	}
+
+	if (kind == ExprTree::ATTRREF_NODE) {
+		ExprTree *scope = nullptr;
+		std::string name;
+		bool absolute = false;
+		static_cast<const AttributeReference *>(tree)->GetComponents(scope, name, absolute);
+
+		if ( ! scope && ! absolute) {
+			m_refs.push_back(Ref{AttrName(name), -1, 0});
+			return Emit(ATTR, tree, (int)m_refs.size() - 1);
+		}
+
+		if (scope && scope->GetKind() == ExprTree::ATTRREF_NODE) {
+			ExprTree *scope_scope = nullptr;
+			std::string scope_name;
+			bool scope_absolute = false;
+			static_cast<const AttributeReference *>(scope)->GetComponents(scope_scope, scope_name, scope_absolute);
+			if ( ! scope_scope) {
+				int idx = 0;
+				while (idx < (int)m_scopes.size() &&
+					   (m_scopes[idx].absolute != scope_absolute ||
+						strcasecmp(m_scopes[idx].name.c_str(), scope_name.c_str()) != 0)) {
+					++idx;
+				}
+				if (idx == (int)m_scopes.size() && idx < MAX_SCOPES) {
+					m_scopes.push_back(Scope{scope, scope_name, scope_absolute});
+				}
+				if (idx < (int)m_scopes.size()) {
+					m_refs.push_back(Ref{AttrName(name), idx, 0});
+					return Emit(SCOPED_ATTR, tree, (int)m_refs.size() - 1);
+				}
+			}
+		}
+		return Emit(TREE, tree);
+	}
+
+	if (kind == ExprTree::OP_NODE) {
+		Operation::OpKind op = Operation::__NO_OP__;
+		ExprTree *c1 = nullptr, *c2 = nullptr, *c3 = nullptr;
+		static_cast<const Operation *>(tree)->GetComponents(op, c1, c2, c3);
+
+		switch (op) {
+		case Operation::PARENTHESES_OP:
+			return CompileNode(c1);
+
+		case Operation::UNARY_PLUS_OP:
+		case Operation::UNARY_MINUS_OP:
+		case Operation::LOGICAL_NOT_OP:
+			return Emit(UNARY, tree, CompileNode(c1), -1, -1, op);
+
+		case Operation::LESS_THAN_OP:
+		case Operation::LESS_OR_EQUAL_OP:
+		case Operation::NOT_EQUAL_OP:
+		case Operation::EQUAL_OP:
+		case Operation::GREATER_OR_EQUAL_OP:
+		case Operation::GREATER_THAN_OP:
+		case Operation::META_EQUAL_OP:
+		case Operation::META_NOT_EQUAL_OP:
+		case Operation::ADDITION_OP:
+		case Operation::SUBTRACTION_OP:
+		case Operation::MULTIPLICATION_OP:
+		case Operation::DIVISION_OP:
+		case Operation::MODULUS_OP: {
+			int a0 = CompileNode(c1);
+			int a1 = CompileNode(c2);
+			return Emit(BINARY, tree, a0, a1, -1, op);
+		}
+
+		case Operation::LOGICAL_AND_OP:
+		case Operation::LOGICAL_OR_OP: {
+			int a0 = CompileNode(c1);
+			int a1 = CompileNode(c2);
+			return Emit(op == Operation::LOGICAL_AND_OP ? LOGICAL_AND : LOGICAL_OR, tree, a0, a1, -1, op);
+		}
+
+		case Operation::ELVIS_OP: {
+			int a0 = CompileNode(c1);
+			int a1 = CompileNode(c2);
+			return Emit(ELVIS, tree, a0, a1, -1, op);
+		}
+
+		case Operation::TERNARY_OP:
+				// the old-style "x ? : z" form is rare enough to leave alone
+			if (c1 && c2 && c3) {
+				int a0 = CompileNode(c1);
+				int a1 = CompileNode(c2);
+				int a2 = CompileNode(c3);
+				return Emit(TERNARY, tree, a0, a1, a2, op);
+			}
+			break;
+
+		default:
+			break;
+		}
+	}
+
+	return Emit(TREE, tree);
+}
+
+
+bool CompiledExpr::
+FromLiteral(const ExprTree *tree, Cell &out)
+{
+	switch (tree->GetKind()) {
+	case ExprTree::ERROR_LITERAL:
+		out.type = Value::ERROR_VALUE;
+		return true;
+	case ExprTree::UNDEFINED_LITERAL:
+		out.type = Value::UNDEFINED_VALUE;
+		return true;
+	case ExprTree::BOOLEAN_LITERAL:
+		out.type = Value::BOOLEAN_VALUE;
+		out.b = static_cast<const BooleanLiteral *>(tree)->getBool();
+		return true;
+	case ExprTree::INTEGER_LITERAL:
+		out.type = Value::INTEGER_VALUE;
+		out.i = static_cast<const IntegerLiteral *>(tree)->getInteger();
+		return true;
+	case ExprTree::REAL_LITERAL:
+		out.type = Value::REAL_VALUE;
+		out.r = static_cast<const RealLiteral *>(tree)->getReal();
+		return true;
+	case ExprTree::STRING_LITERAL:
+		out.type = Value::STRING_VALUE;
+		out.s = static_cast<const StringLiteral *>(tree)->getCString();
+		return true;
+	default:
+		return false;
+	}
+}
+
+
+void CompiledExpr::
+FromValue(const Value &val, Cell &out)
+{
+	out.type = val.GetType();
+	switch (out.type) {
+	case Value::ERROR_VALUE:
+	case Value::UNDEFINED_VALUE:
+		break;
+	case Value::BOOLEAN_VALUE:
+		val.IsBooleanValue(out.b);
+		break;
+	case Value::INTEGER_VALUE:
+		val.IsIntegerValue(out.i);
+		break;
+	case Value::REAL_VALUE:
+		val.IsRealValue(out.r);
+		break;
+	case Value::STRING_VALUE:
+		val.IsStringValue(out.s);
+		break;
+	default:
+		out.v = &val;
+		break;
+	}
+}
+
+
+void CompiledExpr::
+ToValue(const Cell &cell, Value &val)
+{
+	switch (cell.type) {
+	case Value::ERROR_VALUE:
+		val.SetErrorValue();
+		break;
+	case Value::UNDEFINED_VALUE:
+		val.SetUndefinedValue();
+		break;
+	case Value::BOOLEAN_VALUE:
+		val.SetBooleanValue(cell.b);
+		break;
+	case Value::INTEGER_VALUE:
+		val.SetIntegerValue(cell.i);
+		break;
+	case Value::REAL_VALUE:
+		val.SetRealValue(cell.r);
+		break;
+	case Value::STRING_VALUE: {
+		const char *cur = nullptr;
+		if ( ! val.IsStringValue(cur) || cur != cell.s) {
+			val.SetStringValue(cell.s);
+		}
+		break;
+	}
+	default:
+		if (cell.v != &val) {
+			val.CopyFrom(*cell.v);
+		}
+		break;
+	}
+}
+
+
+bool CompiledExpr::
+Evaluate(EvalState &state, Value &val) const
+{
+	if (m_code.empty()) {
+		return false;
+	}
+	if (state.debug) {
+			// let the tree do the per-node logging
+		return m_tree->Evaluate(state, val);
+	}
+
+	const ClassAd *scopes[MAX_SCOPES] = {};
+	Cell out;
+	bool rval = Run((int)m_code.size() - 1, state, scopes, out, val);
+	ToValue(out, val);
+	return rval;
+}
+
+
+bool CompiledExpr::
+Evaluate(const ClassAd &ad, Value &val, Value::ValueType mask) const
+{
+		// ClassAd::EvaluateExpr()
+	EvalState state;
+	state.SetScopes(&ad);
+	bool res = Evaluate(state, val);
+	if (res && ! val.SafetyCheck(state, mask)) {
+		res = false;
+	}
+	return res;
+}
+
+
+bool CompiledExpr::
+RunTree(const ExprTree *tree, EvalState &state, Cell &out, Value &store) const
+{
+	bool rval = tree->Evaluate(state, store);
+	FromValue(store, out);
+	return rval;
+}
+
+
+	// AttributeReference::_Evaluate(), for the common case where the
+	// attribute is in the ad itself; everything else goes to the tree.
+bool CompiledExpr::
+RunRef(const Insn &insn, EvalState &state, const ClassAd **scopes, Cell &out, Value &store) const
+{
+	const Ref &ref = m_refs[insn.arg[0]];
+	const ClassAd *ad = state.curAd;
+
+	if (ref.scope >= 0) {
+		ad = scopes[ref.scope];
+		if ( ! ad) {
+			Value scope_val;
+			ClassAd *scope_ad = nullptr;
+			if (m_scopes[ref.scope].tree->Evaluate(state, scope_val) &&
+				scope_val.GetType() == Value::CLASSAD_VALUE &&
+				scope_val.IsClassAdValue(scope_ad) && scope_ad) {
+				ad = scope_ad;
+			} else {
+				ad = UNRESOLVED_SCOPE;
+			}
+			scopes[ref.scope] = ad;
+		}
+		if (ad == UNRESOLVED_SCOPE) {
+			return RunTree(insn.tree, state, out, store);
+		}
+	}
+
+	if ( ! ad || state.depth_remaining <= 0) {
+		return RunTree(insn.tree, state, out, store);
+	}
+
+		// ClassAd::Lookup(), without the chained parent, checking the slot
+		// where we found this attribute last time before searching
+	const ExprTree *expr = nullptr;
+	size_t num_attrs = (size_t)ad->size();
+	if (ref.hint < num_attrs) {
+		ClassAd::const_iterator it = ad->begin() + ref.hint;
+		if (it->first.SameAs(ref.name)) {
+			expr = it->second;
+		}
+	}
+	if ( ! expr) {
+		ClassAd::const_iterator it = std::lower_bound(ad->begin(), ad->end(), ref.name, ClassAdFlatMapOrder(ref.name));
+		if (it != ad->end() && ClassAdFlatMapEqual(*it, ref.name)) {
+			ref.hint = it - ad->begin();
+			expr = it->second;
+		}
+	}
+	if ( ! expr) {
+		return RunTree(insn.tree, state, out, store);
+	}
+
+	const ExprTree *inner = expr;
+	if (inner->GetKind() == ExprTree::EXPR_ENVELOPE) {
+		inner = static_cast<const CachedExprEnvelope *>(inner)->get();
+	}
+	if (inner && FromLiteral(inner, out)) {
+		return true;
+	}
+
+	const ClassAd *cur_ad = state.curAd;
+	state.curAd = ad;
+	state.depth_remaining--;
+	bool rval = expr->Evaluate(state, store);
+	state.depth_remaining++;
+	state.curAd = cur_ad;
+	FromValue(store, out);
+	return rval;
+}
+
+
+bool CompiledExpr::
+Run(int pc, EvalState &state, const ClassAd **scopes, Cell &out, Value &store) const
+{
+	const Insn &insn = m_code[pc];
+
+	switch (insn.opcode) {
+	case CONSTANT:
+		out = m_constants[insn.arg[0]];
+		return true;
+
+	case ATTR:
+	case SCOPED_ATTR:
+		return RunRef(insn, state, scopes, out, store);
+
+	case TREE:
+		return RunTree(insn.tree, state, out, store);
+
+	case UNARY: {
+		Value store1;
+		Cell a;
+		if ( ! Run(insn.arg[0], state, scopes, a, store1)) {
+			out.type = Value::ERROR_VALUE;
+			return false;
+		}
+		Unary(insn.op, a, out, store);
+		return true;
+	}
+
+	case BINARY: {
+		Value store1, store2;
+		Cell a, b;
+		if ( ! Run(insn.arg[0], state, scopes, a, store1) ||
+			 ! Run(insn.arg[1], state, scopes, b, store2)) {
+			out.type = Value::ERROR_VALUE;
+			return false;
+		}
+		Binary(insn.op, a, b, out, store);
+		return true;
+	}
+
+	case LOGICAL_AND:
+	case LOGICAL_OR: {
+			// Operation::shortCircuit(), then Operation::doLogical()
+		bool is_and = insn.opcode == LOGICAL_AND;
+		Value store1, store2;
+		Cell a, b;
+		bool b1 = false, b2 = false;
+		if ( ! Run(insn.arg[0], state, scopes, a, store1)) {
+			out.type = Value::ERROR_VALUE;
+			return false;
+		}
+		if (BooleanEquiv(a, b1) && b1 != is_and) {
+			out.type = Value::BOOLEAN_VALUE;
+			out.b = b1;
+			return true;
+		}
+		if ( ! Run(insn.arg[1], state, scopes, b, store2)) {
+			out.type = Value::ERROR_VALUE;
+			return false;
+		}
+		if ( ! IsCoreType(a.type) || ! IsCoreType(b.type)) {
+			Binary(insn.op, a, b, out, store);
+			return true;
+		}
+		if (BooleanEquiv(a, b1)) {
+			a.type = Value::BOOLEAN_VALUE;
+			a.b = b1;
+		}
+		if (BooleanEquiv(b, b2)) {
+			b.type = Value::BOOLEAN_VALUE;
+			b.b = b2;
+		}
+		if ((a.type != Value::UNDEFINED_VALUE && a.type != Value::ERROR_VALUE && a.type != Value::BOOLEAN_VALUE) ||
+			(b.type != Value::UNDEFINED_VALUE && b.type != Value::ERROR_VALUE && b.type != Value::BOOLEAN_VALUE)) {
+			out.type = Value::ERROR_VALUE;
+		} else if (a.type == Value::ERROR_VALUE) {
+			out.type = Value::ERROR_VALUE;
+		} else if (a.type == Value::BOOLEAN_VALUE || b.type != Value::BOOLEAN_VALUE) {
+				// a is the identity of this operator, or b is exceptional
+			out = b;
+		} else if (b.b != is_and) {
+			out.type = Value::BOOLEAN_VALUE;
+			out.b = b.b;
+		} else {
+			out.type = Value::UNDEFINED_VALUE;
+		}
+		return true;
+	}
+
+	case TERNARY: {
+			// Operation3::shortCircuit(), then Operation::_doOperation()
+		Value store1;
+		Cell a;
+		bool b1 = false;
+		if ( ! Run(insn.arg[0], state, scopes, a, store1)) {
+			out.type = Value::ERROR_VALUE;
+			return false;
+		}
+		if (BooleanEquiv(a, b1)) {
+			if ( ! Run(insn.arg[b1 ? 1 : 2], state, scopes, out, store)) {
+				out.type = Value::ERROR_VALUE;
+				return false;
+			}
+			return true;
+		}
+			// both branches are evaluated, for their failures only
+		Cell ignored;
+		if ( ! Run(insn.arg[1], state, scopes, ignored, store) ||
+			 ! Run(insn.arg[2], state, scopes, ignored, store)) {
+			out.type = Value::ERROR_VALUE;
+			return false;
+		}
+		out.type = (a.type == Value::UNDEFINED_VALUE) ? Value::UNDEFINED_VALUE : Value::ERROR_VALUE;
+		return true;
+	}
+
+	case ELVIS:
+		if ( ! Run(insn.arg[0], state, scopes, out, store)) {
+			out.type = Value::ERROR_VALUE;
+			return false;
+		}
+		if (out.type != Value::UNDEFINED_VALUE) {
+			return true;
+		}
+		if ( ! Run(insn.arg[1], state, scopes, out, store)) {
+			out.type = Value::ERROR_VALUE;
+			return false;
+		}
+		return true;
+	}
+
+	CLASSAD_EXCEPT("Should not get here");
+	return false;
+}
+
+
+	// Operation::_doOperation() for unary +, - and !
+void CompiledExpr::
+Unary(Operation::OpKind op, const Cell &a, Cell &out, Value &store)
+{
+	if ( ! IsCoreType(a.type)) {
+		double secs = 0;
+		if (a.type == Value::RELATIVE_TIME_VALUE && a.v->IsRelativeTimeValue(secs) &&
+			(op == Operation::UNARY_PLUS_OP || op == Operation::UNARY_MINUS_OP)) {
+			store.SetRelativeTimeValue(op == Operation::UNARY_MINUS_OP ? -secs : secs);
+			FromValue(store, out);
+		} else {
+			out.type = Value::ERROR_VALUE;
+		}
+		return;
+	}
+
+	if (op == Operation::UNARY_PLUS_OP) {
+		if (a.type == Value::BOOLEAN_VALUE || a.type == Value::STRING_VALUE) {
+			out.type = Value::ERROR_VALUE;
+		} else {
+			out = a;
+		}
+		return;
+	}
+
+	if (a.type == Value::ERROR_VALUE || a.type == Value::UNDEFINED_VALUE) {
+		out.type = a.type;
+		return;
+	}
+
+	if (op == Operation::UNARY_MINUS_OP) {
+			// Operation::doArithmetic(); note that -true is an error
+		if (a.type == Value::INTEGER_VALUE) {
+			out.type = Value::INTEGER_VALUE;
+			out.i = -a.i;
+		} else if (a.type == Value::REAL_VALUE) {
+			out.type = Value::REAL_VALUE;
+			out.r = -a.r;
+		} else {
+			out.type = Value::ERROR_VALUE;
+		}
+		return;
+	}
+
+		// Operation::doLogical()
+	bool b = false;
+	if (BooleanEquiv(a, b)) {
+		out.type = Value::BOOLEAN_VALUE;
+		out.b = !b;
+	} else {
+		out.type = Value::ERROR_VALUE;
+	}
+}
+
+
+	// Operation::_doOperation() for binary operators, with both operands
+	// already evaluated
+void CompiledExpr::
+Binary(Operation::OpKind op, Cell a, Cell b, Cell &out, Value &store)
+{
+	if ( ! IsCoreType(a.type) || ! IsCoreType(b.type)) {
+		Value v1, v2;
+		ToValue(a, v1);
+		ToValue(b, v2);
+		Operation::Operate(op, v1, v2, store);
+		FromValue(store, out);
+		return;
+	}
+
+	bool meta = (op == Operation::META_EQUAL_OP || op == Operation::META_NOT_EQUAL_OP);
+
+	if (meta) {
+			// Operation::doComparison(): no promotions, and the types
+			// must match
+		if (a.type != b.type) {
+			out.type = Value::BOOLEAN_VALUE;
+			out.b = (op == Operation::META_NOT_EQUAL_OP);
+			return;
+		}
+		out.type = Value::BOOLEAN_VALUE;
+		switch (a.type) {
+		case Value::UNDEFINED_VALUE:
+		case Value::ERROR_VALUE:
+			out.b = (op == Operation::META_EQUAL_OP);
+			break;
+		case Value::STRING_VALUE:
+			out.b = Compare(op, strcmp(a.s, b.s), 0);
+			break;
+		case Value::BOOLEAN_VALUE:
+			out.b = Compare(op, a.b, b.b);
+			break;
+		case Value::INTEGER_VALUE:
+			out.b = Compare(op, a.i, b.i);
+			break;
+		default:
+			out.b = Compare(op, a.r, b.r);
+			break;
+		}
+		return;
+	}
+
+		// the strict operators
+	if (a.type == Value::ERROR_VALUE || b.type == Value::ERROR_VALUE) {
+		out.type = Value::ERROR_VALUE;
+		return;
+	}
+	if (a.type == Value::UNDEFINED_VALUE || b.type == Value::UNDEFINED_VALUE) {
+		out.type = Value::UNDEFINED_VALUE;
+		return;
+	}
+
+	bool comparison = (op >= Operation::__COMPARISON_START__ && op <= Operation::__COMPARISON_END__);
+
+	if (a.type == Value::STRING_VALUE || b.type == Value::STRING_VALUE) {
+			// Operation::compareStrings(); strings don't do arithmetic
+		if (comparison && a.type == b.type) {
+			out.type = Value::BOOLEAN_VALUE;
+			out.b = Compare(op, strcasecmp(a.s, b.s), 0);
+		} else {
+			out.type = Value::ERROR_VALUE;
+		}
+		return;
+	}
+
+		// Operation::coerceToNumber()
+	if (a.type == Value::BOOLEAN_VALUE) {
+		a.type = Value::INTEGER_VALUE;
+		a.i = a.b ? 1 : 0;
+	}
+	if (b.type == Value::BOOLEAN_VALUE) {
+		b.type = Value::INTEGER_VALUE;
+		b.i = b.b ? 1 : 0;
+	}
+
+	if (a.type == Value::INTEGER_VALUE && b.type == Value::INTEGER_VALUE) {
+		long long i1 = a.i, i2 = b.i;
+		if (comparison) {
+			out.type = Value::BOOLEAN_VALUE;
+			out.b = Compare(op, i1, i2);
+			return;
+		}
+		out.type = Value::INTEGER_VALUE;
+		switch (op) {
+		case Operation::ADDITION_OP:
+			out.i = i1 + i2;
+			break;
+		case Operation::SUBTRACTION_OP:
+			out.i = i1 - i2;
+			break;
+		case Operation::MULTIPLICATION_OP:
+			out.i = i1 * i2;
+			break;
+		case Operation::DIVISION_OP:
+			if (i1 == std::numeric_limits<long long>::min() && i2 == -1) {
+				out.i = std::numeric_limits<long long>::max();
+			} else if (i2 != 0) {
+				out.i = i1 / i2;
+			} else {
+				out.type = Value::ERROR_VALUE;
+			}
+			break;
+		case Operation::MODULUS_OP:
+			if (i1 == std::numeric_limits<long long>::min() && i2 == -1) {
+				out.i = 0;
+			} else if (i2 != 0) {
+				out.i = i1 % i2;
+			} else {
+				out.type = Value::ERROR_VALUE;
+			}
+			break;
+		default:
+			CLASSAD_EXCEPT("Should not get here");
+		}
+		return;
+	}
+
+	double r1 = (a.type == Value::INTEGER_VALUE) ? (double)a.i : a.r;
+	double r2 = (b.type == Value::INTEGER_VALUE) ? (double)b.i : b.r;
+	if (comparison) {
+		out.type = Value::BOOLEAN_VALUE;
+		out.b = Compare(op, r1, r2);
+		return;
+	}
+
+		// Operation::doRealArithmetic()
+	double comp = 0;
+	switch (op) {
+	case Operation::ADDITION_OP:       comp = r1 + r2; break;
+	case Operation::SUBTRACTION_OP:    comp = r1 - r2; break;
+	case Operation::MULTIPLICATION_OP: comp = r1 * r2; break;
+	case Operation::DIVISION_OP:       comp = r1 / r2; break;
+	case Operation::MODULUS_OP:
+		out.type = Value::ERROR_VALUE;
+		return;
+	default:
+		CLASSAD_EXCEPT("Should not get here");
+	}
+	if (comp == HUGE_VAL) {
+		out.type = Value::ERROR_VALUE;
+	} else {
+		out.type = Value::REAL_VALUE;
+		out.r = comp;
+	}
+}
+
+} // classad
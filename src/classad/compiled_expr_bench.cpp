@@ -0,0 +1,265 @@
+/***************************************************************
+ *
+ * Copyright (C) 2025, Condor Team, Computer Sciences Department,
+ * University of Wisconsin-Madison, WI.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you
+ * may not use this file except in compliance with the License.  You may
+ * obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ ***************************************************************/
+
+// Check that CompiledExpr gives the same answers as ExprTree::Evaluate(),
+// then time the two against each other on a job ad and a pool of slot
+// ads like the negotiator and the schedd see them.  Exits non-zero if
+// any answer differs.
+
+#include "classad/classad_distribution.h"
+
+#include <chrono>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <vector>
+
+using namespace classad;
+
+static const char *job_ad_text =
+	"[ ClusterId = 1234; ProcId = 7; Owner = \"alice\"; User = \"alice@example.org\";"
+	"  AcctGroup = \"physics\"; JobUniverse = 5; JobStatus = 2; JobPrio = 0;"
+	"  Cmd = \"/home/alice/analysis.sh\"; Iwd = \"/home/alice/run7\";"
+	"  RequestCpus = 1; RequestMemory = 2048; RequestDisk = 1048576; RequestGPUs = 0;"
+	"  ImageSize = 150000; ImageSize_RAW = 149876; MemoryUsage = ((ResidentSetSize + 1023) / 1024);"
+	"  ResidentSetSize = 1800000; DiskUsage = 400000; NumJobStarts = 1; NumShadowStarts = 1;"
+	"  JobRunCount = 1; EnteredCurrentStatus = 1700000000; QDate = 1699990000;"
+	"  RemoteWallClockTime = 5400.0; CumulativeSlotTime = 5400.0; MaxWallTime = 7200;"
+	"  WantCheckpoint = false; ShouldTransferFiles = \"YES\"; WhenToTransferOutput = \"ON_EXIT\";"
+	"  DesiredOS = \"LINUX\"; ConcurrencyLimits = undefined; HoldReasonCode = undefined;"
+	"  Requirements = (TARGET.Arch == \"X86_64\") && (TARGET.OpSys == \"LINUX\") &&"
+	"    (TARGET.Disk >= RequestDisk) && (TARGET.Memory >= RequestMemory) &&"
+	"    (TARGET.Cpus >= RequestCpus) && (TARGET.HasFileTransfer) && (TARGET.HasSingularity =!= false);"
+	"  Rank = TARGET.Mips + (TARGET.KFlops / 1000.0) - (TARGET.LoadAvg * 10);"
+	"]";
+
+	// a partitionable slot, a static slot, and a dynamic one, which are
+	// then varied to make up the pool
+static const char *slot_ad_text[] = {
+	"[ Name = \"slot1@node%d.example.org\"; Machine = \"node.example.org\"; SlotType = \"Partitionable\";"
+	"  Arch = \"X86_64\"; OpSys = \"LINUX\"; OpSysAndVer = \"AlmaLinux9\"; Cpus = 32; TotalCpus = 64;"
+	"  Memory = 131072; TotalMemory = 262144; Disk = 900000000; GPUs = 0; Mips = 31000; KFlops = 2600000;"
+	"  LoadAvg = 0.35; HasFileTransfer = true; HasSingularity = true; State = \"Unclaimed\"; Activity = \"Idle\";"
+	"  PartitionableSlot = true; SlotWeight = Cpus; AcctGroupAllowed = \"physics\";"
+	"  Start = (TARGET.RequestCpus <= MY.Cpus) && (TARGET.RequestMemory <= MY.Memory) &&"
+	"    (MY.AcctGroupAllowed =?= undefined || TARGET.AcctGroup == MY.AcctGroupAllowed);"
+	"  Requirements = START;"
+	"  Rank = (TARGET.Owner == \"alice\") ? 10 : 0; ]",
+
+	"[ Name = \"slot%d@worker.example.org\"; Machine = \"worker.example.org\"; SlotType = \"Static\";"
+	"  Arch = \"x86_64\"; OpSys = \"linux\"; Cpus = 1; Memory = %d; Disk = 20000000; Mips = 22000; KFlops = 1400000;"
+	"  LoadAvg = 1.0; HasFileTransfer = true; State = \"Claimed\"; Activity = \"Busy\"; RemoteOwner = \"bob@example.org\";"
+	"  Start = KeyboardIdle > 15 * 60 && (LoadAvg - CondorLoadAvg) <= 0.3; KeyboardIdle = 3600; CondorLoadAvg = 1.0;"
+	"  Requirements = START; ]",
+
+	"[ Name = \"slot1_%d@gpu.example.org\"; Machine = \"gpu.example.org\"; SlotType = \"Dynamic\";"
+	"  Arch = \"X86_64\"; OpSys = \"LINUX\"; Cpus = 4; Memory = %d; Disk = 50000000; GPUs = 1; Mips = 28000; KFlops = 2200000;"
+	"  LoadAvg = 0.0; HasFileTransfer = false; HasSingularity = false; State = \"Unclaimed\"; Activity = \"Idle\";"
+	"  Start = TARGET.RequestGPUs > 0 || MY.GPUs == 0;"
+	"  Requirements = START; ]",
+};
+
+	// expressions evaluated in the job ad against each slot, the way the
+	// negotiator does, and in the job ad alone, like the schedd's
+	// periodic policy
+static const char *job_exprs[] = {
+	"Requirements",
+	"Rank",
+	"TARGET.Start",
+	"(JobStatus == 2) && (RemoteWallClockTime > MaxWallTime)",
+	"(JobStatus == 5) && (HoldReasonCode =!= 12) && (NumJobStarts < 3)",
+	"MemoryUsage > RequestMemory * 1.5",
+	"(JobStatus == 2) && (MemoryUsage > RequestMemory ?: 4096)",
+	"DiskUsage > RequestDisk || ImageSize_RAW > 1024 * RequestMemory",
+	"NumJobStarts > 10 ? true : JobRunCount >= NumShadowStarts",
+	"time() - EnteredCurrentStatus > 60 * 60 * 24 * 365 * 100",
+	"stringListMember(TARGET.OpSys, \"LINUX,WINDOWS\") && TARGET.Memory % 1024 == 0",
+};
+
+	// corner cases of the operators, checked but not timed
+static const char *corner_exprs[] = {
+	"1 + 2 * 3 - 4 / 3 % 2", "7 / 0", "7 % 0", "7.0 % 2", "7.0 / 0", "-7 / 2", "-(-9223372036854775807 - 1) / -1",
+	"(-9223372036854775807 - 1) / -1", "(-9223372036854775807 - 1) % -1", "1e308 * 10", "-1e308 * 10",
+	"true + true", "-true", "+true", "+\"x\"", "-\"x\"", "!1", "!0.0", "!\"x\"", "!undefined", "-error",
+	"\"abc\" == \"ABC\"", "\"abc\" =?= \"ABC\"", "\"abc\" =!= \"abc\"", "\"abc\" < \"abd\"", "\"a\" + 1",
+	"\"a\" == 1", "1 == 1.0", "1 =?= 1.0", "true == 1", "true =?= 1", "true =?= true", "false < true",
+	"undefined == 1", "undefined =?= undefined", "error =?= error", "undefined =!= error", "1 == error",
+	"undefined == error", "error == undefined", "error && false", "false && error", "undefined && false",
+	"undefined && true", "undefined || true", "undefined || false", "true || error", "1 && 2", "0.0 || \"x\"",
+	"\"x\" || true", "true && \"x\"", "true && 3", "false || 0", "undefined ? 1 : 2", "error ? 1 : 2",
+	"\"x\" ? 1 : 2", "0.5 ? 1 : 2", "0 ? 1 : error", "undefined ?: 7", "error ?: 7", "3 ?: 7",
+	"{1, 2} == {1, 2}", "{1, 2} =?= {1, 2}", "[a = 1] == 3", "{1, 2}[1] + 1", "size({1, 2, 3}) * 2",
+	"relTime(\"1:00:00\") + relTime(\"0:30\")", "-relTime(\"1:00\")", "+relTime(\"1:00\")",
+	"relTime(\"1:00\") < 3600", "absTime(\"2025-01-01T00:00:00Z\") == absTime(\"2025-01-01T00:00:00Z\")",
+	"5 & 3", "1 << 4", "~0", "NoSuchAttribute", "NoSuchAttribute + 1", "TARGET.NoSuchAttribute",
+	"MY.RequestMemory", "MY.MY.RequestMemory", "TARGET.Memory / MY.RequestMemory", ".RIGHT.Cpus",
+	"Owner == TARGET.RemoteOwner", "CurrentTime > 0", "real(RequestMemory) / 3",
+	"RequestMemory > 1000 ? \"big\" : \"small\"", "ifThenElse(RequestCpus > 1, 2, 3) + 1",
+};
+
+static std::string
+Unparsed(const Value &val)
+{
+	ClassAdUnParser unparser;
+	std::string buf;
+	unparser.Unparse(buf, val);
+	return std::to_string((int)val.GetType()) + ":" + buf;
+}
+
+static ClassAd *
+ParseAd(const char *text)
+{
+	ClassAdParser parser;
+	ClassAd *ad = parser.ParseClassAd(text, true);
+	if ( ! ad) {
+		fprintf(stderr, "Failed to parse %s\n", text);
+		exit(2);
+	}
+	return ad;
+}
+
+int
+main( int argc, const char *argv[] )
+{
+	int num_slots = 2000;
+	int iterations = 20;
+	for (int i = 1; i < argc; ++i) {
+		if (i + 1 < argc && ! strcmp(argv[i], "-slots")) {
+			num_slots = atoi(argv[++i]);
+		} else if (i + 1 < argc && ! strcmp(argv[i], "-iterations")) {
+			iterations = atoi(argv[++i]);
+		} else {
+			fprintf(stderr, "Usage: %s [-slots N] [-iterations N]\n", argv[0]);
+			return 1;
+		}
+	}
+
+	ClassAd *job = ParseAd(job_ad_text);
+
+	std::vector<ClassAd *> slots;
+	for (int i = 0; i < num_slots; ++i) {
+		char buf[4096];
+		snprintf(buf, sizeof(buf), slot_ad_text[i % 3], i, 1024 * (1 + i % 8));
+		slots.push_back(ParseAd(buf));
+	}
+		// a few slots that don't look like the others
+	slots[0]->InsertAttr("Memory", "lots");
+	slots[1]->Delete("OpSys");
+	slots[2]->InsertAttr("Arch", 64);
+	slots[3]->Insert("Memory", ClassAdParser().ParseExpression("TotalMemory / 2"));
+
+	MatchClassAd mad;
+	unsigned failures = 0;
+
+	auto check = [&](const char *text, const ExprTree *tree, const ClassAd &scope, const ClassAd *slot) {
+		CompiledExpr compiled;
+		compiled.Compile(tree);
+			// twice, so that the second time uses the lookup hints
+		for (int pass = 0; pass < 2; ++pass) {
+			Value classic_val, compiled_val;
+			bool classic_ok = scope.EvaluateExpr(tree, classic_val);
+			bool compiled_ok = compiled.Evaluate(scope, compiled_val);
+			if (classic_ok != compiled_ok || Unparsed(classic_val) != Unparsed(compiled_val)) {
+				++failures;
+				std::string slot_name;
+				if (slot) { slot->EvaluateAttrString("Name", slot_name); }
+				fprintf(stderr, "MISMATCH %s [%s]: classic %d %s, compiled %d %s\n", text, slot_name.c_str(),
+					classic_ok, Unparsed(classic_val).c_str(), compiled_ok, Unparsed(compiled_val).c_str());
+			}
+		}
+	};
+
+	ClassAdParser parser;
+	std::vector<ExprTree *> exprs;
+	for (const char *text : job_exprs) {
+		ExprTree *tree = job->Lookup(text);
+		exprs.push_back(tree ? tree->Copy() : parser.ParseExpression(text));
+	}
+	std::vector<ExprTree *> corners;
+	for (const char *text : corner_exprs) {
+		ExprTree *tree = parser.ParseExpression(text);
+		if ( ! tree) {
+			fprintf(stderr, "Failed to parse %s\n", text);
+			return 2;
+		}
+		corners.push_back(tree);
+	}
+
+	mad.ReplaceLeftAd(job);
+	for (int i = 0; i < 16 && i < num_slots; ++i) {
+		mad.ReplaceRightAd(slots[i]);
+		for (size_t e = 0; e < exprs.size(); ++e) {
+			exprs[e]->SetParentScope(job);
+			check(job_exprs[e], exprs[e], *job, slots[i]);
+		}
+		for (size_t e = 0; e < corners.size(); ++e) {
+			corners[e]->SetParentScope(job);
+			check(corner_exprs[e], corners[e], *job, slots[i]);
+		}
+		mad.RemoveRightAd();
+	}
+
+	printf("%-75s %6s %10s %10s %7s\n", "expression", "insns", "tree ns", "comp ns", "speedup");
+	for (size_t e = 0; e < exprs.size(); ++e) {
+		CompiledExpr compiled;
+		compiled.Compile(exprs[e]);
+
+		double usec[2] = { 0, 0 };
+		long long trues[2] = { 0, 0 };
+		for (int which = 0; which < 2; ++which) {
+			auto begin = std::chrono::steady_clock::now();
+			for (int iter = 0; iter < iterations; ++iter) {
+				for (ClassAd *slot : slots) {
+					mad.ReplaceRightAd(slot);
+					Value val;
+					bool b = false;
+					bool ok = which ? compiled.Evaluate(*job, val) : job->EvaluateExpr(exprs[e], val);
+					if (ok && val.IsBooleanValueEquiv(b) && b) {
+						++trues[which];
+					}
+					mad.RemoveRightAd();
+				}
+			}
+			auto end = std::chrono::steady_clock::now();
+			usec[which] = std::chrono::duration<double, std::micro>(end - begin).count();
+		}
+		if (trues[0] != trues[1]) {
+			++failures;
+			fprintf(stderr, "MISMATCH %s: %lld true from the tree, %lld compiled\n", job_exprs[e], trues[0], trues[1]);
+		}
+
+		double evals = (double)iterations * slots.size();
+		printf("%-75.75s %3zu/%-2zu %10.1f %10.1f %6.2fx\n", job_exprs[e], compiled.size(), compiled.numFallbacks(),
+			1000.0 * usec[0] / evals, 1000.0 * usec[1] / evals, usec[1] > 0 ? usec[0] / usec[1] : 0.0);
+	}
+	mad.RemoveLeftAd();
+
+	for (ExprTree *tree : exprs) { delete tree; }
+	for (ExprTree *tree : corners) { delete tree; }
+	for (ClassAd *ad : slots) { delete ad; }
+	delete job;
+
+	if (failures) {
+		fprintf(stderr, "%u mismatches\n", failures);
+		return 1;
+	}
+	printf("All compiled results matched.\n");
+	return 0;
+}
@@ -49,6 +49,11 @@
 
 #include "dc_schedd.h"
 
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+
 using std::vector;
 using std::string;
 
@@ -112,6 +117,7 @@ int CollectorDaemon::max_pending_query_workers = 50;
 int CollectorDaemon::max_query_worktime = 0;
 int CollectorDaemon::active_query_workers = 0;
 int CollectorDaemon::pending_query_workers = 0;
+bool CollectorDaemon::query_threads = false;
 
 #ifdef TRACK_QUERIES_BY_SUBSYS
 bool CollectorDaemon::want_track_queries_by_subsys = false;
@@ -374,6 +380,8 @@ void CollectorDaemon::Init()
 	// install command handlers for updates
 	daemonCore->Register_CommandWithPayload(UPDATE_STARTD_AD,"UPDATE_STARTD_AD",
 		receive_update,"receive_update",ADVERTISE_STARTD_PERM);
+	daemonCore->Register_CommandWithPayload(UPDATE_STARTD_AD_DELTA,"UPDATE_STARTD_AD_DELTA",
+		receive_update,"receive_update",ADVERTISE_STARTD_PERM);
 	daemonCore->Register_CommandWithPayload(MERGE_STARTD_AD,"MERGE_STARTD_AD",
 		receive_update,"receive_update",NEGOTIATOR);
 	daemonCore->Register_CommandWithPayload(UPDATE_SCHEDD_AD,"UPDATE_SCHEDD_AD",
@@ -464,6 +472,9 @@ collector_runtime_probe HandleQueryForked_runtime;
 collector_runtime_probe HandleQueryMissedFork_runtime;
 collector_runtime_probe HandleLocateForked_runtime;
 collector_runtime_probe HandleLocateMissedFork_runtime;
+collector_runtime_probe QueryQueueWait_runtime;
+collector_runtime_probe QueryThreadScan_runtime;
+collector_runtime_probe QueryThreadSend_runtime;
 
 
 template <typename T>
@@ -836,6 +847,7 @@ int CollectorDaemon::receive_query_cedar(int command,
 			  (active_query_workers - reserved_for_highprio_query_workers + (int)query_queue_high_prio.size() <  max_query_workers + max_pending_query_workers))
 		   )
 		{
+			query_entry->enqueue_time = _condor_debug_get_time_double();
 			if ( high_prio_query ) {
 				query_queue_high_prio.push( query_entry );
 			} else {
@@ -886,6 +898,58 @@ END:
 }
 
 
+// Decide whether a query may see the private attributes of the ads.
+// This must be called on the main thread.
+static bool
+query_filters_private_attrs(ClassAd * query, Stream * sock)
+{
+	bool wants_pvt_attrs = false;
+	query->LookupBool(ATTR_SEND_PRIVATE_ATTRIBUTES, wants_pvt_attrs);
+
+		// If our peer is at least 8.9.3 and has NEGOTIATOR authz, then we'll
+		// trust it to handle our capabilities.
+		// Starting with 10.0.0, send the private attributes only if the
+		// client requests them.
+	bool filter_private_attrs = true;
+	auto *verinfo = sock->get_peer_version();
+	if (verinfo && verinfo->built_since_version(8, 9, 3) && !verinfo->built_since_version(10, 0, 0)) {
+		wants_pvt_attrs = true;
+	}
+	if (wants_pvt_attrs &&
+		(USER_AUTH_SUCCESS == daemonCore->Verify("send private attrs", NEGOTIATOR, *static_cast<ReliSock*>(sock), D_SECURITY|D_FULLDEBUG)))
+	{
+		filter_private_attrs = false;
+	}
+
+		// If our peer has ADMINISTRATOR authz and explicitly asks for
+		// private attributes, then we'll trust it to handle our capabilities
+	if (wants_pvt_attrs &&
+		(USER_AUTH_SUCCESS == daemonCore->Verify("send private attrs", ADMINISTRATOR, *static_cast<ReliSock*>(sock), D_SECURITY|D_FULLDEBUG)))
+	{
+		dprintf(D_SECURITY|D_FULLDEBUG, "Administrator requesting private attributes - will not filter.\n");
+		filter_private_attrs = false;
+	}
+
+	return filter_private_attrs;
+}
+
+// Evaluate the projection expression of a query against an ad.  Unlike
+// EvalString(), this uses a match ad of its own, and puts an empty ad chained
+// to the target into it rather than the target itself, so that the target
+// isn't modified; a query thread may be sharing it with other threads.
+static bool
+eval_query_projection(const std::string & attr, ClassAd * query, ClassAd * ad, std::string & value)
+{
+	ClassAd target;
+	target.ChainToAd(ad);
+	classad::MatchClassAd mad(query, &target);
+	bool rc = query->EvaluateAttrString(attr, value);
+	mad.RemoveLeftAd();
+	mad.RemoveRightAd();
+	target.Unchain();
+	return rc;
+}
+
 // Return 1 if forked a worker, 0 if not, and -1 upon an error.
 int CollectorDaemon::QueryReaper(int pid, int /* exit_status */ )
 {
@@ -898,6 +962,13 @@ int CollectorDaemon::QueryReaper(int pid, int /* exit_status */ )
 		collectorStats.global.ActiveQueryWorkers = active_query_workers;
 	}
 
+	return start_queued_query(pid >= 0);
+}
+
+// Start a worker for the next pending query, if there is a worker slot for it.
+// Return 1 if started a worker, 0 if not, and -1 upon an error.
+int CollectorDaemon::start_queued_query(bool worker_exited)
+{
 	// Grab a queue_entry to service, ignoring "stale" (old) entries.
 	bool high_prio_query;
 	pending_query_entry_t * query_entry = NULL;	
@@ -938,12 +1009,12 @@ int CollectorDaemon::QueryReaper(int pid, int /* exit_status */ )
 			return 0;
 		}
 
-		// If we are here because a fork worker just exited (pid >= 0), or
+		// If we are here because a worker just finished, or
 		// if there are still more pending queries in the queue, then it is possible
 		// that the query_entry we are about to service has been sitting around
 		// in the queue for some time.  So we need to check if it is "stale"
 		// before we spend time forking.
-		if ( pid >= 0 || pending_query_workers > 0 ) {
+		if ( worker_exited || pending_query_workers > 0 ) {
 			// Consider a query_request to be stale if
 			//   a) our deadline on the socket has expired, or
 			//   b) the client has closed the TCP socket.
@@ -970,6 +1041,14 @@ int CollectorDaemon::QueryReaper(int pid, int /* exit_status */ )
 		}
 	}  // end of while queue_entry == NULL
 
+	QueryQueueWait_runtime += _condor_debug_get_time_double() - query_entry->enqueue_time;
+
+#ifndef WIN32
+	if (query_threads && start_query_job(query_entry, high_prio_query)) {
+		return 1;
+	}
+#endif
+
 	// If we have made it here, we are allowed to fork another worker
 	// to handle the query represented by query_entry. Fork one!
 	// First stash a copy of query_entry->sock and query_entry->cad so 
@@ -1017,8 +1096,248 @@ int CollectorDaemon::QueryReaper(int pid, int /* exit_status */ )
 	return 1;
 }
 
+// A query handed to the query thread pool.  Everything the query needs from
+// the collector's tables and from daemon core is gathered on the main thread
+// before the job is queued, so the thread that serves it only reads snapshots
+// of ads that the main thread no longer modifies.  The job is deleted on the
+// main thread, so that the last reference to an ad is never dropped on a
+// query thread.
+struct CollectorDaemon::query_job {
+	~query_job() {
+		if (self_stats_ad) { self_stats_ad->Unchain(); delete self_stats_ad; }
+		delete sock;
+		delete entry->cad;
+		free(entry);
+	}
+
+	int id = 0;
+	pending_query_entry_t * entry = nullptr;
+	Stream * sock = nullptr;
+	bool high_prio = false;
+	bool filter_private_attrs = true;
+	// for each sub-query, snapshots of the tables it scans
+	std::vector<std::vector<std::shared_ptr<const CollectorSnapshot>>> tables;
+	std::shared_ptr<CollectorRecordAds> self_ads;
+	ClassAd * self_stats_ad = nullptr;
+	double scan_time = 0;
+	double send_time = 0;
+};
+
+// The query thread pool.  Jobs are passed to the threads and back again
+// under the mutex; a byte written to the pipe wakes the main thread to
+// collect the finished ones.
+static struct {
+	std::mutex mutex;
+	std::condition_variable cv;
+	std::deque<CollectorDaemon::query_job *> ready;
+	std::deque<CollectorDaemon::query_job *> done;
+	std::vector<std::thread> threads;
+	bool stopping = false;
+	int pipe_ends[2] = { -1, -1 };
+	int wake_fd = -1;
+	int next_id = 1;
+} query_pool;
+
+static void
+query_thread_main()
+{
+	std::unique_lock<std::mutex> guard(query_pool.mutex);
+	while (true) {
+		query_pool.cv.wait(guard, [] { return query_pool.stopping || ! query_pool.ready.empty(); });
+		if (query_pool.stopping) {
+			return;
+		}
+		CollectorDaemon::query_job * job = query_pool.ready.front();
+		query_pool.ready.pop_front();
+		guard.unlock();
+
+		CollectorDaemon::serve_query(job->entry, job->sock, job);
+
+		guard.lock();
+		query_pool.done.push_back(job);
+		// if the write fails because the pipe is full, the main thread
+		// already has a wakeup waiting.
+		if (write(query_pool.wake_fd, "q", 1) < 0) { }
+	}
+}
+
+static void
+stop_query_threads()
+{
+	{
+		std::lock_guard<std::mutex> guard(query_pool.mutex);
+		query_pool.stopping = true;
+	}
+	query_pool.cv.notify_all();
+	for (auto & thread : query_pool.threads) {
+		thread.join();
+	}
+	query_pool.threads.clear();
+}
+
+bool CollectorDaemon::start_query_job(pending_query_entry_t * query_entry, bool high_prio)
+{
+	if (query_pool.pipe_ends[0] < 0) {
+		if ( ! daemonCore->Create_Pipe(query_pool.pipe_ends, true, false, true, true) ||
+			! daemonCore->Get_Pipe_FD(query_pool.pipe_ends[1], &query_pool.wake_fd) ||
+			daemonCore->Register_Pipe(query_pool.pipe_ends[0], "Query thread pipe",
+				&CollectorDaemon::QueryJobsDone, "CollectorDaemon::QueryJobsDone") < 0)
+		{
+			dprintf(D_ALWAYS, "QueryWorker: failed to set up the query threads, will fork query workers instead\n");
+			if (query_pool.pipe_ends[0] >= 0) {
+				daemonCore->Close_Pipe(query_pool.pipe_ends[0]);
+				daemonCore->Close_Pipe(query_pool.pipe_ends[1]);
+				query_pool.pipe_ends[0] = query_pool.pipe_ends[1] = -1;
+			}
+			query_threads = false;
+			return false;
+		}
+		dprintf_make_thread_safe();
+	}
+	while ((int)query_pool.threads.size() < max_query_workers) {
+		query_pool.threads.emplace_back(query_thread_main);
+	}
+
+	query_job * job = new query_job;
+	job->id = query_pool.next_id++;
+	job->entry = query_entry;
+	job->sock = query_entry->sock;
+	job->high_prio = high_prio;
+	job->filter_private_attrs = query_filters_private_attrs(query_entry->cad, job->sock);
+
+	// Take the snapshots now, while nothing else is touching the tables.
+	int num_adtypes = (query_entry->num_adtypes > 0) ? query_entry->num_adtypes : 1;
+	bool self_filter_private_attrs = job->filter_private_attrs;
+	job->tables.resize(num_adtypes);
+	for (int ix = 0; ix < num_adtypes; ++ix) {
+		AdTypes whichAds = (AdTypes) query_entry->adt[ix].whichAds;
+		for (auto * table : get_query_tables(query_entry, ix)) {
+			// a constraint that the index can narrow gets a snapshot of just
+			// the candidates, which is too specific to be worth caching.
+			CollectorIndex * index = collector.getIndex(table);
+			std::vector<CollectorRecord *> candidates;
+			if (index && index->lookup(query_entry->adt[ix].constraint, candidates)) {
+				auto ads = std::make_shared<CollectorSnapshot>();
+				ads->reserve(candidates.size());
+				for (auto * record : candidates) { ads->push_back(record->m_ads); }
+				job->tables[ix].push_back(ads);
+			} else {
+				job->tables[ix].push_back(collector.snapshotHashTable(table));
+			}
+		}
+		if (whichAds == STARTD_PVT_AD) {
+			self_filter_private_attrs = false;
+		}
+		// the statistics that go into the collector's own ad come from
+		// this thread, so publish them now.
+		if (whichAds == COLLECTOR_AD && ! job->self_ads) {
+			job->self_ads = collector.getSelfAds();
+			if (job->self_ads) {
+				job->self_stats_ad = make_self_stats_ad(query_entry->cad, job->self_ads.get(), self_filter_private_attrs);
+			}
+		}
+	}
+
+	{
+		std::lock_guard<std::mutex> guard(query_pool.mutex);
+		query_pool.ready.push_back(job);
+	}
+	query_pool.cv.notify_one();
+
+	active_query_workers++;
+	collectorStats.global.ActiveQueryWorkers = active_query_workers;
+
+	dprintf(D_ALWAYS,
+			"QueryWorker: started %squery thread job %d ( max %d active %d pending %d )\n",
+			high_prio ? "high priority " : "", job->id,
+			max_query_workers, active_query_workers, pending_query_workers);
+
+	return true;
+}
+
+int CollectorDaemon::QueryJobsDone(int pipe_end)
+{
+	char buf[64];
+	while (daemonCore->Read_Pipe(pipe_end, buf, sizeof(buf)) > 0) { }
+
+	std::deque<query_job *> done;
+	{
+		std::lock_guard<std::mutex> guard(query_pool.mutex);
+		done.swap(query_pool.done);
+	}
+
+	for (query_job * job : done) {
+		dprintf(D_FULLDEBUG, "QueryWorker: query thread job %d done\n", job->id);
+		QueryThreadScan_runtime += job->scan_time;
+		QueryThreadSend_runtime += job->send_time;
+		delete job;
+
+		if (active_query_workers > 0) {
+			active_query_workers--;
+		}
+		collectorStats.global.ActiveQueryWorkers = active_query_workers;
+		start_queued_query(true);
+	}
+	return TRUE;
+}
+
+// Return the tables to scan for the given sub-query, in the order to scan them.
+std::vector<CollectorHashTable *> CollectorDaemon::get_query_tables(pending_query_entry_t * query_entry, int ix)
+{
+	const AdTypes whichAds = (AdTypes) query_entry->adt[ix].whichAds;
+	std::vector<CollectorHashTable *> tables;
+
+	CollectorHashTable * table = nullptr;
+	if (whichAds == GENERIC_AD) {
+		table = collector.getGenericHashTable(query_entry->adt[ix].tag);
+	} else if (whichAds != ANY_AD) {
+		table = collector.getHashTable(whichAds);
+	}
+	if (table) {
+		tables.push_back(table);
+	} else if (ix==0 && whichAds == ANY_AD) {
+		tables = collector.getAnyHashTables(query_entry->adt[ix].match_mytype ? query_entry->adt[ix].tag : nullptr);
+	}
+	return tables;
+}
+
+// if querying collector ads, and the collectors own ad appears in this list.
+// then we want to shove in current statistics. we do this by chaining a
+// temporary stats ad into the ad to be returned, and publishing updated
+// statistics into the stats ad.  we do this because if the verbosity level
+// is increased we do NOT want to put the high-verbosity attributes into
+// our persistent collector ad.
+ClassAd * CollectorDaemon::make_self_stats_ad(ClassAd * query, CollectorRecordAds * self_ads, bool filter_private_attrs)
+{
+	// update stats in the collector ad before we return it.
+	std::string stats_config;
+	query->LookupString("STATISTICS_TO_PUBLISH",stats_config);
+	if (stats_config == "stored") {
+		return nullptr;
+	}
+
+	dprintf(D_ALWAYS,"Updating collector stats using a chained ad and config=%s\n", stats_config.c_str());
+	ClassAd * stats_ad = new ClassAd();
+	if (!filter_private_attrs) {
+		stats_ad->CopyFrom(*self_ads->m_pvtAd);
+	}
+	daemonCore->dc_stats.Publish(*stats_ad, stats_config.c_str());
+	daemonCore->monitor_data.ExportData(stats_ad, true);
+	collectorStats.publishGlobal(stats_ad, stats_config.c_str());
+	stats_ad->ChainToAd(self_ads->m_publicAd);
+	return stats_ad;
+}
+
 
 int CollectorDaemon::receive_query_cedar_worker_thread(void *in_query_entry, Stream* sock)
+{
+	return serve_query((pending_query_entry_t *) in_query_entry, sock, nullptr);
+}
+
+// Run a query and send the results.  When job is NULL, this scans the tables
+// directly, so it must run on the main thread or in a forked worker.
+// Otherwise it scans the snapshots in the job, and may run on any thread.
+int CollectorDaemon::serve_query(pending_query_entry_t * query_entry, Stream * sock, query_job * job)
 {
 	int return_status = TRUE;
 	_condor_runtime runtime;
@@ -1027,38 +1346,14 @@ int CollectorDaemon::receive_query_cedar_worker_thread(void *in_query_entry, Str
 	double send_time = 0;
 
 	// Pull out relavent state from query_entry
-	pending_query_entry_t *query_entry = (pending_query_entry_t *) in_query_entry;
 	ClassAd *query = query_entry->cad;
 	bool is_locate = query_entry->is_locate;
-	bool wants_pvt_attrs = false;
 	int num_adtypes = (query_entry->num_adtypes > 0) ? query_entry->num_adtypes : 1;
-	std::deque<CollectorRecord*> results;
-
-	query->LookupBool(ATTR_SEND_PRIVATE_ATTRIBUTES, wants_pvt_attrs);
-
-		// If our peer is at least 8.9.3 and has NEGOTIATOR authz, then we'll
-		// trust it to handle our capabilities.
-		// Starting with 10.0.0, send the private attributes only if the
-		// client requests them.
-	bool filter_private_attrs = true;
-	auto *verinfo = sock->get_peer_version();
-	if (verinfo && verinfo->built_since_version(8, 9, 3) && !verinfo->built_since_version(10, 0, 0)) {
-		wants_pvt_attrs = true;
-	}
-	if (wants_pvt_attrs &&
-		(USER_AUTH_SUCCESS == daemonCore->Verify("send private attrs", NEGOTIATOR, *static_cast<ReliSock*>(sock), D_SECURITY|D_FULLDEBUG)))
-	{
-		filter_private_attrs = false;
-	}
+	std::deque<CollectorRecordAds*> results;
 
-		// If our peer has ADMINISTRATOR authz and explicitly asks for
-		// private attributes, then we'll trust it to handle our capabilities
-	if (wants_pvt_attrs &&
-		(USER_AUTH_SUCCESS == daemonCore->Verify("send private attrs", ADMINISTRATOR, *static_cast<ReliSock*>(sock), D_SECURITY|D_FULLDEBUG)))
-	{
-		dprintf(D_SECURITY|D_FULLDEBUG, "Administrator requesting private attributes - will not filter.\n");
-		filter_private_attrs = false;
-	}
+	bool filter_private_attrs = job ? job->filter_private_attrs : query_filters_private_attrs(query, sock);
+	std::shared_ptr<CollectorRecordAds> self_ads;
+	if (job) { self_ads = job->self_ads; }
 
 	// See if query ad asks for server-side projection
 	std::string projection;
@@ -1075,6 +1370,8 @@ int CollectorDaemon::receive_query_cedar_worker_thread(void *in_query_entry, Str
 		// (the negotiator sends this sort of projection)
 		proj_is_expr = true;
 	}
+	std::string filter_str;
+	std::vector<CollectorRecord *> candidates;
 
 	// Perform the query
 	CollectorDaemon::collect_op op;
@@ -1091,31 +1388,36 @@ int CollectorDaemon::receive_query_cedar_worker_thread(void *in_query_entry, Str
 		op.__results__ = &results;
 		results.clear();
 
-		CollectorHashTable * table = nullptr;
-		if (whichAds == GENERIC_AD) {
-			table = collector.getGenericHashTable(query_entry->adt[ix].tag);
-		} else if (whichAds != ANY_AD) {
-			table = collector.getHashTable(whichAds);
-		}
-		if (table) {
-			collector.walkHashTable (*table,
-				[&op](CollectorRecord*cr){
-					return op.query_scanFunc(cr);
-				});
-		} else if (ix==0 && whichAds == ANY_AD) {
-			std::vector<CollectorHashTable *> tables = collector.getAnyHashTables(op.__mytype__);
-			for (auto table : tables) {
-				collector.walkHashTable (*table,
+		std::vector<CollectorHashTable *> tables;
+		if ( ! job) {
+			tables = get_query_tables(query_entry, ix);
+		}
+		size_t num_tables = job ? job->tables[ix].size() : tables.size();
+		if ( ! num_tables) {
+			dprintf (D_ALWAYS, "Error no collector table for %s\n", query_entry->adt[ix].tag);
+			continue;
+		}
+		for (size_t it = 0; it < num_tables; ++it) {
+			if (job) {
+				for (auto & ads : *job->tables[ix][it]) {
+					if ( ! op.query_scanFunc(ads.get())) break;
+				}
+			} else if (CollectorIndex * index = collector.getIndex(tables[it]);
+					index && index->lookup(op.__filter__, candidates)) {
+				for (auto * cr : candidates) {
+					if ( ! op.query_scanFunc(cr->m_ads.get())) break;
+				}
+			} else {
+				collector.walkHashTable (*tables[it],
 					[&op](CollectorRecord*cr){
-						return op.query_scanFunc(cr);
+						return op.query_scanFunc(cr->m_ads.get());
 					});
-				if (op.__numAds__ >= op.__resultLimit__)
-					break;
 			}
+			if (op.__numAds__ >= op.__resultLimit__)
+				break;
+		}
+		if (whichAds == ANY_AD) {
 			num_adtypes = 1; // don't allow Any as part of a multi-table scan.
-		} else {
-			dprintf (D_ALWAYS, "Error no collector table for %s\n", query_entry->adt[ix].tag);
-			continue;
 		}
 
 		query_time += runtime.tick(tick_time);
@@ -1131,6 +1433,7 @@ int CollectorDaemon::receive_query_cedar_worker_thread(void *in_query_entry, Str
 			sending = true;
 		}
 		if (whichAds == STARTD_PVT_AD) { filter_private_attrs = false; }
+		if (whichAds == COLLECTOR_AD && ! job && ! self_ads) { self_ads = collector.getSelfAds(); }
 
 		attr_projection = ATTR_PROJECTION;
 		bool evaluate_projection = proj_is_expr;
@@ -1152,39 +1455,24 @@ int CollectorDaemon::receive_query_cedar_worker_thread(void *in_query_entry, Str
 			}
 		}
 
-		for (CollectorRecord* curr_rec : results)
+		for (CollectorRecordAds* curr_ads : results)
 		{
-			ClassAd* ad_to_send = filter_private_attrs ? curr_rec->m_publicAd : curr_rec->m_pvtAd;
-			// if querying collector ads, and the collectors own ad appears in this list.
-			// then we want to shove in current statistics. we do this by chaining a
-			// temporary stats ad into the ad to be returned, and publishing updated
-			// statistics into the stats ad.  we do this because if the verbosity level
-			// is increased we do NOT want to put the high-verbosity attributes into
-			// our persistent collector ad.
+			ClassAd* ad_to_send = filter_private_attrs ? curr_ads->m_publicAd : curr_ads->m_pvtAd;
 			ClassAd * stats_ad = NULL;
-			if ((whichAds == COLLECTOR_AD) && collector.isSelfAd(curr_rec)) {
+			if ((whichAds == COLLECTOR_AD) && curr_ads == self_ads.get()) {
 				dprintf(D_ALWAYS,"Query includes collector's self ad\n");
-				// update stats in the collector ad before we return it.
-				std::string stats_config;
-				query->LookupString("STATISTICS_TO_PUBLISH",stats_config);
-				if (stats_config != "stored") {
-					dprintf(D_ALWAYS,"Updating collector stats using a chained ad and config=%s\n", stats_config.c_str());
-					stats_ad = new ClassAd();
-					if (!filter_private_attrs) {
-						stats_ad->CopyFrom(*curr_rec->m_pvtAd);
-					}
-					daemonCore->dc_stats.Publish(*stats_ad, stats_config.c_str());
-					daemonCore->monitor_data.ExportData(stats_ad, true);
-					collectorStats.publishGlobal(stats_ad, stats_config.c_str());
-					stats_ad->ChainToAd(curr_rec->m_publicAd);
-					ad_to_send = stats_ad; // send the stats ad instead of the self ad.
+				if (job) {
+					if (job->self_stats_ad) { ad_to_send = job->self_stats_ad; }
+				} else {
+					stats_ad = make_self_stats_ad(query, curr_ads, filter_private_attrs);
+					if (stats_ad) { ad_to_send = stats_ad; } // send the stats ad instead of the self ad.
 				}
 			}
 
 			if (evaluate_projection) {
 				active_proj->clear();
 				projection.clear();
-				if (EvalString(attr_projection.c_str(), query, curr_rec->m_publicAd, projection) && ! projection.empty()) {
+				if (eval_query_projection(attr_projection, query, curr_ads->m_publicAd, projection) && ! projection.empty()) {
 					StringTokenIterator list(projection);
 					const std::string * attr;
 					while ((attr = list.next_string())) { active_proj->insert(*attr); }
@@ -1247,7 +1535,7 @@ int CollectorDaemon::receive_query_cedar_worker_thread(void *in_query_entry, Str
 			 query_time,
 			 send_time,
 			 query_entry->label ? query_entry->label : "?",
-			 op.__filter__ ? ExprTreeToString(op.__filter__) : "",
+			 op.__filter__ ? ExprTreeToString(op.__filter__, filter_str) : "",
 			 is_locate,
 			 (op.__resultLimit__ == INT_MAX) ? 0 : op.__resultLimit__,
 			 query_entry->subsys,
@@ -1255,9 +1543,14 @@ int CollectorDaemon::receive_query_cedar_worker_thread(void *in_query_entry, Str
 			 projection.c_str(),
 			 filter_private_attrs);
 END:
-	
+	if (job) {
+		job->scan_time = query_time;
+		job->send_time = send_time + runtime.tick(tick_time);
+	}
+
 	// All done.  Deallocate memory allocated in this method.  Note that DaemonCore 
 	// will supposedly free() the query_entry struct itself and also delete sock.
+	// A query job is deleted by the main thread once we return.
 
 	return return_status;
 }
@@ -1546,9 +1839,18 @@ int CollectorDaemon::receive_update(int command, Stream* sock)
 			// which already does all the necessary logging.
 		}
 
+		// insert == -5 is a delta update that doesn't match the ad we have.
+		// Returning FALSE closes the update socket, which is how the startd
+		// learns to send its whole ads again.
+
 		return FALSE;
 
 	}
+
+	// from here on, a delta update has become a whole ad
+	if (command == UPDATE_STARTD_AD_DELTA) {
+		command = UPDATE_STARTD_AD;
+	}
 #ifdef PROFILE_RECEIVE_UPDATE
 	CollectorEngine_ru_collect_runtime += rt.tick(rt_last);
 #endif
@@ -1729,9 +2031,11 @@ CollectorDaemon::stashSocket( ReliSock* sock )
 	}
 
 		// Register this socket w/ DaemonCore so we wake up if
-		// there's more data to read...
+		// there's more data to read.  DaemonCore reads each update
+		// without blocking and only calls us once all of it is here,
+		// so a slow link to one daemon can't hold up everyone else.
 	int rc = daemonCore->Register_Command_Socket(
-		sock, "Update Socket" );
+		sock, "Update Socket", true );
 
 	if( rc < 0 ) {
 		dprintf(D_ALWAYS,
@@ -1747,12 +2051,17 @@ CollectorDaemon::stashSocket( ReliSock* sock )
 	return KEEP_STREAM;
 }
 
-int CollectorDaemon::collect_op::query_scanFunc (CollectorRecord *record)
+int CollectorDaemon::collect_op::query_scanFunc (CollectorRecordAds *record)
 {
 	ClassAd* cad = record->m_publicAd;
 
-	if (__mytype__ && MATCH != strcasecmp(__mytype__, GetMyTypeName(*cad))) {
-		return 1;
+	// not GetMyTypeName(), since its static buffer isn't safe on a query thread
+	if (__mytype__) {
+		std::string mytype;
+		cad->EvaluateAttrString(ATTR_MY_TYPE, mytype);
+		if (MATCH != strcasecmp(__mytype__, mytype.c_str())) {
+			return 1;
+		}
 	}
 
 	int rc = 1;
@@ -1853,16 +2162,17 @@ void CollectorDaemon::process_query_public (AdTypes whichAds,
 //
 int CollectorDaemon::collect_op::expiration_scanFunc (CollectorRecord *record)
 {
-    return setAttrLastHeardFrom( record->m_publicAd, 1 );
+    return setAttrLastHeardFrom( record, 1 );
 }
 
 int CollectorDaemon::collect_op::invalidation_scanFunc (CollectorRecord *record)
 {
-    return setAttrLastHeardFrom( record->m_publicAd, 0 );
+    return setAttrLastHeardFrom( record, 0 );
 }
 
-int CollectorDaemon::collect_op::setAttrLastHeardFrom (ClassAd* cad, unsigned long time)
+int CollectorDaemon::collect_op::setAttrLastHeardFrom (CollectorRecord* record, unsigned long time)
 {
+	ClassAd* cad = record->m_publicAd;
 	if (__mytype__) {
 		std::string type = "";
 		cad->LookupString( ATTR_MY_TYPE, type );
@@ -1876,7 +2186,8 @@ int CollectorDaemon::collect_op::setAttrLastHeardFrom (ClassAd* cad, unsigned lo
 	if ( EvalExprToBool( __filter__, cad, NULL, result ) &&
 		 result.IsBooleanValueEquiv(val) && val ) {
 
-		cad->Assign( ATTR_LAST_HEARD_FROM, time );
+		record->MakeWritable();
+		record->m_publicAd->Assign( ATTR_LAST_HEARD_FROM, time );
         __numAds__++;
     }
 
@@ -2266,6 +2577,18 @@ void CollectorDaemon::Config()
 	max_pending_query_workers = param_integer ("COLLECTOR_QUERY_WORKERS_PENDING", 50, 0);
 	max_query_worktime = param_integer("COLLECTOR_QUERY_MAX_WORKTIME",0,0);
 	reserved_for_highprio_query_workers = param_integer("COLLECTOR_QUERY_WORKERS_RESERVE_FOR_HIGH_PRIO",1,0);
+#ifndef WIN32
+	query_threads = param_boolean("COLLECTOR_QUERY_THREADS", false);
+#endif
+
+	{
+		std::string attrs;
+		classad::References index_attrs;
+		if (param(attrs, "COLLECTOR_INDEX_ATTRIBUTES")) {
+			for (const auto & attr : StringTokenIterator(attrs)) { index_attrs.insert(attr); }
+		}
+		collector.setIndexedAttributes(index_attrs);
+	}
 
 	// max_query_workers had better be at least one greater than reserved_for_highprio_query_workers,
 	// or condor_status queries will never be answered.
@@ -2322,6 +2645,7 @@ void CollectorDaemon::Exit()
 	// because the collector will be shutdown and the daemonCore
 	// object deleted by the time the worker cleanup is attempted.
 	// forkQuery.DeleteAll( );
+	stop_query_threads();
 	if ( UpdateTimerId >= 0 ) {
 		daemonCore->Cancel_Timer(UpdateTimerId);
 		UpdateTimerId = -1;
@@ -2344,6 +2668,7 @@ void CollectorDaemon::Shutdown()
 	// because the collector will be shutdown and the daemonCore
 	// object deleted by the time the worker cleanup is attempted.
 	// forkQuery.DeleteAll( );
+	stop_query_threads();
 	if ( UpdateTimerId >= 0 ) {
 		daemonCore->Cancel_Timer(UpdateTimerId);
 		UpdateTimerId = -1;
@@ -81,7 +81,7 @@ public:
 #if 1
 	struct collect_op {
 		ClassAd* __query__ = nullptr;
-		std::deque<CollectorRecord*> * __results__;
+		std::deque<CollectorRecordAds*> * __results__;
 		ExprTree *__filter__ = nullptr;
 		const char * __mytype__ = nullptr; // implicit filter, if non-null return only ads with this mytype
 		bool __skip_absent__ = false; // implicit filter
@@ -91,11 +91,11 @@ public:
 		int __absent__ = 0;
 
 		//void process_query_public(AdTypes, ClassAd *query, std::deque<CollectorRecord*> * results);
-		int query_scanFunc(CollectorRecord*);
+		int query_scanFunc(CollectorRecordAds*);
 		void process_invalidation(AdTypes, ClassAd&, Stream*);
 		int invalidation_scanFunc(CollectorRecord*);
 		int expiration_scanFunc(CollectorRecord*);
-		int setAttrLastHeardFrom( ClassAd* cad, unsigned long time );
+		int setAttrLastHeardFrom( CollectorRecord* record, unsigned long time );
 	};
 #else
 	static void process_query_public(AdTypes, ClassAd*, List<CollectorRecord>*);
@@ -156,6 +156,7 @@ public:
 		bool is_multi;
 		char subsys[15];
 		int  limit;           // overall result limit
+		double enqueue_time;  // when the query was queued for a worker
 		int num_adtypes;
 		struct adtype_query_props {
 			char whichAds;
@@ -180,6 +181,16 @@ public:
 	static std::queue<pending_query_entry_t *> query_queue_low_prio;
 	static int ReaperId;
 	static int QueryReaper(int pid, int exit_status);
+	static int start_queued_query(bool worker_exited);
+	static std::vector<CollectorHashTable *> get_query_tables(pending_query_entry_t * query_entry, int ix);
+	static ClassAd * make_self_stats_ad(ClassAd * query, CollectorRecordAds * self_ads, bool filter_private_attrs);
+
+	// a query being served on a thread of the query thread pool
+	struct query_job;
+	static int serve_query(pending_query_entry_t * query_entry, Stream * sock, query_job * job);
+	static bool start_query_job(pending_query_entry_t * query_entry, bool high_prio);
+	static int QueryJobsDone(int pipe_end);
+	static bool query_threads;  // from config file
 	static int max_query_workers;  // from config file
 	static int max_pending_query_workers;  // from config file
 	static int max_query_worktime;  // from config file
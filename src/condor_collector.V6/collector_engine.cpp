@@ -149,6 +149,7 @@ CollectorEngine::
 	killHashTable (HadAds);
 	killHashTable (GridAds);
 	GenericAds.walk(killGenericHashTable);
+	for (auto & [table, index] : m_indexes) { delete index; }
 
 	if(m_collector_requirements) {
 		delete m_collector_requirements;
@@ -358,6 +359,73 @@ CollectorEngine::getAnyHashTables(const char * mytype)
 	return tables;
 }
 
+std::shared_ptr<const CollectorSnapshot>
+CollectorEngine::snapshotHashTable(CollectorHashTable * table)
+{
+	auto & cached = m_snapshots[table];
+	std::shared_ptr<const CollectorSnapshot> snap;
+	if (cached.first == CollectorRecord::generation) {
+		snap = cached.second.lock();
+	}
+	if ( ! snap) {
+		auto ads = std::make_shared<CollectorSnapshot>();
+		ads->reserve(table->getNumElements());
+		walkHashTable(*table, [&ads](CollectorRecord * record) {
+			ads->push_back(record->m_ads);
+			return 1;
+		});
+		snap = ads;
+		cached.first = CollectorRecord::generation;
+		cached.second = snap;
+	}
+	return snap;
+}
+
+void
+CollectorEngine::indexHashTable(CollectorHashTable * table)
+{
+	CollectorIndex * index = new CollectorIndex(m_indexAttrs);
+	m_indexes[table] = index;
+	walkHashTable(*table, [index](CollectorRecord * record) {
+		record->m_index = index;
+		index->insert(record);
+		return 1;
+	});
+}
+
+void
+CollectorEngine::setIndexedAttributes(const classad::References & attrs)
+{
+	if (attrs == m_indexAttrs) {
+		return;
+	}
+
+	for (auto & [table, index] : m_indexes) {
+		walkHashTable(*table, [](CollectorRecord * record) {
+			record->m_index = nullptr;
+			record->m_indexKeys.clear();
+			return 1;
+		});
+		delete index;
+	}
+	m_indexes.clear();
+
+	m_indexAttrs = attrs;
+	if (m_indexAttrs.empty()) {
+		return;
+	}
+	for (auto * table : getAnyHashTables()) {
+		indexHashTable(table);
+	}
+}
+
+CollectorIndex *
+CollectorEngine::getIndex(CollectorHashTable * table)
+{
+	auto it = m_indexes.find(table);
+	return (it != m_indexes.end()) ? it->second : nullptr;
+}
+
 #else
 int CollectorEngine::
 walkHashTable (AdTypes adType, int (*scanFunction)(CollectorRecord *))
@@ -419,6 +487,9 @@ CollectorHashTable *CollectorEngine::findOrCreateTable(const istring &type)
 			delete table;
 			return NULL;
 		}
+		if ( ! m_indexAttrs.empty()) {
+			indexHashTable(table);
+		}
 	}
 
 	return table;
@@ -528,6 +599,7 @@ bool CollectorEngine::ValidateClassAd(int command,ClassAd *clientAd,Sock *sock)
 	  case MERGE_STARTD_AD:
 	  case UPDATE_STARTD_AD:
 	  case UPDATE_STARTD_AD_WITH_ACK:
+	  case UPDATE_STARTD_AD_DELTA:
 		  ipattr = ATTR_STARTD_IP_ADDR;
 		  break;
 	  case UPDATE_OWN_SUBMITTOR_AD:
@@ -676,6 +748,7 @@ ClassAd * synthesize_startd_daemon_ad(ClassAd & machineAd) {
 }
 
 bool   last_updateClassAd_was_insert;
+unsigned long long CollectorRecord::generation = 0;
 
 CollectorRecord *CollectorEngine::
 collect (int command,ClassAd *clientAd,const condor_sockaddr& from,int &insert,Sock *sock)
@@ -691,6 +764,10 @@ collect (int command,ClassAd *clientAd,const condor_sockaddr& from,int &insert,S
 	double rt_last = rt.begin;
 #endif
 
+	if (command == UPDATE_STARTD_AD_DELTA) {
+		return applyStartdAdDelta(clientAd, from, insert, sock);
+	}
+
 	if( !ValidateClassAd(command,clientAd,sock) ) {
 	    insert = -4;
 		return NULL;
@@ -771,6 +848,7 @@ collect (int command,ClassAd *clientAd,const condor_sockaddr& from,int &insert,S
 				// Negotiator matches up private ad with public ad by
 				// using the following.
 			if( retVal ) {
+				retVal->MakeWritable();
 				CopyAttribute( ATTR_MY_ADDRESS, *pvtAd, *retVal->m_publicAd );
 				CopyAttribute( ATTR_NAME, *pvtAd, *retVal->m_publicAd );
 			}
@@ -1114,6 +1192,7 @@ int CollectorEngine::expire(CollectorHashTable * hTable, AdNameHashKey & hKey) {
 	int rVal = 0;
 	CollectorRecord* record = nullptr;
 	if( hTable->lookup( hKey, record ) != -1 ) {
+		record->MakeWritable();
 		record->m_publicAd->Assign( ATTR_LAST_HEARD_FROM, 1 );
 
 		if( CollectorDaemon::offline_plugin_.expire( * record->m_publicAd ) == true ) {
@@ -1164,6 +1243,7 @@ remove (AdTypes adType, AdNameHashKey &hk)
 	if (!LookupByAdType(adType, table, func)) {
 		return 0;
 	}
+	++CollectorRecord::generation;
 	return !table->remove(hk);
 }
 
@@ -1173,6 +1253,18 @@ identifySelfAd(CollectorRecord * ad)
 	__self_ad__ = (void*)ad;
 }
 
+std::shared_ptr<CollectorRecordAds> CollectorEngine::
+getSelfAds()
+{
+	// __self_ad__ may be out of date, so only compare it, never dereference it.
+	std::shared_ptr<CollectorRecordAds> ads;
+	walkHashTable(CollectorAds, [&](CollectorRecord * record) {
+		if (isSelfAd(record)) { ads = record->m_ads; return 0; }
+		return 1;
+	});
+	return ads;
+}
+
 extern bool   last_updateClassAd_was_insert;
 
 void
@@ -1245,6 +1337,8 @@ updateClassAd (CollectorHashTable &hashTable,
 		{
 			EXCEPT ("Error inserting ad (out of memory)");
 		}
+		record->m_index = getIndex(&hashTable);
+		if (record->m_index) { record->m_index->insert(record); }
 
 		insert = 1;
 
@@ -1338,13 +1432,143 @@ mergeClassAd (CollectorHashTable &hashTable,
 		movePrivateAttrs(new_pvt_ad, new_ad_copy);
 
 		// Now, finally, merge the new ClassAd into the old one
+		record->MakeWritable();
 		MergeClassAds(record->m_publicAd, &new_ad_copy, true);
 		MergeClassAds(record->m_pvtAd, &new_pvt_ad, true);
+
+			// The startd doesn't know about the merged attributes, so a
+			// delta from it would no longer describe this ad.
+		record->m_publicAd->Delete(ATTR_UPDATE_DELTA_VERSION);
 	}
 	delete new_ad;
 	return record;
 }
 
+CollectorRecord * CollectorEngine::
+applyStartdAdDelta (ClassAd *delta, const condor_sockaddr& from, int &insert, Sock *sock)
+{
+	CollectorRecord* record = nullptr;
+	AdNameHashKey hk;
+	std::string hashString;
+
+	if (!makeStartdAdHashKey (hk, delta))
+	{
+		dprintf (D_ALWAYS, "Could not make hashkey --- ignoring ad\n");
+		insert = -3;
+		return NULL;
+	}
+	hk.sprint(hashString);
+
+		// The delta only means something relative to the ad it was made
+		// from.  If that isn't the ad we have, the startd must send it all.
+	long long base = -1, version = -1;
+	delta->LookupInteger(ATTR_UPDATE_DELTA_BASE, base);
+	if (StartdSlotAds.lookup(hk, record) == -1 ||
+		! record->m_publicAd->LookupInteger(ATTR_UPDATE_DELTA_VERSION, version) ||
+		version != base)
+	{
+		dprintf (D_ALWAYS, "MachineSlotAd: Delta update for \"%s\" is based on version %lld, "
+				 "but we have %lld; asking for the whole ad\n",
+				 hashString.c_str(), base, record ? version : -1LL);
+		insert = -5;
+		return NULL;
+	}
+
+	ClassAd *old_ad = record->m_publicAd;
+	std::string removed;
+	delta->LookupString(ATTR_UPDATE_DELTA_REMOVED, removed);
+	std::vector<std::string> removed_attrs = split(removed);
+	delta->Delete(ATTR_UPDATE_DELTA_BASE);
+	delta->Delete(ATTR_UPDATE_DELTA_REMOVED);
+	if ( ! delta->LookupExpr(ATTR_LAST_HEARD_FROM)) {
+		delta->Assign(ATTR_LAST_HEARD_FROM, time(nullptr));
+	}
+
+		// Check and count the ad as it will be once the delta is applied,
+		// which is what chaining the delta to the old ad looks like.
+	delta->ChainToAd(old_ad);
+	bool valid = ValidateClassAd(UPDATE_STARTD_AD_DELTA, delta, sock);
+	if (valid) {
+		collectorStats->update("Slot", old_ad, delta);
+		if (m_forwardFilteringEnabled) {
+			bool forward = false;
+			time_t last_forwarded = 0;
+			old_ad->LookupInteger(ATTR_LAST_FORWARDED, last_forwarded);
+			if (last_forwarded + m_forwardInterval < time(NULL)) {
+				forward = true;
+			} else {
+				classad::Value old_val;
+				classad::Value new_val;
+				for (const auto& attr : m_forwardWatchList) {
+					if (contains_anycase(removed_attrs, attr)) {
+						forward = true;
+						break;
+					}
+					if ( ! delta->LookupIgnoreChain(attr)) continue;
+					if ( old_ad->EvaluateAttr( attr, old_val ) &&
+						 delta->EvaluateAttr( attr, new_val ) &&
+						 !new_val.SameAs( old_val ) )
+					{
+						forward = true;
+						break;
+					}
+				}
+			}
+			delta->Assign(ATTR_SHOULD_FORWARD, forward);
+			delta->Assign(ATTR_LAST_FORWARDED, forward ? time(nullptr) : last_forwarded);
+		}
+	}
+	delta->Unchain();
+	if ( ! valid) {
+		insert = -4;
+		return NULL;
+	}
+
+	dprintf (D_FULLDEBUG, "MachineSlotAd: Applying delta update (%d attributes) to \"%s\"\n",
+			 delta->size(), hashString.c_str());
+
+	ClassAd delta_pvt;
+	movePrivateAttrs(delta_pvt, *delta);
+
+	record->MakeWritable();
+	for (const auto& attr : removed_attrs) {
+		record->m_publicAd->Delete(attr);
+		record->m_pvtAd->Delete(attr);
+	}
+	MergeClassAds(record->m_publicAd, delta, true);
+	MergeClassAds(record->m_pvtAd, &delta_pvt, true);
+	delete delta;
+	insert = 0;
+
+		// As for a whole ad, an old startd's slot1 ad stands in for its daemon ad
+	if (get_real_startd_adtype(*record->m_publicAd) == STARTD_AD && is_primary_slot_ad(*record->m_publicAd)) {
+		int insDaemon;
+		ClassAd * daemonAd = synthesize_startd_daemon_ad(*record->m_publicAd);
+		if ( ! updateClassAd(StartdDaemonAds, "StartDaemonAd", "StartD", false,
+			daemonAd, hk, hashString, insDaemon, from)) {
+			delete daemonAd;
+		}
+	}
+
+		// the private ad follows as usual, and it is always sent whole.
+	if (sock) {
+		ClassAd *pvtAd = new ClassAd;
+		if ( ! getClassAdEx(sock, *pvtAd, m_get_ad_options)) {
+			dprintf(D_FULLDEBUG,"\t(Could not get startd's private ad)\n");
+			delete pvtAd;
+		} else {
+			int insPvt;
+			CopyAttribute(ATTR_MY_TYPE, *pvtAd, *record->m_publicAd);
+			CopyAttribute(ATTR_MY_ADDRESS, *pvtAd, *record->m_publicAd);
+			CopyAttribute(ATTR_NAME, *pvtAd, *record->m_publicAd);
+			(void) updateClassAd (StartdPrivateAds, "MachinePvtAd ", "MachinePvt", true,
+								  pvtAd, hk, hashString, insPvt, from);
+		}
+	}
+
+	return record;
+}
+
 
 void
 CollectorEngine::
@@ -1458,6 +1682,7 @@ cleanHashTable (CollectorHashTable &hashTable, time_t now, HashFunc makeKey) con
 				   potentially mark the ad absent. if expire() returns false, then delete
 				   the ad as planned; if it return true, it was likely marked as absent,
 				   so then this ad should NOT be deleted. */
+				record->MakeWritable();
 				if ( CollectorDaemon::offline_plugin_.expire( *record->m_publicAd ) == true ) {
 					// plugin say to not delete this ad, so continue
 					continue;
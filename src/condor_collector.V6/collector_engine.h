@@ -20,23 +20,67 @@
 #ifndef __COLLECTOR_ENGINE_H__
 #define __COLLECTOR_ENGINE_H__
 
+#include <map>
+#include <memory>
+#include <vector>
+
 #include "condor_classad.h"
 
+#include "collector_index.h"
 #include "collector_stats.h"
 #include "hashkey.h"
 
+// The public and private ads of one collector record.  These are shared
+// with the snapshots that query threads scan, so once a snapshot has been
+// taken they must not be modified; see CollectorRecord::MakeWritable().
+struct CollectorRecordAds
+{
+	CollectorRecordAds(ClassAd* public_ad, ClassAd* pvt_ad)
+		: m_publicAd(public_ad), m_pvtAd(pvt_ad) { m_pvtAd->ChainToAd(m_publicAd); }
+	~CollectorRecordAds() { delete m_publicAd; delete m_pvtAd; }
+
+	ClassAd* m_publicAd;
+	ClassAd* m_pvtAd;
+};
+
 struct CollectorRecord
 {
 	CollectorRecord(ClassAd* public_ad, ClassAd* pvt_ad)
-		: m_publicAd(public_ad), m_pvtAd(pvt_ad) { m_pvtAd->ChainToAd(m_publicAd); }
-	~CollectorRecord() { delete m_publicAd; delete m_pvtAd; }
+		: m_ads(std::make_shared<CollectorRecordAds>(public_ad, pvt_ad))
+		, m_publicAd(public_ad), m_pvtAd(pvt_ad) { ++generation; }
+	~CollectorRecord() { if (m_index) m_index->remove(this); ++generation; }
 	void ReplaceAds(ClassAd* public_ad, ClassAd* pvt_ad)
-	{ delete m_publicAd; delete m_pvtAd; m_publicAd=public_ad; m_pvtAd=pvt_ad; m_pvtAd->ChainToAd(m_publicAd); }
+	{
+		m_ads = std::make_shared<CollectorRecordAds>(public_ad, pvt_ad); m_publicAd=public_ad; m_pvtAd=pvt_ad; ++generation;
+		if (m_index) m_index->update(this);
+	}
 
-	ClassAd* m_publicAd;
+	// call before modifying the ads in place.  if a query snapshot still
+	// refers to the current ads, the record gets its own copy of them.
+	void MakeWritable()
+	{
+		if (m_ads.use_count() > 1) { ReplaceAds(new ClassAd(*m_publicAd), new ClassAd(*m_pvtAd)); }
+		else { ++generation; }
+		if (m_index) m_index->invalidate(this);
+	}
+
+	std::shared_ptr<CollectorRecordAds> m_ads;
+	ClassAd* m_publicAd; // these alias the ads in m_ads
 	ClassAd* m_pvtAd;
+
+	// the index of the table this record is in, if that table has one
+	CollectorIndex* m_index{nullptr};
+	std::vector<CollectorIndexKey> m_indexKeys;
+
+	// bumped whenever any record is added, removed or changed, so that a
+	// table snapshot can be reused for as long as the tables are unchanged.
+	static unsigned long long generation;
 };
 
+// a point-in-time list of the ads in one table, for a query thread to scan
+// while the main thread goes on applying updates.
+typedef std::vector<std::shared_ptr<CollectorRecordAds>> CollectorSnapshot;
+
 // type for the hash tables ...
 typedef HashTable <AdNameHashKey, CollectorRecord *> CollectorHashTable;
 typedef HashTable <istring, CollectorHashTable *> GenericAdHashTable;
@@ -150,6 +194,16 @@ class CollectorEngine : public Service
 	// insert fresh stats into it when it is fetched.
 	void identifySelfAd(CollectorRecord * record);
 	bool isSelfAd(void * ad) { return __self_ad__ != NULL && __self_ad__ == ad; }
+	std::shared_ptr<CollectorRecordAds> getSelfAds();
+
+	// return a snapshot of the ads in the given table.  snapshots are shared
+	// between queries for as long as no record has changed in the meantime.
+	std::shared_ptr<const CollectorSnapshot> snapshotHashTable(CollectorHashTable * table);
+
+	// index every table on the given attributes (or on none), and return
+	// the index of a table, or NULL if it has none.
+	void setIndexedAttributes(const classad::References & attrs);
+	CollectorIndex * getIndex(CollectorHashTable * table);
 
 	// Publish stats into the collector's ClassAd
 	//int publishStats( ClassAd *ad );
@@ -213,12 +267,25 @@ class CollectorEngine : public Service
 	// support for dynamically created tables
 	CollectorHashTable *findOrCreateTable(const istring &str);
 
+	// apply an UPDATE_STARTD_AD_DELTA to the slot ad it was made from
+	CollectorRecord* applyStartdAdDelta (ClassAd *delta, const condor_sockaddr& from,
+							int &insert, Sock *sock);
+
 	bool ValidateClassAd(int command,ClassAd *clientAd,Sock *sock);
 
 	void* __self_ad__; // contains address of last Ad for this collector added to the hashtable, do NOT free from here
 					   // this pointer is only used to recognise this collector's ad during a condor_status query
 					   // so it's harmless if this pointer is out of date.
 
+	// the snapshots that query threads may still be using, by table.  these are
+	// weak so that an idle snapshot doesn't force MakeWritable() to copy ads.
+	std::map<CollectorHashTable *, std::pair<unsigned long long, std::weak_ptr<const CollectorSnapshot>>> m_snapshots;
+
+	// secondary indexes for queries, see COLLECTOR_INDEX_ATTRIBUTES
+	classad::References m_indexAttrs;
+	std::map<CollectorHashTable *, CollectorIndex *> m_indexes;
+	void indexHashTable(CollectorHashTable * table);
+
 	// Statistics
 	CollectorStats	*collectorStats;
 
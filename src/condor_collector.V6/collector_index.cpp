@@ -0,0 +1,279 @@
+/***************************************************************
+ *
+ * Copyright (C) 2025, Condor Team, Computer Sciences Department,
+ * University of Wisconsin-Madison, WI.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you
+ * may not use this file except in compliance with the License.  You may
+ * obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ ***************************************************************/
+
+#include "condor_common.h"
+#include "condor_classad.h"
+#include "condor_debug.h"
+#include "condor_daemon_core.h"
+#include "stl_string_utils.h"
+
+#include "collector.h"
+#include "collector_engine.h"
+#include "collector_index.h"
+
+#include <cmath>
+
+CollectorIndex::CollectorIndex(const classad::References & attrs)
+	: m_attributes(attrs)
+{
+	for (const auto & attr : attrs) {
+		m_index[attr];
+	}
+}
+
+void
+CollectorIndex::insert(CollectorRecord * record)
+{
+	m_dirty.erase(record);
+	record->m_indexKeys.clear();
+
+	for (auto & [attr, index] : m_index) {
+		classad::ExprTree * expr = record->m_publicAd->Lookup(attr);
+		if ( ! expr) {
+			// a missing attribute is undefined, which never compares true to a literal
+			continue;
+		}
+
+		CollectorIndexKey key;
+		key.attr = &index;
+		key.num = 0;
+		classad::Value value;
+		double num;
+		if ( ! ExprTreeIsLiteral(expr, value)) {
+			key.kind = CollectorIndexKey::OTHER;
+			index.others.insert(record);
+		} else if (value.IsStringValue(key.str)) {
+			lower_case(key.str);
+			key.kind = CollectorIndexKey::STRING;
+			index.strings[key.str].insert(record);
+		} else if (value.IsNumber(num) && ! std::isnan(num)) {
+			key.kind = CollectorIndexKey::NUMBER;
+			key.num = num;
+			index.numbers.emplace(num, record);
+		} else if (value.IsUndefinedValue() || value.IsErrorValue()) {
+			continue;
+		} else {
+			// lists, nested ads and the like
+			key.kind = CollectorIndexKey::OTHER;
+			index.others.insert(record);
+		}
+		record->m_indexKeys.push_back(std::move(key));
+	}
+}
+
+void
+CollectorIndex::remove(CollectorRecord * record)
+{
+	m_dirty.erase(record);
+	for (auto & key : record->m_indexKeys) {
+		switch (key.kind) {
+		case CollectorIndexKey::STRING: {
+			auto it = key.attr->strings.find(key.str);
+			if (it != key.attr->strings.end()) {
+				it->second.erase(record);
+				if (it->second.empty()) { key.attr->strings.erase(it); }
+			}
+			} break;
+		case CollectorIndexKey::NUMBER:
+			key.attr->numbers.erase(std::make_pair(key.num, record));
+			break;
+		case CollectorIndexKey::OTHER:
+			key.attr->others.erase(record);
+			break;
+		}
+	}
+	record->m_indexKeys.clear();
+}
+
+void
+CollectorIndex::invalidate(CollectorRecord * record)
+{
+	remove(record);
+	m_dirty.insert(record);
+}
+
+void
+CollectorIndex::refresh()
+{
+	while ( ! m_dirty.empty()) {
+		insert(*m_dirty.begin());
+	}
+}
+
+// returns the attribute named by an unscoped or MY. attribute reference
+static bool
+attr_ref_name(const classad::ExprTree * tree, std::string & attr)
+{
+	if ( ! tree || tree->GetKind() != classad::ExprTree::ATTRREF_NODE) return false;
+
+	classad::ExprTree * scope = nullptr;
+	bool absolute = false;
+	static_cast<const classad::AttributeReference*>(tree)->GetComponents(scope, attr, absolute);
+	if (absolute) return false;
+	if (scope) {
+		std::string scope_attr;
+		classad::ExprTree * scope_scope = nullptr;
+		if (scope->GetKind() != classad::ExprTree::ATTRREF_NODE) return false;
+		static_cast<const classad::AttributeReference*>(scope)->GetComponents(scope_scope, scope_attr, absolute);
+		if (scope_scope || absolute || strcasecmp(scope_attr.c_str(), "MY") != 0) return false;
+	}
+	return true;
+}
+
+// only the top level && clauses of a constraint are useful, since the constraint
+// as a whole can only be true when every one of them is true
+static void
+collect_clauses(classad::ExprTree * tree, std::vector<classad::ExprTree *> & clauses)
+{
+	tree = SkipExprParens(SkipExprEnvelope(tree));
+	if ( ! tree) return;
+
+	if (tree->GetKind() == classad::ExprTree::OP_NODE) {
+		classad::Operation::OpKind op;
+		classad::ExprTree *t1, *t2, *t3;
+		static_cast<const classad::Operation*>(tree)->GetComponents(op, t1, t2, t3);
+		if (op == classad::Operation::LOGICAL_AND_OP) {
+			collect_clauses(t1, clauses);
+			collect_clauses(t2, clauses);
+			return;
+		}
+	}
+	clauses.push_back(tree);
+}
+
+bool
+CollectorIndex::lookup(classad::ExprTree * constraint, std::vector<CollectorRecord *> & candidates)
+{
+	if ( ! constraint || m_index.empty()) {
+		return false;
+	}
+
+	std::vector<classad::ExprTree *> clauses;
+	collect_clauses(constraint, clauses);
+
+	refresh();
+
+	// Of the clauses that compare an indexed attribute to a literal, use
+	// the one that leaves the fewest candidates.
+	const AttrIndex * best_index = nullptr;
+	const std::unordered_set<CollectorRecord *> * best_strings = nullptr;
+	std::set<std::pair<double, CollectorRecord *>>::const_iterator best_lo, best_hi;
+	size_t best_count = 0;
+
+	for (auto * clause : clauses) {
+		if (clause->GetKind() != classad::ExprTree::OP_NODE) continue;
+
+		classad::Operation::OpKind op;
+		classad::ExprTree *t1, *t2, *t3;
+		static_cast<const classad::Operation*>(clause)->GetComponents(op, t1, t2, t3);
+
+		std::string attr;
+		classad::Value literal;
+		t1 = SkipExprParens(t1);
+		t2 = SkipExprParens(t2);
+		if (attr_ref_name(t1, attr) && ExprTreeIsLiteral(t2, literal)) {
+			// attribute on the left, as the operators below expect
+		} else if (attr_ref_name(t2, attr) && ExprTreeIsLiteral(t1, literal)) {
+			switch (op) {
+			case classad::Operation::LESS_THAN_OP: op = classad::Operation::GREATER_THAN_OP; break;
+			case classad::Operation::LESS_OR_EQUAL_OP: op = classad::Operation::GREATER_OR_EQUAL_OP; break;
+			case classad::Operation::GREATER_OR_EQUAL_OP: op = classad::Operation::LESS_OR_EQUAL_OP; break;
+			case classad::Operation::GREATER_THAN_OP: op = classad::Operation::LESS_THAN_OP; break;
+			default: break;
+			}
+		} else {
+			continue;
+		}
+
+		auto found = m_index.find(attr);
+		if (found == m_index.end()) continue;
+		const AttrIndex & index = found->second;
+
+		std::string str;
+		double num = 0;
+		bool is_string = literal.IsStringValue(str);
+		if ( ! is_string && ( ! literal.IsNumber(num) || std::isnan(num))) continue;
+
+		const std::unordered_set<CollectorRecord *> * strings = nullptr;
+		auto lo = index.numbers.end(), hi = index.numbers.end();
+		size_t count = index.others.size();
+		static const std::unordered_set<CollectorRecord *> no_records;
+
+		if (op == classad::Operation::EQUAL_OP || op == classad::Operation::META_EQUAL_OP) {
+			if (is_string) {
+				lower_case(str);
+				auto it = index.strings.find(str);
+				strings = (it != index.strings.end()) ? &it->second : &no_records;
+				count += strings->size();
+			} else {
+				lo = index.numbers.lower_bound(std::make_pair(num, (CollectorRecord *)nullptr));
+				hi = index.numbers.upper_bound(std::make_pair(num, (CollectorRecord *)UINTPTR_MAX));
+				count += std::distance(lo, hi);
+			}
+		} else if ( ! is_string) {
+			switch (op) {
+			case classad::Operation::LESS_THAN_OP:
+				lo = index.numbers.begin();
+				hi = index.numbers.lower_bound(std::make_pair(num, (CollectorRecord *)nullptr));
+				break;
+			case classad::Operation::LESS_OR_EQUAL_OP:
+				lo = index.numbers.begin();
+				hi = index.numbers.upper_bound(std::make_pair(num, (CollectorRecord *)UINTPTR_MAX));
+				break;
+			case classad::Operation::GREATER_OR_EQUAL_OP:
+				lo = index.numbers.lower_bound(std::make_pair(num, (CollectorRecord *)nullptr));
+				hi = index.numbers.end();
+				break;
+			case classad::Operation::GREATER_THAN_OP:
+				lo = index.numbers.upper_bound(std::make_pair(num, (CollectorRecord *)UINTPTR_MAX));
+				hi = index.numbers.end();
+				break;
+			default:
+				continue;
+			}
+			count += std::distance(lo, hi);
+		} else {
+			continue;
+		}
+
+		if ( ! best_index || count < best_count) {
+			best_index = &index;
+			best_strings = strings;
+			best_lo = lo;
+			best_hi = hi;
+			best_count = count;
+		}
+	}
+
+	if ( ! best_index) {
+		return false;
+	}
+
+	candidates.clear();
+	candidates.reserve(best_count);
+	if (best_strings) {
+		candidates.insert(candidates.end(), best_strings->begin(), best_strings->end());
+	} else {
+		for (auto it = best_lo; it != best_hi; ++it) {
+			candidates.push_back(it->second);
+		}
+	}
+	candidates.insert(candidates.end(), best_index->others.begin(), best_index->others.end());
+	return true;
+}
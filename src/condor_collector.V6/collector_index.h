@@ -0,0 +1,89 @@
+/***************************************************************
+ *
+ * Copyright (C) 2025, Condor Team, Computer Sciences Department,
+ * University of Wisconsin-Madison, WI.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you
+ * may not use this file except in compliance with the License.  You may
+ * obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ ***************************************************************/
+
+#ifndef __COLLECTOR_INDEX_H__
+#define __COLLECTOR_INDEX_H__
+
+#include <map>
+#include <set>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "condor_classad.h"
+
+struct CollectorRecord;
+
+// Secondary indexes on some attributes of the ads in one collector table.
+// String values are hashed (case-insensitively, as == compares them), and
+// numeric values are kept sorted, so a query whose constraint is a
+// conjunction that compares an indexed attribute to a literal only has to
+// evaluate the constraint against the ads that could match.
+//
+// Only literal values are indexed.  An ad whose value for an indexed
+// attribute is an expression is a candidate for every lookup.  Ads that
+// are changed in place (by merges or expiration) are re-indexed lazily, on
+// the next lookup.
+class CollectorIndex
+{
+  public:
+	CollectorIndex(const classad::References & attrs);
+
+	// add a record to the index, or update it from its current ads
+	void insert(CollectorRecord * record);
+	void update(CollectorRecord * record) { remove(record); insert(record); }
+	void remove(CollectorRecord * record);
+	// the ads of the record are about to be changed in place, so stop trusting
+	// the index for it until refresh()
+	void invalidate(CollectorRecord * record);
+	// re-index the records that were changed in place
+	void refresh();
+
+	// If the constraint can use the index, fill candidates with the records
+	// that might match it and return true.  Every record that matches the
+	// constraint is a candidate, but not every candidate matches.
+	bool lookup(classad::ExprTree * constraint, std::vector<CollectorRecord *> & candidates);
+
+	const classad::References & attributes() const { return m_attributes; }
+
+	struct AttrIndex {
+		std::unordered_map<std::string, std::unordered_set<CollectorRecord *>> strings; // by lower-cased value
+		std::set<std::pair<double, CollectorRecord *>> numbers;
+		std::unordered_set<CollectorRecord *> others; // values that aren't literals
+	};
+
+  private:
+	classad::References m_attributes;
+	std::map<std::string, AttrIndex, classad::CaseIgnLTStr> m_index;
+	std::unordered_set<CollectorRecord *> m_dirty;
+};
+
+// where a record is in a CollectorIndex, so that it can be removed without
+// looking at its ads, which may have changed since it was indexed.
+struct CollectorIndexKey
+{
+	enum Kind { STRING, NUMBER, OTHER };
+	CollectorIndex::AttrIndex * attr;
+	Kind kind;
+	std::string str;
+	double num;
+};
+
+#endif // __COLLECTOR_INDEX_H__
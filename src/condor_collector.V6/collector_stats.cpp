@@ -384,6 +384,11 @@ void UpdatesStats::Init()
 	ADD_EXTERN_RUNTIME(Pool, HandleLocateForked, IF_VERBOSEPUB);
 	ADD_EXTERN_RUNTIME(Pool, HandleLocateMissedFork, IF_VERBOSEPUB);
 
+	// per-query latency of queued queries, and of queries served by the query threads.
+	ADD_EXTERN_RUNTIME(Pool, QueryQueueWait, IF_VERBOSEPUB);
+	ADD_EXTERN_RUNTIME(Pool, QueryThreadScan, IF_VERBOSEPUB);
+	ADD_EXTERN_RUNTIME(Pool, QueryThreadSend, IF_VERBOSEPUB);
+
 #ifdef TRACK_QUERIES_BY_SUBSYS
     #define ADD_SUBSYS_PROBES(pool,subsys,as) \
 	   pool.AddProbe("InProcQueriesFrom" #subsys, &InProcQueriesFrom[SUBSYSTEM_ID_##subsys], "InProcQueriesFrom" #subsys, as | InProcQueriesFrom[SUBSYSTEM_ID_##subsys].PubDefault); \
@@ -27,6 +27,7 @@
 #include "condor_daemon_core.h"
 #include "dc_collector.h"
 #include "subsystem_info.h"
+#include "selector.h"
 
 #include <algorithm>
 
@@ -109,6 +110,7 @@ DCCollector::deepCopy( const DCCollector& copy )
 
 	use_tcp = copy.use_tcp;
 	use_nonblocking_update = copy.use_nonblocking_update;
+	use_delta_updates = copy.use_delta_updates;
 
 	up_type = copy.up_type;
 
@@ -222,6 +224,7 @@ void
 DCCollector::reconfig( void )
 {
 	use_nonblocking_update = param_boolean("NONBLOCKING_COLLECTOR_UPDATE",true);
+	use_delta_updates = param_boolean("STARTD_SEND_DELTA_UPDATES",false);
 
 	if( _addr.empty() ) {
 		locate();
@@ -414,12 +417,184 @@ DCCollector::sendUpdate( int cmd, ClassAd* ad1, DCCollectorAdSequences& adSeq, C
 	}
 
 	if( use_tcp ) {
+		if( use_delta_updates && cmd == UPDATE_STARTD_AD && ad1 && ad2 ) {
+			if( sendDeltaUpdate( ad1, ad2, nonblocking, callback_fn, miscdata ) ) {
+				return true;
+			}
+				// Send the whole ad, and make it the baseline for the
+				// deltas that follow it on the same connection.
+			long long version = ++delta_version;
+			ad1->Assign( ATTR_UPDATE_DELTA_VERSION, version );
+			if( ! sendTCPUpdate( cmd, ad1, ad2, nonblocking, callback_fn, miscdata ) ) {
+				return false;
+			}
+			rememberDeltaBaseline( ad1, ad2 );
+			return true;
+		}
 		return sendTCPUpdate( cmd, ad1, ad2, nonblocking, callback_fn, miscdata );
 	}
 	return sendUDPUpdate( cmd, ad1, ad2, nonblocking, callback_fn, miscdata );
 }
 
 
+static std::string
+deltaBaselineKey( const ClassAd & ad )
+{
+	std::string key, mytype;
+	ad.LookupString( ATTR_NAME, key );
+	ad.LookupString( ATTR_MY_TYPE, mytype );
+	key += "\n"; key += mytype;
+	return key;
+}
+
+void
+DCCollector::rememberDeltaBaseline( ClassAd* ad1, ClassAd* ad2 )
+{
+	DeltaBaseline & base = delta_baselines[deltaBaselineKey( *ad1 )];
+	base.ad = *ad1;
+	base.ad.Delete( ATTR_UPDATE_DELTA_VERSION );
+	base.private_ad = *ad2;
+	ad1->LookupInteger( ATTR_UPDATE_DELTA_VERSION, base.version );
+	base.last_sent = time( NULL );
+}
+
+// The collector closed the update socket because a delta we sent didn't
+// apply, and it dropped whatever we sent after that.  We can't tell which
+// slots those were, so send every slot we have sent deltas for as a whole
+// ad right away, rather than leave the collector with stale ads until each
+// slot next changes.  ad1 is left out, since our caller is about to send
+// it whole.
+void
+DCCollector::resendDeltaBaselines( ClassAd* ad1, bool nonblocking )
+{
+	std::map<std::string, DeltaBaseline> baselines;
+	baselines.swap( delta_baselines );
+	baselines.erase( deltaBaselineKey( *ad1 ) );
+
+	for( auto & [key, base] : baselines ) {
+			// this isn't a new update, so don't let the collector count
+			// the repeated sequence number as a lost one
+		base.ad.Delete( ATTR_UPDATE_SEQUENCE_NUMBER );
+		base.ad.Assign( ATTR_UPDATE_DELTA_VERSION, ++delta_version );
+		if( ! sendTCPUpdate( UPDATE_STARTD_AD, &base.ad, &base.private_ad, nonblocking, nullptr, nullptr ) ) {
+			return;
+		}
+		rememberDeltaBaseline( &base.ad, &base.private_ad );
+	}
+}
+
+bool
+DCCollector::sendDeltaUpdate( ClassAd* ad1, ClassAd* ad2, bool nonblocking, StartCommandCallbackType callback_fn, void *miscdata )
+{
+	time_t now = time( NULL );
+
+		// Forget the ads of slots that have gone away.  Forgetting one
+		// that is still around just costs a whole ad the next time.
+	if( now - delta_last_prune > 600 ) {
+		delta_last_prune = now;
+		for( auto it = delta_baselines.begin(); it != delta_baselines.end(); ) {
+			if( now - it->second.last_sent > 3600 ) {
+				it = delta_baselines.erase( it );
+			} else {
+				++it;
+			}
+		}
+	}
+
+		// A delta has to follow its baseline on the same connection, so
+		// we need a connected socket with nothing queued ahead of it.
+		// Released 24.12.x collectors report the same version as this one
+		// without taking deltas, so STARTD_SEND_DELTA_UPDATES must only be
+		// set when every collector we update does.
+	if( ! update_rsock || ! pending_update_list.empty() ||
+		! checkCachedVersion( 24, 12, 0, false ) ) {
+		return false;
+	}
+
+		// The collector never writes to an update socket, it closes it
+		// when it cannot apply a delta.  So if there is anything to read,
+		// the connection is done and the collector wants whole ads again.
+	Selector selector;
+	selector.add_fd( update_rsock->get_file_desc(), Selector::IO_READ );
+	selector.set_timeout( 0 );
+	selector.execute();
+	if( selector.has_ready() ) {
+		dprintf( D_FULLDEBUG, "Collector %s closed the update socket, "
+				 "reconnecting to send whole ads\n", update_destination );
+		delete update_rsock;
+		update_rsock = NULL;
+		resendDeltaBaselines( ad1, nonblocking );
+		return false;
+	}
+
+	auto it = delta_baselines.find( deltaBaselineKey( *ad1 ) );
+	if( it == delta_baselines.end() ) {
+		return false;
+	}
+
+	DeltaBaseline & base = it->second;
+	ClassAd delta;
+	for( auto & [attr, expr] : *ad1 ) {
+		if( strcasecmp( attr.c_str(), ATTR_UPDATE_DELTA_VERSION ) == MATCH ) {
+			continue;
+		}
+		ExprTree * old_expr = base.ad.Lookup( attr );
+		if( ! old_expr || ! old_expr->SameAs( expr ) ) {
+			delta.Insert( attr, expr->Copy() );
+			base.ad.Insert( attr, expr->Copy() );
+		}
+	}
+	std::string removed;
+	for( auto itr = base.ad.begin(); itr != base.ad.end(); ) {
+		if( ! ad1->Lookup( itr->first ) ) {
+			if( ! removed.empty() ) { removed += ","; }
+			removed += itr->first;
+			itr = base.ad.erase( itr );
+		} else {
+			++itr;
+		}
+	}
+
+		// The collector needs these to find the ad and keep its statistics
+	static const char * const key_attrs[] = {
+		ATTR_NAME, ATTR_MY_TYPE, ATTR_MACHINE, ATTR_SLOT_ID, ATTR_MY_ADDRESS,
+		ATTR_STARTD_IP_ADDR, ATTR_UPDATE_SEQUENCE_NUMBER, ATTR_DAEMON_START_TIME,
+	};
+	for( const char * attr : key_attrs ) {
+		if( ! delta.Lookup( attr ) && ad1->Lookup( attr ) ) {
+			CopyAttribute( attr, delta, *ad1 );
+		}
+	}
+
+	long long version = ++delta_version;
+	delta.Assign( ATTR_UPDATE_DELTA_BASE, base.version );
+	delta.Assign( ATTR_UPDATE_DELTA_VERSION, version );
+	if( ! removed.empty() ) {
+		delta.Assign( ATTR_UPDATE_DELTA_REMOVED, removed );
+	}
+
+	update_rsock->encode();
+	if( update_rsock->put( UPDATE_STARTD_AD_DELTA ) &&
+		finishUpdate( this, update_rsock, &delta, ad2, nullptr, nullptr ) )
+	{
+		base.version = version;
+		base.private_ad = *ad2;
+		base.last_sent = now;
+		if( callback_fn ) {
+			(*callback_fn)(true, update_rsock, nullptr, update_rsock->getTrustDomain(), update_rsock->shouldTryTokenRequest(), miscdata);
+		}
+		return true;
+	}
+	dprintf( D_FULLDEBUG,
+			 "Couldn't send delta update to collector, "
+			 "starting new connection\n" );
+	delete update_rsock;
+	update_rsock = NULL;
+	relocate();
+	return false;
+}
+
+
 
 bool
 DCCollector::finishUpdate( DCCollector *self, Sock* sock, ClassAd* ad1, ClassAd* ad2, StartCommandCallbackType callback_fn, void *miscdata )
@@ -755,6 +930,12 @@ DCCollector::initiateTCPUpdate( int cmd, ClassAd* ad1, ClassAd* ad2, bool nonblo
 	if( update_rsock ) {
 		delete update_rsock;
 		update_rsock = NULL;
+	}
+		// A new connection may well reach a new collector, so the deltas
+		// start over from whole ads.  Updates already queued will go out
+		// on the connection we are about to make, so keep their baselines.
+	if( pending_update_list.empty() ) {
+		delta_baselines.clear();
 	}
 	if (!new_tcp_connections) {
 		dprintf(D_FULLDEBUG, "Not allowing new TCP connection to collector %s\n", update_destination);
@@ -156,6 +156,26 @@ private:
 
 	bool initiateTCPUpdate( int cmd, ClassAd* ad1, ClassAd* ad2, bool nonblocking, StartCommandCallbackType callback_fn, void *miscdata );
 
+	// Items to manage delta updates of startd slot ads.  For each ad, we
+	// remember what this collector was last sent over update_rsock, and
+	// send only the differences from that.  The collector closes the socket
+	// when a delta does not apply to the ad it has; when we see that, we
+	// send every remembered ad whole on a new connection.
+	struct DeltaBaseline {
+		ClassAd ad;
+		ClassAd private_ad;
+		long long version{0};
+		time_t last_sent{0};
+	};
+	bool use_delta_updates{false};
+	long long delta_version{0};
+	time_t delta_last_prune{0};
+	std::map<std::string, DeltaBaseline> delta_baselines;
+
+	bool sendDeltaUpdate( ClassAd* ad1, ClassAd* ad2, bool nonblocking, StartCommandCallbackType callback_fn, void *miscdata );
+	void rememberDeltaBaseline( ClassAd* ad1, ClassAd* ad2 );
+	void resendDeltaBaselines( ClassAd* ad1, bool nonblocking );
+
 	char* update_destination;
 
 	struct timeval m_blacklist_monitor_query_started;
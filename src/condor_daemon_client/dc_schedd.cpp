@@ -1901,6 +1901,63 @@ bool DCSchedd::recycleShadow( int previous_job_exit_reason, ClassAd **new_job_ad
 	return true;
 }
 
+bool DCSchedd::multiplexedShadowJobExit( PROC_ID job_id, int exit_reason, std::string & error_msg )
+{
+	int timeout = 300;
+	CondorError errstack;
+
+	if (IsDebugLevel(D_COMMAND)) {
+		dprintf (D_COMMAND, "DCSchedd::multiplexedShadowJobExit(%s,...) making connection to %s\n",
+			getCommandStringSafe(MULTIPLEX_SHADOW_JOB_EXIT), _addr.c_str());
+	}
+
+	ReliSock sock;
+	if( !connectSock(&sock,timeout,&errstack) ) {
+		formatstr(error_msg, "Failed to connect to schedd: %s",
+						  errstack.getFullText().c_str());
+		return false;
+	}
+
+	if( !startCommand(MULTIPLEX_SHADOW_JOB_EXIT, &sock, timeout, &errstack) ) {
+		formatstr(error_msg, "Failed to send MULTIPLEX_SHADOW_JOB_EXIT to schedd: %s",
+						  errstack.getFullText().c_str());
+		return false;
+	}
+
+	if( !forceAuthentication(&sock, &errstack) ) {
+		formatstr(error_msg, "Failed to authenticate: %s",
+						  errstack.getFullText().c_str());
+		return false;
+	}
+
+	sock.encode();
+	int mypid = getpid();
+	if( !sock.put( mypid ) ||
+		!sock.put( job_id.cluster ) ||
+		!sock.put( job_id.proc ) ||
+		!sock.put( exit_reason ) ||
+		!sock.end_of_message() )
+	{
+		error_msg = "Failed to send job exit reason";
+		return false;
+	}
+
+	sock.decode();
+
+	int ok = 0;
+	if( !sock.get( ok ) || !sock.end_of_message() ) {
+		error_msg = "Failed to receive reply";
+		return false;
+	}
+	if( !ok ) {
+			// the schedd already gave up on the job, e.g. it was removed
+		dprintf( D_FULLDEBUG, "Schedd was no longer expecting job %d.%d from us\n",
+				 job_id.cluster, job_id.proc );
+	}
+
+	return true;
+}
+
 bool
 DCSchedd::reassignSlot( PROC_ID bid, ClassAd & reply, std::string & errorMessage, PROC_ID * vids, unsigned vCount, int flags ) {
 	std::string vidList;
@@ -407,6 +407,11 @@ public:
 		// If no new job found, returns true with *new_job_ad=NULL
 	bool recycleShadow( int previous_job_exit_reason, ClassAd **new_job_ad, std::string & error_msg );
 
+		// Used by a shadow that is running several jobs to tell the
+		// schedd it is done with one of them.
+		// Returns false on error (see error_msg)
+	bool multiplexedShadowJobExit( PROC_ID job_id, int exit_reason, std::string & error_msg );
+
 
 		/*
 		 * Retrieve a token with someone else's identity from a remote schedd,
@@ -74,6 +74,7 @@ class ProcFamilyInterface;
 #define DEBUG_SETTABLE_ATTR_LISTS 0
 
 class Probe;
+class Selector;
 
 #define USE_MIRON_PROBE_FOR_DC_RUNTIME_STATS
 
@@ -960,12 +961,17 @@ class DaemonCore : public Service
     /** Not_Yet_Documented
         @param iosock           Not_Yet_Documented
         @param descrip          Not_Yet_Documented
+        @param wait_for_msg     If true and iosock is a ReliSock, read
+                                from it without blocking and only
+                                dispatch the command once a whole CEDAR
+                                message has arrived
         @return -1 if iosock is NULL, -2 is reregister, 0 or above on success
     */
     int Register_Command_Socket (Stream*      iosock,
-                                 const char * descrip = NULL ) {
+                                 const char * descrip = NULL,
+                                 bool         wait_for_msg = false ) {
 	m_dirty_command_sock_sinfuls = true;
-        return Register_Socket (iosock,
+        int rc = Register_Socket (iosock,
                                 descrip,
                                 (SocketHandler)NULL,
                                 (SocketHandlercpp)NULL,
@@ -973,6 +979,10 @@ class DaemonCore : public Service
                                 NULL,
 				HANDLE_READ,
                                 0);
+        if ( rc >= 0 ) {
+            sockTable[rc].wait_for_msg = wait_for_msg;
+        }
+        return rc;
     }
 
     /** Not_Yet_Documented
@@ -1915,6 +1925,8 @@ class DaemonCore : public Service
 	int m_iMaxReapsPerCycle; // maximum number reapers to invoke per event loop
 	int m_MaxTimeSkip;
 	int m_iMaxUdpMsgsPerCycle;	// max number of udp messages read per loop
+	bool m_use_epoll_selector;	// keep Driver() fds registered with epoll across loops
+	Selector *m_driver_selector; // Driver()'s selector, so Cancel_* can drop persistent registrations
 
     void Inherit( void );  // called in main()
 	void InitDCCommandSocket( int command_port );  // called in main()
@@ -2076,6 +2088,7 @@ class DaemonCore : public Service
 		HandlerType		handler_type;
 		int				servicing_tid;	// tid servicing this socket
 		bool            is_command_sock;
+		bool            wait_for_msg;	// dispatch only once a whole message is buffered
     };
     void              DumpSocketTable(int, const char* = NULL);
 	int				  nRegisteredSocks; // number of sockets registered, always < nSock
@@ -307,6 +307,8 @@ DaemonCore::DaemonCore(int ComSize,int SigSize,
 	m_super_dc_port = -1;
 	m_iMaxReapsPerCycle = 1;
     m_iMaxAcceptsPerCycle = 1;
+	m_use_epoll_selector = false;
+	m_driver_selector = NULL;
 
 	m_MaxTimeSkip = 60 * 20;  // 20 minutes
 
@@ -1818,6 +1820,7 @@ int DaemonCore::Register_Socket(Stream *iosock, const char* iosock_descrip,
 	sockTable[i].service = s;
 	sockTable[i].data_ptr = NULL;
 	sockTable[i].waiting_for_data = false;
+	sockTable[i].wait_for_msg = false;
 	free(sockTable[i].iosock_descrip);
 	if ( iosock_descrip )
 		sockTable[i].iosock_descrip = strdup(iosock_descrip);
@@ -1914,6 +1917,11 @@ int DaemonCore::Cancel_Socket( Stream* insock, void *prev_entry)
 		// Log a message
 		dprintf(D_DAEMONCORE,"Cancel_Socket: cancelled socket %zu <%s> %p\n",
 				i,sockTable[i].iosock_descrip, sockTable[i].iosock );
+		// The caller may close the socket as soon as we return, so the
+		// Driver's persistent (epoll) registration must go now.
+		if ( m_driver_selector ) {
+			m_driver_selector->forget_fd( ((Sock *)sockTable[i].iosock)->get_file_desc() );
+		}
 		// Remove entry; mark it is available for next add via iosock=NULL
 		sockTable[i].iosock = NULL;
 		free( sockTable[i].iosock_descrip );
@@ -2311,6 +2319,12 @@ int DaemonCore::Cancel_Pipe( int pipe_end )
 			"Cancel_Pipe: cancelled pipe end %d <%s> (entry=%zu)\n",
 			pipe_end,pipeTable[i].pipe_descrip, i );
 
+#ifndef WIN32
+	if ( m_driver_selector ) {
+		m_driver_selector->forget_fd( pipeHandleTable[pipeTable[i].index] );
+	}
+#endif
+
 	// mark entry unused
 	pipeTable[i].index = -1;
 	free(pipeTable[i].pipe_descrip );
@@ -3084,6 +3098,10 @@ DaemonCore::reconfig(void) {
     if( m_iMaxReapsPerCycle != 0 ) {
         dprintf(D_FULLDEBUG,"Setting maximum reaps per cycle %d.\n", m_iMaxReapsPerCycle);
     }
+
+#ifdef CONDOR_HAVE_EPOLL
+	m_use_epoll_selector = param_boolean("DAEMON_CORE_USE_EPOLL", false);
+#endif
 		// Initialize the collector list for ClassAd updates
 	initCollectorList();
 
@@ -3468,6 +3486,7 @@ DaemonCore::callSignalHandlers(double & runtime) {
 void DaemonCore::Driver()
 {
 	Selector	selector;
+	Selector	recheck_selector;
 	int			i;
 	int			tmpErrno;
 	time_t		timeout;
@@ -3554,6 +3573,16 @@ void DaemonCore::Driver()
 		// Setup what socket descriptors to select on.  We recompute this
 		// every time because 1) some timeout handler may have removed/added
 		// sockets, and 2) it ain't that expensive....
+		// With DAEMON_CORE_USE_EPOLL, the selector keeps its kernel
+		// registrations across passes and only pushes the changes, so
+		// rebuilding the interest set here stays cheap for idle sockets.
+		if ( selector.using_epoll() != m_use_epoll_selector ) {
+			if ( ! selector.use_epoll( m_use_epoll_selector ) ) {
+				dprintf(D_ALWAYS, "DaemonCore: unable to use epoll, falling back to select()\n");
+				m_use_epoll_selector = false;
+			}
+			m_driver_selector = selector.using_epoll() ? &selector : NULL;
+		}
 		selector.reset();
 		min_deadline = 0;
 		for (auto & sockEnt : sockTable) {
@@ -3926,11 +3955,11 @@ void DaemonCore::Driver()
 #else
 							// UNIX
 							int pipefd = pipeHandleTable[pipeTable[i].index];
-							selector.reset();
-							selector.set_timeout( 0 );
-							selector.add_fd( pipefd, Selector::IO_READ );
-							selector.execute();
-							if ( selector.timed_out() ) {
+							recheck_selector.reset();
+							recheck_selector.set_timeout( 0 );
+							recheck_selector.add_fd( pipefd, Selector::IO_READ );
+							recheck_selector.execute();
+							if ( recheck_selector.timed_out() ) {
 								// nothing available, try the next entry...
 								continue;
 							}
@@ -4030,13 +4059,13 @@ void DaemonCore::Driver()
 							// read on the pipe could block?  to prevent this, we need
 							// to check one more time to make certain the pipe is ready
 							// for reading.
-							selector.reset();
-							selector.set_timeout( 0 );// set timeout for a poll
-							selector.add_fd( sockTable[i].iosock->get_file_desc(),
+							recheck_selector.reset();
+							recheck_selector.set_timeout( 0 );// set timeout for a poll
+							recheck_selector.add_fd( sockTable[i].iosock->get_file_desc(),
 											 Selector::IO_READ );
 
-							selector.execute();
-							if ( selector.timed_out() ) {
+							recheck_selector.execute();
+							if ( recheck_selector.timed_out() ) {
 								// nothing available, try the next entry...
 								continue;
 							}
@@ -4157,6 +4186,23 @@ DaemonCore::CallSocketHandler( const size_t i, bool default_to_HandleCommand )
 		return;
 	}
 
+	// For TCP command sockets that asked for it, pull in whatever has
+	// arrived without blocking, and only dispatch once the whole message
+	// is buffered, so that a slow peer can't stall us in HandleReq().
+	// If the peer closed the socket or the read failed, dispatch anyway
+	// and let HandleReq() clean up.
+	if ( sockTable[i].wait_for_msg && default_to_HandleCommand &&
+			sockTable[i].iosock->type() == Stream::reli_sock ) {
+
+		ReliSock *rsock = (ReliSock *)sockTable[i].iosock;
+		rsock->clear_read_block_flag();
+		if ( !rsock->msgReady() && rsock->clear_read_block_flag() ) {
+			dprintf( D_NETWORK, "Waiting for the rest of a message on <%s>\n",
+					 sockTable[i].iosock_descrip );
+			return;
+		}
+	}
+
     // if it is an accepting socket it will try for the connect
     // up (n) elements
     while ( iAcceptCnt )
@@ -698,6 +698,8 @@
 #define ATTR_SCHEDD_NAME  "ScheddName"
 #define ATTR_SCHEDDS_ARE_SUBMITTERS  "ScheddsAreSubmitters"
 #define ATTR_SCHEDULER  "Scheduler"
+#define ATTR_SHADOW_MEMORY_PER_RUNNING_JOB  "ShadowMemoryPerRunningJob"
+#define ATTR_SHADOW_PROCESSES_RUNNING  "ShadowProcessesRunning"
 #define ATTR_SHADOW_WAIT_FOR_DEBUG  "ShadowWaitForDebug"
 #define ATTR_SHOULD_FORWARD	"ShouldForward"
 #define ATTR_SCITOKENS_FILE "ScitokensFile"
@@ -836,6 +838,9 @@
 #define ATTR_CLASSAD_LIFETIME  "ClassAdLifetime"
 #define ATTR_UPDATE_PRIO  "UpdatePrio"
 #define ATTR_UPDATE_SEQUENCE_NUMBER  "UpdateSequenceNumber"
+#define ATTR_UPDATE_DELTA_VERSION  "UpdateDeltaVersion"
+#define ATTR_UPDATE_DELTA_BASE  "UpdateDeltaBase"
+#define ATTR_UPDATE_DELTA_REMOVED  "UpdateDeltaRemoved"
 #define ATTR_USE_PARROT  "UseParrot"
 #define ATTR_USER  "User"
 #define ATTR_USERREC_OPT_prefix "_userrec_opt_"
@@ -1015,6 +1020,7 @@ extern const char ATTR_SEC_AUTHENTICATED_USER [];
 #define ATTR_SEC_ECDH_PUBLIC_KEY "ECDHPublicKey"
 #define ATTR_SEC_RESUME_RESPONSE "ResumeResponse"
 #define ATTR_SEC_NEGOTIATED_SESSION "NegotiatedSession"
+#define ATTR_SEC_BINARY_CLASSADS "BinaryClassAds"
 
 #define ATTR_MULTIPLE_TASKS_PER_PVMD  "MultipleTasksPerPvmd"
 
@@ -1179,6 +1185,15 @@ extern const char ATTR_SEC_AUTHENTICATED_USER [];
 #define ATTR_LAST_NEGOTIATION_CYCLE_PIE_SPINS  "LastNegotiationCyclePieSpins"
 #define ATTR_LAST_NEGOTIATION_CYCLE_PREFETCH_DURATION  "LastNegotiationCyclePrefetchDuration"
 #define ATTR_LAST_NEGOTIATION_CYCLE_PREFETCH_CPU_TIME  "LastNegotiationCyclePrefetchCpuTime"
+#define ATTR_LAST_NEGOTIATION_CYCLE_PARALLEL_MATCH_DURATION  "LastNegotiationCycleParallelMatchDuration"
+#define ATTR_LAST_NEGOTIATION_CYCLE_PARALLEL_MATCH_CPU_TIME  "LastNegotiationCycleParallelMatchCpuTime"
+#define ATTR_LAST_NEGOTIATION_CYCLE_PARALLEL_MATCH_SCANS  "LastNegotiationCycleParallelMatchScans"
+#define ATTR_LAST_NEGOTIATION_CYCLE_SLOT_INDEX_SCANS  "LastNegotiationCycleSlotIndexScans"
+#define ATTR_LAST_NEGOTIATION_CYCLE_SLOT_INDEX_CONSIDERED  "LastNegotiationCycleSlotIndexConsidered"
+#define ATTR_LAST_NEGOTIATION_CYCLE_SLOT_INDEX_PRUNED  "LastNegotiationCycleSlotIndexPruned"
+#define ATTR_LAST_NEGOTIATION_CYCLE_SLOT_INDEX_PRUNE_RATIO  "LastNegotiationCycleSlotIndexPruneRatio"
+#define ATTR_LAST_NEGOTIATION_CYCLE_MATCH_CACHE_HITS  "LastNegotiationCycleMatchCacheHits"
+#define ATTR_LAST_NEGOTIATION_CYCLE_MATCH_CACHE_MISSES  "LastNegotiationCycleMatchCacheMisses"
 #define ATTR_LAST_NEGOTIATION_CYCLE_SCHEDDS_OUT_OF_TIME  "LastNegotiationCycleScheddsOutOfTime"
 #define ATTR_LAST_NEGOTIATION_CYCLE_CPU_TIME  "LastNegotiationCycleCpuTime"
 #define ATTR_LAST_NEGOTIATION_CYCLE_PHASE1_CPU_TIME  "LastNegotiationCyclePhase1CpuTime"
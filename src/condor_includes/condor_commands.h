@@ -67,7 +67,7 @@ const int REQUEST_CLAIM_SLOT_AD          = 7;
 
 
 constexpr const
-std::array<std::pair<int, const char *>, 197> makeCommandTable() {
+std::array<std::pair<int, const char *>, 200> makeCommandTable() {
 	return {{ // Yes, we need two...
 
 /****
@@ -388,6 +388,8 @@ std::array<std::pair<int, const char *>, 197> makeCommandTable() {
 		{DELETE_USERREC, "DELETE_USERREC"},
 #define GET_CONTACT_INFO  (SCHED_VERS+150) // Ask Schedd for child daemons contact information (addr and secret) Note: Used for DAGMan
 		{GET_CONTACT_INFO, "GET_CONTACT_INFO"},
+#define MULTIPLEX_SHADOW_JOB_EXIT (SCHED_VERS+151) // schedd: a multiplexed shadow is done with one of its jobs
+		{MULTIPLEX_SHADOW_JOB_EXIT, "MULTIPLEX_SHADOW_JOB_EXIT"},
 
 #define HAD_ALIVE_CMD                   (HAD_COMMANDS_BASE + 0)
 		{HAD_ALIVE_CMD, "HAD_ALIVE_CMD"},
@@ -639,6 +641,10 @@ std::array<std::pair<int, const char *>, 197> makeCommandTable() {
 //#define RECEIVE_JOBAD		   (DCSHADOW_BASE+4)	/* Not used */
 #define UPDATE_JOBAD		   (DCSHADOW_BASE+5)
 		{UPDATE_JOBAD, "UPDATE_JOBAD"},
+#define MULTIPLEX_SHADOW_ADD_JOB   (DCSHADOW_BASE+6)  // multiplexed shadow: start shadowing another job
+		{MULTIPLEX_SHADOW_ADD_JOB, "MULTIPLEX_SHADOW_ADD_JOB"},
+#define MULTIPLEX_SHADOW_SIGNAL_JOB (DCSHADOW_BASE+7) // multiplexed shadow: signal one of its jobs
+		{MULTIPLEX_SHADOW_SIGNAL_JOB, "MULTIPLEX_SHADOW_SIGNAL_JOB"},
 
 
 /*
@@ -721,7 +727,7 @@ static_assert(makeCommandTable().back().first == COMMAND_LAST, "Is the size of t
 *** Command ids used by the collector 
 ************/
 constexpr const
-std::array<std::pair<int, const char *>, 63> makeCollectorCommandTable() {
+std::array<std::pair<int, const char *>, 64> makeCollectorCommandTable() {
 	return {{ 
 #define UPDATE_STARTD_AD		0
 		{UPDATE_STARTD_AD, "UPDATE_STARTD_AD"},
@@ -889,6 +895,11 @@ std::array<std::pair<int, const char *>, 63> makeCollectorCommandTable() {
 #define IMPERSONATION_TOKEN_REQUEST 81
 		{IMPERSONATION_TOKEN_REQUEST, "IMPERSONATION_TOKEN_REQUEST"},
 
+			// A startd slot ad that holds only the attributes that changed
+			// since an earlier update to the same collector. New for 24.12.0
+#define UPDATE_STARTD_AD_DELTA 82
+		{UPDATE_STARTD_AD_DELTA, "UPDATE_STARTD_AD_DELTA"},
+
 #define COLLECTOR_COMMAND_LAST (INT_MAX - 1)			// used by the Win32 credd only
 		{COLLECTOR_COMMAND_LAST, "COLLECTOR_COMMAND_LAST"},
 	}};
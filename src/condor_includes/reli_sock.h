@@ -191,6 +191,11 @@ public:
 	int put_file( filesize_t *size, const char *source, filesize_t offset=0, filesize_t max_bytes=-1, class DCTransferQueue *xfer_q=NULL );
     /// returns -1 on failure, 0 for ok
 	int put_file( filesize_t *size, int fd, filesize_t offset=0, filesize_t max_bytes=-1, class DCTransferQueue *xfer_q=NULL );
+	/// Send just the length bytes of the file that start at offset (or up to
+	/// the end of the file, if it is shorter), as though they were the whole
+	/// file.  size is set to the number of bytes sent.
+	/// returns -1 on failure, 0 for ok
+	int put_file_range( filesize_t *size, int fd, filesize_t offset, filesize_t length, class DCTransferQueue *xfer_q=NULL );
 
 	// This is used internally to recover sanity on the stream after
 	// failing to open a file.  The remote side will see this as a zero-sized file.
@@ -225,6 +230,9 @@ public:
 	void reset_bytes_sent() { _bytes_sent = 0; }
     ///
 	void reset_bytes_recvd() { _bytes_recvd = 0; }
+	/// bytes moved by put_file()/get_file() without copying them
+	/// through a user-space buffer (sendfile/splice on Linux)
+	filesize_t get_zero_copy_bytes() const { return m_zero_copy_bytes; }
 
 	/// Used by CCBClient to put this socket in a state that behaves
 	/// like a socket waiting for a non-blocking connection when it
@@ -337,6 +345,8 @@ protected:
 		size_t		m_remaining_read_length; // Length remaining on a partial packet
 		size_t		m_len_t; // Network-encoded length of packet (used to reconstruct header).
 		int		m_end; // The end status of the partial packet.
+		char		m_partial_hdr[MAC_SIZE + 5]; // Start of a header read without blocking.
+		int		m_partial_hdr_len; // Bytes of m_partial_hdr that are filled.
 		Buf		*m_tmp;
 	public:
 		RcvMsg();
@@ -385,6 +395,7 @@ protected:
 	int	ignore_next_encode_eom;
 	int	ignore_next_decode_eom;
 	float _bytes_sent, _bytes_recvd;
+	filesize_t m_zero_copy_bytes;
 
 	int is_client;
 	char *hostAddr;
@@ -432,6 +443,7 @@ private:
 	void init();				/* shared initialization method */
 
 	bool connect_socketpair_impl( ReliSock & dest, condor_protocol proto, bool isLoopback );
+	int put_file_impl( filesize_t *size, int fd, filesize_t offset, filesize_t max_bytes, bool range, class DCTransferQueue *xfer_q );
 	std::function<void(void)> m_xfer_alive_callback;
 };
 
@@ -29,12 +29,22 @@
 #include "classy_counted_ptr.h"
 #include "cedar_enums.h"
 
+#include <unordered_map>
+
 enum CONDOR_MD_MODE {
     MD_OFF        = 0,         // off
     MD_ALWAYS_ON,              // always on, condor will check MAC automatically
     MD_EXPLICIT                // user needs to call checkMAC explicitly
 };
 
+/// The attribute names that putClassAd() and getClassAd() refer to by
+/// position on a connection that uses the binary ClassAd encoding.
+/// Each direction of the connection has its own list.
+struct ClassAdWireNames {
+	std::unordered_map<std::string, unsigned int> sent;
+	std::vector<std::string> received;
+};
+
 const int CLEAR_HEADER     = 0;
 const int MD_IS_ON         = 1;
 const int ENCRYPTION_IS_ON = 2;
@@ -463,6 +473,20 @@ public:
 	/// Set the peer's version.
 	void set_peer_version(CondorVersionInfo const *version);
 
+	/// True if the peer said in the security handshake that it can
+	/// read ClassAds in the binary encoding.
+	bool peer_reads_binary_classads() const;
+
+	void set_peer_reads_binary_classads(bool reads);
+
+	/// The attribute names this connection has agreed on with its peer
+	/// for the binary ClassAd encoding, created on first use.  NULL for
+	/// streams that can lose or reorder messages.
+	ClassAdWireNames *classad_wire_names();
+
+	/// Forget the agreed names, e.g. when the connection is closed.
+	void reset_classad_wire_names();
+
 	/** Get this stream's type.
         @return the type of this stream
     */
@@ -551,6 +575,8 @@ protected:
 	int decrypt_buf_len;
 	char *m_peer_description_str;
 	CondorVersionInfo *m_peer_version;
+	bool m_peer_reads_binary_classads;
+	ClassAdWireNames *m_classad_wire_names;
 
 	time_t m_deadline_time;
 	static int timeout_multiplier;
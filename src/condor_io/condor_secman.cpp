@@ -1568,6 +1568,12 @@ SecManStartCommand::sendAuthInfo_inner()
 			}
 		}
 
+		// Go by what the peer said it could read when the session was made,
+		// until the server's response to the resume says otherwise.
+		bool peer_binary_classads = false;
+		m_auth_info.LookupBool(ATTR_SEC_BINARY_CLASSADS, peer_binary_classads);
+		m_sock->set_peer_reads_binary_classads(peer_binary_classads);
+
 		if (!param_boolean("SEC_ENABLE_RESUME_SERVER_RESPONSE", true)) {
 			dprintf(D_SECURITY, "SECMAN: Requesting no server response to resume due to configuration\n");
 			m_want_resume_response = false;
@@ -1763,6 +1769,7 @@ SecManStartCommand::sendAuthInfo_inner()
 
 	// fill in our version
 	m_auth_info.Assign(ATTR_SEC_REMOTE_VERSION,CondorVersion());
+	m_auth_info.Assign(ATTR_SEC_BINARY_CLASSADS, true);
 
 	// fill in return address, if we are a daemon
 	char const* dcss = global_dc_sinful();
@@ -2098,6 +2105,11 @@ SecManStartCommand::receiveAuthInfo_inner()
 				CondorVersionInfo ver_info(m_remote_version.c_str());
 				m_sock->set_peer_version(&ver_info);
 			}
+			bool peer_binary_classads = false;
+			m_auth_info.Delete(ATTR_SEC_BINARY_CLASSADS);
+			m_sec_man.sec_copy_attribute( m_auth_info, auth_response, ATTR_SEC_BINARY_CLASSADS );
+			m_auth_info.LookupBool(ATTR_SEC_BINARY_CLASSADS, peer_binary_classads);
+			m_sock->set_peer_reads_binary_classads(peer_binary_classads);
 			m_sec_man.sec_copy_attribute( m_auth_info, auth_response, ATTR_SEC_ENACT );
 			m_sec_man.sec_copy_attribute( m_auth_info, auth_response, ATTR_SEC_AUTHENTICATION_METHODS_LIST );
 			m_sec_man.sec_copy_attribute( m_auth_info, auth_response, ATTR_SEC_AUTHENTICATION_METHODS );
@@ -2310,6 +2322,9 @@ SecManStartCommand::authenticate_inner()
 					CondorVersionInfo ver_info(peer_version.c_str());
 					m_sock->set_peer_version(&ver_info);
 				}
+				bool peer_binary_classads = false;
+				auth_response.LookupBool(ATTR_SEC_BINARY_CLASSADS, peer_binary_classads);
+				m_sock->set_peer_reads_binary_classads(peer_binary_classads);
 			}
 		}
 	}
@@ -3314,6 +3329,7 @@ SecMan::SecMan() :
 		m_resume_proj.insert(ATTR_SEC_NONCE);
 		m_resume_proj.insert(ATTR_SEC_RESUME_RESPONSE);
 		m_resume_proj.insert(ATTR_SEC_REMOTE_VERSION);
+		m_resume_proj.insert(ATTR_SEC_BINARY_CLASSADS);
 	}
 
 	if ( NULL == m_ipverify ) {
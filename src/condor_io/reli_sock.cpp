@@ -40,6 +40,9 @@
 #ifdef WIN32
 #include <mswsock.h>	// For TransmitFile()
 #endif
+#ifdef LINUX
+#include <sys/sendfile.h>	// For sendfile()
+#endif
 
 #define NORMAL_HEADER_SIZE 5
 #define MAX_HEADER_SIZE MAC_SIZE + NORMAL_HEADER_SIZE
@@ -64,6 +67,7 @@ ReliSock::init()
 	ignore_next_decode_eom = FALSE;
 	_bytes_sent = 0.0;
 	_bytes_recvd = 0.0;
+	m_zero_copy_bytes = 0;
 	_special_state = relisock_none;
 	is_client = 0;
 	hostAddr = NULL;
@@ -107,6 +111,9 @@ ReliSock::ReliSock(const ReliSock & orig) : Sock(orig),
 	std::string buf;
 	orig.serialize(buf);	// get state from orig sock
 	deserialize(buf.c_str());	// put the state into the new sock
+	if ( orig.m_classad_wire_names ) {
+		m_classad_wire_names = new ClassAdWireNames(*orig.m_classad_wire_names);
+	}
 }
 
 Stream *
@@ -148,6 +155,7 @@ ReliSock::close()
 	m_final_recv_header = false;
 	m_send_md_ctx.reset();
 	m_recv_md_ctx.reset();
+	reset_classad_wire_names();
 
 	// then invoke close() in parent class to close fd etc
 	return Sock::close();
@@ -796,6 +804,7 @@ ReliSock::RcvMsg :: RcvMsg() :
 	m_remaining_read_length(0),
 	m_len_t(0),
 	m_end(0),
+	m_partial_hdr_len(0),
 	m_tmp(NULL),
 	ready(0),
 	m_closed(false)
@@ -837,12 +846,26 @@ int ReliSock::RcvMsg::rcv_packet( char const *peer_description, SOCKET _sock, ti
 
 	header_filled = 0;
 
-	retval = condor_read(peer_description,_sock,hdr,header_size,_timeout, 0, p_sock->is_non_blocking());
+	// We read the start of the header in a previous non-blocking read.
+	if (m_partial_hdr_len > 0) {
+		memcpy(hdr, m_partial_hdr, m_partial_hdr_len);
+		header_filled = m_partial_hdr_len;
+		m_partial_hdr_len = 0;
+	}
+
+	retval = condor_read(peer_description,_sock,hdr+header_filled,header_size-header_filled,_timeout, 0, p_sock->is_non_blocking());
 	if ( retval == 0 ) {   // 0 means that the read would have blocked; unlike a normal read(), condor_read
 	                       // returns -2 if the socket has been closed.
 		dprintf(D_NETWORK, "Reading header would have blocked.\n");
+		if (header_filled) {
+			memcpy(m_partial_hdr, hdr, header_filled);
+			m_partial_hdr_len = header_filled;
+		}
 		return 2;
 	}
+	if ( retval > 0 ) {
+		retval += header_filled;
+	}
 
 	// Block on short reads for the header.  Since the header is very short (typically, 5 bytes),
 	// we don't care to gracefully handle the case where it has been fragmented over multiple
@@ -866,9 +889,17 @@ int ReliSock::RcvMsg::rcv_packet( char const *peer_description, SOCKET _sock, ti
 			goto check_header; // jump down to a check we now know will fail
 		}
 
+		// In non-blocking mode, keep what we have and finish the header
+		// when the rest of it arrives, rather than waiting for it here.
+		if ( p_sock->is_non_blocking() ) {
+			dprintf(D_NETWORK, "Reading remainder of header would have blocked.\n");
+			memcpy(m_partial_hdr, hdr, retval);
+			m_partial_hdr_len = retval;
+			return 2;
+		}
+
 		dprintf(D_NETWORK, "Force-reading remainder of header.\n");
-		retval = condor_read(peer_description, _sock, hdr+retval, header_size-retval,
-			p_sock->is_non_blocking() ? 1 : _timeout);
+		retval = condor_read(peer_description, _sock, hdr+retval, header_size-retval, _timeout);
 	}
 
 	if ( retval < 0 && 
@@ -1863,6 +1894,79 @@ const int GET_FILE_NULL_FD = -10;
 const size_t OLD_FILE_BUF_SZ = 65536;
 const size_t AES_FILE_BUF_SZ = 262144;
 
+#if defined(LINUX)
+// Wait until the socket is ready for the given kind of i/o, giving up
+// after timeout seconds the way condor_read() and condor_write() do.
+// A timeout of 0 waits forever.
+static bool
+wait_for_sock( char const *peer_description, int sock, Selector::IO_FUNC io, time_t timeout )
+{
+	Selector selector;
+	selector.add_fd( sock, io );
+	time_t deadline = timeout > 0 ? time(nullptr) + timeout : 0;
+
+	while ( true ) {
+		if ( deadline ) {
+			time_t now = time(nullptr);
+			if ( now >= deadline ) {
+				break;
+			}
+			selector.set_timeout( deadline - now );
+		}
+		selector.execute();
+		if ( selector.signalled() ) {
+			continue;
+		}
+		if ( selector.has_ready() ) {
+			return true;
+		}
+		if ( ! selector.timed_out() ) {
+			dprintf( D_ALWAYS, "ReliSock: select() returned %d waiting for %s (errno=%d %s)\n",
+					 selector.select_retval(), peer_description, errno, strerror(errno) );
+			return false;
+		}
+		break;
+	}
+	dprintf( D_ALWAYS, "ReliSock: timed out waiting for %s\n", peer_description );
+	return false;
+}
+
+// Move len bytes that are sitting in a pipe into fd with ordinary reads and
+// writes.  This is used when splice() can't write to fd.  If fd is
+// GET_FILE_NULL_FD, or a write fails, the data is read and thrown away so
+// the pipe is always left empty.  Returns the number of bytes written to
+// fd, and sets write_errno if a write failed.
+static ssize_t
+drain_pipe( int pipe_fd, ssize_t len, int fd, char *buf, size_t buf_sz, int & write_errno )
+{
+	ssize_t written = 0;
+	while ( len > 0 ) {
+		ssize_t nrd = ::read( pipe_fd, buf, MIN( (size_t)len, buf_sz ) );
+		if ( nrd < 0 && errno == EINTR ) {
+			continue;
+		}
+		if ( nrd <= 0 ) {
+			break;
+		}
+		len -= nrd;
+		for ( ssize_t off = 0; fd != GET_FILE_NULL_FD && off < nrd; ) {
+			ssize_t nw = ::write( fd, buf + off, nrd - off );
+			if ( nw < 0 && errno == EINTR ) {
+				continue;
+			}
+			if ( nw <= 0 ) {
+				write_errno = nw < 0 ? errno : EIO;
+				fd = GET_FILE_NULL_FD;
+				break;
+			}
+			off += nw;
+			written += nw;
+		}
+	}
+	return written;
+}
+#endif
+
 int
 ReliSock::get_file( filesize_t *size, const char *destination,
 					bool flush_buffers, bool append, filesize_t max_bytes,
@@ -1986,6 +2090,123 @@ ReliSock::get_file( filesize_t *size, int fd,
 		  RSC in the syscall library.  this code isn't like that.
 		*/
 
+#if defined(LINUX)
+	// If the data isn't encrypted, it arrives on the socket exactly as it
+	// goes into the file, so we can have the kernel splice() it from the
+	// socket into the file through a pipe without it ever being copied
+	// into our buffer.  splice() can't write to a file opened for append,
+	// and if it fails before anything has been received, we just fall
+	// back to the ordinary loop below.
+	if ( !get_encryption() && !append && fd != GET_FILE_NULL_FD &&
+		 total < bytes_to_receive && param_boolean("ENABLE_ZERO_COPY_FILE_TRANSFER", true) )
+	{
+		int pipe_fds[2];
+		if ( !prepare_for_nobuffering(stream_decode) ) {
+			dprintf( D_ALWAYS, "get_file: prepare_for_nobuffering() failed!\n" );
+			return -1;
+		}
+		if ( pipe2(pipe_fds, O_CLOEXEC) < 0 ) {
+			dprintf( D_FULLDEBUG, "get_file: pipe2() failed (errno=%d), not using splice()\n", errno );
+		} else {
+			// a bigger pipe means fewer trips through the kernel
+			int pipe_sz = fcntl( pipe_fds[1], F_SETPIPE_SZ, (int)AES_FILE_BUF_SZ );
+			if ( pipe_sz <= 0 ) {
+				pipe_sz = (int)OLD_FILE_BUF_SZ;
+			}
+
+			bool use_splice = true;
+			while( use_splice && total < bytes_to_receive ) {
+				struct timeval t1,t2;
+				if( xfer_q ) {
+					condor_gettimestamp(t1);
+					this->XferPingAliveTime();
+				}
+
+				if ( !wait_for_sock( peer_description(), _sock, Selector::IO_READ, _timeout ) ) {
+					::close( pipe_fds[0] );
+					::close( pipe_fds[1] );
+					return -1;
+				}
+				size_t iosize = (size_t) MIN( (filesize_t) pipe_sz, bytes_to_receive - total );
+				ssize_t nbytes = splice( _sock, nullptr, pipe_fds[1], nullptr, iosize, SPLICE_F_MOVE );
+				if ( nbytes < 0 && (errno == EINTR || errno == EAGAIN) ) {
+					continue;
+				}
+				if ( nbytes < 0 && total == 0 && (errno == EINVAL || errno == ENOSYS) ) {
+					dprintf( D_FULLDEBUG, "get_file: splice() from socket not supported (errno=%d), "
+							 "falling back to read()\n", errno );
+					break;
+				}
+				if ( nbytes <= 0 ) {
+					dprintf( D_ALWAYS, "get_file: splice() from %s returned %d (errno=%d %s)\n",
+							 peer_description(), (int)nbytes, errno, strerror(errno) );
+					::close( pipe_fds[0] );
+					::close( pipe_fds[1] );
+					return -1;
+				}
+				_bytes_recvd += nbytes;
+
+				if( xfer_q ) {
+					condor_gettimestamp(t2);
+					xfer_q->AddUsecNetRead(timersub_usec(t2, t1));
+				}
+
+				ssize_t spliced = 0;
+				while ( spliced < nbytes ) {
+					ssize_t rval = splice( pipe_fds[0], nullptr, fd, nullptr, nbytes - spliced, SPLICE_F_MOVE );
+					if ( rval < 0 && errno == EINTR ) {
+						continue;
+					}
+					if ( rval <= 0 ) {
+						break;
+					}
+					spliced += rval;
+				}
+				m_zero_copy_bytes += spliced;
+
+				if ( spliced < nbytes ) {
+						// Either splice() can't write to this file, or the
+						// write itself failed.  Find out which by writing
+						// what's left in the pipe the ordinary way, and
+						// use the ordinary loop for the rest of the file.
+					int write_errno = 0;
+					drain_pipe( pipe_fds[0], nbytes - spliced, fd, buf.get(), buf_sz, write_errno );
+					if ( write_errno ) {
+						saved_errno = write_errno;
+						dprintf( D_ALWAYS,
+								 "ReliSock::get_file: write() failed: %s (errno=%d)\n",
+								 strerror(write_errno), write_errno );
+							// Continue reading data, but throw it all away.
+						fd = GET_FILE_NULL_FD;
+						retval = GET_FILE_WRITE_FAILED;
+					}
+					use_splice = false;
+				}
+
+				if( xfer_q ) {
+					condor_gettimestamp(t1);
+					xfer_q->AddUsecFileWrite(timersub_usec(t1, t2));
+					xfer_q->AddBytesReceived(nbytes);
+					xfer_q->ConsiderSendingReport(t1.tv_sec);
+				}
+
+				total += nbytes;
+				if( max_bytes >= 0 && total > max_bytes ) {
+						// See the comment about this in the loop below.
+					dprintf( D_ALWAYS, "get_file: aborting after downloading %ld of %ld bytes, because max transfer size is exceeded.\n",
+							 (long int)total,
+							 (long int)bytes_to_receive);
+					::close( pipe_fds[0] );
+					::close( pipe_fds[1] );
+					return GET_FILE_MAX_BYTES_EXCEEDED;
+				}
+			}
+			::close( pipe_fds[0] );
+			::close( pipe_fds[1] );
+		}
+	}
+#endif
+
 	// Now, read it all in & save it
 	while( total < bytes_to_receive ) {
 		struct timeval t1,t2;
@@ -2205,6 +2426,20 @@ ReliSock::put_file( filesize_t *size, const char *source, filesize_t offset, fil
 
 int
 ReliSock::put_file( filesize_t *size, int fd, filesize_t offset, filesize_t max_bytes, DCTransferQueue *xfer_q )
+{
+	return put_file_impl( size, fd, offset, max_bytes, false, xfer_q );
+}
+
+int
+ReliSock::put_file_range( filesize_t *size, int fd, filesize_t offset, filesize_t length, DCTransferQueue *xfer_q )
+{
+	return put_file_impl( size, fd, offset, length, true, xfer_q );
+}
+
+// With range, max_bytes is the length of the piece of the file to send,
+// and stopping there is not an error.
+int
+ReliSock::put_file_impl( filesize_t *size, int fd, filesize_t offset, filesize_t max_bytes, bool range, DCTransferQueue *xfer_q )
 {
 	filesize_t	filesize;
 	filesize_t	total = 0;
@@ -2255,7 +2490,7 @@ ReliSock::put_file( filesize_t *size, int fd, filesize_t offset, filesize_t max_
 	bool max_bytes_exceeded = false;
 	if( max_bytes >= 0 && bytes_to_send > max_bytes ) {
 		bytes_to_send = max_bytes;
-		max_bytes_exceeded = true;
+		max_bytes_exceeded = ! range;
 	}
 
 	// Send the file size to the receiver
@@ -2328,6 +2563,75 @@ ReliSock::put_file( filesize_t *size, int fd, filesize_t offset, filesize_t max_
 		}
 #endif
 
+#if defined(LINUX)
+		// On Linux, if we don't need encryption, have the kernel send the
+		// file straight from the page cache with sendfile(), rather than
+		// copying it through our buffer.  If sendfile() can't handle this
+		// file, we fall back to the ordinary loop below.
+		if ( !get_encryption() && param_boolean("ENABLE_ZERO_COPY_FILE_TRANSFER", true) ) {
+
+			// First drain outgoing buffers
+			if ( !prepare_for_nobuffering(stream_encode) ) {
+				dprintf(D_ALWAYS,
+						"ReliSock: put_file: failed to drain buffers!\n");
+				return -1;
+			}
+
+			// sendfile() doesn't move the file position, so start from
+			// wherever it is, and put it where the loop below expects it
+			// when we're done.
+			off_t file_pos = lseek( fd, 0, SEEK_CUR );
+			off_t start_pos = file_pos;
+			while ( file_pos >= 0 && total < bytes_to_send ) {
+				struct timeval t1;
+				struct timeval t2;
+				if( xfer_q ) {
+					condor_gettimestamp(t1);
+					this->XferPingAliveTime();
+				}
+
+				if ( !wait_for_sock( peer_description(), _sock, Selector::IO_WRITE, _timeout ) ) {
+					return -1;
+				}
+				size_t iosize = (size_t) MIN( (filesize_t) AES_FILE_BUF_SZ, bytes_to_send - total );
+				ssize_t nbytes = sendfile( _sock, fd, &file_pos, iosize );
+				if ( nbytes < 0 && (errno == EINTR || errno == EAGAIN) ) {
+					continue;
+				}
+				if ( nbytes < 0 && total == 0 && (errno == EINVAL || errno == ENOSYS) ) {
+					dprintf( D_FULLDEBUG, "put_file: sendfile() not supported (errno=%d), "
+							 "falling back to read()\n", errno );
+					break;
+				}
+				if ( nbytes < 0 ) {
+					dprintf( D_ALWAYS, "ReliSock::put_file: sendfile() to %s failed (errno=%d %s)\n",
+							 peer_description(), errno, strerror(errno) );
+					return -1;
+				}
+				if ( nbytes == 0 ) {
+						// the file is shorter than it was when we
+						// started; the loop below will notice too
+					break;
+				}
+
+				if( xfer_q ) {
+						// As with TransmitFile(), we don't know how much
+						// of this was disk i/o, so it is all network time.
+					condor_gettimestamp(t2);
+					xfer_q->AddUsecNetWrite(timersub_usec(t2, t1));
+					xfer_q->AddBytesSent(nbytes);
+					xfer_q->ConsiderSendingReport(t2.tv_sec);
+				}
+				total += nbytes;
+				_bytes_sent += nbytes;
+				m_zero_copy_bytes += nbytes;
+			}
+			if ( total > 0 && total < bytes_to_send ) {
+				lseek( fd, start_pos + total, SEEK_SET );
+			}
+		}
+#endif
+
 		std::unique_ptr<char[]> buf(new char[buf_sz]);
 		int nbytes, nrd;
 
@@ -2422,7 +2726,7 @@ ReliSock::put_file( filesize_t *size, int fd, filesize_t offset, filesize_t max_
 		return PUT_FILE_MAX_BYTES_EXCEEDED;
 	}
 
-	*size = filesize;
+	*size = range ? bytes_to_send : filesize;
 	return 0;
 }
 
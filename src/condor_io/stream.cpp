@@ -66,6 +66,8 @@ Stream :: Stream() :
 	decrypt_buf_len(0),
 	m_peer_description_str(NULL),
 	m_peer_version(NULL),
+	m_peer_reads_binary_classads(false),
+	m_classad_wire_names(NULL),
 	m_deadline_time(0),
 	ignore_timeout_multiplier(false)
 {
@@ -99,6 +101,7 @@ Stream :: ~Stream()
 	if( m_peer_version ) {
 		delete m_peer_version;
 	}
+	delete m_classad_wire_names;
 }
 
 int 
@@ -1247,6 +1250,39 @@ Stream::set_peer_version(CondorVersionInfo const *version)
 	}
 }
 
+bool
+Stream::peer_reads_binary_classads() const
+{
+	return m_peer_reads_binary_classads;
+}
+
+void
+Stream::set_peer_reads_binary_classads(bool reads)
+{
+	m_peer_reads_binary_classads = reads;
+}
+
+ClassAdWireNames *
+Stream::classad_wire_names()
+{
+		// a name is only known to the peer if every message that came
+		// before it arrived, in order
+	if( type() != reli_sock ) {
+		return NULL;
+	}
+	if( ! m_classad_wire_names ) {
+		m_classad_wire_names = new ClassAdWireNames;
+	}
+	return m_classad_wire_names;
+}
+
+void
+Stream::reset_classad_wire_names()
+{
+	delete m_classad_wire_names;
+	m_classad_wire_names = NULL;
+}
+
 void
 Stream::set_deadline_timeout(int t)
 {
@@ -0,0 +1,163 @@
+/***************************************************************
+ *
+ * Copyright (C) 2025, Condor Team, Computer Sciences Department,
+ * University of Wisconsin-Madison, WI.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you
+ * may not use this file except in compliance with the License.  You may
+ * obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ ***************************************************************/
+
+// Check that MatchCache only ever answers with what a fresh evaluation
+// would have said, across cycles where slots change, come and go, and
+// refer to things that can't be cached.
+
+#include "condor_common.h"
+#include "condor_classad.h"
+#include "condor_attributes.h"
+#include "compat_classad_util.h"
+#include "matchmaker_match_cache.h"
+
+#include <string>
+#include <vector>
+
+static const char * slot_ads[] = {
+	"[ Name = \"slot1@a\"; Memory = 2048; Cpus = 1; Requirements = TARGET.RequestMemory <= MY.Memory ]",
+	"[ Name = \"slot1@b\"; Memory = 8192; Cpus = 8; Requirements = TARGET.RequestMemory <= Memory && TARGET.Owner != \"bad\" ]",
+	"[ Name = \"slot1@c\"; Memory = 4096; Cpus = 4; Requirements = MY.CurrentTime > 0 ]",
+	"[ Name = \"slot1@d\"; Memory = 4096; Cpus = 4; Requirements = true; Busy = RemoteUserPrio > 10 ]",
+	"[ Name = \"slot1@e\"; Memory = 16384; Cpus = 2; Requirements = time() > 0 && TARGET.RequestMemory < 10000 ]",
+};
+
+static const char * job_ads[] = {
+	"[ Owner = \"alice\"; RequestMemory = 4096; Requirements = TARGET.Memory >= RequestMemory ]",
+	"[ Owner = \"bob\"; RequestMemory = 4096; Requirements = TARGET.Memory >= RequestMemory ]",
+	"[ Owner = \"bad\"; RequestMemory = 1024; Requirements = TARGET.Cpus >= 1 ]",
+	"[ Owner = \"alice\"; RequestMemory = 1024; Requirements = TARGET.Cpus > 2 && TARGET.Busy =!= true ]",
+	"[ Owner = \"alice\"; RequestMemory = 1024; Requirements = TARGET.Cpus > 2 && CurrentTime > 0 ]",
+};
+
+static const char * job_attrs = "RequestMemory,Owner";
+
+static bool
+is_a_match(ClassAd &job, ClassAd &slot)
+{
+	classad::MatchClassAd mad;
+	mad.ReplaceLeftAd(&job);
+	mad.ReplaceRightAd(&slot);
+	bool result = mad.symmetricMatch();
+	mad.RemoveLeftAd();
+	mad.RemoveRightAd();
+	return result;
+}
+
+static std::vector<ClassAd *>
+make_slots(int cycle)
+{
+	classad::ClassAdParser parser;
+	std::vector<ClassAd *> slots;
+	for (const char * text : slot_ads) {
+		ClassAd * ad = new ClassAd;
+		parser.ParseClassAd(text, *ad, true);
+		ad->Assign(ATTR_UPDATE_SEQUENCE_NUMBER, 1);
+		slots.push_back(ad);
+	}
+		// the first slot changes every cycle, and from the third cycle on
+		// the second has gone away
+	slots[0]->Assign(ATTR_UPDATE_SEQUENCE_NUMBER, cycle + 1);
+	slots[0]->Assign(ATTR_MEMORY, (cycle % 2) ? 8192 : 2048);
+	if (cycle >= 2) {
+		delete slots[1];
+		slots.erase(slots.begin() + 1);
+	}
+	return slots;
+}
+
+int
+main( int /* argc */, char ** /* argv */ ) {
+	classad::ClassAdParser parser;
+	std::vector<ClassAd *> jobs;
+	for (const char * text : job_ads) {
+		ClassAd * ad = new ClassAd;
+		if ( ! parser.ParseClassAd(text, *ad, true)) {
+			fprintf(stderr, "failed to parse %s\n", text);
+			return 1;
+		}
+		jobs.push_back(ad);
+	}
+
+	MatchCache cache;
+	cache.SetMaxEntries(3);
+
+	unsigned failures = 0;
+	unsigned hits = 0;
+	for (int cycle = 0; cycle < 4; ++cycle) {
+		std::vector<ClassAd *> slots = make_slots(cycle);
+		cache.BeginCycle(slots, job_attrs, [](ClassAd *) { return false; });
+
+			// slot1@c and slot1@e look at the time
+		if (cache.numCacheableSlots() != slots.size() - 2) {
+			++failures;
+			fprintf(stderr, "cycle %d: %zu cacheable slots, expected %zu\n",
+				cycle, cache.numCacheableSlots(), slots.size() - 2);
+		}
+
+		for (size_t j = 0; j < jobs.size(); ++j) {
+			MatchCache::Entry * entry = cache.Lookup(*jobs[j]);
+			bool want_entry = (j < 3);
+			if ((entry != nullptr) != want_entry) {
+				++failures;
+				fprintf(stderr, "cycle %d: job %zu %s cacheable\n", cycle, j, entry ? "is" : "is not");
+			}
+			for (ClassAd * slot : slots) {
+				bool matches = is_a_match(*jobs[j], *slot);
+				int cached = cache.Get(entry, slot);
+				if (cached >= 0) {
+					++hits;
+					if ((bool)cached != matches) {
+						++failures;
+						std::string buf;
+						fprintf(stderr, "cycle %d: job %zu cached %d for %s\n", cycle, j, cached,
+							ExprTreeToString(slot, buf));
+					}
+				} else {
+					cache.Put(entry, slot, matches);
+				}
+			}
+		}
+
+		cache.EndCycle();
+		for (ClassAd * ad : slots) {
+			delete ad;
+		}
+	}
+
+	if (hits == 0) {
+		++failures;
+		fprintf(stderr, "the cache never answered anything\n");
+	}
+	if (cache.numEntries() > 3) {
+		++failures;
+		fprintf(stderr, "cache has %zu entries, limit is 3\n", cache.numEntries());
+	}
+
+	for (ClassAd * ad : jobs) {
+		delete ad;
+	}
+
+	if( failures == 0 ) {
+		fprintf( stdout, "All tests passed (%u cache hits).\n", hits );
+		return 0;
+	} else {
+		return 1;
+	}
+}
@@ -51,6 +51,10 @@
 
 #include "matchmaker.h"
 
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
 static int jobsInSlot(ClassAd &job, ClassAd &offer);
 
 // possible outcomes of negotiating with a schedd
@@ -89,6 +93,23 @@ public:
     time_t prefetch_duration;
     double prefetch_cpu_time;
 
+    // time spent in the multi-threaded Requirements/Rank scan
+    // (NEGOTIATOR_NUM_THREADS > 1); cpu time is summed over all threads
+    double parallel_match_duration;
+    double parallel_match_cpu_time;
+    int parallel_match_scans;
+
+    // matchmaking scans narrowed by the slot index, and how many slots
+    // those scans would have looked at vs. how many were skipped
+    int slot_index_scans;
+    long long slot_index_considered;
+    long long slot_index_pruned;
+
+    // slot Requirements results answered from the match cache, and
+    // those that had to be evaluated and were then remembered
+    long long match_cache_hits;
+    long long match_cache_misses;
+
     int total_slots;
     int trimmed_slots;
     int candidate_slots;
@@ -131,6 +152,14 @@ NegotiationCycleStats::NegotiationCycleStats():
     phase4_cpu_time(0.0),
     prefetch_duration(0),
     prefetch_cpu_time(0.0),
+    parallel_match_duration(0.0),
+    parallel_match_cpu_time(0.0),
+    parallel_match_scans(0),
+    slot_index_scans(0),
+    slot_index_considered(0),
+    slot_index_pruned(0),
+    match_cache_hits(0),
+    match_cache_misses(0),
     total_slots(0),
     trimmed_slots(0),
     candidate_slots(0),
@@ -887,6 +916,17 @@ reinitialize ()
 
 	m_staticRanks = param_boolean("NEGOTIATOR_IGNORE_JOB_RANKS", false);
 
+	m_slotIndexAttrs.clear();
+	std::string slot_index_attrs;
+	if (param(slot_index_attrs, "NEGOTIATOR_SLOT_INDEX_ATTRS")) {
+		m_slotIndexAttrs = split(slot_index_attrs);
+	}
+
+		// The config may have changed what the slot or job ads look like
+		// to matchmaking, so start over with an empty match cache.
+	m_matchCache.Flush();
+	m_matchCache.SetMaxEntries(param_integer("NEGOTIATOR_MATCH_CACHE_SIZE", 0, 0));
+
 	if( first_time ) {
 		first_time = false;
 	} else {
@@ -1811,6 +1851,29 @@ Matchmaker::negotiationTime( int /* timerID */ )
 	// available during matchmaking
 	addRemoteUserPrios( startdAds );
 
+		// Index the slots so that matchmakingAlgorithm() can skip the ones
+		// that can't satisfy a job's Requirements.  Slots with a consumption
+		// policy are matched against a modified job ad and are mutated as
+		// jobs match them, so they are never pruned.
+	if ( ! m_slotIndexAttrs.empty()) {
+		m_slotIndex.Build(startdAds, m_slotIndexAttrs, [](ClassAd *ad) { return cp_supports_policy(*ad); });
+		dprintf(D_FULLDEBUG, "Built slot index on %zu attributes over %zu slots\n",
+				m_slotIndexAttrs.size(), startdAds.size());
+	}
+
+		// Tell the match cache which slots it can remember results for.
+		// Slots with a consumption policy, or that want to be reevaluated,
+		// are modified by the negotiator as jobs match them.
+	if (m_matchCache.enabled()) {
+		m_matchCache.BeginCycle(startdAds, job_attr_references, [](ClassAd *ad) {
+			bool reevaluate_ad = false;
+			ad->LookupBool(ATTR_WANT_AD_REVAULATE, reevaluate_ad);
+			return reevaluate_ad || cp_supports_policy(*ad);
+		});
+		dprintf(D_FULLDEBUG, "Match cache has %zu entries, %zu of %zu slots are cacheable\n",
+				m_matchCache.numEntries(), m_matchCache.numCacheableSlots(), startdAds.size());
+	}
+
 	SetupMatchSecurity(submitterAds);
 
     if (hgq_groups.size() <= 1) {
@@ -1896,6 +1959,20 @@ Matchmaker::negotiationTime( int /* timerID */ )
         dprintf(D_ALWAYS, "end sleep: %d seconds\n", insert_duration);
     }
 
+    if (negotiation_cycle_stats[0]->slot_index_considered > 0) {
+        NegotiationCycleStats *s = negotiation_cycle_stats[0];
+        dprintf(D_ALWAYS, "Slot index skipped %lld of %lld slots (%.1f%%) in %d matchmaking scans\n",
+                s->slot_index_pruned, s->slot_index_considered,
+                100.0 * (double)s->slot_index_pruned / (double)s->slot_index_considered,
+                s->slot_index_scans);
+    }
+    if (negotiation_cycle_stats[0]->match_cache_hits + negotiation_cycle_stats[0]->match_cache_misses > 0) {
+        NegotiationCycleStats *s = negotiation_cycle_stats[0];
+        dprintf(D_ALWAYS, "Match cache answered %lld of %lld slot Requirements checks (%.1f%%)\n",
+                s->match_cache_hits, s->match_cache_hits + s->match_cache_misses,
+                100.0 * (double)s->match_cache_hits / (double)(s->match_cache_hits + s->match_cache_misses));
+    }
+
     // ----- Done with the negotiation cycle
     dprintf( D_ALWAYS, "---------- Finished Negotiation Cycle ----------\n" );
 
@@ -4453,6 +4530,30 @@ getSinfulStringProtocolBools( bool isIPv4, bool isIPv6,
 }
 
 
+// The same as mad.symmetricMatch(), with the request (the left ad of mad)
+// evaluating its Requirements through a compiled copy of them.
+static bool
+RequestMatches(ClassAd &request, const classad::CompiledExpr &requirements,
+	classad::MatchClassAd &mad)
+{
+	classad::Value val;
+	bool result = false;
+	if ( ! requirements.Evaluate(request, val) ||
+		 ! val.IsBooleanValueEquiv(result) || ! result) {
+		return false;
+	}
+	return mad.leftMatchesRight();
+}
+
+static bool
+RequestMatches(ClassAd &request, const classad::CompiledExpr &requirements, ClassAd *offer)
+{
+	classad::MatchClassAd *mad = getTheMatchAd(&request, offer);
+	bool result = RequestMatches(request, requirements, *mad);
+	releaseTheMatchAd();
+	return result;
+}
+
 /*
 Warning: scheddAddr may not be the actual address we'll use to contact the
 schedd, thanks to CCB.  It _is_ suitable for use as a unique identifier, for
@@ -4606,14 +4707,54 @@ matchmakingAlgorithm(const char *submitterName, const char *scheddAddr, const ch
 
 	bool allow_pslot_preemption = param_boolean("ALLOW_PSLOT_PREEMPTION", false);
 	double allocatedWeight = 0.0;
-		// Set up for parallel matchmaking, if enabled
-	std::vector<ClassAd *> par_candidates;
-	std::vector<ClassAd *> par_matches;
 
+		// Narrow down the slots to scan using the slot index.  The index
+		// only knows about the job's Requirements, so don't use it when a
+		// non-matching pslot could still be claimed by preempting its
+		// dslots (see pslotMultiMatch).
+	std::vector<ClassAd *> *scanAds = &startdAds;
+	bool jobWantsMultiMatch = false;
+	request.LookupBool(ATTR_WANT_PSLOT_PREEMPTION, jobWantsMultiMatch);
+	bool mustScanAll = ConsiderPreemption && allow_pslot_preemption && jobWantsMultiMatch;
+	if ( ! mustScanAll &&
+		 m_slotIndex.Prune(request, startdAds, m_prunedStartdAds) )
+	{
+		size_t pruned = startdAds.size() - m_prunedStartdAds.size();
+		negotiation_cycle_stats[0]->slot_index_scans++;
+		negotiation_cycle_stats[0]->slot_index_considered += startdAds.size();
+		negotiation_cycle_stats[0]->slot_index_pruned += pruned;
+		dprintf(D_FULLDEBUG, "Slot index pruned %zu of %zu slots\n", pruned, startdAds.size());
+		scanAds = &m_prunedStartdAds;
+	}
+
+		// The request's Requirements are evaluated against every slot
+		// scanned below, so compile them once up front.
+	classad::CompiledExpr requestRequirements;
+	requestRequirements.Compile(request.Lookup(ATTR_REQUIREMENTS));
+
+		// Then drop the slots the match cache already knows this request
+		// doesn't match, from an earlier job with the same signature.
+	MatchCache::Entry *cacheEntry = m_matchCache.Lookup(request);
+	if (cacheEntry && ! mustScanAll) {
+		m_uncachedStartdAds.clear();
+		for (ClassAd *ad : *scanAds) {
+			if (m_matchCache.Get(cacheEntry, ad) == 0) {
+				negotiation_cycle_stats[0]->match_cache_hits++;
+			} else {
+				m_uncachedStartdAds.push_back(ad);
+			}
+		}
+		scanAds = &m_uncachedStartdAds;
+	}
+
+		// Set up for parallel matchmaking, if enabled.  The expensive
+		// Requirements and Rank evaluations are done up front across
+		// threads; the loop below still walks the candidates serially and
+		// in order, so the winner (and tie-breaking) is the same as when
+		// running single threaded.
 	int num_threads =  param_integer("NEGOTIATOR_NUM_THREADS", 1);
 	if (num_threads > 1) {
-		par_candidates = startdAds;
-		ParallelIsAMatch(&request, par_candidates, par_matches, num_threads, false);
+		ParallelMatchAndRank(request, *scanAds, num_threads, m_parallelMatchResults);
 	}
 
 	// scan the offer ads
@@ -4625,7 +4766,9 @@ matchmakingAlgorithm(const char *submitterName, const char *scheddAddr, const ch
 	bool isIPv6 = false;
 	getSinfulStringProtocolBools( false, false, scheddAddr, isIPv4, isIPv6 );
 
-	for (ClassAd *candidate: startdAds) {
+	for (size_t cand_idx = 0; cand_idx < scanAds->size(); ++cand_idx) {
+		ClassAd *candidate = (*scanAds)[cand_idx];
+		const ParallelMatchResult *par_result = (num_threads > 1) ? &m_parallelMatchResults[cand_idx] : nullptr;
 		bool v4 = false;
 		bool v6 = false;
 		candidate->LookupString( "MyAddress", machineAddr );
@@ -4685,12 +4828,20 @@ matchmakingAlgorithm(const char *submitterName, const char *scheddAddr, const ch
         // requested via consumption policy must also be available from
         // the resource
 		bool is_a_match = false;
-		if (num_threads > 1) {
-			is_a_match = cp_sufficient &&
-				(par_matches.end() !=
-					std::find(par_matches.begin(), par_matches.end(), candidate));
+		int cached_match = m_matchCache.Get(cacheEntry, candidate);
+		if (par_result && !has_cp) {
+			is_a_match = par_result->is_a_match;
+		} else if (cached_match >= 0) {
+			is_a_match = cached_match;
+			negotiation_cycle_stats[0]->match_cache_hits++;
 		} else {
-			is_a_match = cp_sufficient && IsAMatch(&request, candidate);
+			// slots with a consumption policy must be matched against the
+			// overridden request, which only this thread has
+			is_a_match = cp_sufficient && RequestMatches(request, requestRequirements, candidate);
+		}
+			// slots with a consumption policy are never cached
+		if (cached_match < 0 && m_matchCache.Put(cacheEntry, candidate, is_a_match)) {
+			negotiation_cycle_stats[0]->match_cache_misses++;
 		}
 
         if (has_cp) {
@@ -4702,8 +4853,6 @@ matchmakingAlgorithm(const char *submitterName, const char *scheddAddr, const ch
 
 		candidateDslotClaims.clear();
 		if (!is_a_match && ConsiderPreemption) {
-			bool jobWantsMultiMatch = false;
-			request.LookupBool(ATTR_WANT_PSLOT_PREEMPTION, jobWantsMultiMatch);
 			if (allow_pslot_preemption && jobWantsMultiMatch) {
 				// Note: after call to pslotMultiMatch(), iff is_a_match == True,
 				// then candidatePreemptState will be updated as well as candidateDslotClaims
@@ -4848,7 +4997,19 @@ matchmakingAlgorithm(const char *submitterName, const char *scheddAddr, const ch
 			}
 		}
 
-		calculateRanks(request, candidate, candidatePreemptState, candidateRankValue, candidatePreJobRankValue, candidatePostJobRankValue, candidatePreemptRankValue);
+		if (par_result && par_result->ranked) {
+			candidatePreJobRankValue = par_result->PreJobRankValue;
+			candidateRankValue = par_result->RankValue;
+			candidatePostJobRankValue = par_result->PostJobRankValue;
+			candidatePreemptRankValue = -(FLT_MAX);
+			if (candidatePreemptState != NO_PREEMPTION) {
+				candidatePreemptRankValue = EvalNegotiatorMatchRank(
+					"PREEMPTION_RANK",PreemptionRank,
+					request, candidate);
+			}
+		} else {
+			calculateRanks(request, candidate, candidatePreemptState, candidateRankValue, candidatePreJobRankValue, candidatePostJobRankValue, candidatePreemptRankValue);
+		}
 
 		if ( MatchList ) {
 			MatchList->add_candidate(
@@ -4951,6 +5112,116 @@ matchmakingAlgorithm(const char *submitterName, const char *scheddAddr, const ch
 	return bestSoFar;
 }
 
+// Evaluate Requirements (both ways) and the job and negotiator ranks of
+// every candidate slot, spread across num_threads OpenMP threads.  Each
+// thread works on its own copy of the request and of the negotiator rank
+// expressions, bound into its own MatchClassAd, and any one slot ad is
+// only ever bound into a single thread's MatchClassAd, so no ClassAd is
+// mutated by two threads at once.  Nothing in here may dprintf or touch
+// Matchmaker state: when an evaluation would have logged a failure we
+// leave the result unranked and matchmakingAlgorithm() redoes it serially.
+void Matchmaker::
+ParallelMatchAndRank(ClassAd &request, std::vector<ClassAd *> &startdAds,
+					 int num_threads, std::vector<ParallelMatchResult> &results)
+{
+	double start_time = _condor_debug_get_time_double();
+	double start_usage = get_rusage_utime();
+
+	int num_ads = (int)startdAds.size();
+	results.assign(num_ads, ParallelMatchResult{false, false, 0.0, 0.0, 0.0});
+	if (num_ads == 0) {
+		return;
+	}
+
+	struct ThreadState {
+		ClassAd request;
+		classad::MatchClassAd mad;
+		ExprTree *preJobRank = nullptr;
+		ExprTree *postJobRank = nullptr;
+		classad::CompiledExpr requirements;
+		classad::CompiledExpr rank;
+		~ThreadState() {
+			mad.RemoveLeftAd();
+			delete preJobRank;
+			delete postJobRank;
+		}
+	};
+	std::unique_ptr<ThreadState[]> states(new ThreadState[num_threads]);
+	for (int t = 0; t < num_threads; t++) {
+		states[t].request.CopyFrom(request);
+		states[t].mad.ReplaceLeftAd(&states[t].request);
+		states[t].requirements.Compile(states[t].request.Lookup(ATTR_REQUIREMENTS));
+		states[t].rank.Compile(states[t].request.Lookup(ATTR_RANK));
+		if (NegotiatorPreJobRank) { states[t].preJobRank = NegotiatorPreJobRank->Copy(); }
+		if (NegotiatorPostJobRank) { states[t].postJobRank = NegotiatorPostJobRank->Copy(); }
+	}
+
+	// evaluate a negotiator rank expression the way EvalNegotiatorMatchRank() does
+	auto eval_negotiator_rank = [](ExprTree *expr, ClassAd *candidate, double &rank) -> bool {
+		rank = -(DBL_MAX);
+		if ( ! expr) {
+			return true;
+		}
+		classad::Value result;
+		double val;
+		expr->SetParentScope(candidate);
+		if ( ! candidate->EvaluateExpr(expr, result, classad::Value::ValueType::NUMBER_VALUES) ||
+			 ! result.IsNumber(val)) {
+			return false;
+		}
+		rank = (float)val;
+		return true;
+	};
+
+	bool want_ranks = ! m_staticRanks;
+
+#ifdef _OPENMP
+	omp_set_num_threads(num_threads);
+#endif
+
+#pragma omp parallel for schedule(dynamic, 64)
+	for (int idx = 0; idx < num_ads; idx++) {
+#ifdef _OPENMP
+		int omp_id = omp_get_thread_num();
+#else
+		int omp_id = 0;
+#endif
+		ThreadState &ts = states[omp_id];
+		ClassAd *candidate = startdAds[idx];
+		ParallelMatchResult &res = results[idx];
+
+		bool has_cp = cp_supports_policy(*candidate);
+		ts.mad.ReplaceRightAd(candidate);
+		res.is_a_match = ! has_cp && RequestMatches(ts.request, ts.requirements, ts.mad);
+
+		if (want_ranks && (res.is_a_match || has_cp)) {
+				// same lookup order as EvalFloat(ATTR_RANK, &request, candidate)
+			double rank = 0.0;
+			if (ts.rank.GetTree()) {
+				classad::Value val;
+				if ( ! ts.rank.Evaluate(ts.request, val, classad::Value::ValueType::NUMBER_VALUES) ||
+					 ! val.IsNumber(rank)) {
+					rank = 0.0;
+				}
+			} else if (candidate->Lookup(ATTR_RANK)) {
+				if ( ! candidate->EvaluateAttrNumber(ATTR_RANK, rank)) { rank = 0.0; }
+			}
+			res.RankValue = rank;
+			res.ranked = eval_negotiator_rank(ts.preJobRank, candidate, res.PreJobRankValue) &&
+			             eval_negotiator_rank(ts.postJobRank, candidate, res.PostJobRankValue);
+		}
+
+		ts.mad.RemoveRightAd();
+	}
+
+	NegotiationCycleStats *stats = negotiation_cycle_stats[0];
+	if (stats) {
+		stats->parallel_match_duration += _condor_debug_get_time_double() - start_time;
+		stats->parallel_match_cpu_time += get_rusage_utime() - start_usage;
+		stats->parallel_match_scans++;
+	}
+}
+
 void Matchmaker::
 insertNegotiatorMatchExprs( std::vector<ClassAd *> &cal )
 {
@@ -5071,6 +5342,10 @@ matchmakingProtocol (ClassAd &request, ClassAd *offer,
 	request.LookupInteger (ATTR_CLUSTER_ID, cluster);
 	request.LookupInteger (ATTR_PROC_ID, proc);
 
+		// The offer is modified below, and may stay in the list of slots
+		// if the match falls through, so stop caching results for it.
+	m_matchCache.Forget(offer);
+
 	bool offline = false;
 	offer->LookupBool(ATTR_OFFLINE,offline);
 	if( offline ) {
@@ -6185,6 +6460,14 @@ SetAttrN( ClassAd *ad, char const *attr, int n, time_t value )
 	ad->Assign(attrn,value);
 }
 
+static void
+SetAttrN( ClassAd *ad, char const *attr, int n, long long value )
+{
+	std::string attrn;
+	formatstr(attrn,"%s%d",attr,n);
+	ad->Assign(attrn,value);
+}
+
 static void
 SetAttrN( ClassAd *ad, char const *attr, int n, double value )
 {
@@ -6240,6 +6523,15 @@ Matchmaker::publishNegotiationCycleStats( ClassAd *ad )
         ATTR_LAST_NEGOTIATION_CYCLE_PIE_SPINS,
         ATTR_LAST_NEGOTIATION_CYCLE_PREFETCH_DURATION,
         ATTR_LAST_NEGOTIATION_CYCLE_PREFETCH_CPU_TIME,
+        ATTR_LAST_NEGOTIATION_CYCLE_PARALLEL_MATCH_DURATION,
+        ATTR_LAST_NEGOTIATION_CYCLE_PARALLEL_MATCH_CPU_TIME,
+        ATTR_LAST_NEGOTIATION_CYCLE_PARALLEL_MATCH_SCANS,
+        ATTR_LAST_NEGOTIATION_CYCLE_SLOT_INDEX_SCANS,
+        ATTR_LAST_NEGOTIATION_CYCLE_SLOT_INDEX_CONSIDERED,
+        ATTR_LAST_NEGOTIATION_CYCLE_SLOT_INDEX_PRUNED,
+        ATTR_LAST_NEGOTIATION_CYCLE_SLOT_INDEX_PRUNE_RATIO,
+        ATTR_LAST_NEGOTIATION_CYCLE_MATCH_CACHE_HITS,
+        ATTR_LAST_NEGOTIATION_CYCLE_MATCH_CACHE_MISSES,
         ATTR_LAST_NEGOTIATION_CYCLE_CPU_TIME,
         ATTR_LAST_NEGOTIATION_CYCLE_PHASE1_CPU_TIME,
         ATTR_LAST_NEGOTIATION_CYCLE_PHASE2_CPU_TIME,
@@ -6295,6 +6587,15 @@ Matchmaker::publishNegotiationCycleStats( ClassAd *ad )
 		SetAttrN( ad, ATTR_LAST_NEGOTIATION_CYCLE_PREFETCH_DURATION, i, s->prefetch_duration );
 		// TODO Should we truncate these to integer values?
 		SetAttrN( ad, ATTR_LAST_NEGOTIATION_CYCLE_PREFETCH_CPU_TIME, i, s->prefetch_cpu_time );
+		SetAttrN( ad, ATTR_LAST_NEGOTIATION_CYCLE_PARALLEL_MATCH_DURATION, i, s->parallel_match_duration );
+		SetAttrN( ad, ATTR_LAST_NEGOTIATION_CYCLE_PARALLEL_MATCH_CPU_TIME, i, s->parallel_match_cpu_time );
+		SetAttrN( ad, ATTR_LAST_NEGOTIATION_CYCLE_PARALLEL_MATCH_SCANS, i, s->parallel_match_scans );
+		SetAttrN( ad, ATTR_LAST_NEGOTIATION_CYCLE_SLOT_INDEX_SCANS, i, s->slot_index_scans );
+		SetAttrN( ad, ATTR_LAST_NEGOTIATION_CYCLE_SLOT_INDEX_CONSIDERED, i, s->slot_index_considered );
+		SetAttrN( ad, ATTR_LAST_NEGOTIATION_CYCLE_SLOT_INDEX_PRUNED, i, s->slot_index_pruned );
+		SetAttrN( ad, ATTR_LAST_NEGOTIATION_CYCLE_SLOT_INDEX_PRUNE_RATIO, i, (s->slot_index_considered > 0) ? (double)s->slot_index_pruned/(double)s->slot_index_considered : 0.0 );
+		SetAttrN( ad, ATTR_LAST_NEGOTIATION_CYCLE_MATCH_CACHE_HITS, i, s->match_cache_hits );
+		SetAttrN( ad, ATTR_LAST_NEGOTIATION_CYCLE_MATCH_CACHE_MISSES, i, s->match_cache_misses );
 		SetAttrN( ad, ATTR_LAST_NEGOTIATION_CYCLE_CPU_TIME, i, s->phase1_cpu_time );
 		SetAttrN( ad, ATTR_LAST_NEGOTIATION_CYCLE_PHASE1_CPU_TIME, i, s->phase1_cpu_time );
 		SetAttrN( ad, ATTR_LAST_NEGOTIATION_CYCLE_PHASE2_CPU_TIME, i, s->phase2_cpu_time );
@@ -6554,6 +6855,9 @@ Matchmaker::pslotMultiMatch(ClassAd *job, ClassAd *machine, const char *submitte
 			// when/if we purge the match list in DeleteMatchList().
 			unmutatedSlotAds.emplace_back(machine, backupAd );
 
+			// Until then, other jobs must be matched against the mutated ad
+			m_matchCache.Forget(machine);
+
 			// Note we do not want to delete backupAd when returning here, since we handed off this
 			// pointer to unmutatedSlotAds above; it will be deleted in DeleteMatchList().
 			return true;
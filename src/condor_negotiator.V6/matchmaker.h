@@ -28,6 +28,8 @@
 #include "dc_collector.h"
 #include "condor_ver_info.h"
 #include "matchmaker_negotiate.h"
+#include "matchmaker_slot_index.h"
+#include "matchmaker_match_cache.h"
 #include "GroupEntry.h"
 
 #include <vector>
@@ -188,6 +190,19 @@ class Matchmaker : public Service
                                       double limitUsed, double limitUsedUnclaimed,
                                       double submitterLimit, double submitterLimitUnclaimed, 
                                       double pieLeft, bool only_for_startdrank);
+
+			// Per-candidate results of the parallel phase of matchmakingAlgorithm(),
+			// indexed the same as startdAds.
+		struct ParallelMatchResult {
+			bool is_a_match;	// symmetric match, not valid for consumption policy slots
+			bool ranked;		// the rank values below were computed
+			double RankValue;
+			double PreJobRankValue;
+			double PostJobRankValue;
+		};
+		void ParallelMatchAndRank(ClassAd &request, std::vector<ClassAd *> &startdAds,
+								  int num_threads, std::vector<ParallelMatchResult> &results);
+		std::vector<ParallelMatchResult> m_parallelMatchResults;
 		int matchmakingProtocol(ClassAd &request, ClassAd *offer, 
 						ClaimIdHash &claimIds, Sock *sock,
 						const char* submitterName, const char* scheddAddr);
@@ -350,6 +365,17 @@ class Matchmaker : public Service
 
 		bool m_staticRanks;
 
+			// per-cycle index of the startd ads, used to skip slots that
+			// can't satisfy a job's Requirements (NEGOTIATOR_SLOT_INDEX_ATTRS)
+		std::vector<std::string> m_slotIndexAttrs;
+		SlotIndex m_slotIndex;
+		std::vector<ClassAd *> m_prunedStartdAds;
+
+			// Requirements results that persist across submitters and
+			// cycles, keyed by request signature (NEGOTIATOR_MATCH_CACHE_SIZE)
+		MatchCache m_matchCache;
+		std::vector<ClassAd *> m_uncachedStartdAds;
+
 		std::map<std::string, std::string> NegotiatorMatchExprs;
 
 		std::map<std::string, time_t> ScheddsTimeInCycle;
@@ -424,7 +450,8 @@ class Matchmaker : public Service
 		    also invoke Matchmaker::DeleteMatchList in the destructor.
 			We want this because DeleteMatchList will dereference pointers
 			to ads in this ClassAdList, so this must hapen before the
-			ads are deleted.
+			ads are deleted.  The slot index is keyed on those same
+			pointers, so it is cleared here too.
 		*/
 		class ClassAdList_DeleteAdsAndMatchList: public ClassAdList
 		{
@@ -433,6 +460,10 @@ class Matchmaker : public Service
 				pMatchmaker(p) {};
 			virtual ~ClassAdList_DeleteAdsAndMatchList() {
 				pMatchmaker->DeleteMatchList();
+				pMatchmaker->m_slotIndex.Clear();
+				pMatchmaker->m_prunedStartdAds.clear();
+				pMatchmaker->m_matchCache.EndCycle();
+				pMatchmaker->m_uncachedStartdAds.clear();
 			};
 		private:
 			Matchmaker * const pMatchmaker;
@@ -0,0 +1,504 @@
+/***************************************************************
+ *
+ * Copyright (C) 2025, Condor Team, Computer Sciences Department,
+ * University of Wisconsin-Madison, WI.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you
+ * may not use this file except in compliance with the License.  You may
+ * obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ ***************************************************************/
+
+#include "condor_common.h"
+#include "condor_classad.h"
+#include "condor_attributes.h"
+#include "compat_classad_util.h"
+#include "stl_string_utils.h"
+#include "matchmaker_match_cache.h"
+
+#include <functional>
+
+	// Generations live in the upper 31 bits of a result
+static const unsigned max_generation = 0x7fffffff;
+
+	// Attributes whose value can change while the ad they are in doesn't.
+	// Most of these are inserted by the negotiator every cycle, some of
+	// them also as slotN_<attr> (see addRemoteUserPrios).
+static const char * const volatile_attrs[] = {
+	ATTR_CURRENT_TIME,
+	ATTR_REMOTE_USER_PRIO,
+	ATTR_REMOTE_USER_RESOURCES_IN_USE,
+	ATTR_REMOTE_GROUP_RESOURCES_IN_USE,
+	ATTR_REMOTE_GROUP_QUOTA,
+	ATTR_REMOTE_GROUP,
+	ATTR_SUBMITTOR_PRIO,
+	ATTR_SUBMITTER_USER_PRIO,
+	ATTR_SUBMITTER_USER_RESOURCES_IN_USE,
+	ATTR_SUBMITTER_GROUP_RESOURCES_IN_USE,
+	ATTR_SUBMITTER_GROUP_QUOTA,
+	ATTR_CURRENT_RANK,
+	ATTR_PREEMPT_STATE_,
+	ATTR_MATCHED_CONCURRENCY_LIMITS,
+	ATTR_RESOURCE_REQUEST_CLUSTER,
+	ATTR_RESOURCE_REQUEST_PROC,
+	"PreemptDslotClaims",
+	"MachineMatchCount",
+	"OfflineMatches",
+};
+
+	// Functions that don't always return the same thing for the same
+	// arguments, or that can look at attributes we can't see.
+static const char * const volatile_functions[] = {
+	"time",
+	"absTime",		// with no arguments, the current time
+	"random",
+	"eval",
+	"ResourcesInUseByUser",
+	"ResourcesInUseByUsersGroup",
+};
+
+static bool
+IsVolatileAttr(const std::string &attr)
+{
+	for (const char *name : volatile_attrs) {
+		size_t len = strlen(name);
+		if (attr.size() < len || strcasecmp(attr.c_str() + attr.size() - len, name) != 0) {
+			continue;
+		}
+			// the attribute itself, or a slotN_ copy of it
+		if (attr.size() == len || attr[attr.size() - len - 1] == '_') {
+			return true;
+		}
+	}
+	return false;
+}
+
+static bool
+IsVolatileFunction(const std::string &fn)
+{
+	for (const char *name : volatile_functions) {
+		if (strcasecmp(fn.c_str(), name) == 0) {
+			return true;
+		}
+	}
+	return false;
+}
+
+enum RefScope { REF_MY, REF_TARGET, REF_UNSCOPED };
+typedef std::pair<RefScope, std::string> AttrRef;
+
+	// Collect the attribute references of an expression in an ad that will
+	// be the left (job) or right (slot) ad of a MatchClassAd.  Returns false
+	// if the expression calls a volatile function or has a reference we
+	// can't pin down to either ad.
+static bool
+CollectRefs(const classad::ExprTree *tree, bool left_ad, std::vector<AttrRef> &refs)
+{
+	if ( ! tree) return true;
+	switch (tree->GetKind()) {
+		case classad::ExprTree::ERROR_LITERAL:
+		case classad::ExprTree::UNDEFINED_LITERAL:
+		case classad::ExprTree::BOOLEAN_LITERAL:
+		case classad::ExprTree::INTEGER_LITERAL:
+		case classad::ExprTree::REAL_LITERAL:
+		case classad::ExprTree::RELTIME_LITERAL:
+		case classad::ExprTree::ABSTIME_LITERAL:
+		case classad::ExprTree::STRING_LITERAL:
+			return true;
+
+		case classad::ExprTree::ATTRREF_NODE: {
+			classad::ExprTree *scope = nullptr;
+			std::string attr;
+			bool absolute = false;
+			((const classad::AttributeReference *)tree)->GetComponents(scope, attr, absolute);
+			if ( ! scope) {
+				if (absolute) {
+					return false;	// .X is an attribute of the match ad
+				}
+				refs.emplace_back(REF_UNSCOPED, attr);
+				return true;
+			}
+			std::string scope_name;
+			bool scope_absolute = false;
+			if ( ! ExprTreeIsAttrRef(scope, scope_name, &scope_absolute)) {
+					// e.g. MY.Foo.Bar, which depends on whatever MY.Foo does
+				return CollectRefs(scope, left_ad, refs);
+			}
+			bool is_left = strcasecmp(scope_name.c_str(), "LEFT") == 0;
+			bool is_right = strcasecmp(scope_name.c_str(), "RIGHT") == 0;
+			if (is_left || is_right) {
+					// .LEFT.X and .RIGHT.X, as made by OptimizeJobAdForMatchmaking()
+				if ( ! scope_absolute) {
+					return false;
+				}
+				refs.emplace_back((is_left == left_ad) ? REF_MY : REF_TARGET, attr);
+			} else if (scope_absolute) {
+				return false;
+			} else if (strcasecmp(scope_name.c_str(), "MY") == 0) {
+				refs.emplace_back(REF_MY, attr);
+			} else if (strcasecmp(scope_name.c_str(), "TARGET") == 0) {
+				refs.emplace_back(REF_TARGET, attr);
+			} else {
+					// Foo.Bar, which depends on whatever Foo does
+				refs.emplace_back(REF_UNSCOPED, scope_name);
+			}
+			return true;
+		}
+
+		case classad::ExprTree::OP_NODE: {
+			classad::Operation::OpKind op;
+			classad::ExprTree *t1, *t2, *t3;
+			((const classad::Operation *)tree)->GetComponents(op, t1, t2, t3);
+			return CollectRefs(t1, left_ad, refs) && CollectRefs(t2, left_ad, refs) && CollectRefs(t3, left_ad, refs);
+		}
+
+		case classad::ExprTree::FN_CALL_NODE: {
+			std::string fnName;
+			std::vector<classad::ExprTree *> args;
+			((const classad::FunctionCall *)tree)->GetComponents(fnName, args);
+			if (IsVolatileFunction(fnName)) {
+				return false;
+			}
+			for (classad::ExprTree *arg : args) {
+				if ( ! CollectRefs(arg, left_ad, refs)) return false;
+			}
+			return true;
+		}
+
+		case classad::ExprTree::CLASSAD_NODE: {
+				// references inside a nested ad might resolve in it, but
+				// treating them as references to the outer ad is only more
+				// conservative
+			std::vector<std::pair<std::string, classad::ExprTree *>> attrs;
+			((const classad::ClassAd *)tree)->GetComponents(attrs);
+			for (auto &[name, expr] : attrs) {
+				if ( ! CollectRefs(expr, left_ad, refs)) return false;
+			}
+			return true;
+		}
+
+		case classad::ExprTree::EXPR_LIST_NODE: {
+			std::vector<classad::ExprTree *> exprs;
+			((const classad::ExprList *)tree)->GetComponents(exprs);
+			for (classad::ExprTree *expr : exprs) {
+				if ( ! CollectRefs(expr, left_ad, refs)) return false;
+			}
+			return true;
+		}
+
+		case classad::ExprTree::EXPR_ENVELOPE:
+			return CollectRefs(SkipExprEnvelope(tree), left_ad, refs);
+	}
+	return false;
+}
+
+void
+MatchCache::SetMaxEntries(size_t max_entries)
+{
+	m_maxEntries = max_entries;
+	if ( ! m_maxEntries) {
+		Flush();
+		return;
+	}
+	while (m_lru.size() > m_maxEntries) {
+		m_entries.erase(m_lru.back().signature);
+		m_lru.pop_back();
+	}
+}
+
+void
+MatchCache::Flush()
+{
+	m_entries.clear();
+	m_lru.clear();
+	m_slots.clear();
+	m_generations.clear();
+	m_freeSerials.clear();
+	m_adSerials.clear();
+	m_taintedSlotAttrs.clear();
+	m_jobAttrsStr.clear();
+	m_jobAttrs.clear();
+}
+
+void
+MatchCache::BumpGeneration(unsigned serial)
+{
+	if (++m_generations[serial] < max_generation) {
+		return;
+	}
+		// Out of generations, start over.  Every result is forgotten, so
+		// resetting them all can't make an old result valid again.
+	m_entries.clear();
+	m_lru.clear();
+	std::fill(m_generations.begin(), m_generations.end(), 1);
+}
+
+void
+MatchCache::BeginCycle(const std::vector<ClassAd *> &slots, const char *job_attrs)
+{
+	m_adSerials.clear();
+	m_taintedSlotAttrs.clear();
+	if ( ! enabled()) {
+		return;
+	}
+	++m_cycle;
+
+	if ( ! job_attrs) job_attrs = "";
+	if (m_jobAttrsStr != job_attrs) {
+		m_jobAttrsStr = job_attrs;
+		m_jobAttrs.clear();
+		for (const auto &attr : split(m_jobAttrsStr)) {
+			m_jobAttrs.insert(attr);
+		}
+		++m_jobAttrsGen;
+	}
+
+	std::string id, name, addr;
+	std::vector<unsigned> duplicates;
+	for (ClassAd *slot : slots) {
+		long long sequence = -1, start_time = 0, heard_from = 0;
+			// Without a sequence number (e.g. an ad stashed from an earlier
+			// cycle) we can't tell when the ad changes.
+		if ( ! slot->LookupString(ATTR_NAME, name) ||
+			 ! slot->LookupInteger(ATTR_UPDATE_SEQUENCE_NUMBER, sequence)) {
+			continue;
+		}
+		if ( ! slot->LookupString(ATTR_STARTD_IP_ADDR, addr)) {
+			addr = "<No Address>";
+		}
+		id = addr;
+		id += ' ';
+		id += name;
+		slot->LookupInteger(ATTR_DAEMON_START_TIME, start_time);
+		slot->LookupInteger(ATTR_LAST_HEARD_FROM, heard_from);
+
+		auto [it, inserted] = m_slots.try_emplace(id);
+		SlotState &state = it->second;
+		if (inserted) {
+			if (m_freeSerials.empty()) {
+				state.serial = (unsigned)m_generations.size();
+				m_generations.push_back(1);
+			} else {
+				state.serial = m_freeSerials.back();
+				m_freeSerials.pop_back();
+			}
+			state.checked_attrs_gen = 0;
+			state.cacheable = false;
+		} else if (state.last_cycle == m_cycle) {
+				// two ads with the same name; cache neither of them
+			duplicates.push_back(state.serial);
+			continue;
+		} else if (state.sequence != sequence || state.start_time != start_time || state.heard_from != heard_from) {
+			BumpGeneration(state.serial);
+			state.checked_attrs_gen = 0;
+		}
+		state.sequence = sequence;
+		state.start_time = start_time;
+		state.heard_from = heard_from;
+		state.last_cycle = m_cycle;
+
+		if (state.checked_attrs_gen != m_jobAttrsGen) {
+			state.cacheable = SlotIsCacheable(slot, state.tainted);
+			state.checked_attrs_gen = m_jobAttrsGen;
+		}
+		if (state.cacheable) {
+			m_adSerials[slot] = state.serial;
+			m_taintedSlotAttrs.insert(state.tainted.begin(), state.tainted.end());
+		}
+	}
+
+	for (unsigned serial : duplicates) {
+		std::erase_if(m_adSerials, [serial](const auto &item) { return item.second == serial; });
+	}
+
+		// Slots that went away; a later slot may reuse the serial, so bump
+		// the generation to invalidate what we know about this one.
+	for (auto it = m_slots.begin(); it != m_slots.end(); ) {
+		if (it->second.last_cycle != m_cycle) {
+			BumpGeneration(it->second.serial);
+			m_freeSerials.push_back(it->second.serial);
+			it = m_slots.erase(it);
+		} else {
+			++it;
+		}
+	}
+}
+
+void
+MatchCache::EndCycle()
+{
+	m_adSerials.clear();
+	m_taintedSlotAttrs.clear();
+}
+
+void
+MatchCache::Forget(const ClassAd *slot)
+{
+		// What we learned before the negotiator changed the ad still holds
+		// for the collector's copy, which is what we see next cycle.
+	m_adSerials.erase(slot);
+}
+
+	// A slot is cacheable if its Requirements can't change without the ad
+	// changing.  Other attributes that could are returned in tainted, since
+	// requests that refer to them can't be cached.
+bool
+MatchCache::SlotIsCacheable(ClassAd *slot, std::vector<std::string> &tainted) const
+{
+	enum { VISITING, CLEAN, TAINTED };
+	std::unordered_map<std::string, int, classad::ClassadAttrNameHash, classad::CaseIgnEqStr> state;
+
+	std::function<bool(const std::string &)> is_tainted = [&](const std::string &attr) -> bool {
+		if (IsVolatileAttr(attr)) {
+			return true;
+		}
+		auto found = state.find(attr);
+		if (found != state.end()) {
+				// a reference loop evaluates to error every time, so it's clean
+			return found->second == TAINTED;
+		}
+		state[attr] = VISITING;
+
+		bool bad = false;
+		std::vector<AttrRef> refs;
+		classad::ExprTree *tree = slot->Lookup(attr);
+		if (tree && ! CollectRefs(tree, false, refs)) {
+			bad = true;
+		}
+		for (const auto &[scope, name] : refs) {
+			if (bad) break;
+			if (scope == REF_TARGET || (scope == REF_UNSCOPED && ! slot->Lookup(name))) {
+					// a job attribute, which had better be in the signature
+				bad = IsVolatileAttr(name) || ! m_jobAttrs.contains(name);
+			} else {
+				bad = is_tainted(name);
+			}
+		}
+		state[attr] = bad ? TAINTED : CLEAN;
+		return bad;
+	};
+
+	tainted.clear();
+	if (is_tainted(ATTR_REQUIREMENTS)) {
+		return false;
+	}
+	for (const auto &[attr, tree] : *slot) {
+		if (is_tainted(attr) && ! IsVolatileAttr(attr)) {
+			tainted.push_back(attr);
+		}
+	}
+	return true;
+}
+
+	// The signature is every job attribute that matching could look at,
+	// starting from the Requirements and the attributes the slots refer
+	// to, as name=value lines.  Attributes the job doesn't have are listed
+	// with no value, since adding them could change the outcome.
+bool
+MatchCache::RequestSignature(ClassAd &request, std::string &signature) const
+{
+	signature.clear();
+	classad::References seen;
+	std::vector<std::string> todo(m_jobAttrs.begin(), m_jobAttrs.end());
+	todo.emplace_back(ATTR_REQUIREMENTS);
+	std::vector<AttrRef> refs;
+	while ( ! todo.empty()) {
+		std::string attr = std::move(todo.back());
+		todo.pop_back();
+		if ( ! seen.insert(attr).second) {
+			continue;
+		}
+		signature += attr;
+		signature += '=';
+		classad::ExprTree *tree = request.Lookup(attr);
+		if (tree) {
+			ExprTreeToString(tree, signature);
+		}
+		signature += '\n';
+		if ( ! tree) {
+			continue;
+		}
+
+		refs.clear();
+		if ( ! CollectRefs(tree, true, refs)) {
+			return false;
+		}
+		for (auto &[scope, name] : refs) {
+			if (scope != REF_MY) {
+					// possibly a slot attribute, which must not be volatile
+				if (IsVolatileAttr(name) || m_taintedSlotAttrs.contains(name)) {
+					return false;
+				}
+			}
+			if (scope != REF_TARGET) {
+				todo.emplace_back(std::move(name));
+			}
+		}
+	}
+	return true;
+}
+
+MatchCache::Entry *
+MatchCache::Lookup(ClassAd &request)
+{
+	if ( ! enabled() || m_adSerials.empty()) {
+		return nullptr;
+	}
+
+	std::string signature;
+	if ( ! RequestSignature(request, signature)) {
+		return nullptr;
+	}
+
+	auto it = m_entries.find(signature);
+	if (it != m_entries.end()) {
+		m_lru.splice(m_lru.begin(), m_lru, it->second);
+		return &*it->second;
+	}
+
+	while ( ! m_lru.empty() && m_lru.size() >= m_maxEntries) {
+		m_entries.erase(m_lru.back().signature);
+		m_lru.pop_back();
+	}
+	m_lru.emplace_front();
+	m_lru.front().signature = std::move(signature);
+	m_entries.emplace(m_lru.front().signature, m_lru.begin());
+	return &m_lru.front();
+}
+
+int
+MatchCache::Get(const Entry *entry, const ClassAd *slot) const
+{
+	auto it = m_adSerials.find(slot);
+	if ( ! entry || it == m_adSerials.end()) {
+		return -1;
+	}
+	unsigned serial = it->second;
+	if (serial >= entry->results.size() || (entry->results[serial] >> 1) != m_generations[serial]) {
+		return -1;
+	}
+	return entry->results[serial] & 1;
+}
+
+bool
+MatchCache::Put(Entry *entry, const ClassAd *slot, bool is_a_match)
+{
+	auto it = m_adSerials.find(slot);
+	if ( ! entry || it == m_adSerials.end()) {
+		return false;
+	}
+	unsigned serial = it->second;
+	if (serial >= entry->results.size()) {
+		entry->results.resize(m_generations.size(), 0);
+	}
+	entry->results[serial] = (m_generations[serial] << 1) | (is_a_match ? 1 : 0);
+	return true;
+}
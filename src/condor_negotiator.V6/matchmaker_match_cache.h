@@ -0,0 +1,150 @@
+/***************************************************************
+ *
+ * Copyright (C) 2025, Condor Team, Computer Sciences Department,
+ * University of Wisconsin-Madison, WI.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you
+ * may not use this file except in compliance with the License.  You may
+ * obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ ***************************************************************/
+
+#ifndef _MATCHMAKER_MATCH_CACHE_H
+#define _MATCHMAKER_MATCH_CACHE_H
+
+#include "condor_classad.h"
+
+#include <list>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+// Cache of job/slot Requirements results that survives across submitters
+// and negotiation cycles, used by matchmakingAlgorithm() so that requests
+// we have seen before only need to look at slots that are new or have
+// changed since the last time.
+//
+// Requests are keyed on their signature: the unparsed Requirements plus
+// every job attribute the slots refer to (the same significant attributes
+// the schedds build their autoclusters from) and everything those refer
+// to in turn.  Two requests with the same signature match the same slots.
+//
+// Slots are identified across cycles by name and address, and each one is
+// given a small integer serial.  A slot's generation is bumped whenever its
+// DaemonStartTime, UpdateSequenceNumber or LastHeardFrom changes (i.e. the
+// collector has a new ad for it), or when it goes away, which invalidates
+// every cached result for that slot at once without touching the entries.
+//
+// Anything that could change between two evaluations against the same
+// pair of ads makes the request or slot uncacheable: CurrentTime, the
+// accounting attributes the negotiator inserts every cycle (RemoteUserPrio,
+// SubmitterUserPrio and friends), and the time(), random() and eval()
+// functions.  Uncacheable requests and slots are evaluated as usual.
+//
+// Slot ads are only compared by address after BeginCycle(); EndCycle()
+// must be called before they are deleted.
+class MatchCache {
+ public:
+	struct Entry;
+
+	MatchCache() : m_maxEntries(0), m_cycle(0), m_jobAttrsGen(1) {}
+
+		// Maximum number of request signatures to remember; 0 disables
+		// the cache.  Entries beyond the new limit are evicted.
+	void SetMaxEntries(size_t max_entries);
+	bool enabled() const { return m_maxEntries > 0; }
+
+		// Forget everything, e.g. on reconfig.
+	void Flush();
+
+		// Called once per cycle with the slots that will be matched against
+		// and the significant job attributes.  Slots for which never_cache
+		// is true are always evaluated.
+	template <class Pred>
+	void BeginCycle(const std::vector<ClassAd *> &slots, const char *job_attrs, Pred never_cache) {
+		std::vector<ClassAd *> cacheable;
+		cacheable.reserve(slots.size());
+		for (ClassAd *slot : slots) {
+			if ( ! never_cache(slot)) {
+				cacheable.push_back(slot);
+			}
+		}
+		BeginCycle(cacheable, job_attrs);
+	}
+	void EndCycle();
+
+		// Find (or create) the entry for this request; nullptr if the
+		// request can't be cached.
+	Entry *Lookup(ClassAd &request);
+
+		// Return 1 if the request of the entry is known to match the slot,
+		// 0 if it is known not to, and -1 if we don't know.
+	int Get(const Entry *entry, const ClassAd *slot) const;
+		// Remember a result; returns false if the slot isn't cacheable.
+	bool Put(Entry *entry, const ClassAd *slot, bool is_a_match);
+
+		// Stop caching a slot for the rest of the cycle, because the
+		// negotiator is about to modify its ad.
+	void Forget(const ClassAd *slot);
+
+	size_t numEntries() const { return m_lru.size(); }
+	size_t numCacheableSlots() const { return m_adSerials.size(); }
+
+	struct Entry {
+		std::string signature;
+			// indexed by slot serial: the slot generation << 1 | is_a_match,
+			// or 0 if never evaluated
+		std::vector<unsigned> results;
+	};
+
+ private:
+	struct SlotState {
+		unsigned serial;
+		long long start_time;
+		long long sequence;
+		long long heard_from;
+		unsigned checked_attrs_gen;	// m_jobAttrsGen when cacheable was computed
+		bool cacheable;
+		std::vector<std::string> tainted;	// see SlotIsCacheable()
+		unsigned last_cycle;
+	};
+
+	void BeginCycle(const std::vector<ClassAd *> &slots, const char *job_attrs);
+	bool SlotIsCacheable(ClassAd *slot, std::vector<std::string> &tainted) const;
+	bool RequestSignature(ClassAd &request, std::string &signature) const;
+	void BumpGeneration(unsigned serial);
+
+	size_t m_maxEntries;
+	unsigned m_cycle;
+
+		// significant job attributes, and a counter bumped when they change
+	std::string m_jobAttrsStr;
+	classad::References m_jobAttrs;
+	unsigned m_jobAttrsGen;
+
+		// slots we know about, by MachineAdID-style name, and the current
+		// generation of each serial
+	std::unordered_map<std::string, SlotState> m_slots;
+	std::vector<unsigned> m_generations;
+	std::vector<unsigned> m_freeSerials;
+
+		// the cacheable slot ads of this cycle, and their attributes
+		// that requests must not refer to
+	std::unordered_map<const ClassAd *, unsigned> m_adSerials;
+	classad::References m_taintedSlotAttrs;
+
+		// most recently used entry first
+	std::list<Entry> m_lru;
+	std::unordered_map<std::string_view, std::list<Entry>::iterator> m_entries;
+};
+
+#endif
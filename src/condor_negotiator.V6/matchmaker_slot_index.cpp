@@ -0,0 +1,297 @@
+/***************************************************************
+ *
+ * Copyright (C) 2025, Condor Team, Computer Sciences Department,
+ * University of Wisconsin-Madison, WI.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you
+ * may not use this file except in compliance with the License.  You may
+ * obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ ***************************************************************/
+
+#include "condor_common.h"
+#include "condor_classad.h"
+#include "condor_attributes.h"
+#include "compat_classad_util.h"
+#include "stl_string_utils.h"
+#include "matchmaker_slot_index.h"
+
+#include <algorithm>
+#include <cmath>
+
+	// Integers beyond this can't be compared exactly as doubles, so
+	// slots with such values are treated as unknown.
+static const double max_exact_double = 9007199254740992.0; // 2^53
+
+void
+SlotIndex::Clear()
+{
+	m_attrs.clear();
+	m_slotIds.clear();
+	m_marks.clear();
+	m_stamp = 0;
+}
+
+void
+SlotIndex::Build(const std::vector<ClassAd *> &slots, const std::vector<std::string> &attrs)
+{
+	Clear();
+	if (attrs.empty()) {
+		return;
+	}
+
+	for (size_t id = 0; id < slots.size(); ++id) {
+		m_slotIds.emplace(slots[id], (int)id);
+	}
+	m_marks.assign(slots.size(), 0);
+
+	classad::Value val;
+	std::string str;
+	std::vector<std::pair<double, int>> numbers;
+	for (const auto &attr : attrs) {
+		AttrIndex &index = m_attrs[attr];
+		numbers.clear();
+		for (size_t id = 0; id < slots.size(); ++id) {
+			classad::ExprTree *tree = slots[id]->Lookup(attr);
+			if ( ! tree) {
+					// evaluates to undefined, which never satisfies a term
+				continue;
+			}
+			double num = 0;
+			if ( ! ExprTreeIsLiteral(tree, val)) {
+				index.others.push_back((int)id);
+			} else if (val.IsStringValue(str)) {
+					// == on strings is case-insensitive
+				lower_case(str);
+				index.strings[str].push_back((int)id);
+			} else if (val.IsNumber(num)) {
+				if (std::isnan(num) || fabs(num) >= max_exact_double) {
+					index.others.push_back((int)id);
+				} else {
+					numbers.emplace_back(num, (int)id);
+				}
+			} else if ( ! val.IsUndefinedValue()) {
+				index.others.push_back((int)id);
+			}
+		}
+		std::sort(numbers.begin(), numbers.end());
+		index.values.reserve(numbers.size());
+		index.value_ids.reserve(numbers.size());
+		for (const auto &[num, id] : numbers) {
+			index.values.push_back(num);
+			index.value_ids.push_back(id);
+		}
+	}
+}
+
+	// Return true if tree is TARGET.attr in a job ad, either as written
+	// (TARGET.attr) or as rewritten by OptimizeJobAdForMatchmaking (.RIGHT.attr)
+static bool
+ExprTreeIsTargetAttrRef(classad::ExprTree *tree, std::string &attr)
+{
+	tree = SkipExprParens(tree);
+	if ( ! tree || tree->GetKind() != classad::ExprTree::ATTRREF_NODE) {
+		return false;
+	}
+	classad::ExprTree *scope = nullptr;
+	bool absolute = false;
+	((classad::AttributeReference *)tree)->GetComponents(scope, attr, absolute);
+	std::string scope_name;
+	if ( ! scope || absolute || ! ExprTreeIsAttrRef(scope, scope_name, &absolute)) {
+		return false;
+	}
+	if (absolute) {
+		return strcasecmp(scope_name.c_str(), "RIGHT") == 0;
+	}
+	return strcasecmp(scope_name.c_str(), "TARGET") == 0;
+}
+
+	// Turn one conjunct of a job's Requirements into the set of slot id
+	// ranges that could satisfy it.  Returns false if the term can't be
+	// answered from the index.
+bool
+SlotIndex::TermRanges(classad::ExprTree *term, std::vector<IdRange> &ranges)
+{
+	ranges.clear();
+	term = SkipExprParens(term);
+	if ( ! term) {
+		return false;
+	}
+
+	std::string attr;
+	classad::Operation::OpKind op = classad::Operation::__NO_OP__;
+	classad::Value val;
+	if (ExprTreeIsTargetAttrRef(term, attr)) {
+			// a bare TARGET.attr, true for any non-zero number
+		op = classad::Operation::NOT_EQUAL_OP;
+		val.SetIntegerValue(0);
+	} else if (term->GetKind() == classad::ExprTree::OP_NODE) {
+		classad::ExprTree *t1, *t2, *t3;
+		((classad::Operation *)term)->GetComponents(op, t1, t2, t3);
+		if (ExprTreeIsTargetAttrRef(t1, attr) && ExprTreeIsLiteral(t2, val)) {
+			// TARGET.attr <op> literal
+		} else if (ExprTreeIsLiteral(t1, val) && ExprTreeIsTargetAttrRef(t2, attr)) {
+				// literal <op> TARGET.attr, flip it around
+			switch (op) {
+			case classad::Operation::LESS_THAN_OP: op = classad::Operation::GREATER_THAN_OP; break;
+			case classad::Operation::LESS_OR_EQUAL_OP: op = classad::Operation::GREATER_OR_EQUAL_OP; break;
+			case classad::Operation::GREATER_THAN_OP: op = classad::Operation::LESS_THAN_OP; break;
+			case classad::Operation::GREATER_OR_EQUAL_OP: op = classad::Operation::LESS_OR_EQUAL_OP; break;
+			default: break;
+			}
+		} else {
+			return false;
+		}
+			// =?= is stricter than ==, so the == candidates are a superset
+		if (op == classad::Operation::META_EQUAL_OP) {
+			op = classad::Operation::EQUAL_OP;
+		}
+	} else {
+		return false;
+	}
+
+	auto it = m_attrs.find(attr);
+	if (it == m_attrs.end()) {
+		return false;
+	}
+	const AttrIndex &index = it->second;
+
+	std::string str;
+	double num = 0;
+	if (val.IsStringValue(str)) {
+		if (op != classad::Operation::EQUAL_OP) {
+			return false;
+		}
+		lower_case(str);
+		auto bucket = index.strings.find(str);
+		if (bucket != index.strings.end()) {
+			ranges.emplace_back(bucket->second.data(), bucket->second.data() + bucket->second.size());
+		}
+	} else if (val.IsNumber(num) && ! std::isnan(num) && fabs(num) < max_exact_double) {
+		const double *begin = index.values.data();
+		const double *end = begin + index.values.size();
+		const double *lo = begin, *hi = end;
+		switch (op) {
+		case classad::Operation::EQUAL_OP:
+			lo = std::lower_bound(begin, end, num);
+			hi = std::upper_bound(lo, end, num);
+			break;
+		case classad::Operation::NOT_EQUAL_OP:
+				// either side of num (also the bare attribute test)
+			lo = std::lower_bound(begin, end, num);
+			hi = std::upper_bound(lo, end, num);
+			ranges.emplace_back(index.value_ids.data(), index.value_ids.data() + (lo - begin));
+			lo = hi;
+			hi = end;
+			break;
+		case classad::Operation::LESS_THAN_OP:
+			hi = std::lower_bound(begin, end, num);
+			break;
+		case classad::Operation::LESS_OR_EQUAL_OP:
+			hi = std::upper_bound(begin, end, num);
+			break;
+		case classad::Operation::GREATER_THAN_OP:
+			lo = std::upper_bound(begin, end, num);
+			break;
+		case classad::Operation::GREATER_OR_EQUAL_OP:
+			lo = std::lower_bound(begin, end, num);
+			break;
+		default:
+			return false;
+		}
+		ranges.emplace_back(index.value_ids.data() + (lo - begin), index.value_ids.data() + (hi - begin));
+	} else {
+		return false;
+	}
+
+	ranges.emplace_back(index.others.data(), index.others.data() + index.others.size());
+	return true;
+}
+
+bool
+SlotIndex::Prune(ClassAd &request, const std::vector<ClassAd *> &slots, std::vector<ClassAd *> &candidates)
+{
+	candidates.clear();
+	if (empty()) {
+		return false;
+	}
+
+	classad::ExprTree *requirements = request.Lookup(ATTR_REQUIREMENTS);
+	if ( ! requirements) {
+		return false;
+	}
+
+		// Split the Requirements on && and look up each term.  The result
+		// can only be true if every term is true.
+	std::vector<std::vector<IdRange>> terms;
+	std::vector<classad::ExprTree *> todo(1, requirements);
+	std::vector<IdRange> ranges;
+	while ( ! todo.empty()) {
+		classad::ExprTree *tree = SkipExprParens(todo.back());
+		todo.pop_back();
+		if (tree && tree->GetKind() == classad::ExprTree::OP_NODE) {
+			classad::Operation::OpKind op;
+			classad::ExprTree *t1, *t2, *t3;
+			((classad::Operation *)tree)->GetComponents(op, t1, t2, t3);
+			if (op == classad::Operation::LOGICAL_AND_OP) {
+				todo.push_back(t2);
+				todo.push_back(t1);
+				continue;
+			}
+		}
+		if (TermRanges(tree, ranges)) {
+			terms.push_back(ranges);
+		}
+	}
+	if (terms.empty()) {
+		return false;
+	}
+
+		// Intersect, starting with the most selective term
+	auto term_size = [](const std::vector<IdRange> &term) {
+		size_t n = 0;
+		for (const auto &[b, e] : term) { n += e - b; }
+		return n;
+	};
+	std::sort(terms.begin(), terms.end(), [&](const std::vector<IdRange> &a, const std::vector<IdRange> &b) {
+		return term_size(a) < term_size(b);
+	});
+
+		// Marks left over from earlier requests are all <= m_stamp, so
+		// the first term marks unconditionally and later terms only
+		// advance slots that passed the term before.
+	if (m_stamp >= UINT_MAX - terms.size() - 1) {
+		std::fill(m_marks.begin(), m_marks.end(), 0);
+		m_stamp = 0;
+	}
+	unsigned pass = m_stamp;
+	bool first = true;
+	for (const auto &term : terms) {
+		for (const auto &[b, e] : term) {
+			for (const int *id = b; id != e; ++id) {
+				if (first || m_marks[*id] == pass) {
+					m_marks[*id] = pass + 1;
+				}
+			}
+		}
+		first = false;
+		++pass;
+	}
+	m_stamp = pass;
+
+	for (ClassAd *slot : slots) {
+		auto it = m_slotIds.find(slot);
+		if (it == m_slotIds.end() || m_marks[it->second] == pass) {
+			candidates.push_back(slot);
+		}
+	}
+	return true;
+}
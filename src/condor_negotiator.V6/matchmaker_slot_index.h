@@ -0,0 +1,101 @@
+/***************************************************************
+ *
+ * Copyright (C) 2025, Condor Team, Computer Sciences Department,
+ * University of Wisconsin-Madison, WI.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you
+ * may not use this file except in compliance with the License.  You may
+ * obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ ***************************************************************/
+
+#ifndef _MATCHMAKER_SLOT_INDEX_H
+#define _MATCHMAKER_SLOT_INDEX_H
+
+#include "condor_classad.h"
+
+#include <map>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Per-cycle index over the startd ads, used by matchmakingAlgorithm() to
+// skip slots that cannot possibly satisfy a job's Requirements before
+// doing a full ClassAd evaluation.
+//
+// For each configured attribute we keep a hash of the (lower-cased) string
+// values, a sorted array of the numeric values, and a list of slots where
+// the attribute is not a literal.  A request's Requirements are split on
+// &&, and each term of the form
+//     TARGET.Attr == "string"
+//     TARGET.Attr <op> number        (op is ==, =?=, !=, <, <=, >, >=)
+//     TARGET.Attr                    (a bare boolean test)
+// selects a candidate set from the index; the candidates for the request
+// are the intersection of those sets.  Any term we don't understand is
+// simply ignored, so the result is always a superset of the slots that
+// match.  This works best on a job ad that has been through
+// OptimizeJobAdForMatchmaking(), since that inlines MY.RequestMemory and
+// friends into literals and turns TARGET.X into .RIGHT.X.
+//
+// Slot ads are never dereferenced after Build(), only compared by address,
+// but the index must be Clear()ed before they are deleted, or a later ad
+// could be allocated at the same address.
+class SlotIndex {
+ public:
+	SlotIndex() : m_stamp(0) {}
+
+		// Index the given attributes of the given slots.  Slots for which
+		// never_prune is true are not indexed, and are always returned
+		// as candidates by Prune().
+	template <class Pred>
+	void Build(const std::vector<ClassAd *> &slots, const std::vector<std::string> &attrs, Pred never_prune) {
+		std::vector<ClassAd *> indexed;
+		indexed.reserve(slots.size());
+		for (ClassAd *slot : slots) {
+			if ( ! never_prune(slot)) {
+				indexed.push_back(slot);
+			}
+		}
+		Build(indexed, attrs);
+	}
+
+	void Clear();
+
+	bool empty() const { return m_attrs.empty() || m_slotIds.empty(); }
+
+		// Fill candidates with the members of slots (in the same order) that
+		// might match request.  Returns false if none of the Requirements
+		// could be answered from the index, in which case candidates is
+		// left empty and the caller should scan all of slots.
+	bool Prune(ClassAd &request, const std::vector<ClassAd *> &slots, std::vector<ClassAd *> &candidates);
+
+ private:
+	struct AttrIndex {
+		std::unordered_map<std::string, std::vector<int>> strings;
+		std::vector<double> values;		// sorted numeric values...
+		std::vector<int> value_ids;		// ...and the slots they belong to
+		std::vector<int> others;		// not a literal, could be anything
+	};
+	typedef std::pair<const int *, const int *> IdRange;
+
+	void Build(const std::vector<ClassAd *> &slots, const std::vector<std::string> &attrs);
+	bool TermRanges(classad::ExprTree *term, std::vector<IdRange> &ranges);
+
+	std::map<std::string, AttrIndex, classad::CaseIgnLTStr> m_attrs;
+	std::unordered_map<const ClassAd *, int> m_slotIds;
+
+		// scratch space for Prune(); a slot's mark is advanced once for
+		// each term it passes, so stale marks never need clearing
+	std::vector<unsigned> m_marks;
+	unsigned m_stamp;
+};
+
+#endif
@@ -0,0 +1,131 @@
+/***************************************************************
+ *
+ * Copyright (C) 2025, Condor Team, Computer Sciences Department,
+ * University of Wisconsin-Madison, WI.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you
+ * may not use this file except in compliance with the License.  You may
+ * obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ ***************************************************************/
+
+// Check that SlotIndex::Prune() never drops a slot that the job's
+// Requirements would have matched, with and without the job ad having
+// been optimized for matchmaking.
+
+#include "condor_common.h"
+#include "condor_classad.h"
+#include "condor_attributes.h"
+#include "compat_classad_util.h"
+#include "matchmaker_slot_index.h"
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+static const char * slot_ads[] = {
+	"[ OpSys = \"LINUX\"; Arch = \"X86_64\"; Memory = 2048; Cpus = 1; HasSingularity = true ]",
+	"[ OpSys = \"LINUX\"; Arch = \"X86_64\"; Memory = 4096; Cpus = 4; HasSingularity = false ]",
+	"[ OpSys = \"linux\"; Arch = \"aarch64\"; Memory = 8192.0; Cpus = 8 ]",
+	"[ OpSys = \"WINDOWS\"; Arch = \"X86_64\"; Memory = 16384; Cpus = 16; HasGPU = 1 ]",
+	"[ OpSys = \"LINUX\"; Arch = \"X86_64\"; Memory = 65536; Cpus = 32; HasGPU = true; HasSingularity = true ]",
+	"[ OpSys = \"LINUX\"; Arch = \"X86_64\"; Memory = TotalMemory / 2; TotalMemory = 10000; Cpus = 2 ]",
+	"[ OpSys = undefined; Arch = \"X86_64\"; Memory = 1024; Cpus = 1; HasGPU = 0 ]",
+	"[ OpSys = \"LINUX\"; Arch = 42; Memory = \"lots\"; Cpus = 1; HasGPU = \"yes\" ]",
+	"[ OpSys = \"LINUX\"; Arch = \"X86_64\"; Memory = 4096; Cpus = 4; HasSingularity = MY.Cpus > 2 ]",
+	"[ Arch = \"X86_64\"; Memory = 512; Cpus = 1 ]",
+};
+
+static const char * requirements[] = {
+	"TARGET.OpSys == \"LINUX\"",
+	"(TARGET.OpSys == \"LINUX\") && (TARGET.Arch == \"X86_64\")",
+	"(TARGET.Arch == \"X86_64\") && (TARGET.Memory >= RequestMemory)",
+	"TARGET.Memory >= 4096 && TARGET.Memory < 65536",
+	"4096 <= TARGET.Memory && TARGET.Cpus > 2",
+	"TARGET.HasGPU",
+	"TARGET.HasSingularity && TARGET.OpSys =?= \"LINUX\"",
+	"TARGET.HasGPU == true || TARGET.Cpus >= 8",
+	"TARGET.Memory == 8192 && TARGET.Cpus != 4",
+	"TARGET.Memory >= RequestMemory && (TARGET.OpSys == \"LINUX\" && TARGET.Arch == \"aarch64\")",
+	"TARGET.NotIndexed == 1 && TARGET.Cpus >= 1",
+	"MY.RequestMemory > 0 && TARGET.OpSys == \"SOLARIS\"",
+	"TARGET.OpSys =!= \"LINUX\"",
+};
+
+int
+main( int /* argc */, char ** /* argv */ ) {
+	classad::ClassAdParser parser;
+	std::vector<ClassAd *> slots;
+	for (const char * text : slot_ads) {
+		ClassAd * ad = new ClassAd;
+		if ( ! parser.ParseClassAd(text, *ad, true)) {
+			fprintf(stderr, "failed to parse %s\n", text);
+			return 1;
+		}
+		slots.push_back(ad);
+	}
+
+	std::vector<std::string> attrs = { "OpSys", "Arch", "Memory", "Cpus", "HasGPU", "HasSingularity" };
+	SlotIndex index;
+	index.Build(slots, attrs, [](ClassAd *) { return false; });
+
+	unsigned failures = 0;
+	unsigned pruned = 0;
+	for (const char * req : requirements) {
+		for (int optimize = 0; optimize < 2; ++optimize) {
+			ClassAd job;
+			job.AssignExpr(ATTR_REQUIREMENTS, req);
+			job.Assign("RequestMemory", 4096);
+			if (optimize) {
+				classad::MatchClassAd::OptimizeLeftAdForMatchmaking(&job, nullptr);
+			}
+
+			std::vector<ClassAd *> candidates;
+			if ( ! index.Prune(job, slots, candidates)) {
+				candidates = slots;
+			}
+			pruned += slots.size() - candidates.size();
+
+			classad::MatchClassAd mad;
+			for (ClassAd * slot : slots) {
+				mad.ReplaceLeftAd(&job);
+				mad.ReplaceRightAd(slot);
+				bool matches = mad.rightMatchesLeft();
+				mad.RemoveLeftAd();
+				mad.RemoveRightAd();
+
+				bool kept = std::find(candidates.begin(), candidates.end(), slot) != candidates.end();
+				if (matches && ! kept) {
+					++failures;
+					std::string buf;
+					fprintf(stderr, "%s (optimize=%d) pruned matching slot %s\n",
+						req, optimize, ExprTreeToString(slot, buf));
+				}
+			}
+		}
+	}
+
+	if (pruned == 0) {
+		++failures;
+		fprintf(stderr, "the index never pruned anything\n");
+	}
+
+	for (ClassAd * ad : slots) {
+		delete ad;
+	}
+
+	if( failures == 0 ) {
+		fprintf( stdout, "All tests passed (%u slots pruned).\n", pruned );
+		return 0;
+	} else {
+		return 1;
+	}
+}
@@ -38,8 +38,8 @@ public:
 	bool next(JOB_ID_KEY &jid) { if (it == jobs.end()) return false; jid = *it; ++it; return true; }
 	bool first(JOB_ID_KEY &jid) { if (jobs.empty()) return false; jid = *(jobs.begin()); return true; }
 	bool last(JOB_ID_KEY &jid)  { if (jobs.empty()) return false; jid = *(jobs.rbegin()); return true; }
-	void insert(JOB_ID_KEY &jid) { jobs.insert(jid); }
-	void erase(JOB_ID_KEY &jid) { jobs.erase(jid); }
+	void insert(const JOB_ID_KEY &jid) { jobs.insert(jid); }
+	void erase(const JOB_ID_KEY &jid) { jobs.erase(jid); }
 	const std::set<JOB_ID_KEY> & joblist() const { return jobs; }
 private:
 	std::set<JOB_ID_KEY> jobs;
@@ -65,13 +65,36 @@ JobCluster::~JobCluster()
 void JobCluster::clear()
 {
 	cluster_map.clear();
+	cluster_sigs.clear();
+	cluster_hash.clear();
 #ifdef USE_AUTOCLUSTER_TO_JOBID_MAP
 	cluster_use.clear();
-	cluster_gone.clear();
 #endif
 	next_id = 1;
 }
 
+// forget everything about an autocluster
+void JobCluster::forgetCluster(int id)
+{
+	auto it = cluster_sigs.find(id);
+	if (it != cluster_sigs.end()) {
+		if (it->second.sig != cluster_map.end() && it->second.sig->second == id) {
+			cluster_map.erase(it->second.sig);
+		}
+		auto range = cluster_hash.equal_range(it->second.hash);
+		for (auto hit = range.first; hit != range.second; ++hit) {
+			if (hit->second == id) {
+				cluster_hash.erase(hit);
+				break;
+			}
+		}
+		cluster_sigs.erase(it);
+	}
+#ifdef USE_AUTOCLUSTER_TO_JOBID_MAP
+	cluster_use.erase(id);
+#endif
+}
+
 bool JobCluster::setSigAttrs(const char* new_sig_attrs, bool free_input_attrs, bool replace_attrs)
 {
 	if ( ! new_sig_attrs) {
@@ -152,73 +175,115 @@ JobCluster::JobIdSetMap::iterator JobCluster::find_job_id_set(JobQueueJob & job)
 	return cluster_use.end();
 }
 
-// scan all autoclusters for a given jobid
-/* not used, and can be expensive
-JobCluster::JobIdSetMap::iterator JobCluster::brute_force_find_job_id_set(const JOB_ID_KEY & jid)
+// remove a job from an autocluster, and forget the autocluster if that was its last job
+void JobCluster::leaveCluster(JobIdSetMap::iterator jit, const JOB_ID_KEY & jid)
 {
-	JobIdSetMap::iterator it;
-	for (it = cluster_use.begin(); it != cluster_use.end(); ++it) {
-		if (it->second.contains(jid)) {
-			break;
-		}
+	jit->second.erase(jid);
+	if (jit->second.empty()) {
+		dprintf(D_FULLDEBUG,"removing auto cluster id %d\n",jit->first);
+		forgetCluster(jit->first);
 	}
-	return it;
 }
-*/
 
-// free up unused autoclusters, if brute_force flags is used, then all autoclusters are checked to
-// see if they refer to any jobs that are still in the queue before deleting. otherwise only
-// autoclusters that have been added to the cluster_gone list are removed.
-//
-void JobCluster::collect_garbage(bool brute_force) // free the deleted clusters
+#endif
+
+extern int    last_autocluster_classad_cache_hit;
+
+// hash the typed values of a signature rather than printing them. values that are SameAs()
+// each other must hash the same, but things that are rare in a signature, like nested ads
+// and time literals, are hashed by their kind alone.
+static inline size_t hash_mix(size_t h, size_t v)
 {
-	if (cluster_gone.empty() && ! brute_force)
-		return;
-
-	// scan the cluster collection, checking to see if there are no longer any referring jobs.
-	JobSigidMap::iterator it;
-	for (it = cluster_map.begin(); it != cluster_map.end(); /*advance at bottom of loop!*/) {
-		bool gone = cluster_gone.find(it->second) != cluster_gone.end();
-		if (brute_force || gone) {
-			// found a deleted cluster. but we should double check to see that it's really unused.
-			auto jit = cluster_use.find(it->second);
-			if (jit != cluster_use.end()) {
-				gone = false;
-				if (brute_force) {
-					gone = true;
-					JOB_ID_KEY jid;
-					jit->second.rewind();
-					while (jit->second.next(jid)) {
-						if (GetJobAd(jid)) {
-							gone = false;
-							break;
-						}
-					}
-					if (gone) { cluster_use.erase(jit); }
-				}
-			}
-		}
-		// advance here so that we can erase the previous entry if needed.
-		auto last = it++;
-		if (gone) { cluster_map.erase(last); }
+	return h ^ (v + 0x9e3779b97f4a7c15ULL + (h << 6) + (h >> 2));
+}
+
+static size_t hash_attr_name(const std::string & name)
+{
+	// attribute names are case-insensitive
+	size_t h = 14695981039346656037ULL;
+	for (char ch : name) {
+		h = (h ^ (unsigned char)tolower(ch)) * 1099511628211ULL;
 	}
-	cluster_gone.clear();
+	return h;
 }
 
-#endif
+static size_t hash_expr(const classad::ExprTree * tree)
+{
+	if ( ! tree) {
+		return 0;
+	}
+	tree = tree->self();
+	classad::ExprTree::NodeKind kind = tree->GetKind();
+	size_t h = hash_mix(0, (size_t)kind + 1);
+	switch (kind) {
+	case classad::ExprTree::BOOLEAN_LITERAL:
+		return hash_mix(h, static_cast<const classad::BooleanLiteral*>(tree)->getBool());
+	case classad::ExprTree::INTEGER_LITERAL:
+		return hash_mix(h, std::hash<int64_t>{}(static_cast<const classad::IntegerLiteral*>(tree)->getInteger()));
+	case classad::ExprTree::REAL_LITERAL: {
+		double d = static_cast<const classad::RealLiteral*>(tree)->getReal();
+		if (d == 0) { d = 0; } // so that -0 hashes the same as 0
+		return hash_mix(h, std::hash<double>{}(d));
+	}
+	case classad::ExprTree::STRING_LITERAL:
+		return hash_mix(h, std::hash<std::string>{}(static_cast<const classad::StringLiteral*>(tree)->getString()));
+	case classad::ExprTree::ATTRREF_NODE: {
+		classad::ExprTree * expr = nullptr;
+		std::string attr;
+		bool absolute = false;
+		static_cast<const classad::AttributeReference*>(tree)->GetComponents(expr, attr, absolute);
+		h = hash_mix(h, std::hash<std::string>{}(attr)); // SameAs() compares reference names case-sensitively
+		h = hash_mix(h, absolute);
+		return hash_mix(h, hash_expr(expr));
+	}
+	case classad::ExprTree::OP_NODE: {
+		classad::Operation::OpKind op = classad::Operation::__NO_OP__;
+		classad::ExprTree *t1 = nullptr, *t2 = nullptr, *t3 = nullptr;
+		static_cast<const classad::Operation*>(tree)->GetComponents(op, t1, t2, t3);
+		h = hash_mix(h, (size_t)op);
+		h = hash_mix(h, hash_expr(t1));
+		h = hash_mix(h, hash_expr(t2));
+		return hash_mix(h, hash_expr(t3));
+	}
+	case classad::ExprTree::FN_CALL_NODE: {
+		std::string name;
+		std::vector<classad::ExprTree*> args;
+		static_cast<const classad::FunctionCall*>(tree)->GetComponents(name, args);
+		h = hash_mix(h, std::hash<std::string>{}(name));
+		for (const auto * arg : args) {
+			h = hash_mix(h, hash_expr(arg));
+		}
+		return h;
+	}
+	case classad::ExprTree::EXPR_LIST_NODE:
+		for (const auto * item : *static_cast<const classad::ExprList*>(tree)) {
+			h = hash_mix(h, hash_expr(item));
+		}
+		return h;
+	default:
+		return h;
+	}
+}
 
-extern int    last_autocluster_classad_cache_hit;
+static bool same_value(const classad::ExprTree * a, const classad::ExprTree * b)
+{
+	if (a == b) { return true; }
+	if ( ! a || ! b) { return false; }
+	// expressions from the classad cache share their parsed tree, which SameAs() checks first
+	if (a->GetKind() == classad::ExprTree::EXPR_ENVELOPE && a->SameAs(b)) { return true; }
+	return a->self()->SameAs(b->self());
+}
 
 int JobCluster::getClusterid(JobQueueJob & job, bool expand_refs, std::string * final_list)
 {
 	int cur_id = -1;
 
-	// we want to summarize job into a string "signature"
-	// the signature will consist of "key1=val1\nkey2=val2\n"
-	// for each of the keys in the significant_attrs list and (if expand_refs is true)
-	// the keys that the significant_attrs values refer to that are internal references.
+	// we want to summarize job into a "signature"
+	// the signature will consist of the names and values of each of the keys in the significant_attrs list
+	// and (if expand_refs is true) the keys that the significant_attrs values refer to that are internal references.
 	// the order of the keys in the signature will be the same as the order specified in significant_attrs
 	// followed by the expanded keys in case-insensitive alpha order.
+	// jobs with the same signature have the same cluster id.
 
 	// first put build a set of class ad values, one for each significant attribute
 	//
@@ -273,73 +338,112 @@ int JobCluster::getClusterid(JobQueueJob & job, bool expand_refs, std::string *
 
 	// sigset now contains the values of all the attributes we need,
 	// significant attibutes are first, followed by expanded attributes
-	// we build a signature essentially by printing it all out in one big string
+	// we hash the names and values of the attributes to find the clusters that may have the
+	// same signature, and then compare the values with those of the cluster to be sure.
 	//
-	bool need_sep = false; // true after the first item, (when we need to print separators)
-	std::string signature;
-	signature.reserve(strlen(significant_attrs) + exattrs.size()*20 + sigset.size()*20); // make a guess as to how much space the signature will take.
-
-	classad::ClassAdUnParser unp;
-	unp.SetOldClassAd( true, true );
-
-	// first put the pre-defined significant attrs in the sig
+	size_t hash = 0;
+	size_t ix = 0;
 	list.rewind();
-	int ix = 0;
 	while ((attr = list.next_string())) {
-		ExprTree * tree = sigset[ix];
-		signature += *attr;
-		signature += " = ";
-		if (tree) { unp.Unparse(signature, tree); }
-		signature += '\n';
-		if (final_list) {
-			if (need_sep) { (*final_list) += ','; }
-			final_list->append(*attr);
-			need_sep = true;
-		}
-		++ix;
+		hash = hash_mix(hash, hash_attr_name(*attr));
+		hash = hash_mix(hash, hash_expr(sigset[ix++]));
 	}
-
-	// now put out the expanded attribs (if any)
 	for (const auto & exattr : exattrs) {
-		ExprTree * tree = sigset[ix];
-		signature += exattr;
-		signature += " = ";
-		if (tree) { unp.Unparse(signature, tree); }
-		signature += '\n';
-		if (final_list) {
-			if (need_sep) { (*final_list) += ','; }
-			final_list->append(exattr);
-			need_sep = true;
+		hash = hash_mix(hash, hash_attr_name(exattr));
+		hash = hash_mix(hash, hash_expr(sigset[ix++]));
+	}
+
+	auto same_signature = [&](const JobClusterSig & sig) -> bool {
+		if (sig.values.size() != sigset.size()) {
+			return false;
+		}
+		size_t i = 0;
+		list.rewind();
+		while ((attr = list.next_string())) {
+			if (strcasecmp(attr->c_str(), sig.attrs[i].c_str()) != MATCH || ! same_value(sigset[i], sig.values[i])) {
+				return false;
+			}
+			++i;
+		}
+		for (const auto & exattr : exattrs) {
+			if (strcasecmp(exattr.c_str(), sig.attrs[i].c_str()) != MATCH || ! same_value(sigset[i], sig.values[i])) {
+				return false;
+			}
+			++i;
+		}
+		return true;
+	};
+
+	const JobClusterSig * found = nullptr;
+	auto range = cluster_hash.equal_range(hash);
+	for (auto hit = range.first; hit != range.second; ++hit) {
+		auto sit = cluster_sigs.find(hit->second);
+		if (sit != cluster_sigs.end() && same_signature(sit->second)) {
+			cur_id = sit->first;
+			found = &sit->second;
+			break;
 		}
-		++ix;
 	}
 
-	// now check the signature against the current cluster map
-	// and either return the matching cluster id, or a new cluster id.
-	JobSigidMap::iterator it;
-	it = cluster_map.find(signature);
-	if (it != cluster_map.end()) {
-		cur_id = it->second;
+	std::string attr_list;
+	if ( ! found) {
+		// this is a new cluster, so we need its signature string, this is used as the
+		// key of the cluster_map and becomes the ad returned for the cluster by a query.
+		// the signature will consist of "key1=val1\nkey2=val2\n"
+		std::vector<std::string> attrs;
+		attrs.reserve(sigset.size());
+		list.rewind();
+		while ((attr = list.next_string())) { attrs.emplace_back(*attr); }
+		for (const auto & exattr : exattrs) { attrs.emplace_back(exattr); }
+
+		std::string signature;
+		signature.reserve(strlen(significant_attrs) + exattrs.size()*20 + sigset.size()*20); // make a guess as to how much space the signature will take.
+
+		classad::ClassAdUnParser unp;
+		unp.SetOldClassAd( true, true );
+		for (ix = 0; ix < attrs.size(); ++ix) {
+			signature += attrs[ix];
+			signature += " = ";
+			if (sigset[ix]) { unp.Unparse(signature, sigset[ix]); }
+			signature += '\n';
+			if (ix > 0) { attr_list += ','; }
+			attr_list += attrs[ix];
+		}
+
+		auto [it, inserted] = cluster_map.insert(JobSigidMap::value_type(signature, next_id));
+		if ( ! inserted) {
+			// values that are not the same can print the same, the cluster of the
+			// signature string wins, as it did when the string was the only key.
+			cur_id = it->second;
+			found = &cluster_sigs[cur_id];
+		} else {
+			cur_id = next_id++;
+			JobClusterSig & sig = cluster_sigs[cur_id];
+			sig.hash = hash;
+			sig.attrs.swap(attrs);
+			sig.values.reserve(sigset.size());
+			for (auto * tree : sigset) {
+				sig.values.push_back(tree ? tree->Copy() : nullptr);
+			}
+			sig.attr_list = attr_list;
+			sig.sig = it;
+			cluster_hash.emplace(hash, cur_id);
+		}
 	}
-	else {
-		cur_id = next_id++;
-		cluster_map.insert(JobSigidMap::value_type(signature,cur_id));
+	if (final_list) {
+		*final_list = found ? found->attr_list : attr_list;
 	}
 
 #ifdef USE_AUTOCLUSTER_TO_JOBID_MAP
 	if (keep_job_ids) {
-		if (true) {
-			auto jit = find_job_id_set(job);
-			if (jit != cluster_use.end()) {
-				int old_id = jit->first;
-				if (old_id != cur_id) {
-					jit->second.erase(job.jid);
-					if (jit->second.empty()) { cluster_gone.insert(old_id); }
-					cluster_use[cur_id].insert(job.jid);
-				}
-			} else {
+		auto jit = find_job_id_set(job);
+		if (jit != cluster_use.end()) {
+			if (jit->first != cur_id) {
 				cluster_use[cur_id].insert(job.jid);
+				leaveCluster(jit, job.jid);
 			}
+		} else {
+			cluster_use[cur_id].insert(job.jid);
 		}
 	}
 #endif
@@ -547,32 +651,6 @@ bool AutoCluster::config(const classad::References &basic_attrs, const char* sig
 	return sig_attrs_changed;
 }
 
-void AutoCluster::mark()
-{
-	cluster_in_use.clear();
-}
-
-void AutoCluster::sweep()
-{
-	JobSigidMap::iterator it,next;
-	for( it = cluster_map.begin();
-		 it != cluster_map.end();
-		 it = next )
-	{
-		next = it;
-		next++; // avoid invalid iterator if we delete this element
-
-		int id = it->second;
-		JobClusterIDs::iterator in_use;
-		in_use = cluster_in_use.find(id);
-		if (in_use == cluster_in_use.end()) {
-				// found an entry to remove.
-			dprintf(D_FULLDEBUG,"removing auto cluster id %d\n",id);
-			cluster_map.erase( it );
-		}
-	}
-}
-
 extern double last_autocluster_runtime;
 extern bool   last_autocluster_make_sig;
 extern int    last_autocluster_type;
@@ -596,9 +674,6 @@ int AutoCluster::getAutoClusterid(JobQueueJob *job)
 	job->LookupInteger(ATTR_AUTO_CLUSTER_ID, cur_id);
 	if (cur_id != -1)  {
 			// we've previously figured it out...
-
-			// tag it as touched
-		cluster_in_use.insert(cur_id);
 		return cur_id;
 	}
 
@@ -611,12 +686,10 @@ int AutoCluster::getAutoClusterid(JobQueueJob *job)
 		EXCEPT("Auto cluster IDs exhausted! (allocated %d)",cur_id);
 	}
 
-		// mark as in-use for the mark/sweep code
-	cluster_in_use.insert(cur_id);
-
 		// put the new auto cluster id into the job ad to cache it.
 	job->Assign(ATTR_AUTO_CLUSTER_ID,cur_id);
 	job->autocluster_id = cur_id;
+	MarkJobQueueColumnsDirty(job->jid);
 
 		// for some nice feedback, place the final list of attrs used to create this
 		// signature into the job ad.
@@ -662,14 +735,15 @@ void AutoCluster::removeFromAutocluster(JobQueueJob &job)
 {
 	if (job.autocluster_id >= 0) {
 #ifdef USE_AUTOCLUSTER_TO_JOBID_MAP
-		auto it = cluster_use.find(job.autocluster_id);
-		if (it != cluster_use.end()) {
-			it->second.erase(job.jid);
+		auto jit = find_job_id_set(job);
+		if (jit != cluster_use.end()) {
+			leaveCluster(jit, job.jid);
 		}
 #endif
 		job.Delete(ATTR_AUTO_CLUSTER_ID);
 		job.Delete(ATTR_AUTO_CLUSTER_ATTRS);
 		job.autocluster_id = -1;
+		MarkJobQueueColumnsDirty(job.jid);
 	}
 }
 
@@ -46,18 +46,35 @@ public:
 	void clear();
 #ifdef USE_AUTOCLUSTER_TO_JOBID_MAP
 	bool hasJobIds() const { return keep_job_ids; }
-	void collect_garbage(bool brute_force); // free the deleted clusters
 #endif
 
 protected:
 	friend class JobAggregationResults;
 	typedef std::map<std::string,int> JobSigidMap;
 	JobSigidMap cluster_map;  // map of signature to a cluster id
+
+	// the signature of an autocluster, the names of its attributes and a copy of their values.
+	// jobs are matched to an autocluster by a hash of their values and then comparing them
+	// with these, so the signature string is only made when an autocluster is created.
+	struct JobClusterSig {
+		JobClusterSig() = default;
+		JobClusterSig(const JobClusterSig &) = delete;
+		JobClusterSig & operator=(const JobClusterSig &) = delete;
+		~JobClusterSig() { for (auto * tree : values) { delete tree; } }
+		size_t hash{0};
+		std::vector<std::string> attrs;
+		std::vector<classad::ExprTree*> values; // owned, null when the job does not have the attribute
+		std::string attr_list;                  // attrs as a comma separated list
+		JobSigidMap::iterator sig;              // entry in cluster_map
+	};
+	std::map<int, JobClusterSig> cluster_sigs;         // map of cluster id to signature
+	std::unordered_multimap<size_t, int> cluster_hash; // map of signature hash to cluster id
+	void forgetCluster(int id);
 #ifdef USE_AUTOCLUSTER_TO_JOBID_MAP
 	typedef std::map<int, JobIdSet> JobIdSetMap;
-	JobIdSetMap cluster_use; // map clusterId to a set of jobIds
-	std::set<int> cluster_gone; // holds the set of deleted clusters until the next garbage collect pass
+	JobIdSetMap cluster_use; // map clusterId to a set of jobIds, when the last job leaves the cluster is forgotten
 	JobIdSetMap::iterator find_job_id_set(JobQueueJob & job); // lookup the autocluster for a job (assumes job.autocluster_id is valid)
+	void leaveCluster(JobIdSetMap::iterator jit, const JOB_ID_KEY & jid);
 #endif
 	int next_id;
 	const char *significant_attrs;
@@ -107,32 +124,16 @@ public:
 	
 	/** Given a job classad, return the value of the attribute
 		ATTR_AUTO_CLUSTER_ID, or if this attribute is not present,
-		compute the autocluster id and store it in the ad.  Also,
-		the deletion flag for this autocluster entry will be cleared.
+		compute the autocluster id and store it in the ad.
+		An autocluster is forgotten as soon as the last of its jobs
+		leaves it, either because a significant attribute of the job
+		changed or because the job was removed from the queue.
 		@param job A job classad
 		@return The autocluster id for this job, or -1 if it cannot
 		be computed.
 	*/
 	int getAutoClusterid(JobQueueJob *job);
 
-		// garbage collection methods...
-
-	/** Set the deletion flag for all autocluster id entries in the class.
-		After calling mark(), calls to getAutoClusterid() will clear the deletion
-		flag for the autocluster returned.  The idea here is to call mark(),
-		then call getAutoClusterid() on all job classads still active, then
-		call sweep() to remove data structures assicoated with autoclusters
-		no longer being used.
-		@see sweep
-	*/
-	void mark();
-
-	/** Deallocate and purge from memory the data structures associated with
-		all autoclusters that have their corresponding deletion flag set.
-		@see mark
-	*/
-	void sweep();
-
 	/** Create (or find) and aggregation on the given projection
 	  */
 	JobAggregationResults * aggregateOn(bool use_default, const char * projection, int result_limit, classad::ExprTree * constraint);
@@ -149,7 +150,7 @@ public:
 
 	/** Return number of active autoclusters
 	  */
-	int getNumAutoclusters() const { return (int)cluster_in_use.size(); }
+	int getNumAutoclusters() const { return (int)cluster_sigs.size(); }
 
 #ifdef USE_AUTOCLUSTER_TO_JOBID_MAP
 	const std::set<JOB_ID_KEY> & joblist(JobQueueJob & job);
@@ -157,8 +158,6 @@ public:
 
 protected:
 	bool sig_attrs_came_from_config_file;
-	typedef std::set<int> JobClusterIDs;
-	JobClusterIDs cluster_in_use; // used by mark & sweep code. id in list if in use
 
 	// used by the aggregateOn option
 	// std::map<std::string, JobCluster> current_aggregations;
@@ -0,0 +1,411 @@
+/***************************************************************
+ *
+ * Copyright (C) 2025, Condor Team, Computer Sciences Department,
+ * University of Wisconsin-Madison, WI.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you
+ * may not use this file except in compliance with the License.  You may
+ * obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ ***************************************************************/
+
+#include "condor_common.h"
+#include "condor_debug.h"
+#include "condor_attributes.h"
+#include "compat_classad_util.h"
+#include "qmgmt.h"
+#include "job_queue_columns.h"
+
+// the attribute of each column, in the order of the column enum
+static const char * const column_attrs[JobQueueColumns::NUM_COLUMNS] = {
+	ATTR_OWNER,
+	ATTR_JOB_STATUS,
+	ATTR_CLUSTER_ID,
+	ATTR_PROC_ID,
+	ATTR_Q_DATE,
+	ATTR_AUTO_CLUSTER_ID,
+};
+
+// one <attr> <cmp> <literal> clause of a constraint
+struct JobQueueColumns::Clause {
+	int col{0};
+	classad::Operation::OpKind op{classad::Operation::__NO_OP__};
+	bool attr_on_left{true};
+	classad::Value literal;
+	bool int_literal{false};
+	long long ival{0};
+	// results already worked out for the strings of the column's dictionary
+	// and for UNDEFINED. -1 is not yet known, 0 is pass, 1 is reject
+	std::vector<signed char> string_rejects;
+	signed char undefined_rejects{-1};
+
+	// true if the clause is not true for the given value of the attribute
+	bool Rejects(const classad::Value & val) const {
+		classad::Value lhs, rhs, result;
+		lhs.CopyFrom(attr_on_left ? val : literal);
+		rhs.CopyFrom(attr_on_left ? literal : val);
+		classad::Operation::Operate(op, lhs, rhs, result);
+		bool bval = false;
+		return ! (result.IsBooleanValueEquiv(bval) && bval);
+	}
+};
+
+// the prefilter handed to the job queue iterator; a bit for each row that is ruled
+// out by the constraint, and the generation of the columns when the bits were set.
+class JobQueueColumns::Selection : public JobQueueLogType::filter_prefilter {
+public:
+	Selection(const JobQueueColumns & cols, unsigned long long stamp, std::vector<bool> && rejects)
+		: m_cols(cols), m_stamp(stamp), m_rejects(std::move(rejects)) {}
+	virtual ~Selection() {}
+
+	virtual bool Rejects(JobQueuePayload ad) const {
+		if ( ! ad->IsJob() && ! ad->IsCluster()) return false;
+		int row = static_cast<JobQueueJob*>(ad)->column_row;
+		if (row < 0 || row >= (int)m_rejects.size() || ! m_rejects[row]) return false;
+		// don't trust the bit if the job or its cluster has changed since it was set
+		return m_cols.RowUnchangedSince(row, m_stamp);
+	}
+
+private:
+	const JobQueueColumns & m_cols;
+	unsigned long long m_stamp;
+	std::vector<bool> m_rejects;
+};
+
+
+void JobQueueColumns::Clear()
+{
+	m_built = false;
+	for (auto & col : m_cols) {
+		col.values.clear();
+		col.kinds.clear();
+		// the string dictionaries are kept, owners come and go but not that many of them
+	}
+	m_keys.clear();
+	m_parent.clear();
+	m_stamp.clear();
+	m_dirty.clear();
+	m_free.clear();
+	m_pending.clear();
+	m_overflow = false;
+	m_rows.clear();
+}
+
+void JobQueueColumns::MarkDirty(const JOB_ID_KEY & key)
+{
+	if ( ! m_built) return;
+
+	auto found = m_rows.find(key);
+	if (found != m_rows.end()) {
+		int row = found->second;
+		m_stamp[row] = ++m_generation;
+		if (m_dirty[row]) return;
+		m_dirty[row] = true;
+	}
+	if (m_overflow) return;
+	m_pending.push_back(key);
+
+	// if nobody is querying the queue, don't let the pending keys grow without bound.
+	// once there are more of them than rows it is cheaper to just rebuild
+	if (m_pending.size() > 4096 && m_pending.size() > 2*m_rows.size()) {
+		m_overflow = true;
+		m_pending.clear();
+		m_pending.shrink_to_fit();
+	}
+}
+
+bool JobQueueColumns::TakeDirty(std::vector<JOB_ID_KEY> & keys)
+{
+	keys.clear();
+	if (m_overflow) {
+		return false;
+	}
+	keys.swap(m_pending);
+	return true;
+}
+
+int JobQueueColumns::AllocRow(const JOB_ID_KEY & key)
+{
+	int row;
+	if ( ! m_free.empty()) {
+		row = m_free.back();
+		m_free.pop_back();
+		m_keys[row] = key;
+	} else {
+		row = (int)m_keys.size();
+		m_keys.push_back(key);
+		m_parent.push_back(-1);
+		m_stamp.push_back(0);
+		m_dirty.push_back(false);
+		for (auto & col : m_cols) {
+			col.values.push_back(0);
+			col.kinds.push_back(cellAbsent);
+		}
+	}
+	m_rows[key] = row;
+	return row;
+}
+
+void JobQueueColumns::LoadCell(Column & col, const classad::ExprTree * tree, int row)
+{
+	long long value = 0;
+	unsigned char kind = cellAbsent;
+	if (tree) {
+		kind = cellOther;
+		tree = SkipExprEnvelope(tree);
+		switch (tree->GetKind()) {
+		case classad::ExprTree::INTEGER_LITERAL:
+			kind = cellInt;
+			value = static_cast<const classad::IntegerLiteral*>(tree)->getInteger();
+			break;
+		case classad::ExprTree::STRING_LITERAL: {
+			const std::string & str = static_cast<const classad::StringLiteral*>(tree)->getString();
+			auto it = col.string_ids.find(str);
+			if (it == col.string_ids.end()) {
+				it = col.string_ids.emplace(str, (int)col.strings.size()).first;
+				col.strings.push_back(str);
+			}
+			kind = cellString;
+			value = it->second;
+		} break;
+		case classad::ExprTree::UNDEFINED_LITERAL:
+			kind = cellUndefined;
+			break;
+		default:
+			break;
+		}
+	}
+	col.kinds[row] = kind;
+	col.values[row] = value;
+}
+
+void JobQueueColumns::Load(JobQueueJob & job)
+{
+	int row = job.column_row;
+	if (row < 0 || row >= (int)m_keys.size() || m_keys[row] != job.jid) {
+		auto found = m_rows.find(job.jid);
+		row = (found != m_rows.end()) ? found->second : AllocRow(job.jid);
+		job.column_row = row;
+	}
+
+	for (int ix = 0; ix < NUM_COLUMNS; ++ix) {
+		LoadCell(m_cols[ix], job.LookupIgnoreChain(column_attrs[ix]), row);
+	}
+
+	m_parent[row] = -1;
+	if (job.IsJob()) {
+		JobQueueCluster * cluster = job.Cluster();
+		if ( ! cluster) {
+			// not yet attached to its cluster, so attributes it doesn't have are unknown
+			m_parent[row] = -2;
+		} else {
+			if (cluster->column_row < 0) { Load(*cluster); }
+			m_parent[row] = cluster->column_row;
+		}
+	}
+	m_stamp[row] = ++m_generation;
+	m_dirty[row] = false;
+}
+
+void JobQueueColumns::Remove(const JOB_ID_KEY & key)
+{
+	auto found = m_rows.find(key);
+	if (found == m_rows.end()) return;
+	int row = found->second;
+	m_rows.erase(found);
+
+	for (auto & col : m_cols) { col.kinds[row] = cellOther; }
+	m_keys[row] = JOB_ID_KEY(0, 0);
+	m_parent[row] = -1;
+	m_stamp[row] = ++m_generation;
+	m_dirty[row] = false;
+	m_free.push_back(row);
+}
+
+bool JobQueueColumns::RowUnchangedSince(int row, unsigned long long stamp) const
+{
+	if (row >= (int)m_stamp.size() || m_stamp[row] > stamp) return false;
+	int parent = m_parent[row];
+	return parent < 0 || m_stamp[parent] <= stamp;
+}
+
+// returns the column of an unscoped or MY. attribute reference, or -1
+static int ColumnOfAttrRef(const classad::ExprTree * tree)
+{
+	if ( ! tree || tree->GetKind() != classad::ExprTree::ATTRREF_NODE) return -1;
+
+	classad::ExprTree * scope = nullptr;
+	std::string attr;
+	bool absolute = false;
+	static_cast<const classad::AttributeReference*>(tree)->GetComponents(scope, attr, absolute);
+	if (absolute) return -1;
+	if (scope) {
+		std::string scope_attr;
+		classad::ExprTree * scope_scope = nullptr;
+		if (scope->GetKind() != classad::ExprTree::ATTRREF_NODE) return -1;
+		static_cast<const classad::AttributeReference*>(scope)->GetComponents(scope_scope, scope_attr, absolute);
+		if (scope_scope || absolute || strcasecmp(scope_attr.c_str(), "MY") != 0) return -1;
+	}
+
+	for (int ix = 0; ix < JobQueueColumns::NUM_COLUMNS; ++ix) {
+		if (strcasecmp(attr.c_str(), column_attrs[ix]) == 0) return ix;
+	}
+	return -1;
+}
+
+bool JobQueueColumns::ParseClause(const classad::ExprTree * tree, Clause & clause) const
+{
+	if (tree->GetKind() != classad::ExprTree::OP_NODE) return false;
+
+	classad::Operation::OpKind op;
+	classad::ExprTree *t1, *t2, *t3;
+	static_cast<const classad::Operation*>(tree)->GetComponents(op, t1, t2, t3);
+	if (op < classad::Operation::__COMPARISON_START__ || op > classad::Operation::__COMPARISON_END__) {
+		return false;
+	}
+
+	t1 = SkipExprParens(t1);
+	t2 = SkipExprParens(t2);
+	int col = ColumnOfAttrRef(t1);
+	if (col >= 0 && ExprTreeIsLiteral(t2, clause.literal)) {
+		clause.attr_on_left = true;
+	} else if ((col = ColumnOfAttrRef(t2)) >= 0 && ExprTreeIsLiteral(t1, clause.literal)) {
+		clause.attr_on_left = false;
+	} else {
+		return false;
+	}
+
+	clause.col = col;
+	clause.op = op;
+	clause.int_literal = clause.literal.IsIntegerValue(clause.ival);
+	clause.string_rejects.assign(m_cols[col].strings.size(), -1);
+	return true;
+}
+
+// only the top level && clauses of a constraint are useful, since the constraint
+// as a whole can only be true when every one of them is true
+void JobQueueColumns::CollectClauses(const classad::ExprTree * tree, std::vector<Clause> & clauses) const
+{
+	tree = SkipExprParens(tree);
+	if ( ! tree) return;
+
+	if (tree->GetKind() == classad::ExprTree::OP_NODE) {
+		classad::Operation::OpKind op;
+		classad::ExprTree *t1, *t2, *t3;
+		static_cast<const classad::Operation*>(tree)->GetComponents(op, t1, t2, t3);
+		if (op == classad::Operation::LOGICAL_AND_OP) {
+			CollectClauses(t1, clauses);
+			CollectClauses(t2, clauses);
+			return;
+		}
+	}
+
+	Clause clause;
+	if (ParseClause(tree, clause)) {
+		clauses.push_back(std::move(clause));
+	}
+}
+
+bool JobQueueColumns::ClauseRejects(Clause & clause, int row) const
+{
+	const Column & col = m_cols[clause.col];
+	unsigned char kind = col.kinds[row];
+	long long value = col.values[row];
+
+	// a proc ad that doesn't have the attribute gets it from its cluster ad
+	if (kind == cellAbsent) {
+		int parent = m_parent[row];
+		if (parent == -2) return false;
+		if (parent >= 0) {
+			kind = col.kinds[parent];
+			value = col.values[parent];
+		}
+		if (kind == cellAbsent) kind = cellUndefined;
+	}
+
+	switch (kind) {
+	case cellInt:
+		if (clause.int_literal) {
+			long long a = clause.attr_on_left ? value : clause.ival;
+			long long b = clause.attr_on_left ? clause.ival : value;
+			switch (clause.op) {
+			case classad::Operation::LESS_THAN_OP: return ! (a < b);
+			case classad::Operation::LESS_OR_EQUAL_OP: return ! (a <= b);
+			case classad::Operation::NOT_EQUAL_OP: return a == b;
+			case classad::Operation::META_NOT_EQUAL_OP: return a == b;
+			case classad::Operation::EQUAL_OP: return a != b;
+			case classad::Operation::META_EQUAL_OP: return a != b;
+			case classad::Operation::GREATER_OR_EQUAL_OP: return ! (a >= b);
+			case classad::Operation::GREATER_THAN_OP: return ! (a > b);
+			default: break;
+			}
+		} else {
+			classad::Value val;
+			val.SetIntegerValue(value);
+			return clause.Rejects(val);
+		}
+		return false;
+
+	case cellString: {
+		if ((size_t)value >= clause.string_rejects.size()) {
+			clause.string_rejects.resize(col.strings.size(), -1);
+		}
+		signed char & rejects = clause.string_rejects[value];
+		if (rejects < 0) {
+			classad::Value val;
+			val.SetStringValue(col.strings[value]);
+			rejects = clause.Rejects(val) ? 1 : 0;
+		}
+		return rejects != 0;
+	}
+
+	case cellUndefined:
+		if (clause.undefined_rejects < 0) {
+			classad::Value val;
+			val.SetUndefinedValue();
+			clause.undefined_rejects = clause.Rejects(val) ? 1 : 0;
+		}
+		return clause.undefined_rejects != 0;
+
+	default:
+		return false;
+	}
+}
+
+std::shared_ptr<const JobQueueLogType::filter_prefilter>
+JobQueueColumns::Select(const classad::ExprTree & constraint) const
+{
+	if ( ! m_built) return nullptr;
+
+	std::vector<Clause> clauses;
+	CollectClauses(&constraint, clauses);
+	if (clauses.empty()) return nullptr;
+
+	size_t num_rows = m_keys.size();
+	std::vector<bool> rejects(num_rows, false);
+	size_t num_rejected = 0;
+	for (int row = 0; row < (int)num_rows; ++row) {
+		// rows that are pending a reload, or free, are never ruled out
+		if (m_dirty[row] || (m_parent[row] >= 0 && m_dirty[m_parent[row]])) continue;
+		for (auto & clause : clauses) {
+			if (ClauseRejects(clause, row)) {
+				rejects[row] = true;
+				++num_rejected;
+				break;
+			}
+		}
+	}
+
+	dprintf(D_COMMAND | D_VERBOSE, "JobQueueColumns: %d clauses of the constraint rule out %d of %d rows\n",
+		(int)clauses.size(), (int)num_rejected, (int)NumRows());
+
+	return std::make_shared<Selection>(*this, m_generation, std::move(rejects));
+}
@@ -0,0 +1,126 @@
+/***************************************************************
+ *
+ * Copyright (C) 2025, Condor Team, Computer Sciences Department,
+ * University of Wisconsin-Madison, WI.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you
+ * may not use this file except in compliance with the License.  You may
+ * obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ ***************************************************************/
+
+#ifndef _job_queue_columns_H_
+#define _job_queue_columns_H_
+
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+// A columnar copy of the handful of job attributes that condor_q constraints
+// test most often: Owner, JobStatus, ClusterId, ProcId, QDate and AutoClusterId.
+//
+// Each job and cluster ad in the queue has a row that holds its own value of
+// each of these attributes, when that value is an integer or string literal.
+// A query constraint whose top level is a chain of && clauses of the form
+// <attr> <cmp> <literal> can then be checked against the columns to rule out
+// most of the queue without evaluating the constraint against each job ad.
+// This is only ever a prefilter; a job that is not ruled out is still matched
+// against the whole constraint, so query results are exactly the same as
+// evaluating the constraint against every ad.
+//
+// Rows are refreshed lazily. The job queue log tells us the key of every ad it
+// changes, and the few places that change these attributes without going through
+// the log call MarkDirty themselves; the rows for those keys are reloaded the next
+// time a query asks for a prefilter. Every row has a change stamp so that a prefilter
+// never trusts a row that changed after it was made, which can happen when a query
+// is spread over several timeslices.
+class JobQueueColumns {
+public:
+	enum {
+		colOwner = 0,
+		colJobStatus,
+		colClusterId,
+		colProcId,
+		colQDate,
+		colAutoClusterId,
+		NUM_COLUMNS
+	};
+
+	JobQueueColumns() = default;
+
+	// true when every job and cluster ad in the queue has a row
+	bool IsBuilt() const { return m_built; }
+	void SetBuilt() { m_built = true; }
+
+	// forget all rows, the caller should Load every job and cluster ad before calling SetBuilt()
+	void Clear();
+
+	// note that an ad has changed or been destroyed. until the columns are built this does nothing.
+	void MarkDirty(const JOB_ID_KEY & key);
+
+	// move the keys marked dirty since the last call into keys.
+	// returns false if so many keys were marked that the columns should just be rebuilt.
+	bool TakeDirty(std::vector<JOB_ID_KEY> & keys);
+
+	// load the row of a job or cluster ad, or forget the row of an ad that has been destroyed.
+	void Load(JobQueueJob & job);
+	void Remove(const JOB_ID_KEY & key);
+
+	// make a prefilter for a query constraint from the current rows.
+	// returns null when no part of the constraint can be checked against the columns.
+	std::shared_ptr<const JobQueueLogType::filter_prefilter> Select(const classad::ExprTree & constraint) const;
+
+	size_t NumRows() const { return m_keys.size() - m_free.size(); }
+
+private:
+	class Selection;
+	struct Clause;
+
+	// what a cell holds
+	enum : unsigned char {
+		cellAbsent = 0,  // the ad has no such attribute, for a proc ad use the cluster's cell
+		cellUndefined,   // the literal UNDEFINED
+		cellInt,         // value is the integer
+		cellString,      // value is the index of the string in the column's dictionary
+		cellOther,       // anything else, which the columns can't say anything about
+	};
+
+	struct Column {
+		std::vector<long long> values;
+		std::vector<unsigned char> kinds;
+		std::vector<std::string> strings;
+		std::unordered_map<std::string, int> string_ids;
+	};
+
+	// hash JOB_ID_KEY for unordered_map
+	struct KeyHash { size_t operator()(const JOB_ID_KEY & key) const noexcept { return JOB_ID_KEY::hash(key); } };
+
+	int  AllocRow(const JOB_ID_KEY & key);
+	void LoadCell(Column & col, const classad::ExprTree * tree, int row);
+	bool ParseClause(const classad::ExprTree * tree, Clause & clause) const;
+	void CollectClauses(const classad::ExprTree * tree, std::vector<Clause> & clauses) const;
+	bool ClauseRejects(Clause & clause, int row) const;
+	bool RowUnchangedSince(int row, unsigned long long stamp) const;
+
+	bool m_built{false};
+	unsigned long long m_generation{0};
+	Column m_cols[NUM_COLUMNS];
+	std::vector<JOB_ID_KEY> m_keys;
+	std::vector<int> m_parent;                  // row of the cluster of a proc, -1 for a cluster, -2 if not yet attached
+	std::vector<unsigned long long> m_stamp;    // generation of the last change to the row
+	std::vector<unsigned char> m_dirty;         // row is in m_pending
+	std::vector<int> m_free;                    // rows of destroyed ads, for reuse
+	std::vector<JOB_ID_KEY> m_pending;          // keys marked dirty and not yet taken
+	bool m_overflow{false};                     // too many keys were marked dirty to bother with
+	std::unordered_map<JOB_ID_KEY, int, KeyHash> m_rows;
+};
+
+#endif
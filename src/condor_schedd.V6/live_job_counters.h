@@ -37,6 +37,7 @@ struct LiveJobCounters {
   int SchedulerJobsCompleted;
   int SchedulerJobsHeld;
   void clear_counters() { memset(this, 0, sizeof(*this)); }
+  bool operator==(const LiveJobCounters &) const = default;
   void publish(ClassAd & ad, const char * prefix) const;
   LiveJobCounters()
 	: JobsSuspended(0)
@@ -55,6 +56,25 @@ struct LiveJobCounters {
 
 void IncrementLiveJobCounter(LiveJobCounters & num, int universe, int status, int increment /*, JobQueueJob * job*/);
 
+// What one job adds to the live job counts of its submitter (the SubmitterLiveCounters in scheduler.h)
+// as of the last time the schedd counted it, so the same amounts can be taken back out when the job
+// changes or leaves the queue.  Jobs are counted the way count_a_job() counts them, so idle is
+// MaxHosts - CurrentHosts, and scheduler and local universe jobs are counted separately.
+struct SubmitterJobCounters {
+  struct SubmitterData * submitter{nullptr}; // null when the job isn't counted for any submitter
+  int JobsIdle{0};          // only jobs in universes that the schedd finds matches for
+  int WeightedJobsIdle{0};
+  int JobsHeld{0};
+  int SchedulerJobsRunning{0};
+  int SchedulerJobsIdle{0};
+  int LocalJobsRunning{0};
+  int LocalJobsIdle{0};
+  bool OCUWanted{false};
+  bool OCURunning{false};
+  bool FlockDefault{false}; // the job's FlockTo includes "default"
+  std::string FlockTo;      // the job's FlockTo, when it has idle to count
+};
+
 struct AccumJobUsageCounters {
 	int Jobs{0};           // number of proc ads being counted
 	int Spare{0};          // spare to align
@@ -0,0 +1,97 @@
+/***************************************************************
+ *
+ * Copyright (C) 2025, Condor Team, Computer Sciences Department,
+ * University of Wisconsin-Madison, WI.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you
+ * may not use this file except in compliance with the License.  You may
+ * obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ ***************************************************************/
+
+#ifndef _MULTIPLEXED_SHADOWS_H
+#define _MULTIPLEXED_SHADOWS_H
+
+#include <functional>
+#include <map>
+#include <string>
+
+// The shadows that the schedd runs with MAX_JOBS_PER_SHADOW > 1.  A shadow
+// switches to the user its jobs run as, and a process can only be one user,
+// so the shadows are kept by that user (the job's OsUser, or User and
+// NTDomain), and a job is only given to a shadow of the same user.
+class MultiplexedShadows {
+public:
+	void add(int pid, const std::string & user) {
+		byPid[pid] = Shadow{user, true};
+		byUser.emplace(user, pid);
+	}
+
+	// returns false if pid isn't a multiplexed shadow
+	bool remove(int pid) {
+		auto it = byPid.find(pid);
+		if (it == byPid.end()) {
+			return false;
+		}
+		auto range = byUser.equal_range(it->second.user);
+		for (auto uit = range.first; uit != range.second; ++uit) {
+			if (uit->second == pid) {
+				byUser.erase(uit);
+				break;
+			}
+		}
+		byPid.erase(it);
+		return true;
+	}
+
+	bool contains(int pid) const { return byPid.count(pid) > 0; }
+	size_t size() const { return byPid.size(); }
+
+	// don't give this shadow any more jobs
+	void stopAccepting(int pid) {
+		auto it = byPid.find(pid);
+		if (it != byPid.end()) {
+			it->second.accepting = false;
+		}
+	}
+
+	// The shadow of the given user with the fewest jobs that still has room
+	// for another, or 0 if there is none.  num_jobs(pid) is how many jobs a
+	// shadow has, and jobs is set to that for the chosen one.
+	int pick(const std::string & user, size_t max_jobs, const std::function<size_t(int)> & num_jobs,
+	         size_t & jobs) const
+	{
+		int pid = 0;
+		jobs = max_jobs;
+		auto range = byUser.equal_range(user);
+		for (auto it = range.first; it != range.second; ++it) {
+			if ( ! byPid.at(it->second).accepting) {
+				continue;
+			}
+			size_t n = num_jobs(it->second);
+			if (n < jobs) {
+				pid = it->second;
+				jobs = n;
+			}
+		}
+		return pid;
+	}
+
+private:
+	struct Shadow {
+		std::string user;
+		bool accepting{true};
+	};
+	std::map<int, Shadow> byPid;
+	std::multimap<std::string, int> byUser;
+};
+
+#endif
@@ -0,0 +1,195 @@
+/***************************************************************
+ *
+ * Copyright (C) 2025, Condor Team, Computer Sciences Department,
+ * University of Wisconsin-Madison, WI.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you
+ * may not use this file except in compliance with the License.  You may
+ * obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ ***************************************************************/
+
+#include "condor_common.h"
+#include "condor_debug.h"
+#include "condor_attributes.h"
+#include "compat_classad_util.h"
+#include "qmgmt.h"
+#include "periodic_policy.h"
+
+// the job attributes that UserPolicy::AnalyzePolicy and ResponsibleForPeriodicExprs look at
+// directly. a change to any of these may change what the policy does with a job.
+static const char * const fixed_policy_attrs[] = {
+	ATTR_JOB_STATUS,
+	ATTR_JOB_UNIVERSE,
+	ATTR_JOB_MANAGED,
+	ATTR_GRID_JOB_ID,
+	ATTR_HOLD_REASON_CODE,
+	ATTR_NUM_HOLDS,
+	ATTR_JOB_ALLOWED_JOB_DURATION,
+	ATTR_JOB_ALLOWED_EXECUTE_DURATION,
+	ATTR_SHADOW_BIRTHDATE,
+	ATTR_JOB_CURRENT_START_EXECUTING_DATE,
+	"TransferOutFinished",
+	ATTR_TIMER_REMOVE_CHECK,
+	ATTR_PERIODIC_HOLD_CHECK,
+	ATTR_PERIODIC_RELEASE_CHECK,
+	ATTR_PERIODIC_REMOVE_CHECK,
+	ATTR_PERIODIC_VACATE_CHECK,
+};
+
+// the policy expressions of the job ad
+static const char * const job_policy_exprs[] = {
+	ATTR_TIMER_REMOVE_CHECK,
+	ATTR_PERIODIC_HOLD_CHECK,
+	ATTR_PERIODIC_RELEASE_CHECK,
+	ATTR_PERIODIC_REMOVE_CHECK,
+	ATTR_PERIODIC_VACATE_CHECK,
+};
+
+void
+PeriodicPolicyTracker::Reset(int interval)
+{
+	m_policy.Init();
+	m_sys_exprs.clear();
+	m_policy.GetSystemPeriodicExprs(m_sys_exprs);
+
+	m_slot_width = MAX(interval, 1);
+	m_full_pass = true;
+	m_refs.clear();
+	m_dirty.clear();
+	m_wheel.clear();
+}
+
+void
+PeriodicPolicyTracker::BeginFullPass()
+{
+	m_full_pass = false;
+	m_refs.clear();
+	m_dirty.clear();
+	m_wheel.clear();
+	for (const char * attr : fixed_policy_attrs) {
+		m_refs.insert(attr);
+	}
+}
+
+void
+PeriodicPolicyTracker::AdChanged(const JOB_ID_KEY & key, const classad::References * attrs)
+{
+	if (m_full_pass) {
+		return;
+	}
+	if ( ! attrs) {
+		m_dirty.insert(key);
+		return;
+	}
+	for (const auto & attr : *attrs) {
+		if (m_refs.count(attr)) {
+			m_dirty.insert(key);
+			return;
+		}
+	}
+}
+
+void
+PeriodicPolicyTracker::TakeDue(time_t now, std::set<JOB_ID_KEY> & keys)
+{
+	// a dirty cluster ad means that every job of the cluster is dirty
+	for (const auto & key : m_dirty) {
+		if (key.proc >= 0) {
+			keys.insert(key);
+			continue;
+		}
+		JobQueueCluster * cad = GetClusterAd(key.cluster);
+		if ( ! cad) {
+			continue;
+		}
+		for (JobQueueJob * job = cad->FirstJob(); job; job = cad->NextJob(job)) {
+			keys.insert(job->jid);
+		}
+	}
+	m_dirty.clear();
+
+	time_t last_slot = now / m_slot_width;
+	auto end = m_wheel.upper_bound(last_slot);
+	std::vector<JOB_ID_KEY> later;
+	for (auto it = m_wheel.begin(); it != end; ++it) {
+		for (const auto & key : it->second) {
+			JobQueueJob * job = GetJobAd(key.cluster, key.proc);
+			if ( ! job || ! job->policy_due || job->policy_due / m_slot_width != it->first) {
+				continue; // the job is gone or has been rescheduled since this entry was made
+			}
+			if (job->policy_due <= now) {
+				keys.insert(key);
+			} else {
+				later.push_back(key);
+			}
+		}
+	}
+	m_wheel.erase(m_wheel.begin(), end);
+	if ( ! later.empty()) {
+		auto & slot = m_wheel[last_slot];
+		slot.insert(slot.end(), later.begin(), later.end());
+	}
+}
+
+void
+PeriodicPolicyTracker::Settle(JobQueueJob & job, int status, time_t now)
+{
+	std::vector<classad::ExprTree*> exprs(m_sys_exprs);
+	for (const char * attr : job_policy_exprs) {
+		classad::ExprTree * expr = job.Lookup(attr);
+		if (expr) {
+			exprs.push_back(expr);
+		}
+	}
+
+	// the references of the expressions, following references to other expressions in the job ad.
+	// if they can't all be found (a circular reference perhaps), evaluate the job on every pass.
+	classad::References refs;
+	bool timed = false;
+	for (const auto * expr : exprs) {
+		if ( ! GetExprReferences(expr, job, &refs, &refs)) {
+			timed = true;
+		}
+		if ( ! timed && ExprTreeMayDependOnTime(expr)) {
+			timed = true;
+		}
+	}
+	for (const auto & attr : refs) {
+		if (timed) break;
+		timed = ExprTreeMayDependOnTime(job.Lookup(attr));
+	}
+	m_refs.insert(refs.begin(), refs.end());
+
+	time_t due = 0;
+	if (timed) {
+		due = now + 1;
+	} else if ((status == RUNNING || status == SUSPENDED) &&
+			(job.Lookup(ATTR_JOB_ALLOWED_JOB_DURATION) || job.Lookup(ATTR_JOB_ALLOWED_EXECUTE_DURATION))) {
+		due = now + 1;
+	} else {
+		long long timer_remove = -1;
+		if (job.LookupInteger(ATTR_TIMER_REMOVE_CHECK, timer_remove) && timer_remove >= 0) {
+			// AnalyzePolicy removes the job once the time is past TimerRemove
+			due = MAX((time_t)timer_remove + 1, now + 1);
+		}
+	}
+	if (due) {
+		ScheduleAt(job, due);
+	}
+}
+
+void
+PeriodicPolicyTracker::ScheduleAt(JobQueueJob & job, time_t when)
+{
+	job.policy_due = when;
+	m_wheel[when / m_slot_width].push_back(job.jid);
+}
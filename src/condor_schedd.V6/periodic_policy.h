@@ -0,0 +1,96 @@
+/***************************************************************
+ *
+ * Copyright (C) 2025, Condor Team, Computer Sciences Department,
+ * University of Wisconsin-Madison, WI.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you
+ * may not use this file except in compliance with the License.  You may
+ * obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ ***************************************************************/
+
+#ifndef _periodic_policy_H_
+#define _periodic_policy_H_
+
+#include <map>
+#include <set>
+#include <vector>
+#include "user_job_policy.h"
+
+class JobQueueJob;
+
+// Keeps track of which jobs need their periodic policy expressions evaluated
+// by the schedd's PeriodicExprHandler, so that a pass over a large queue only
+// evaluates the jobs for which the result could have changed since the last pass.
+//
+// The result of the policy for a job can change for one of two reasons.
+// Either an attribute that the policy refers to has changed, or the policy
+// depends on the current time. For the first, the job queue log tells us the
+// attributes of each ad changed by a transaction, and any job whose change touches
+// an attribute that some policy expression refers to is marked dirty. For the second,
+// a job whose policy depends on the time is put on a timer wheel, either at the time
+// when it is known that the policy will fire (TimerRemove), or at the next pass.
+//
+// An ad whose changed attributes can't be known is always marked dirty, and
+// after a reconfig the next pass evaluates every job, as PeriodicExprHandler
+// always used to.
+class PeriodicPolicyTracker {
+public:
+	PeriodicPolicyTracker() = default;
+
+	// reload the system periodic policy from the config and forget what is known about
+	// all jobs, so that the next pass evaluates all of them. interval is the width of
+	// a slot in the timer wheel, normally PERIODIC_EXPR_INTERVAL
+	void Reset(int interval);
+
+	// the policy to evaluate jobs with
+	UserPolicy & Policy() { return m_policy; }
+
+	// true when the next pass should evaluate every job.
+	bool NeedFullPass() const { return m_full_pass; }
+
+	// start a pass that evaluates every job. until jobs are settled, the only attribute
+	// references that are known are the ones of the system periodic expressions.
+	void BeginFullPass();
+
+	// called for every ad that the job queue log changes, with the names of the attributes
+	// that changed, or null if they aren't known.
+	void AdChanged(const JOB_ID_KEY & key, const classad::References * attrs);
+
+	// mark a job or cluster as needing evaluation on the next pass
+	void MarkDirty(const JOB_ID_KEY & key) { if ( ! m_full_pass) { m_dirty.insert(key); } }
+
+	// move the keys of the jobs and clusters that are dirty, or due on the timer wheel
+	// by the given time, into keys.
+	void TakeDue(time_t now, std::set<JOB_ID_KEY> & keys);
+
+	// called after the policy of a job has been evaluated and nothing was done to it.
+	// learns the attributes that the job's policy refers to, and puts the job on the timer
+	// wheel if the policy depends on the current time.
+	void Settle(JobQueueJob & job, int status, time_t now);
+
+	// put the job on the timer wheel so that it is evaluated on the first pass at or after when
+	void ScheduleAt(JobQueueJob & job, time_t when);
+
+	size_t NumReferences() const { return m_refs.size(); }
+	size_t NumDirty() const { return m_dirty.size(); }
+
+private:
+	bool m_full_pass{true};
+	int m_slot_width{60};
+	UserPolicy m_policy;
+	std::vector<classad::ExprTree*> m_sys_exprs;    // owned by m_policy
+	classad::References m_refs;                     // attributes that some job's policy refers to
+	std::set<JOB_ID_KEY> m_dirty;
+	std::map<time_t, std::vector<JOB_ID_KEY>> m_wheel;  // jobs by slot, an entry is stale unless the job's policy_due is in the slot
+};
+
+#endif
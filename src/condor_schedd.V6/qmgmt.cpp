@@ -56,6 +56,7 @@
 #include "jobsets.h"
 #include "exit.h"
 #include "credmon_interface.h"
+#include "job_queue_columns.h"
 #include <algorithm>
 #include <math.h>
 #include <param_info.h>
@@ -112,6 +113,15 @@ ClassAdLog<K,AD>::filter_iterator::operator++(int)
 			}
 		}
 
+		// the prefilter can rule an ad out without evaluating the requirements,
+		// but those misses still count against the timeslice
+		if (m_prefilter && m_prefilter->Rejects(tmp_ad)) {
+			if ( ! miss_count) { sw.start(); }
+			++miss_count;
+			if ((miss_count & 0x1FF) == 0 && (sw.get_ms() > m_timeslice_ms)) {break;}
+			continue;
+		}
+
 		if (m_requirements) {
 			//IsDebugCatAndVerbosity(D_COMMAND | D_VERBOSE) {
 			//  dprintf(D_COMMAND | D_VERBOSE, "ClassAdLog::filter_iterator++ checking requirements: %s\n", ExprTreeToString(&requirements));
@@ -230,6 +240,7 @@ int active_cluster_num = -1;	// client is restricted to only insert jobs to the
 static bool JobQueueDirty = false;
 static bool in_DestroyJobQueue = false;
 static int in_walk_job_queue = 0;
+static JobQueueColumns QueueColumns;	// used by GetJobQueueIterator to rule out most jobs cheaply
 static time_t xact_start_time = 0;	// time at which the current transaction was started
 static int cluster_initial_val = 1;		// first cluster number to use
 static int cluster_increment_val = 1;	// increment for cluster numbers of successive submissions 
@@ -290,6 +301,9 @@ static int flush_job_queue_log_timer_id = -1;
 static int dirty_notice_timer_id = -1;
 static int flush_job_queue_log_delay = 0;
 static void HandleFlushJobQueueLogTimer(int tid);
+static bool group_commit_enabled = false;
+static bool qmgmt_forked_worker = false; // true in a forked QMGMT_READ_CMD worker
+static int group_commit_max = 0;
 static int dirty_notice_interval = 0;
 static void PeriodicDirtyAttributeNotification(int tid);
 static void ScheduleJobQueueLogFlush();
@@ -441,11 +455,76 @@ DeletePrivateAttribute(int cluster_id, int proc_id, const char *attr_name)
 }
 
 
+// called by the job queue log with the key of every ad that it changes
+static void
+JobQueueAdChanged(const char * key, void * /*context*/)
+{
+	JOB_ID_KEY jid(key);
+	if (jid.cluster > 0 && jid.proc >= -1) {
+		QueueColumns.MarkDirty(jid);
+
+		// when called from CommitTransaction, the transaction is still active,
+		// so we can tell the periodic policy which attributes changed.
+		PeriodicPolicyTracker & policy = scheduler.PeriodicPolicy();
+		if ( ! policy.NeedFullPass()) {
+			classad::References attrs;
+			bool known = JobQueue->AddAttrNamesFromTransaction(jid, attrs);
+			policy.AdChanged(jid, known ? &attrs : nullptr);
+		}
+	}
+}
+
+// for changes to the queried columns that don't go through the job queue log
+void
+MarkJobQueueColumnsDirty(const JOB_ID_KEY & jid)
+{
+	QueueColumns.MarkDirty(jid);
+}
+
+// bring the query columns up to date with the job queue, loading the whole
+// queue the first time and only the ads that have changed after that
+static void
+RefreshJobQueueColumns()
+{
+	std::vector<JOB_ID_KEY> keys;
+	if (QueueColumns.IsBuilt() && QueueColumns.TakeDirty(keys)) {
+		for (const auto & jid : keys) {
+			JobQueuePayload ad = nullptr;
+			if (JobQueue->Lookup(jid, ad) && (ad->IsJob() || ad->IsCluster())) {
+				QueueColumns.Load(*static_cast<JobQueueJob*>(ad));
+			} else {
+				QueueColumns.Remove(jid);
+			}
+		}
+		return;
+	}
+
+	double begin = _condor_debug_get_time_double();
+	QueueColumns.Clear();
+	JobQueue->StartIterateAllClassAds();
+	JobQueueKey key;
+	JobQueuePayload ad = nullptr;
+	while (JobQueue->Iterate(key, ad)) {
+		if (ad->IsJob() || ad->IsCluster()) {
+			QueueColumns.Load(*static_cast<JobQueueJob*>(ad));
+		}
+	}
+	QueueColumns.SetBuilt();
+	dprintf(D_FULLDEBUG, "Loaded %d job queue query columns in %.3f sec\n",
+		(int)QueueColumns.NumRows(), _condor_debug_get_time_double() - begin);
+}
+
 //static int allow_remote_submit = FALSE;
 JobQueueLogType::filter_iterator
 GetJobQueueIterator(const classad::ExprTree &requirements, int timeslice_ms)
 {
-	return JobQueue->GetFilteredIterator(requirements, timeslice_ms);
+	JobQueueLogType::filter_iterator it = JobQueue->GetFilteredIterator(requirements, timeslice_ms);
+	// the rebuild would disturb the iteration of a queue walk that is in progress
+	if ( ! in_walk_job_queue) {
+		RefreshJobQueueColumns();
+		it.set_prefilter(QueueColumns.Select(requirements));
+	}
+	return it;
 }
 
 JobQueueLogType::filter_iterator
@@ -656,7 +735,8 @@ ConstructClassAdLogTableEntry<JobQueuePayload>::Delete(ClassAd* &ad) const
 	} else if (bad->IsJob()) {
 		auto * job = dynamic_cast<JobQueueJob*>(bad);
 		// this is a job
-		//PRAGMA_REMIND("tj: decrement autocluster use count here??")
+		// DestroyProc normally does this, but not every job is destroyed that way.
+		scheduler.autocluster.removeFromAutocluster(*job);
 
 		if (scheduler.jobSets) { scheduler.jobSets->removeJobFromSet(*job); }
 
@@ -665,6 +745,7 @@ ConstructClassAdLogTableEntry<JobQueuePayload>::Delete(ClassAd* &ad) const
 		IncrementLiveJobCounter(scheduler.liveJobCounts, job->Universe(), job->Status(), -1);
 		if (job->ownerinfo) { IncrementLiveJobCounter(job->ownerinfo->live, job->Universe(), job->Status(), -1); }
 		if (job->project) { IncrementLiveJobCounter(job->project->live, job->Universe(), job->Status(), -1); }
+		scheduler.uncountSubmitterJob(job);
 		if (job->Cluster()) {
 			job->Cluster()->DetachJob(job);
 		}
@@ -1522,6 +1603,8 @@ InitQmgmt()
     cluster_maximum_val = param_integer("SCHEDD_CLUSTER_MAXIMUM_VALUE",0,0);
 
 	flush_job_queue_log_delay = param_integer("SCHEDD_JOB_QUEUE_LOG_FLUSH_DELAY",5,0);
+	group_commit_enabled = param_boolean("SCHEDD_JOB_QUEUE_GROUP_COMMIT", false);
+	group_commit_max = param_integer("SCHEDD_JOB_QUEUE_GROUP_COMMIT_MAX",100,1);
 	dirty_notice_interval = param_integer("SCHEDD_JOB_QUEUE_NOTIFY_UPDATES",30,0);
 }
 
@@ -2157,9 +2240,11 @@ InitJobQueue(const char *job_queue_name,int max_historical_logs)
 	CheckSpoolVersion(spool.c_str(),SPOOL_MIN_VERSION_SCHEDD_SUPPORTS,SPOOL_CUR_VERSION_SCHEDD_SUPPORTS,spool_min_version,spool_cur_version);
 
 	JobQueue = new JobQueueType();
+	JobQueue->SetBinaryFormat(param_boolean("JOB_QUEUE_LOG_BINARY", false));
 	if( !JobQueue->InitLogFile(job_queue_name,max_historical_logs) ) {
 		EXCEPT("Failed to initialize job queue log!");
 	}
+	JobQueue->SetChangeObserver(JobQueueAdChanged, nullptr);
 	ClusterSizeHashTable = new ClusterSizeHashTable_t(hashFuncInt);
 	TotalJobsCount = 0;
 	jobs_added_this_transaction = 0;
@@ -2466,6 +2551,7 @@ InitJobQueue(const char *job_queue_name,int max_historical_logs)
 				if (ad->ownerinfo) { IncrementLiveJobCounter(ad->ownerinfo->live, ad->Universe(), ad->Status(), 1); }
 				if (ad->project) { IncrementLiveJobCounter(ad->project->live, ad->Universe(), ad->Status(), 1); }
 			}
+			scheduler.recountSubmitterJob(ad);
 
 				// Make sure ATTR_SCHEDULER is correct.
 				// XXX TODO: Need a better way than hard-coded
@@ -2742,30 +2828,122 @@ InitJobQueue(const char *job_queue_name,int max_historical_logs)
 }
 
 
+// runtime stats for the time the main thread spends cleaning the job queue log.
+// when the log is cleaned in the background this no longer includes writing it.
+schedd_runtime_probe CleanJobQueue_runtime;
+
+static int clean_job_queue_tid = -1;
+static int clean_job_queue_reaper_id = -1;
+
+// the log was just rewritten without the private attributes, so log them again
+static void
+RelogPrivateAttrs()
+{
+	auto job_itr = PrivateAttrs.begin();
+	while (job_itr != PrivateAttrs.end()) {
+		ClassAd *job_ad = GetJobAd(job_itr->first);
+		if (job_ad == nullptr) {
+			job_itr = PrivateAttrs.erase(job_itr);
+		} else {
+			for (auto &attr : job_itr->second) {
+				if (SetAttributeString(job_itr->first.cluster, job_itr->first.proc, attr.first.c_str(), attr.second.c_str()) == 0) {
+					job_ad->Delete(attr.first);
+				}
+			}
+			job_itr++;
+		}
+	}
+}
+
+// stop waiting for a background clean of the log, so that it can be cleaned now
+static void
+AbandonBackgroundCleanJobQueue()
+{
+	if (JobQueue->TruncLogInProgress()) {
+		dprintf(D_ALWAYS, "Abandoning background clean of the job queue\n");
+		JobQueue->AbandonTruncLog();
+	}
+	if (clean_job_queue_tid > 0) {
+		daemonCore->Kill_Thread(clean_job_queue_tid);
+		clean_job_queue_tid = -1;
+	}
+}
+
 void
 CleanJobQueue(int /* tid */)
 {
-	if (JobQueueDirty) {
+	if (JobQueueDirty || (JobQueue && JobQueue->TruncLogInProgress())) {
 		dprintf(D_ALWAYS, "Cleaning job queue...\n");
+		condor_auto_runtime rt(CleanJobQueue_runtime);
+		AbandonBackgroundCleanJobQueue();
 		JobQueue->TruncLog();
+		RelogPrivateAttrs();
+		JobQueueDirty = false;
+	}
+}
 
-		auto job_itr = PrivateAttrs.begin();
-		while (job_itr != PrivateAttrs.end()) {
-			ClassAd *job_ad = GetJobAd(job_itr->first);
-			if (job_ad == nullptr) {
-				job_itr = PrivateAttrs.erase(job_itr);
-			} else {
-				for (auto &attr : job_itr->second) {
-					if (SetAttributeString(job_itr->first.cluster, job_itr->first.proc, attr.first.c_str(), attr.second.c_str()) == 0) {
-						job_ad->Delete(attr.first);
-					}
-				}
-				job_itr++;
-			}
-		}
+// runs in the child process, which has a copy of the job queue as it was
+// when the background clean started
+static int
+CleanJobQueueWorker(void * /* arg */, Stream * /* sock */)
+{
+	return JobQueue->WriteTruncLogSnapshot() ? 0 : 1;
+}
 
-		JobQueueDirty = false;
+static int
+CleanJobQueueReaper(int tid, int exit_status)
+{
+	if (tid != clean_job_queue_tid || ! JobQueue) {
+		// the background clean was abandoned
+		return 0;
+	}
+	clean_job_queue_tid = -1;
+
+	condor_auto_runtime rt(CleanJobQueue_runtime);
+	if ( ! JobQueue->FinishTruncLog(exit_status == 0)) {
+		// try again next time
+		JobQueueDirty = true;
 	}
+	return 0;
+}
+
+void
+PeriodicCleanJobQueue(int /* tid */)
+{
+	if ( ! JobQueueDirty || JobQueue->TruncLogInProgress()) {
+		return;
+	}
+#ifdef WIN32
+	// Create_Thread starts a real thread on Windows, which would walk the job queue
+	// while this thread changes it, so the log is always cleaned in the foreground.
+	bool background = false;
+#else
+	bool background = param_boolean("JOB_QUEUE_LOG_BACKGROUND_CLEAN", true);
+#endif
+	if ( ! background) {
+		CleanJobQueue();
+		return;
+	}
+
+	dprintf(D_ALWAYS, "Cleaning job queue in the background...\n");
+	condor_auto_runtime rt(CleanJobQueue_runtime);
+	if ( ! JobQueue->BeginTruncLog()) {
+		// BeginTruncLog said why, leave the queue dirty so that the next pass tries again
+		return;
+	}
+	if (clean_job_queue_reaper_id < 0) {
+		clean_job_queue_reaper_id = daemonCore->Register_Reaper(
+			"CleanJobQueueReaper", CleanJobQueueReaper, "CleanJobQueueReaper");
+	}
+	clean_job_queue_tid = daemonCore->Create_Thread(CleanJobQueueWorker, nullptr, nullptr, clean_job_queue_reaper_id);
+	if (clean_job_queue_tid == FALSE) {
+		dprintf(D_ALWAYS, "Failed to start background clean of the job queue, cleaning it now\n");
+		clean_job_queue_tid = -1;
+		JobQueue->AbandonTruncLog();
+		JobQueue->TruncLog();
+	}
+	RelogPrivateAttrs();
+	JobQueueDirty = false;
 }
 
 
@@ -2784,11 +2962,15 @@ DestroyJobQueue( )
 	// object deleted by the time the child cleanup is attempted.
 	schedd_forker.DeleteAll( );
 
+	// answer any clients still waiting for a group commit
+	SyncGroupCommit();
+
 	if (JobQueueDirty) {
 			// We can't destroy it until it's clean.
 		CleanJobQueue();
 	}
 	ASSERT( JobQueueDirty == false );
+	QueueColumns.Clear();
 	delete JobQueue;
 	JobQueue = nullptr;
 
@@ -3512,10 +3694,110 @@ unsetQSock()
 }
 
 
+// qmgmt connections whose last request was a CommitTransaction that is
+// part of a group commit.  the socket stays registered between requests,
+// and its next request resumes the connection in handle_q_resume.
+static std::map<Stream*, QmgmtPeer*> parked_qmgmt_connections;
+// the parked connections that are still waiting for their commit reply
+static std::vector<Stream*> group_commit_replies;
+static int group_commit_tid = -1;
+// how long a parked connection may wait for its next request, when its socket has no timeout
+static const int parked_qmgmt_idle_timeout = 300;
+
+// runtime stats for the fsyncs of group commits
+schedd_runtime_probe JobQueueGroupCommit_runtime;
+
+static int handle_q_resume(Stream *sock);
+
+// serve requests on the current connection until it is closed, or until
+// the reply to a CommitTransaction is held for a group commit.
+// returns true in the latter case.
+static bool
+ServeQmgmtRequests()
+{
+	int rval = 0;
+	do {
+		/* Probably should wrap a timer around this */
+		rval = do_Q_request(*Q_SOCK);
+	} while(rval >= 0 && rval != QMGMT_REPLY_DEFERRED);
+
+	return rval == QMGMT_REPLY_DEFERRED;
+}
+
+// stash the state of the current connection until its commit is durable.
+// returns false if the connection could not be parked, in which case it has
+// been answered and unset, and the caller should close it.
+static bool
+ParkQmgmtConnection(Stream *sock)
+{
+	QmgmtPeer *peer = getQmgmtConnectionInfo();
+	auto it = parked_qmgmt_connections.find(sock);
+	if (it == parked_qmgmt_connections.end()) {
+		if (daemonCore->Register_Socket(sock, "QMGMT connection", handle_q_resume, "handle_q_resume") < 0) {
+			dprintf(D_ALWAYS, "Failed to register qmgmt connection for group commit, committing now\n");
+			JobQueue->ForceLog();
+			SendCommitTransactionReply(*peer, 0, 0);
+			delete peer;
+			return false;
+		}
+		parked_qmgmt_connections[sock] = peer;
+	} else {
+		it->second = peer;
+	}
+	// handle_q_resume is called when the deadline passes, as it would have timed out
+	// waiting for the next request had the connection not been parked
+	time_t idle_timeout = ((Sock*)sock)->get_timeout_raw();
+	sock->set_deadline_timeout(idle_timeout > 0 ? (int)idle_timeout : parked_qmgmt_idle_timeout);
+
+	group_commit_replies.push_back(sock);
+	if ((int)group_commit_replies.size() >= group_commit_max) {
+		SyncGroupCommit();
+	} else if (group_commit_tid < 0) {
+		// the group is every commit made before the event loop comes around
+		// to this timer, which is at most one pass over the ready sockets
+		group_commit_tid = daemonCore->Register_Timer(0, SyncGroupCommit, "SyncGroupCommit");
+	}
+	return true;
+}
+
+void
+SyncGroupCommit(int tid)
+{
+	if (group_commit_tid >= 0 && tid != group_commit_tid) {
+		daemonCore->Cancel_Timer(group_commit_tid);
+	}
+	group_commit_tid = -1;
+
+	if (group_commit_replies.empty() || ! JobQueue) {
+		return;
+	}
+
+	{
+		condor_auto_runtime rt(JobQueueGroupCommit_runtime);
+		JobQueue->ForceLog();
+	}
+	scheduler.stats.JobQueueGroupCommitSize.Add((double)group_commit_replies.size());
+
+	std::vector<Stream*> replies;
+	replies.swap(group_commit_replies);
+	for (Stream *sock : replies) {
+		auto it = parked_qmgmt_connections.find(sock);
+		if (it == parked_qmgmt_connections.end() || ! it->second) {
+			continue; // the client went away
+		}
+		if (SendCommitTransactionReply(*it->second, 0, 0) < 0) {
+			// forget the connection, handle_q_resume closes the socket
+			// when it next becomes readable
+			dprintf(D_ALWAYS, "Failed to send deferred CommitTransaction reply to %s\n", it->second->endpoint_ip_str());
+			delete it->second;
+			parked_qmgmt_connections.erase(it);
+		}
+	}
+}
+
 int
 handle_q(int cmd, Stream *sock)
 {
-	int	rval = 0;
 	bool all_good = false;
 
 	all_good = setQSock(dynamic_cast<ReliSock*>(sock));
@@ -3542,11 +3824,15 @@ handle_q(int cmd, Stream *sock)
 		fork_status = schedd_forker.NewJob();
 	}
 
+	if (fork_status == FORK_CHILD) {
+		qmgmt_forked_worker = true;
+	}
+
 	if (fork_status != FORK_PARENT) {
-		do {
-			/* Probably should wrap a timer around this */
-			rval = do_Q_request(*Q_SOCK);
-		} while(rval >= 0);
+		// CommitTransactionForPeer never defers the reply in a forked worker
+		if (ServeQmgmtRequests() && fork_status != FORK_CHILD && ParkQmgmtConnection(sock)) {
+			return KEEP_STREAM;
+		}
 	}
 
 	unsetQSock();
@@ -3570,6 +3856,50 @@ handle_q(int cmd, Stream *sock)
 	return 0;
 }
 
+// the next request on a parked connection
+static int
+handle_q_resume(Stream *sock)
+{
+	auto it = parked_qmgmt_connections.find(sock);
+	if (it == parked_qmgmt_connections.end()) {
+		return FALSE;
+	}
+	QmgmtPeer *peer = it->second;
+
+	auto waiting = std::find(group_commit_replies.begin(), group_commit_replies.end(), sock);
+	if (waiting != group_commit_replies.end()) {
+		// the client hung up before its commit was durable
+		group_commit_replies.erase(waiting);
+		parked_qmgmt_connections.erase(it);
+		delete peer;
+		return FALSE;
+	}
+
+	bool idle = sock->deadline_expired();
+	sock->set_deadline(0);
+
+	it->second = nullptr;
+	if ( ! setQmgmtConnectionInfo(peer)) {
+		unsetQSock();
+		if ( ! setQmgmtConnectionInfo(peer)) {
+			EXCEPT("handle_q_resume: Unable to restore qmgmt connection!!");
+		}
+	}
+
+	if (idle) {
+		dprintf(D_FULLDEBUG, "QMGR closing idle connection from %s\n", peer->endpoint_ip_str());
+	} else if (ServeQmgmtRequests() && ParkQmgmtConnection(sock)) {
+		return KEEP_STREAM;
+	}
+
+	parked_qmgmt_connections.erase(sock);
+	unsetQSock();
+	dprintf(D_FULLDEBUG, "QMGR Connection closed\n");
+	AbortTransactionAndRecomputeClusters();
+
+	return FALSE;
+}
+
 int
 NewCluster(CondorError* errstack)
 {
@@ -4325,6 +4655,15 @@ enum {
 	idATTR_DISABLE_REASON,
 	idATTR_USERREC_OPT_CREATE_DEPRECATED,
 	idATTR_USERREC_LIVE,
+	idATTR_CURRENT_HOSTS,
+	idATTR_MAX_HOSTS,
+	idATTR_REQUEST_CPUS,
+	idATTR_REQUEST_DISK,
+	idATTR_REQUEST_MEMORY,
+	idATTR_FLOCK_TO,
+	idATTR_JOB_MANAGED,
+	idATTR_WANT_PARALLEL_SCHEDULING,
+	idATTR_OCU_WANTED,
 };
 
 enum {
@@ -4344,7 +4683,7 @@ enum {
 	catSetUserRec   = 0x1000,    // a UserRec was edited
 	catNewUser      = 0x2000,    // a new job "owner" or "user" was added
 	catSetOwner     = 0x4000,    // the ATTR_OWNER or ATTR_USER of a job or jobset was set/changed
-	// catUnusedFlag = 0x8000,
+	catSubmitterCounts = 0x8000, // an attribute that count_a_job() counts jobs by, need to recount the job for its submitter
 	catSetProjectRec= 0x10000,    // the ProjectRec was edited
 	catNewProject   = 0x20000,    // a new job project was added
 	catJobProject   = 0x40000,    // the ATTR_PROJECT_NAME of a job was set/changed
@@ -4368,7 +4707,7 @@ typedef struct attr_ident_pair {
 // NOTE: !!!
 #define FILL(attr,cat) { attr, id##attr, cat }
 static const ATTR_IDENT_PAIR aSpecialSetAttrs[] = {
-	FILL(ATTR_ACCOUNTING_GROUP,   catDirtyPrioRec | catSubmitterIdent),
+	FILL(ATTR_ACCOUNTING_GROUP,   catDirtyPrioRec | catSubmitterIdent | catSubmitterCounts | catCallbackTrigger),
 	FILL(ATTR_CLUSTER_ID,         catJobId),
 	FILL(ATTR_CONCURRENCY_LIMITS, catDirtyPrioRec),
 	FILL(ATTR_CRON_DAYS_OF_MONTH, catCron),
@@ -4376,9 +4715,11 @@ static const ATTR_IDENT_PAIR aSpecialSetAttrs[] = {
 	FILL(ATTR_CRON_HOURS,         catCron),
 	FILL(ATTR_CRON_MINUTES,       catCron),
 	FILL(ATTR_CRON_MONTHS,        catCron),
+	FILL(ATTR_CURRENT_HOSTS,      catSubmitterCounts | catCallbackTrigger),
+	FILL(ATTR_FLOCK_TO,           catSubmitterCounts | catCallbackTrigger),
 	FILL(ATTR_HOLD_REASON,        0), // used to detect submit of jobs with the magic 'hold for spooling' hold code
 	FILL(ATTR_HOLD_REASON_CODE,   0), // used to detect submit of jobs with the magic 'hold for spooling' hold code
-	FILL(ATTR_JOB_NOOP,           catDirtyPrioRec),
+	FILL(ATTR_JOB_NOOP,           catDirtyPrioRec | catSubmitterCounts | catCallbackTrigger),
 	FILL(ATTR_JOB_MATERIALIZE_CONSTRAINT, catNewMaterialize | catCallbackTrigger),
 	FILL(ATTR_JOB_MATERIALIZE_DIGEST_FILE, catNewMaterialize | catCallbackTrigger),
 	FILL(ATTR_JOB_MATERIALIZE_ITEMS_FILE, catNewMaterialize | catCallbackTrigger),
@@ -4389,14 +4730,21 @@ static const ATTR_IDENT_PAIR aSpecialSetAttrs[] = {
 	FILL(ATTR_JOB_SET_ID,         catJobId | catJobset | catCallbackTrigger),
 	FILL(ATTR_JOB_SET_NAME,       catJobset | catCallbackTrigger),
 	FILL(ATTR_JOB_STATUS,         catStatus | catCallbackTrigger),
-	FILL(ATTR_JOB_UNIVERSE,       catJobObj),
+	FILL(ATTR_JOB_UNIVERSE,       catJobObj | catSubmitterCounts | catCallbackTrigger),
+	FILL(ATTR_JOB_MANAGED,        catSubmitterCounts | catCallbackTrigger),
+	FILL(ATTR_MAX_HOSTS,          catSubmitterCounts | catCallbackTrigger),
 	FILL(ATTR_NUM_JOB_RECONNECTS, 0),
+	{ "OCUWanted", idATTR_OCU_WANTED, catSubmitterCounts | catCallbackTrigger },
 	FILL(ATTR_OWNER,              0),
 	FILL(ATTR_PROC_ID,            catJobId),
 	FILL(ATTR_PROJECT_NAME,       catJobProject),
 	FILL(ATTR_RANK,               catTargetScope),
+	FILL(ATTR_REQUEST_CPUS,       catSubmitterCounts | catCallbackTrigger),
+	FILL(ATTR_REQUEST_DISK,       catSubmitterCounts | catCallbackTrigger),
+	FILL(ATTR_REQUEST_MEMORY,     catSubmitterCounts | catCallbackTrigger),
 	FILL(ATTR_REQUIREMENTS,       catTargetScope),
 	FILL(ATTR_USER,              0),
+	FILL(ATTR_WANT_PARALLEL_SCHEDULING, catSubmitterCounts | catCallbackTrigger),
 
 
 };
@@ -5553,6 +5901,7 @@ SetAttribute(int cluster_id, int proc_id, const char *attr_name,
 // deal with triggers that SetAttribute sets on the transaction. Currently this is
 //   catMaterializeState  when one of the cluster ad attributes that control the job factory is set
 //   catStatus            when the JobStatus of a job is modified (we only care about existing jobs for this trigger)
+//   catSubmitterCounts   when an attribute that the submitter's job counts depend on is modified
 //
 void DoSetAttributeCallbacks(const std::vector<JobQueueKey> &new_ids, const std::vector<JobQueueKey> &exist_ids, int triggers)
 {
@@ -5606,11 +5955,6 @@ void DoSetAttributeCallbacks(const std::vector<JobQueueKey> &new_ids, const std:
 					IncrementLiveJobCounter(job->project->live, universe, job->Status(), -1);
 					IncrementLiveJobCounter(job->project->live, universe, job_status, 1);
 				}
-				//if (job->submitterdata) {
-				//	IncrementLiveJobCounter(job->submitterdata->live, universe, job->Status(), -1);
-				//	IncrementLiveJobCounter(job->submitterdata->live, universe, job_status, 1);
-				//}
-
 				IncrementLiveJobCounter(scheduler.liveJobCounts, universe, job->Status(), -1);
 				IncrementLiveJobCounter(scheduler.liveJobCounts, universe, job_status, 1);
 
@@ -5631,6 +5975,25 @@ void DoSetAttributeCallbacks(const std::vector<JobQueueKey> &new_ids, const std:
 		}
 	}
 
+	// this trigger happens when the JobStatus or another attribute that count_a_job() counts jobs by
+	// is set. the job is counted again for its submitter, and every job of a cluster whose cluster ad changed.
+	if (triggers & (catStatus | catSubmitterCounts)) {
+		for (auto & job_id : exist_ids) {
+			if (JobQueueBase::IsJobId(job_id)) {
+				JobQueueJob * job = nullptr;
+				if (JobQueue->Lookup(job_id, job)) {
+					scheduler.recountSubmitterJob(job);
+				}
+			} else if (JobQueueBase::IsClusterId(job_id) && (triggers & catSubmitterCounts)) {
+				JobQueueCluster * cad = GetClusterAd(job_id.cluster);
+				if ( ! cad) continue;
+				for (auto * job = cad->FirstJob(); job != nullptr; job = cad->NextJob(job)) {
+					scheduler.recountSubmitterJob(job);
+				}
+			}
+		}
+	}
+
 	// check factory clusters to see if there was a state change that justifies new job materialization
 	if (scheduler.getAllowLateMaterialize()) {
 		if (triggers & catMaterializeState) {
@@ -6736,7 +7099,7 @@ AddSessionAttributes(const std::vector<JobQueueKey> &new_keys, CondorError *)
 	return 0;
 }
 
-int CommitTransactionInternal( bool durable, CondorError * errorStack );
+int CommitTransactionInternal( bool durable, CondorError * errorStack, bool grouped = false );
 
 void
 CommitTransactionOrDieTrying() {
@@ -6780,7 +7143,25 @@ CommitTransactionAndLive( SetAttributeFlags_t flags,
 	return CommitTransactionInternal( durable, errorStack );
 }
 
-int CommitTransactionInternal( bool durable, CondorError * errorStack ) {
+int
+CommitTransactionForPeer( SetAttributeFlags_t flags,
+                          CondorError * errorStack,
+                          bool & reply_deferred )
+{
+	reply_deferred = false;
+	// only the schedd itself can hold a reply, a forked query worker has no event loop
+	// to come back to.  and there is nothing to wait for if the transaction is empty
+	if ( ! group_commit_enabled || (flags & NONDURABLE) || ! Q_SOCK ||
+		qmgmt_forked_worker || JobQueue->TransactionIsEmpty()) {
+		return CommitTransactionAndLive( flags, errorStack );
+	}
+
+	int rval = CommitTransactionInternal( true, errorStack, true );
+	reply_deferred = (rval >= 0);
+	return rval;
+}
+
+int CommitTransactionInternal( bool durable, CondorError * errorStack, bool grouped ) {
 
 	std::string owner;
 
@@ -6871,6 +7252,10 @@ int CommitTransactionInternal( bool durable, CondorError * errorStack ) {
 		JobQueue->CommitNondurableTransaction(commit_comment);
 		ScheduleJobQueueLogFlush();
 	}
+	else if (grouped) {
+		// the caller holds the reply until SyncGroupCommit makes this durable
+		JobQueue->CommitNondurableTransaction(commit_comment);
+	}
 	else {
 		JobQueue->CommitTransaction(commit_comment);
 	}
@@ -7093,11 +7478,9 @@ int CommitTransactionInternal( bool durable, CondorError * errorStack ) {
 				if (procad->project) {
 					IncrementLiveJobCounter(procad->project->live, procad->Universe(), job_status, 1);
 				}
-				//if (procad->submitterdata) {
-				//	IncrementLiveJobCounter(job->submitterdata->live, procad->Universe(), job_status, 1);
-				//}
 
 				IncrementLiveJobCounter(scheduler.liveJobCounts, procad->Universe(), job_status, 1);
+				scheduler.recountSubmitterJob(procad);
 				// add job to cluster's linked list, and update cluster counts by job status
 				clusterad->AttachJob(procad);
 
@@ -8918,11 +9301,9 @@ int update_autocluster_id(JobQueueJob *job, const JOB_ID_KEY & /*jid*/, void * p
 {
 	struct _get_job_prio_info & info = *(struct _get_job_prio_info*)pv;
 
-	// getAutoClusterid() performs a mark/sweep algorithm to garbage collect
-	// old autocluster information.  If we fail to call getAutoClusterid, the
-	// autocluster information for this job will be removed, causing the schedd
-	// to ASSERT later on in the autocluster code. 
-	// Quesitons?  Ask Todd <tannenba@cs.wisc.edu> 01/04
+	// getAutoClusterid() only computes a signature for jobs that don't have an autocluster,
+	// autoclusters are forgotten when their last job leaves them, so there is no need to
+	// touch the autocluster of every job in order to keep it.
 	last_autocluster_runtime = 0;
 	last_autocluster_make_sig = false;
 
@@ -9362,16 +9743,12 @@ void DirtyPrioRecArray(int tid /*default -1 which means we were not called from
 // runtime stats for count & time spent building the priorec array
 //
 schedd_runtime_probe BuildPrioRec_runtime;
-schedd_runtime_probe BuildPrioRec_mark_runtime;
 schedd_runtime_probe BuildPrioRec_walk_runtime;
 schedd_runtime_probe BuildPrioRec_sort_runtime;
-schedd_runtime_probe BuildPrioRec_sweep_runtime;
 
 static void DoBuildPrioRecArray() {
 	condor_auto_runtime rt(BuildPrioRec_runtime);
 	double now = rt.begin;
-	scheduler.autocluster.mark();
-	BuildPrioRec_mark_runtime += rt.tick(now);
 
 	PrioRec.clear();
 	struct _get_job_prio_info info;
@@ -9388,9 +9765,7 @@ static void DoBuildPrioRecArray() {
 	if ( ! PrioRec.empty()) {
 		std::sort(PrioRec.begin(), PrioRec.end(), prio_compar{});
 	}
-
-	scheduler.autocluster.sweep();
-	BuildPrioRec_sweep_runtime += rt.tick(now);
+	BuildPrioRec_sort_runtime += rt.tick(now);
 
 	if( !scheduler.shadow_prio_recs_consistent() ) {
 		scheduler.mail_problem_message();
@@ -404,12 +404,16 @@ public:
 	int dirty_flags{0};	// one or more of JQJ_CHACHE_DIRTY_ flags indicating that the job ad differs from the JobQueueJob 
 	int set_id{0};
 	int autocluster_id{0};
+	int column_row{-1};     // row of this job in the JobQueueColumns snapshot, or -1 if it has none
+	time_t policy_due{0};   // when the PeriodicPolicyTracker timer wheel should next evaluate this job's policy, 0 if never
 	// cached pointer into schedulers's SubmitterDataMap and OwnerInfoMap and ProjectInfoMap
 	// it is set by count_jobs() or by scheduler::get_submitter_and_owner()
 	// DO NOT FREE FROM HERE!
 	OwnerInfo * ownerinfo{nullptr};
 	JobQueueProjectRec * project{nullptr};
 	struct SubmitterData * submitterdata{nullptr};
+	// what this job adds to its submitter's live job counts, see Scheduler::recountSubmitterJob()
+	SubmitterJobCounters submitter_counts;
 protected:
 	JobQueueCluster * parent{nullptr}; // job pointer back to the cluster ad
 	qelm qe;
@@ -787,6 +791,9 @@ private:
 #define JOB_QUEUE_ITERATOR_OPT_NO_PROC_ADS          0x0004
 JobQueueLogType::filter_iterator GetJobQueueIterator(const classad::ExprTree &requirements, int timeslice_ms);
 JobQueueLogType::filter_iterator GetJobQueueIteratorEnd();
+// call after changing Owner, JobStatus, ClusterId, ProcId, QDate or AutoClusterId
+// of a job ad directly rather than through the job queue log
+void MarkJobQueueColumnsDirty(const JOB_ID_KEY & jid);
 
 
 class schedd_runtime_probe;
@@ -814,6 +821,7 @@ void InitQmgmt();
 void InitJobQueue(const char *job_queue_name,int max_historical_logs);
 void PostInitJobQueue();
 void CleanJobQueue(int tid = -1);
+void PeriodicCleanJobQueue(int tid = -1);
 bool setQSock( ReliSock* rsock );
 void unsetQSock();
 void MarkJobClean(PROC_ID job_id);
@@ -826,6 +834,16 @@ bool UniverseUsesVanillaStartExpr(int universe);
 
 QmgmtPeer* getQmgmtConnectionInfo();
 
+// Group commit of qmgmt transactions. When it is enabled, a durable commit
+// by a qmgmt client is written without waiting for the disk, do_Q_request
+// returns QMGMT_REPLY_DEFERRED, and the connection waits between requests
+// until SyncGroupCommit makes every commit in the group durable with one
+// fsync and sends the replies.
+const int QMGMT_REPLY_DEFERRED = 1;
+int CommitTransactionForPeer(SetAttributeFlags_t flags, CondorError * errorStack, bool & reply_deferred);
+int SendCommitTransactionReply(QmgmtPeer &Q_PEER, int rval, int terrno);
+void SyncGroupCommit(int tid = -1);
+
 // JobSet qmgmt support functions
 bool JobSetDestroy(int setid);
 bool JobSetCreate(int setId, const char * setName, const char * ownerinfoName);
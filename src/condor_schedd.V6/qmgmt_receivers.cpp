@@ -43,6 +43,52 @@ static bool QmgmtMayAccessAttribute( char const *attr_name ) {
 	return !ClassAdAttributeIsPrivateAny( attr_name );
 }
 
+// the reply to CommitTransaction, which may be sent some time after the
+// request when the commit is part of a group commit
+int
+SendCommitTransactionReply(QmgmtPeer &Q_PEER, int rval, int terrno)
+{
+	CondorError& xact_errstack = Q_PEER.getErrStack();
+	ReliSock *syscall_sock = Q_PEER.getReliSock();
+
+	syscall_sock->encode();
+	neg_on_error( syscall_sock->code(rval) );
+	const CondorVersionInfo *vers = syscall_sock->get_peer_version();
+	bool send_classad = vers && vers->built_since_version(8, 3, 4);
+	bool always_send_classad = vers && vers->built_since_version(8, 7, 4);
+	if( rval < 0 ) {
+		neg_on_error( syscall_sock->code(terrno) );
+	}
+	if( rval < 0 && send_classad ) {
+		// Send a classad, for less backwards-incompatibility.
+		int code = 1;
+		const char * reason = "QMGMT rejected job submission.";
+		if(! xact_errstack.empty()) {
+			code = 2;
+			reason = xact_errstack.message();
+		}
+
+		ClassAd reply;
+		reply.Assign( "ErrorCode", code );
+		reply.Assign( "ErrorReason", reason );
+		neg_on_error( putClassAd( syscall_sock, reply ) );
+	} else if( always_send_classad ) {
+		ClassAd reply;
+
+		std::string reason;
+		if(! xact_errstack.empty()) {
+			reason = xact_errstack.getFullText();
+			reply.Assign( "WarningReason", reason );
+		}
+
+		neg_on_error( putClassAd( syscall_sock, reply ) );
+	}
+
+	neg_on_error( syscall_sock->end_of_message() );;
+	xact_errstack.clear();
+	return 0;
+}
+
 int
 do_Q_request(QmgmtPeer &Q_PEER)
 {
@@ -645,6 +691,7 @@ do_Q_request(QmgmtPeer &Q_PEER)
 		}
 		neg_on_error( syscall_sock->end_of_message() );
 
+		bool reply_deferred = false;
 		if (!xact_errstack.empty()) {
 			AbortTransaction();
 			terrno = xact_errstack.code();
@@ -652,47 +699,17 @@ do_Q_request(QmgmtPeer &Q_PEER)
 			else if (terrno > 0) terrno = -terrno;
 		} else {
 			errno = 0;
-			rval = CommitTransactionAndLive( flags, &xact_errstack );
+			rval = CommitTransactionForPeer( flags, &xact_errstack, reply_deferred );
 			terrno = errno;
 		}
-		dprintf( D_SYSCALLS, "\tflags = %d, rval = %d, errno = %d\n", flags, rval, terrno );
+		dprintf( D_SYSCALLS, "\tflags = %d, rval = %d, errno = %d%s\n", flags, rval, terrno,
+			reply_deferred ? ", reply deferred" : "" );
 
-		syscall_sock->encode();
-		neg_on_error( syscall_sock->code(rval) );
-		const CondorVersionInfo *vers = syscall_sock->get_peer_version();
-		bool send_classad = vers && vers->built_since_version(8, 3, 4);
-		bool always_send_classad = vers && vers->built_since_version(8, 7, 4);
-		if( rval < 0 ) {
-			neg_on_error( syscall_sock->code(terrno) );
+		if (reply_deferred) {
+			// the reply is sent by SyncGroupCommit once the commit is durable
+			return QMGMT_REPLY_DEFERRED;
 		}
-		if( rval < 0 && send_classad ) {
-			// Send a classad, for less backwards-incompatibility.
-			int code = 1;
-			const char * reason = "QMGMT rejected job submission.";
-			if(! xact_errstack.empty()) {
-				code = 2;
-				reason = xact_errstack.message();
-			}
-
-			ClassAd reply;
-			reply.Assign( "ErrorCode", code );
-			reply.Assign( "ErrorReason", reason );
-			neg_on_error( putClassAd( syscall_sock, reply ) );
-		} else if( always_send_classad ) {
-			ClassAd reply;
-
-			std::string reason;
-			if(! xact_errstack.empty()) {
-				reason = xact_errstack.getFullText();
-				reply.Assign( "WarningReason", reason );
-			}
-
-			neg_on_error( putClassAd( syscall_sock, reply ) );
-		}
-
-		neg_on_error( syscall_sock->end_of_message() );;
-		xact_errstack.clear();
-		return 0;
+		return SendCommitTransactionReply( Q_PEER, rval, terrno );
 	}
 
 	case CONDOR_GetAttributeFloat:
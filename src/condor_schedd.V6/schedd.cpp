@@ -257,6 +257,8 @@ static void WriteCompletionVisa(ClassAd* ad);
 
 schedd_runtime_probe WalkJobQ_check_for_spool_zombies_runtime;
 schedd_runtime_probe WalkJobQ_count_a_job_runtime;
+schedd_runtime_probe WalkJobQ_count_live_job_runtime;
+schedd_runtime_probe WalkJobQ_count_submitter_job_runtime;
 schedd_runtime_probe WalkJobQ_PeriodicExprEval_runtime;
 schedd_runtime_probe WalkJobQ_clear_autocluster_id_runtime;
 schedd_runtime_probe WalkJobQ_add_runnable_local_jobs_runtime;
@@ -671,6 +673,7 @@ Scheduler::Scheduler() :
 	RequestClaimTimeout = 0;
 	MaxRunningSchedulerJobsPerOwner = INT_MAX;
 	MaxJobsRunning = 0;
+	MaxJobsPerShadow = 1;
 	AllowLateMaterialize = false;
 	NonDurableLateMaterialize = false;
 	EnablePersistentOwnerInfo = true;
@@ -1437,6 +1440,126 @@ Scheduler::updateSubmitterAd(SubmitterData &SubDat, ClassAd &pAd, DCCollector *c
 ** Examine the job queue to determine how many CONDOR jobs we currently have
 ** running, and how many individual users own them.
 */
+// Publish how many shadow processes there are and an estimate of the
+// memory they use per running job, to show what MAX_JOBS_PER_SHADOW buys.
+// Measuring every shadow would be too slow with tens of thousands of
+// them, so only a sample is measured.
+void
+Scheduler::publishShadowMemory(ClassAd *ad)
+{
+	const size_t max_sample = 100;
+
+	std::vector<int> shadow_pids;
+	size_t shadow_jobs = 0;
+	for (const auto &[pid, rec]: shadowsByPid) {
+		if (rec->universe == CONDOR_UNIVERSE_SCHEDULER || rec->universe == CONDOR_UNIVERSE_LOCAL) {
+			continue;
+		}
+		if (shadow_pids.empty() || shadow_pids.back() != pid) {
+			shadow_pids.push_back(pid);
+		}
+		++shadow_jobs;
+	}
+	ad->Assign(ATTR_SHADOW_PROCESSES_RUNNING, shadow_pids.size());
+	if (shadow_pids.empty()) {
+		ad->Delete(ATTR_SHADOW_MEMORY_PER_RUNNING_JOB);
+		return;
+	}
+
+	size_t step = (shadow_pids.size() + max_sample - 1) / max_sample;
+	size_t sampled = 0;
+	unsigned long sampled_kb = 0;
+	for (size_t i = 0; i < shadow_pids.size(); i += step) {
+		piPTR pi = NULL;
+		int status = 0;
+		if (ProcAPI::getProcInfo(shadow_pids[i], pi, status) != PROCAPI_SUCCESS || !pi) {
+			delete pi;
+			continue;
+		}
+		unsigned long kb = pi->rssize;
+#if HAVE_PSS
+			// shadows share most of their pages, so PSS is the better
+			// measure of what each one costs
+		if (ProcAPI::getPSSInfo(shadow_pids[i], *pi, status) == PROCAPI_SUCCESS && pi->pssize_available) {
+			kb = pi->pssize;
+		}
+#endif
+		delete pi;
+		sampled_kb += kb;
+		++sampled;
+	}
+	if (sampled == 0) {
+		ad->Delete(ATTR_SHADOW_MEMORY_PER_RUNNING_JOB);
+		return;
+	}
+
+	double total_kb = (double)sampled_kb / sampled * shadow_pids.size();
+	ad->Assign(ATTR_SHADOW_MEMORY_PER_RUNNING_JOB, (long long)(total_kb / shadow_jobs));
+}
+
+// job counts computed by walking the job queue, to check the live job counts against
+struct LiveJobCountCheck {
+	LiveJobCounters all;
+	std::map<OwnerInfo*, LiveJobCounters> owners;
+	std::map<JobQueueProjectRec*, LiveJobCounters> projects;
+};
+
+static int
+count_live_job(JobQueueJob * job, const JOB_ID_KEY & /*jid*/, void * pv)
+{
+	LiveJobCountCheck * check = (LiveJobCountCheck*)pv;
+	if ( ! job || ! job->IsJob()) {
+		return 0;
+	}
+	int universe = job->Universe();
+	int status = job->Status();
+	IncrementLiveJobCounter(check->all, universe, status, 1);
+	if (job->ownerinfo) { IncrementLiveJobCounter(check->owners[job->ownerinfo], universe, status, 1); }
+	if (job->project) { IncrementLiveJobCounter(check->projects[job->project], universe, status, 1); }
+	return 0;
+}
+
+static bool
+check_live_job_counts(const char * what, const char * name, LiveJobCounters & live, const LiveJobCounters & counted)
+{
+	if (live == counted) {
+		return true;
+	}
+	dprintf(D_ALWAYS, "Live job counts of %s %s are wrong, correcting them. "
+		"JobsIdle %d should be %d, JobsRunning %d should be %d, JobsHeld %d should be %d, "
+		"SchedulerJobsIdle %d should be %d, SchedulerJobsRunning %d should be %d\n",
+		what, name,
+		live.JobsIdle, counted.JobsIdle, live.JobsRunning, counted.JobsRunning, live.JobsHeld, counted.JobsHeld,
+		live.SchedulerJobsIdle, counted.SchedulerJobsIdle, live.SchedulerJobsRunning, counted.SchedulerJobsRunning);
+	live = counted;
+	return false;
+}
+
+// The live job counts of the schedd and of each owner, project and submitter are updated
+// as jobs are added, removed and change, rather than by walking the job queue.
+// When SCHEDD_LIVE_JOB_COUNTS_CHECK_INTERVAL is set, count_jobs() calls this now and then
+// to count the jobs the slow way and fix (and log) any counts that have drifted.
+void
+Scheduler::checkLiveJobCounts()
+{
+	LiveJobCountCheck check;
+	WalkJobQueue3(count_live_job, &check, WalkJobQ_count_live_job_runtime);
+
+	const LiveJobCounters none;
+	int wrong = 0;
+	if ( ! check_live_job_counts("the", "schedd", liveJobCounts, check.all)) { ++wrong; }
+	for (auto & [name, owni] : OwnersInfo) {
+		auto found = check.owners.find(owni);
+		if ( ! check_live_job_counts("owner", owni->Name(), owni->live, (found != check.owners.end()) ? found->second : none)) { ++wrong; }
+	}
+	for (auto & [name, prji] : ProjectInfo) {
+		auto found = check.projects.find(prji);
+		if ( ! check_live_job_counts("project", prji->Name(), prji->live, (found != check.projects.end()) ? found->second : none)) { ++wrong; }
+	}
+	wrong += recountSubmitterLiveCounts(true);
+	dprintf(wrong ? D_ALWAYS : D_FULLDEBUG, "Checked live job counts against the job queue, %d were wrong\n", wrong);
+}
+
 int
 Scheduler::count_jobs()
 {
@@ -1514,11 +1637,16 @@ Scheduler::count_jobs()
 	dedicated_scheduler.clearDedicatedClusters();
 
 		// inserts/finds an entry in Owners for each job
-		// updates SubmitterCounters: Hits, JobsIdle, WeightedJobsIdle & JobsHeld
+		// updates SubmitterCounters: Hits & JobsCounted
 		// 10/8/2021 TJ - count_a_job now also sees cluster and jobset ads so it will update Owner records.
 		//    For job factories that have no materialized jobs it will potentially trigger new materialization
 	WalkJobQueueWith(WJQ_WITH_CLUSTERS | WJQ_WITH_JOBSETS, count_a_job, nullptr);
 
+	if (LiveJobCountsCheckInterval > 0 && current_time - LiveJobCountsCheckTime >= LiveJobCountsCheckInterval) {
+		LiveJobCountsCheckTime = current_time;
+		checkLiveJobCounts();
+	}
+
 	if (JobsSeenOnQueueWalk >= 0) {
 		TotalJobsCount = JobsSeenOnQueueWalk;
 	}
@@ -1533,38 +1661,15 @@ Scheduler::count_jobs()
 	// map of owner to vector of jobs running on borrowed OCU claims
 	std::map<std::string, std::vector<PROC_ID>> jobs_on_borrowed_claims;	
 
-		// set JobsRunning/JobsFlocked for owners
+		// set Hits and JobsFlocked for owners, the submitters' running jobs
+		// are in their live job counts
 	matches->startIterations();
 	match_rec *rec;
 	while(matches->iterate(rec) == 1) {
-		SubmitterData * SubDat;
-		if (user_is_the_new_owner) {
-			SubDat = insert_submitter(rec->user);
-		} else {
-			char *at_sign = strchr(rec->user, '@');
-			if ( ! at_sign) {
-				SubDat = insert_submitter(rec->user);
-			} else {
-				// TJ, I don't think we ever get here but just in case, we preserve the old (pre 8.9) behavior
-				*at_sign = '\0';
-				SubDat = insert_submitter(rec->user);
-				*at_sign = '@';
-			}
-		}
+		SubmitterData * SubDat = submitter_of_match(rec);
 		SubDat->num.Hits += 1;
 		SubDat->LastHitTime = current_time;
-		if (rec->shadowRec && ! rec->pool) {
-				// Sum up the # of cpus claimed by this user and advertise it as
-				// WeightedJobsRunning. 
-
-			double job_weight = calcSlotWeight(rec);
-			
-			SubDat->num.WeightedJobsRunning += job_weight;
-			SubDat->num.JobsRunning++;
-		} else if (rec->pool) { // non-empty pool name indicates a  remote pool, so add to Flocked count
-			auto iter = SubDat->flock.insert({rec->pool, SubmitterFlockCounters()});
-			iter.first->second.JobsRunning++;
-			iter.first->second.WeightedJobsRunning += calcSlotWeight(rec);
+		if (rec->pool) { // non-empty pool name indicates a  remote pool, so add to Flocked count
 			JobsFlocked++;
 		}
 		if (rec->is_ocu) {
@@ -1583,6 +1688,39 @@ Scheduler::count_jobs()
 		}
 	}
 
+	// copy the submitters' live job counts into the counters the submitter ads are made from.
+	// jobs that FlockTo "default", or all jobs when FLOCK_BY_DEFAULT is true, are idle in each
+	// pool of FLOCK_TO, and jobs that name other pools in their FlockTo are idle in those pools.
+	for (auto & [name, SubDat] : Submitters) {
+		const SubmitterLiveCounters & live = SubDat.live;
+		SubDat.num.JobsIdle = live.JobsIdle;
+		SubDat.num.WeightedJobsIdle = live.WeightedJobsIdle;
+		SubDat.num.JobsRunning = live.JobsRunning;
+		SubDat.num.WeightedJobsRunning = live.WeightedJobsRunning;
+		SubDat.num.JobsHeld = live.JobsHeld;
+		SubDat.num.SchedulerJobsRunning = live.SchedulerJobsRunning;
+		SubDat.num.SchedulerJobsIdle = live.SchedulerJobsIdle;
+		SubDat.num.LocalJobsRunning = live.LocalJobsRunning;
+		SubDat.num.LocalJobsIdle = live.LocalJobsIdle;
+		SubDat.num.OCUWantedJobs = live.OCUWantedJobs;
+		SubDat.num.OCURunningJobs = live.OCURunningJobs;
+
+		for (const auto & [pool, live_flock] : live.flock) {
+			SubmitterFlockCounters & flock = SubDat.flock[pool];
+			flock.JobsRunning = live_flock.JobsRunning;
+			flock.WeightedJobsRunning = live_flock.WeightedJobsRunning;
+			if (FlockPools.find(pool) == FlockPools.end()) {
+				flock.JobsIdle = live_flock.JobsIdle;
+				flock.WeightedJobsIdle = live_flock.WeightedJobsIdle;
+			}
+		}
+		for (const auto & pool : FlockPools) {
+			SubmitterFlockCounters & flock = SubDat.flock[pool];
+			flock.JobsIdle = m_include_default_flock_param ? live.JobsIdle : live.DefaultFlockJobsIdle;
+			flock.WeightedJobsIdle = m_include_default_flock_param ? live.WeightedJobsIdle : live.DefaultFlockWeightedJobsIdle;
+		}
+	}
+
 	// count the number of unique owners that have jobs in the queue.
 	NumUniqueOwners = 0;
 	for (OwnerInfoMap::iterator it = OwnersInfo.begin(); it != OwnersInfo.end(); ++it) {
@@ -1727,6 +1865,7 @@ Scheduler::count_jobs()
 	cad->Assign(ATTR_TOTAL_IDLE_JOBS, JobsIdle);
 	cad->Assign(ATTR_TOTAL_RUNNING_JOBS, JobsRunning);
 	cad->Assign(ATTR_TOTAL_JOB_ADS, JobsTotalAds);
+	publishShadowMemory(cad);
 	cad->Assign(ATTR_TOTAL_HELD_JOBS, JobsHeld);
 	cad->Assign(ATTR_TOTAL_FLOCKED_JOBS, JobsFlocked);
 	cad->Assign(ATTR_TOTAL_REMOVED_JOBS, JobsRemoved);
@@ -3514,10 +3653,11 @@ int Scheduler::command_query_job_aggregates(ClassAd &queryAd, Stream* stream)
 
 
 int 
-clear_autocluster_id(JobQueueJob *job, const JOB_ID_KEY & /*jid*/, void *)
+clear_autocluster_id(JobQueueJob *job, const JOB_ID_KEY & jid, void *)
 {
 	job->Delete(ATTR_AUTO_CLUSTER_ID);
 	job->autocluster_id = -1;
+	MarkJobQueueColumnsDirty(jid);
 	return 0;
 }
 
@@ -3742,17 +3882,6 @@ count_a_job(JobQueueBase* ad, const JOB_ID_KEY& /*jid*/, void*)
 		universe = CONDOR_UNIVERSE_VANILLA;
 	}
 
-	int request_cpus = 0;
-    if (job->LookupInteger(ATTR_REQUEST_CPUS, request_cpus) == 0) {
-		request_cpus = 1;
-	}
-	
-		// Just in case it is set funny
-	if (request_cpus < 1) {
-		request_cpus = 1;
-	}
-	
-
 	// because we set job->ownerdata to NULL above, this will refresh
 	// the job->ownerdata pointer. we do this in case the accounting group
 	// or niceness has been queue-edited or otherwise changed.
@@ -3769,16 +3898,8 @@ count_a_job(JobQueueBase* ad, const JOB_ID_KEY& /*jid*/, void*)
 	// increment our count of the number of job ads in the queue
 	scheduler.JobsTotalAds++;
 
-	// Update OCU job counters
-	bool OCUWantedJob = false;
-	job->LookupBool("OCUWanted", OCUWantedJob);
-	if (OCUWantedJob) {
-		SubData->num.OCUWantedJobs += 1;
-	}
-
-	if (OCUWantedJob && (status == RUNNING || status == TRANSFERRING_OUTPUT)) {
-		SubData->num.OCURunningJobs += 1;
-	}
+	// the submitter's job counts are kept up to date by Scheduler::recountSubmitterJob()
+	// as the job changes, so only the counts of the owner and project are made here.
 
     time_t now = time(NULL);
     OwnInfo->LastHitTime = now;
@@ -3834,7 +3955,7 @@ count_a_job(JobQueueBase* ad, const JOB_ID_KEY& /*jid*/, void*)
     }
     #undef OTHER
 
-	// update per-submitter and per-owner counters
+	// update per-owner and per-project counters
 	SubmitterCounters * Counters = &SubData->num;
 	JobQueueUserRec::CountJobsCounters * OwnerCounts = &OwnInfo->num;
 	JobQueueProjectRec::CountJobsCounters * ProjectCounts = (job->project) ? &job->project->num : &NoneProjectRec.num;
@@ -3864,8 +3985,6 @@ count_a_job(JobQueueBase* ad, const JOB_ID_KEY& /*jid*/, void*)
 			OwnerCounts->SchedulerJobsIdle += (max_hosts - cur_hosts);
 			ProjectCounts->SchedulerJobsRunning += cur_hosts;
 			ProjectCounts->SchedulerJobsIdle += (max_hosts - cur_hosts);
-			Counters->SchedulerJobsRunning += cur_hosts;
-			Counters->SchedulerJobsIdle += (max_hosts - cur_hosts);
 		}
 		if (universe == CONDOR_UNIVERSE_LOCAL)
 		{
@@ -3877,8 +3996,6 @@ count_a_job(JobQueueBase* ad, const JOB_ID_KEY& /*jid*/, void*)
 			OwnerCounts->LocalJobsIdle += (max_hosts - cur_hosts);
 			ProjectCounts->LocalJobsRunning += cur_hosts;
 			ProjectCounts->LocalJobsIdle += (max_hosts - cur_hosts);
-			Counters->LocalJobsRunning += cur_hosts;
-			Counters->LocalJobsIdle += (max_hosts - cur_hosts);
 		}
 			// We want to record the cluster id of all idle MPI and parallel
 		    // jobs
@@ -3963,57 +4080,6 @@ count_a_job(JobQueueBase* ad, const JOB_ID_KEY& /*jid*/, void*)
 		int job_idle = (max_hosts - cur_hosts);
 		OwnerCounts->JobsIdle += job_idle;
 		ProjectCounts->JobsIdle += job_idle;
-		Counters->JobsIdle += job_idle;
-
-			// If we're biasing by slot weight, and the job is idle, and everything parsed...
-		int job_idle_weight;
-		if (scheduler.m_use_slot_weights && (max_hosts > cur_hosts)) {
-				// if we're biasing idle jobs by SCHEDD_SLOT_WEIGHT, eval that here
-			double job_weight = request_cpus;
-			if (scheduler.slotWeightOfJob) {
-				classad::Value value;
-				int rval = EvalExprToNumber(scheduler.slotWeightOfJob, job, NULL, value);
-				if ( ! rval || ! value.IsNumber(job_weight)) {
-					job_weight = request_cpus; // fall back if slot weight doesn't evaluate
-				}
-			} else {
-				job_weight = scheduler.guessJobSlotWeight(job);
-			}
-			job_idle_weight = job_weight * job_idle;
-		} else {
-			// here: either max_hosts == cur_hosts || !scheduler.m_use_slot_weights
-			job_idle_weight = request_cpus * job_idle;
-		}
-		Counters->WeightedJobsIdle += job_idle_weight;
-
-			// Update per-flock jobs idle
-		std::string flock_targets;
-		bool include_default_flock = param_boolean("FLOCK_BY_DEFAULT", true);
-		if (job->EvaluateAttrString(ATTR_FLOCK_TO, flock_targets)) {
-			for (auto& flock_entry: StringTokenIterator(flock_targets)) {
-				if (!strcasecmp(flock_entry.c_str(), "default")) {
-					include_default_flock = true;
-				} else {
-					auto iter = SubData->flock.insert({flock_entry, SubmitterFlockCounters()});
-					iter.first->second.JobsIdle += job_idle;
-					iter.first->second.WeightedJobsIdle += job_idle_weight;
-				}
-			}
-				// Subtract out overlap with default list of flocked pools.
-			for (auto& flock_entry: StringTokenIterator(flock_targets)) {
-				auto iter = scheduler.FlockPools.find(flock_entry);
-				if (iter != scheduler.FlockPools.end()) {
-					SubData->flock[flock_entry].JobsIdle -= job_idle;
-					SubData->flock[flock_entry].WeightedJobsIdle -= job_idle_weight;
-				}
-			}
-		}
-		if (include_default_flock) {
-			for (const auto &flock_entry : scheduler.FlockPools) {
-				SubData->flock[flock_entry].JobsIdle += job_idle;
-				SubData->flock[flock_entry].WeightedJobsIdle += job_idle_weight;
-			}
-		}
 
 			// Don't update scheduler.Owners[name].JobsRunning here.
 			// We do it in Scheduler::count_jobs().
@@ -4021,17 +4087,15 @@ count_a_job(JobQueueBase* ad, const JOB_ID_KEY& /*jid*/, void*)
 	} else if (status == HELD) {
 		OwnerCounts->JobsHeld++;
 		ProjectCounts->JobsHeld++;
-		Counters->JobsHeld++;
 	}
 
 	return 0;
 }
 
-bool
-service_this_universe(int universe, ClassAd* job)
+// returns true for the jobs that the schedd finds matches for, see service_this_universe()
+static bool
+schedd_matches_universe(int universe, ClassAd* job)
 {
-	// "service" seems to really mean find a matching resource or not...
-
 	/*  If a non-grid job is externally managed, it's been grabbed by
 		the schedd-on-the-side and we don't want to touch it.
 	 */
@@ -4049,21 +4113,7 @@ service_this_universe(int universe, ClassAd* job)
 		case CONDOR_UNIVERSE_SCHEDULER:
 			return false;
 		case CONDOR_UNIVERSE_LOCAL:
-			if (scheduler.usesLocalStartd()) {
-				bool reqsFixedup = false;
-				job->LookupBool("LocalStartupFixup", reqsFixedup);
-				if (!reqsFixedup) {
-					job->Assign("LocalStartupFixup", true);
-					ExprTree *requirements = job->LookupExpr(ATTR_REQUIREMENTS);
-					const char *rhs = ExprTreeToString(requirements);
-					std::string newRequirements = std::string("IsLocalStartd && ")  + rhs;
-					job->AssignExpr(ATTR_REQUIREMENTS, newRequirements.c_str());
-				}
-				return true;
-			} else {
-				return false;
-			}
-			break;
+			return scheduler.usesLocalStartd();
 		default:
 
 			bool sendToDS = false;
@@ -4076,6 +4126,344 @@ service_this_universe(int universe, ClassAd* job)
 	}
 }
 
+bool
+service_this_universe(int universe, ClassAd* job)
+{
+	// "service" seems to really mean find a matching resource or not...
+
+	if ( ! schedd_matches_universe(universe, job)) {
+		return false;
+	}
+
+	// local universe jobs run on the local startd, so they must only match it
+	if (universe == CONDOR_UNIVERSE_LOCAL) {
+		bool reqsFixedup = false;
+		job->LookupBool("LocalStartupFixup", reqsFixedup);
+		if (!reqsFixedup) {
+			job->Assign("LocalStartupFixup", true);
+			ExprTree *requirements = job->LookupExpr(ATTR_REQUIREMENTS);
+			const char *rhs = ExprTreeToString(requirements);
+			std::string newRequirements = std::string("IsLocalStartd && ")  + rhs;
+			job->AssignExpr(ATTR_REQUIREMENTS, newRequirements.c_str());
+		}
+	}
+	return true;
+}
+
+// Count what the job adds to its submitter's live job counts, the way count_a_job() counts it
+// but without its side effects.  count.submitter is left null for jobs that count_a_job() doesn't
+// count for a submitter.
+void
+Scheduler::countSubmitterJob(JobQueueJob * job, SubmitterJobCounters & count)
+{
+	count = SubmitterJobCounters();
+
+	int status = 0;
+	if ( ! job->IsJob() || ! job->LookupInteger(ATTR_JOB_STATUS, status)) {
+		return;
+	}
+	bool noop = false;
+	job->LookupBool(ATTR_JOB_NOOP, noop);
+	if (noop && status != COMPLETED) {
+		return; // count_jobs() will complete it
+	}
+
+	SubmitterData * SubData = nullptr;
+	if ( ! get_submitter_and_owner(job, SubData) || ! SubData) {
+		return;
+	}
+	count.submitter = SubData;
+
+	int cur_hosts = 0;
+	if ( ! job->LookupInteger(ATTR_CURRENT_HOSTS, cur_hosts)) {
+		cur_hosts = ((status == RUNNING || status == TRANSFERRING_OUTPUT) ? 1 : 0);
+	}
+	int max_hosts = 0;
+	if ( ! job->LookupInteger(ATTR_MAX_HOSTS, max_hosts)) {
+		max_hosts = ((status == IDLE) ? 1 : 0);
+	}
+	int universe = CONDOR_UNIVERSE_VANILLA;
+	if ( ! job->LookupInteger(ATTR_JOB_UNIVERSE, universe)) {
+		universe = CONDOR_UNIVERSE_VANILLA;
+	}
+
+	bool ocu_wanted = false;
+	job->LookupBool("OCUWanted", ocu_wanted);
+	count.OCUWanted = ocu_wanted;
+	count.OCURunning = ocu_wanted && (status == RUNNING || status == TRANSFERRING_OUTPUT);
+
+	if (universe == CONDOR_UNIVERSE_GRID) {
+		return; // the gridmanager counts these
+	}
+	if ( ! schedd_matches_universe(universe, job)) {
+		// Count REMOVED or HELD jobs that are in the process of being
+		// killed. cur_hosts tells us which these are.
+		if (universe == CONDOR_UNIVERSE_SCHEDULER) {
+			count.SchedulerJobsRunning = cur_hosts;
+			count.SchedulerJobsIdle = max_hosts - cur_hosts;
+		} else if (universe == CONDOR_UNIVERSE_LOCAL) {
+			count.LocalJobsRunning = cur_hosts;
+			count.LocalJobsIdle = max_hosts - cur_hosts;
+		}
+		return;
+	}
+
+	if (status == HELD) {
+		count.JobsHeld = 1;
+		return;
+	}
+	if (status != IDLE && status != RUNNING && status != TRANSFERRING_OUTPUT) {
+		return;
+	}
+
+	int request_cpus = 0;
+	if ( ! job->LookupInteger(ATTR_REQUEST_CPUS, request_cpus) || request_cpus < 1) {
+		request_cpus = 1;
+	}
+
+	int job_idle = (max_hosts - cur_hosts);
+	count.JobsIdle = job_idle;
+
+		// If we're biasing by slot weight, and the job is idle, and everything parsed...
+	if (m_use_slot_weights && (max_hosts > cur_hosts)) {
+			// if we're biasing idle jobs by SCHEDD_SLOT_WEIGHT, eval that here
+		double job_weight = request_cpus;
+		if (slotWeightOfJob) {
+			classad::Value value;
+			int rval = EvalExprToNumber(slotWeightOfJob, job, NULL, value);
+			if ( ! rval || ! value.IsNumber(job_weight)) {
+				job_weight = request_cpus; // fall back if slot weight doesn't evaluate
+			}
+		} else {
+			job_weight = guessJobSlotWeight(job);
+		}
+		count.WeightedJobsIdle = job_weight * job_idle;
+	} else {
+		// here: either max_hosts == cur_hosts || !m_use_slot_weights
+		count.WeightedJobsIdle = request_cpus * job_idle;
+	}
+
+	if (job_idle && job->EvaluateAttrString(ATTR_FLOCK_TO, count.FlockTo)) {
+		for (auto& flock_entry: StringTokenIterator(count.FlockTo)) {
+			if (!strcasecmp(flock_entry.c_str(), "default")) {
+				count.FlockDefault = true;
+			}
+		}
+	}
+}
+
+// forget a pool once nothing is counted for it, so that count_jobs() doesn't advertise
+// the submitter to it
+static void
+prune_submitter_flock_counters(SubmitterLiveCounters & live, const std::string & pool)
+{
+	auto it = live.flock.find(pool);
+	if (it != live.flock.end() && it->second == SubmitterFlockCounters()) {
+		live.flock.erase(it);
+	}
+}
+
+// add (sign 1) or take back out (sign -1) what a job adds to its submitter's live job counts
+static void
+add_submitter_job_counts(SubmitterLiveCounters & live, const SubmitterJobCounters & count, int sign)
+{
+	live.JobsIdle += sign * count.JobsIdle;
+	live.WeightedJobsIdle += sign * count.WeightedJobsIdle;
+	live.JobsHeld += sign * count.JobsHeld;
+	live.SchedulerJobsRunning += sign * count.SchedulerJobsRunning;
+	live.SchedulerJobsIdle += sign * count.SchedulerJobsIdle;
+	live.LocalJobsRunning += sign * count.LocalJobsRunning;
+	live.LocalJobsIdle += sign * count.LocalJobsIdle;
+	if (count.OCUWanted) { live.OCUWantedJobs += sign; }
+	if (count.OCURunning) { live.OCURunningJobs += sign; }
+	if (count.FlockDefault) {
+		live.DefaultFlockJobsIdle += sign * count.JobsIdle;
+		live.DefaultFlockWeightedJobsIdle += sign * count.WeightedJobsIdle;
+	}
+	// count_jobs() decides which of these are the pools of FLOCK_TO, and counts those differently
+	for (auto& flock_entry: StringTokenIterator(count.FlockTo)) {
+		if (!strcasecmp(flock_entry.c_str(), "default")) {
+			continue;
+		}
+		SubmitterFlockCounters & flock = live.flock[flock_entry];
+		flock.JobsIdle += sign * count.JobsIdle;
+		flock.WeightedJobsIdle += sign * count.WeightedJobsIdle;
+		prune_submitter_flock_counters(live, flock_entry);
+	}
+}
+
+// add (sign 1) or take back out (sign -1) what a match adds to its submitter's live job counts
+static void
+add_submitter_match_counts(SubmitterLiveCounters & live, const match_rec * rec, int sign)
+{
+	if (rec->pool) {
+		SubmitterFlockCounters & flock = live.flock[rec->pool];
+		flock.JobsRunning += sign;
+		flock.WeightedJobsRunning += sign * (int)rec->counted_weight;
+		prune_submitter_flock_counters(live, rec->pool);
+	} else {
+		live.JobsRunning += sign;
+		live.WeightedJobsRunning += sign * rec->counted_weight;
+		if ( ! live.JobsRunning) {
+			live.WeightedJobsRunning = 0; // don't keep the rounding errors
+		}
+	}
+}
+
+// Count the job again for its submitter after something it is counted by changed.
+// This is called as jobs are loaded and submitted, and when the attributes that
+// count_a_job() looks at are committed.
+void
+Scheduler::recountSubmitterJob(JobQueueJob * job)
+{
+	uncountSubmitterJob(job);
+	countSubmitterJob(job, job->submitter_counts);
+	if (job->submitter_counts.submitter) {
+		add_submitter_job_counts(job->submitter_counts.submitter->live, job->submitter_counts, 1);
+	}
+}
+
+void
+Scheduler::uncountSubmitterJob(JobQueueJob * job)
+{
+	if (job->submitter_counts.submitter) {
+		add_submitter_job_counts(job->submitter_counts.submitter->live, job->submitter_counts, -1);
+	}
+	job->submitter_counts = SubmitterJobCounters();
+}
+
+// the submitter that a match record counts for
+SubmitterData *
+Scheduler::submitter_of_match(match_rec * rec)
+{
+	if (user_is_the_new_owner) {
+		return insert_submitter(rec->user);
+	}
+	char *at_sign = strchr(rec->user, '@');
+	if ( ! at_sign) {
+		return insert_submitter(rec->user);
+	}
+	// TJ, I don't think we ever get here but just in case, we preserve the old (pre 8.9) behavior
+	*at_sign = '\0';
+	SubmitterData * SubDat = insert_submitter(rec->user);
+	*at_sign = '@';
+	return SubDat;
+}
+
+// Decide whether the match counts as a running job of its submitter, and with what weight.
+// A match from a pool we flocked to counts for that pool whether or not it is running a job yet.
+// The dedicated scheduler's matches are not counted.
+void
+Scheduler::countSubmitterMatch(match_rec * rec)
+{
+	rec->counted_submitter = nullptr;
+	rec->counted_weight = 0;
+	if (rec->is_dedicated || ( ! rec->shadowRec && ! rec->pool)) {
+		return;
+	}
+	match_rec * found = nullptr;
+	if (matches->lookup(rec->claim_id.claimId(), found) != 0 || found != rec) {
+		return; // not one of our matches (anymore)
+	}
+	rec->counted_submitter = submitter_of_match(rec);
+	rec->counted_weight = calcSlotWeight(rec);
+}
+
+// Count the match again for its submitter.  This is called when the match is added,
+// and when a shadow is started for it or goes away.
+void
+Scheduler::recountSubmitterMatch(match_rec * rec)
+{
+	uncountSubmitterMatch(rec);
+	countSubmitterMatch(rec);
+	if (rec->counted_submitter) {
+		add_submitter_match_counts(rec->counted_submitter->live, rec, 1);
+	}
+}
+
+void
+Scheduler::uncountSubmitterMatch(match_rec * rec)
+{
+	if (rec->counted_submitter) {
+		add_submitter_match_counts(rec->counted_submitter->live, rec, -1);
+		rec->counted_submitter = nullptr;
+	}
+}
+
+// job and match counts of each submitter, computed by walking the job queue and the match records
+typedef std::map<SubmitterData*, SubmitterLiveCounters> SubmitterLiveCountsMap;
+
+static int
+count_submitter_job(JobQueueJob * job, const JOB_ID_KEY & /*jid*/, void * pv)
+{
+	SubmitterLiveCountsMap * counted = (SubmitterLiveCountsMap*)pv;
+	if ( ! job || ! job->IsJob()) {
+		return 0;
+	}
+	scheduler.countSubmitterJob(job, job->submitter_counts);
+	if (job->submitter_counts.submitter) {
+		add_submitter_job_counts((*counted)[job->submitter_counts.submitter], job->submitter_counts, 1);
+	}
+	return 0;
+}
+
+static bool
+same_submitter_live_counts(const SubmitterLiveCounters & live, const SubmitterLiveCounters & counted)
+{
+	// the weight of running jobs is a sum of doubles, so it may be off by a rounding error
+	SubmitterLiveCounters rounded = counted;
+	if (fabs(live.WeightedJobsRunning - counted.WeightedJobsRunning) < 1e-6) {
+		rounded.WeightedJobsRunning = live.WeightedJobsRunning;
+	}
+	return live == rounded;
+}
+
+// Count the live job counts of every submitter again from the job queue and the match records.
+// This is done on reconfig, since the slot weights may have changed, and by checkLiveJobCounts().
+// Returns the number of submitters whose counts were wrong.
+int
+Scheduler::recountSubmitterLiveCounts(bool log_wrong)
+{
+	SubmitterLiveCountsMap counted;
+	WalkJobQueue3(count_submitter_job, &counted, WalkJobQ_count_submitter_job_runtime);
+
+	matches->startIterations();
+	match_rec *rec;
+	while (matches->iterate(rec) == 1) {
+		countSubmitterMatch(rec);
+		if (rec->counted_submitter) {
+			add_submitter_match_counts(counted[rec->counted_submitter], rec, 1);
+		}
+	}
+
+	const SubmitterLiveCounters none;
+	int wrong = 0;
+	for (auto & [name, SubDat] : Submitters) {
+		auto found = counted.find(&SubDat);
+		const SubmitterLiveCounters & right = (found != counted.end()) ? found->second : none;
+		if ( ! same_submitter_live_counts(SubDat.live, right)) {
+			++wrong;
+			if (log_wrong) {
+				dprintf(D_ALWAYS, "Live job counts of submitter %s are wrong, correcting them. "
+					"JobsIdle %d should be %d, WeightedJobsIdle %d should be %d, "
+					"JobsRunning %d should be %d, WeightedJobsRunning %g should be %g, JobsHeld %d should be %d, "
+					"LocalJobsIdle %d should be %d, LocalJobsRunning %d should be %d, "
+					"SchedulerJobsIdle %d should be %d, SchedulerJobsRunning %d should be %d, "
+					"flocked to %d pools should be %d\n",
+					SubDat.Name(),
+					SubDat.live.JobsIdle, right.JobsIdle, SubDat.live.WeightedJobsIdle, right.WeightedJobsIdle,
+					SubDat.live.JobsRunning, right.JobsRunning, SubDat.live.WeightedJobsRunning, right.WeightedJobsRunning,
+					SubDat.live.JobsHeld, right.JobsHeld,
+					SubDat.live.LocalJobsIdle, right.LocalJobsIdle, SubDat.live.LocalJobsRunning, right.LocalJobsRunning,
+					SubDat.live.SchedulerJobsIdle, right.SchedulerJobsIdle, SubDat.live.SchedulerJobsRunning, right.SchedulerJobsRunning,
+					(int)SubDat.live.flock.size(), (int)right.flock.size());
+			}
+		}
+		SubDat.live = right;
+	}
+	return wrong;
+}
+
 void
 Scheduler::incrementRecentlyAdded(OwnerInfo * ownerInfo)
 {
@@ -4962,6 +5350,13 @@ ResponsibleForPeriodicExprs( JobQueueJob *jobad, int & status )
 	}
 }
 
+// state of one pass of PeriodicExprHandler
+struct PeriodicExprPass {
+	PeriodicPolicyTracker & tracker;
+	time_t now;
+	int evaluated;
+};
+
 /*
 For a given job, evaluate any periodic expressions
 and abort, hold, or release the job as necessary.
@@ -4970,6 +5365,13 @@ and abort, hold, or release the job as necessary.
 static int
 PeriodicExprEval(JobQueueJob *jobad, const JOB_ID_KEY & /*jid*/, void * pvUser)
 {
+	PeriodicExprPass & pass = *(PeriodicExprPass*)pvUser;
+
+	// this evaluation replaces any that the job was waiting for on the timer wheel.
+	// a job that we aren't responsible for is evaluated again when the job ad changes
+	// or its shadow goes away
+	jobad->policy_due = 0;
+
 	int status=-1;
 	if(!ResponsibleForPeriodicExprs(jobad, status)) return 1;
 
@@ -4983,7 +5385,8 @@ PeriodicExprEval(JobQueueJob *jobad, const JOB_ID_KEY & /*jid*/, void * pvUser)
 		if(status<0) return 1;
 	}
 
-	UserPolicy & policy = *(UserPolicy*)pvUser;
+	UserPolicy & policy = pass.tracker.Policy();
+	pass.evaluated += 1;
 
 	policy.ResetTriggers();
 	int action = policy.AnalyzePolicy(*jobad, PERIODIC_ONLY, status);
@@ -5025,14 +5428,24 @@ PeriodicExprEval(JobQueueJob *jobad, const JOB_ID_KEY & /*jid*/, void * pvUser)
 	     ! scheduler.FindSrecByProcID(jobad->jid) )
 	{
 		DestroyProc(cluster,proc);
+		return 1;
+	}
+
+	if (action == STAYS_IN_QUEUE || action == UNDEFINED_EVAL) {
+		// nothing will change until the job ad does, or time passes
+		pass.tracker.Settle(*jobad, status, pass.now);
+	} else {
+		// a policy fired, look at the job again on the next pass as we always have
+		pass.tracker.MarkDirty(jobad->jid);
 	}
 
 	return 1;
 }
 
 /*
-For all of the jobs in the queue, evaluate the 
-periodic user policy expressions.
+For the jobs in the queue whose periodic user policy expressions
+may have a different result since the last time, evaluate them.
+After a reconfig, evaluate them for every job in the queue.
 */
 
 void
@@ -5040,15 +5453,32 @@ Scheduler::PeriodicExprHandler( int /* timerID */ )
 {
 	PeriodicExprInterval.setStartTimeNow();
 
-	UserPolicy policy;
-	policy.Init();
-	WalkJobQueue2(PeriodicExprEval, &policy);
+	PeriodicExprPass pass{periodicPolicy, time(nullptr), 0};
+	bool full_pass = periodicPolicy.NeedFullPass();
+	if (full_pass) {
+		periodicPolicy.BeginFullPass();
+		WalkJobQueue2(PeriodicExprEval, &pass);
+	} else {
+		std::set<JOB_ID_KEY> keys;
+		periodicPolicy.TakeDue(pass.now, keys);
+		for (const auto & key : keys) {
+			JobQueueJob * job = GetJobAd(key.cluster, key.proc);
+			if (job) {
+				PeriodicExprEval(job, key, &pass);
+			}
+		}
+	}
 
 	PeriodicExprInterval.setFinishTimeNow();
 
+	int skipped = MAX(TotalJobsCount - pass.evaluated, 0);
+	stats.PeriodicExprEvaluated += pass.evaluated;
+	stats.PeriodicExprSkipped += skipped;
+
 	unsigned int time_to_next_run = PeriodicExprInterval.getTimeToNextRun();
-	dprintf(D_FULLDEBUG,"Evaluated periodic expressions in %.3fs, "
+	dprintf(D_FULLDEBUG,"Evaluated periodic expressions of %d jobs (%s pass, %d skipped) in %.3fs, "
 			"scheduling next run in %us\n",
+			pass.evaluated, full_pass ? "full" : "incremental", skipped,
 			PeriodicExprInterval.getLastDuration(),
 			time_to_next_run);
 	daemonCore->Reset_Timer( periodicid, time_to_next_run );
@@ -9544,6 +9974,7 @@ Scheduler::makeReconnectRecords( PROC_ID* job, const ClassAd* match_ad )
 
 		// the match_rec also needs to point to the srec...
 	mrec->shadowRec = srec;
+	recountSubmitterMatch(mrec);
 
 		// finally, enqueue this job in our RunnableJob queue.
 	addRunnableJob( srec );
@@ -9764,6 +10195,7 @@ Scheduler::StartJob(match_rec *rec)
 		}
 		return;
 	}
+	recountSubmitterMatch(rec);
 	dprintf(D_FULLDEBUG, "Match (%s) - running %d.%d\n",
 			rec->description(), id.cluster, id.proc);
 
@@ -9931,10 +10363,10 @@ Scheduler::AddRunnableLocalJobs()
 							id.cluster, id.proc);
 						continue;
 					}
-					if (owndat->num.SchedulerJobsRunning >= scheduler.MaxRunningSchedulerJobsPerOwner) {
+					if (owndat->live.SchedulerJobsRunning >= scheduler.MaxRunningSchedulerJobsPerOwner) {
 						dprintf( D_FULLDEBUG,
 							 "Skipping idle scheduler universe job %d.%d because %s already has %d Scheduler jobs running\n",
-							 id.cluster, id.proc, owndat->Name(), owndat->num.SchedulerJobsRunning );
+							 id.cluster, id.proc, owndat->Name(), owndat->live.SchedulerJobsRunning );
 						continue;
 					}
 				} else if (scheduler.MaxRunningSchedulerJobsPerOwner == 0) {
@@ -10431,6 +10863,26 @@ Scheduler::isStillRunnable( int cluster, int proc, int &status )
 }
 
 
+// The user a shadow runs this job as, the same way init_user_ids_from_ad()
+// works it out, or empty if the job doesn't say.
+static std::string
+shadowUserOfJob( const PROC_ID & job_id )
+{
+	JobQueueJob *job = GetJobAd( job_id );
+	std::string user, buf, ntdomain;
+	if( !job ) {
+		return "";
+	}
+	if( job->EvaluateAttrString( ATTR_OS_USER, user ) ) {
+		return user;
+	}
+	if( !job->EvaluateAttrString( ATTR_USER, user ) ) {
+		return "";
+	}
+	job->EvaluateAttrString( ATTR_NT_DOMAIN, ntdomain );
+	return std::string( name_of_user( user.c_str(), buf ) ) + "@" + ntdomain;
+}
+
 void
 Scheduler::spawnShadow( shadow_rec* srec )
 {
@@ -10448,6 +10900,27 @@ Scheduler::spawnShadow( shadow_rec* srec )
 	char* 	shadow_path = NULL;
 	bool wants_reconnect = srec->is_reconnect;
 
+		// if this is a shadow for an MPI job, we need to tell the
+		// dedicated scheduler we finally spawned it so it can update
+		// some of its own data structures, too.
+	bool sendToDS = false;
+	GetAttributeBool(job_id->cluster, job_id->proc, ATTR_WANT_PARALLEL_SCHEDULING, &sendToDS);
+
+		// With MAX_JOBS_PER_SHADOW, serial jobs of the same user share
+		// shadow processes.
+	bool multiplex = MaxJobsPerShadow > 1 && !sendToDS &&
+		(universe == CONDOR_UNIVERSE_VANILLA ||
+		 universe == CONDOR_UNIVERSE_JAVA ||
+		 universe == CONDOR_UNIVERSE_VM);
+	std::string shadow_user;
+	if( multiplex ) {
+		shadow_user = shadowUserOfJob( *job_id );
+		multiplex = !shadow_user.empty();
+	}
+	if( multiplex && handJobToMultiplexedShadow( srec, shadow_user ) ) {
+		return;
+	}
+
 	shadow_path = param("SHADOW");
 
 	args.AppendArg("condor_shadow");
@@ -10461,6 +10934,10 @@ Scheduler::spawnShadow( shadow_rec* srec )
 		args.AppendArg("--reconnect");
 	}
 
+	if( multiplex ) {
+		args.AppendArg("--multiplex");
+	}
+
 	// pass the public ip/port of the schedd (used w/ reconnect)
 	// We need this even if we are not currently in reconnect mode,
 	// because the shadow may go into reconnect mode at any time.
@@ -10504,6 +10981,10 @@ Scheduler::spawnShadow( shadow_rec* srec )
 			 "(shadow pid = %d)\n", job_id->cluster, job_id->proc,
 			 mrec->description(), srec->pid );
 
+	if( multiplex ) {
+		multiplexedShadows.add( srec->pid, shadow_user );
+	}
+
     //time_t now = time(NULL);
     time_t now = stats.Tick();
     stats.ShadowsStarted += 1;
@@ -10535,12 +11016,6 @@ Scheduler::spawnShadow( shadow_rec* srec )
 						 ATTR_LAST_JOB_LEASE_RENEWAL, time(0) );
 	}
 
-		// if this is a shadow for an MPI job, we need to tell the
-		// dedicated scheduler we finally spawned it so it can update
-		// some of its own data structures, too.
-	bool sendToDS = false;
-	GetAttributeBool(job_id->cluster, job_id->proc, ATTR_WANT_PARALLEL_SCHEDULING, &sendToDS);
-
 	if( (sendToDS || universe == CONDOR_UNIVERSE_MPI ) ||
 	    (universe == CONDOR_UNIVERSE_PARALLEL) ){
 		dedicated_scheduler.shadowSpawned( srec );
@@ -11457,24 +11932,8 @@ Scheduler::start_sched_universe_job(PROC_ID* job_id)
 	}
 	SchedUniverseJobsRunning++;
 
-	// if we have a per-user scheduler jobs limit.  then also keep the
-	//  per-user count of idle and running scheduler jobs up-to-date
-	if (MaxRunningSchedulerJobsPerOwner >= 0 && MaxRunningSchedulerJobsPerOwner < MaxJobsPerOwner) {
-		SubmitterData * subdat = NULL;
-		OwnerInfo * owninfo = get_submitter_and_owner(userJob, subdat);
-		if (owninfo) {
-			if (owninfo->num.SchedulerJobsIdle > 0) {
-				owninfo->num.SchedulerJobsIdle--;
-			}
-			owninfo->num.SchedulerJobsRunning++;
-		}
-		if (subdat) {
-			if (subdat->num.SchedulerJobsIdle > 0) {
-				subdat->num.SchedulerJobsIdle--;
-			}
-			subdat->num.SchedulerJobsRunning++;
-		}
-	}
+	// the per-user limit of running scheduler jobs is checked against the live job counts,
+	// which mark_serial_job_running() has already brought up to date.
 
 	retval =  add_shadow_rec(pid, job_id, CONDOR_UNIVERSE_SCHEDULER, NULL, -1, cmd_secret.empty() ? nullptr : cmd_secret.c_str());
 
@@ -12245,13 +12704,22 @@ Scheduler::delete_shadow_rec( shadow_rec *rec )
 	}
 
 	if( pid ) {
-		shadowsByPid.erase(pid);
+		auto range = shadowsByPid.equal_range(pid);
+		for( auto it = range.first; it != range.second; ++it ) {
+			if( it->second == rec ) {
+				shadowsByPid.erase(it);
+				break;
+			}
+		}
 	}
 	shadowsByProcID.erase(rec->job_id);
 	if ( rec->conn_fd != -1 ) {
 		close(rec->conn_fd);
 	}
 
+		// the schedd may now be responsible for the job's periodic policy
+	periodicPolicy.MarkDirty(rec->job_id);
+
 	if ( rec->universe != CONDOR_UNIVERSE_SCHEDULER &&
 		 rec->universe != CONDOR_UNIVERSE_LOCAL ) {
 		numShadows -= 1;
@@ -12825,7 +13293,41 @@ set_job_status(int cluster, int proc, int status)
 void
 Scheduler::child_exit(int pid, int status)
 {
-	shadow_rec*     srec;
+	if( ! multiplexedShadows.remove(pid) ) {
+		shadow_rec *srec = FindSrecByPid(pid);
+		ASSERT(srec);
+		job_handler_exit(srec, pid, status);
+		return;
+	}
+
+		// A multiplexed shadow reports each job as it finishes with it,
+		// so any jobs it still had were cut short.  If it exited on its
+		// own, it never got to them; otherwise treat them as if their
+		// own shadow had exited the same way.
+	std::vector<shadow_rec *> srecs;
+	auto range = shadowsByPid.equal_range(pid);
+	for( auto it = range.first; it != range.second; ++it ) {
+		srecs.push_back(it->second);
+	}
+	if( srecs.empty() ) {
+		dprintf( D_FULLDEBUG, "Multiplexed shadow pid %d exited with no jobs\n", pid );
+		return;
+	}
+	dprintf( D_ALWAYS, "Multiplexed shadow pid %d exited while shadowing %zu jobs\n",
+			 pid, srecs.size() );
+
+	int job_status = status;
+	if( WIFEXITED(status) ) {
+		job_status = (WEXITSTATUS(status) == JOB_EXITED ? JOB_NOT_STARTED : JOB_EXCEPTION) << 8;
+	}
+	for( shadow_rec *srec : srecs ) {
+		job_handler_exit(srec, pid, job_status);
+	}
+}
+
+void
+Scheduler::job_handler_exit(shadow_rec *srec, int pid, int status)
+{
 	int             StartJobsFlag=TRUE;
 	PROC_ID	        job_id;
 	bool            srec_was_local_universe = false;
@@ -12834,9 +13336,6 @@ Scheduler::child_exit(int pid, int status)
 	bool            keep_claim = false; // by default, no
 	bool            srec_keep_claim_attributes;
 
-	srec = FindSrecByPid(pid);
-	ASSERT(srec);
-
 	if( srec->match ) {
 		if (srec->exit_already_handled && (srec->match->keep_while_idle == 0)) {
 			DelMrec( srec->match );
@@ -12846,6 +13345,7 @@ Scheduler::child_exit(int pid, int status)
 			if ((srec->match->keep_while_idle > 0) && ((exitstatus == JOB_EXITED) || (exitstatus == JOB_SHOULD_REMOVE) || (exitstatus == JOB_KILLED))) {
 				srec->match->setStatus(M_CLAIMED);
 				srec->match->shadowRec = NULL;
+				recountSubmitterMatch(srec->match);
 				srec->match->cluster = srec->match->proc = -1;
 				srec->match->idle_timer_deadline = time(NULL) + srec->match->keep_while_idle;
 				srec->match = NULL;
@@ -12890,7 +13390,7 @@ Scheduler::child_exit(int pid, int status)
  		// scheduler universe process
 		daemonCore->Kill_Family( pid );
 		scheduler_univ_job_exit(pid,status,srec);
-		delete_shadow_rec( pid );
+		delete_shadow_rec( srec );
 		// even though this will get set correctly in
 		// count_jobs(), try to keep it accurate here, too.
 		if( SchedUniverseJobsRunning > 0 ) {
@@ -12966,7 +13466,7 @@ Scheduler::child_exit(int pid, int status)
 
 		// We always want to delete the shadow record regardless
 		// of how the job exited
-		delete_shadow_rec( pid );
+		delete_shadow_rec( srec );
 
 	} 
 
@@ -13854,6 +14354,9 @@ Scheduler::Init()
 	// How often should Schedd write ClassAd records to daemon_history (default 15 min)
 	WriteHistRecordInterval = param_integer("SCHEDD_HISTORY_RECORD_INTERVAL", 60 * 15, 0);
 
+	// How often count_jobs() should check the live job counts against the job queue (default never)
+	LiveJobCountsCheckInterval = param_integer("SCHEDD_LIVE_JOB_COUNTS_CHECK_INTERVAL", 0, 0);
+
 		//
 		// We keep a copy of the last interval
 		// If it changes, then we need update all the job ad's
@@ -13944,6 +14447,7 @@ Scheduler::Init()
 #endif
 
 	MaxJobsRunning = param_integer("MAX_JOBS_RUNNING",default_max_jobs_running);
+	MaxJobsPerShadow = param_integer("MAX_JOBS_PER_SHADOW", 1, 1);
 
 	AllowLateMaterialize = param_boolean("SCHEDD_ALLOW_LATE_MATERIALIZE", false);
 	MaxMaterializedJobsPerCluster = param_integer("MAX_MATERIALIZED_JOBS_PER_CLUSTER", MaxMaterializedJobsPerCluster);
@@ -14264,6 +14768,9 @@ Scheduler::Init()
 
 	PeriodicExprInterval.setTimeslice( param_double("PERIODIC_EXPR_TIMESLICE", 0.01,0,1) );
 
+		// the system periodic policy may have changed, so evaluate every job on the next pass
+	periodicPolicy.Reset(param_integer("PERIODIC_EXPR_INTERVAL", 60));
+
 	RequestClaimTimeout = param_integer("REQUEST_CLAIM_TIMEOUT",60*30);
 
 	int int_val = param_integer( "JOB_IS_FINISHED_INTERVAL", 0, 0 );
@@ -14630,6 +15137,11 @@ Scheduler::Register()
 			(CommandHandlercpp)&Scheduler::RecycleShadow,
 			"RecycleShadow", this, DAEMON,
 			true /*force authentication*/);
+	 daemonCore->Register_CommandWithPayload(MULTIPLEX_SHADOW_JOB_EXIT,
+			"MULTIPLEX_SHADOW_JOB_EXIT",
+			(CommandHandlercpp)&Scheduler::MultiplexedShadowJobExit,
+			"MultiplexedShadowJobExit", this, DAEMON,
+			true /*force authentication*/);
 	 daemonCore->Register_CommandWithPayload(DIRECT_ATTACH,
 			"DIRECT_ATTACH",
 			(CommandHandlercpp)&Scheduler::CmdDirectAttach,
@@ -14843,7 +15355,7 @@ Scheduler::RegisterTimers()
         }
         cleanid =
             daemonCore->Register_Timer(QueueCleanInterval,QueueCleanInterval,
-            CleanJobQueue,"CleanJobQueue");
+            PeriodicCleanJobQueue,"PeriodicCleanJobQueue");
     }
     oldQueueCleanInterval = QueueCleanInterval;
 
@@ -14903,6 +15415,9 @@ void Scheduler::reconfig() {
 
 	RegisterTimers();			// reset timers
 
+		// the slot weights the submitters' idle and running jobs are counted with may have changed
+	recountSubmitterLiveCounts(false);
+
 
 		// clear out auto cluster id attributes
 	if ( autocluster.config(MinimalSigAttrs) ) {
@@ -15288,6 +15803,7 @@ Scheduler::AddMrec(
 		return nullptr;
 	}
 	numMatches++;
+	recountSubmitterMatch(rec);
 
 	JobQueueJob *job_ad = nullptr;
 	JobQueueCluster * cluster_ad = nullptr;
@@ -15421,6 +15937,7 @@ Scheduler::unlinkMrec(match_rec* match)
 	}
 
 	matches->remove(match->claim_id.claimId());
+	uncountSubmitterMatch(match);
 
 	matchesByJobID->remove(jobId);
 
@@ -15514,6 +16031,7 @@ Scheduler::RemoveShadowRecFromMrec( shadow_rec* shadow )
 		match_rec *mrec = shadow->match;
 		mrec->shadowRec = NULL;
 		shadow->match = NULL;
+		recountSubmitterMatch(mrec);
 
 			// re-associate match with the original job cluster
 			// and set its status back to CLAIMED
@@ -15925,7 +16443,11 @@ Scheduler::sendAlives( int /* timerID */ )
 				DelMrec( mrec );
 				jobExitCode( srec->job_id, JOB_RECONNECT_FAILED );
 				srec->exit_already_handled = true;
-				daemonCore->Send_Signal( srec->pid, SIGKILL );
+				if( isMultiplexedShadow( srec->pid ) ) {
+					sendSignalToShadow( srec->pid, SIGKILL, srec->job_id );
+				} else {
+					daemonCore->Send_Signal( srec->pid, SIGKILL );
+				}
 			}
 		}
 	}
@@ -17670,9 +18192,140 @@ private:
 	int m_sig;
 };
 
+class MultiplexedShadowAddJobMsg: public DCMsg {
+public:
+	MultiplexedShadowAddJobMsg(int pid, PROC_ID proc, ClassAd *job_ad, bool reconnect):
+		DCMsg(MULTIPLEX_SHADOW_ADD_JOB),
+		m_pid(pid),
+		m_proc(proc),
+		m_job_ad(job_ad),
+		m_reconnect(reconnect)
+	{
+	}
+
+	bool writeMsg( DCMessenger * /*messenger*/, Sock *sock ) override
+	{
+		return sock->put( (int)m_reconnect ) &&
+			putClassAd( sock, *m_job_ad );
+	}
+
+	MessageClosureEnum messageSent( DCMessenger *messenger, Sock *sock ) override
+	{
+		m_job_ad.reset();
+		messenger->startReceiveMsg( this, sock );
+		return MESSAGE_CONTINUING;
+	}
+
+	bool readMsg( DCMessenger * /*messenger*/, Sock *sock ) override
+	{
+		int accepted = 0;
+		if( !sock->get( accepted ) ) {
+			dprintf( D_ALWAYS, "Failed to read reply from shadow pid %d for job %d.%d\n",
+					 m_pid, m_proc.cluster, m_proc.proc );
+			return false;
+		}
+		if( !accepted ) {
+			dprintf( D_ALWAYS, "Shadow pid %d refused job %d.%d\n",
+					 m_pid, m_proc.cluster, m_proc.proc );
+		}
+		return accepted != 0;
+	}
+
+	void messageSendFailed( DCMessenger *messenger ) override
+	{
+		scheduler.multiplexedShadowRefusedJob( m_pid, m_proc );
+		DCMsg::messageSendFailed( messenger );
+	}
+
+	void messageReceiveFailed( DCMessenger *messenger ) override
+	{
+		scheduler.multiplexedShadowRefusedJob( m_pid, m_proc );
+		DCMsg::messageReceiveFailed( messenger );
+	}
+
+private:
+	int m_pid;
+	PROC_ID m_proc;
+	std::unique_ptr<ClassAd> m_job_ad;
+	bool m_reconnect;
+};
+
+class MultiplexedShadowSignalJobMsg: public DCMsg {
+public:
+	MultiplexedShadowSignalJobMsg(int pid, int sig, PROC_ID proc):
+		DCMsg(MULTIPLEX_SHADOW_SIGNAL_JOB),
+		m_pid(pid),
+		m_proc(proc),
+		m_sig(sig)
+	{
+	}
+
+	bool writeMsg( DCMessenger * /*messenger*/, Sock *sock ) override
+	{
+		return sock->put( m_proc.cluster ) &&
+			sock->put( m_proc.proc ) &&
+			sock->put( m_sig );
+	}
+
+	bool readMsg( DCMessenger * /*messenger*/, Sock * /*sock*/ ) override
+	{
+		return true;
+	}
+
+	MessageClosureEnum messageSent( DCMessenger *messenger, Sock *sock ) override
+	{
+			// same bookkeeping as DCShadowKillMsg
+		shadow_rec *srec = scheduler.FindSrecByProcID( m_proc );
+		if( srec && srec->pid == m_pid ) {
+			switch(m_sig)
+			{
+			case DC_SIGSUSPEND:
+			case DC_SIGCONTINUE:
+				break;
+			default:
+				srec->preempt_pending = false;
+				srec->preempted = true;
+			}
+		}
+		return DCMsg::messageSent( messenger, sock );
+	}
+
+	void messageSendFailed( DCMessenger *messenger ) override
+	{
+		shadow_rec *srec = scheduler.FindSrecByProcID( m_proc );
+		if( srec && srec->pid == m_pid ) {
+			srec->preempt_pending = false;
+		}
+		DCMsg::messageSendFailed( messenger );
+	}
+
+private:
+	int m_pid;
+	PROC_ID m_proc;
+	int m_sig;
+};
+
 void
 Scheduler::sendSignalToShadow(pid_t pid,int sig,PROC_ID proc)
 {
+	if( isMultiplexedShadow(pid) ) {
+			// only signal this job, not the others in the same shadow
+		shadow_rec *srec = FindSrecByProcID( proc );
+		char const *shadow_addr = daemonCore->InfoCommandSinfulString( pid );
+		if( shadow_addr ) {
+			classy_counted_ptr<Daemon> shadow = new Daemon( DT_SHADOW, shadow_addr );
+			classy_counted_ptr<MultiplexedShadowSignalJobMsg> msg =
+				new MultiplexedShadowSignalJobMsg( pid, sig, proc );
+			shadow->sendMsg( msg.get() );
+		}
+		if( sig == SIGKILL && srec && srec->pid == pid ) {
+				// A killed shadow is reaped right away; the shadow
+				// drops the job without reporting back.
+			job_handler_exit( srec, pid, SIGKILL );
+		}
+		return;
+	}
+
 	classy_counted_ptr<DCShadowKillMsg> msg = new DCShadowKillMsg(pid,sig,proc);
 	daemonCore->Send_Signal_nonblocking(msg.get());
 
@@ -17836,6 +18489,7 @@ Scheduler::RecycleShadow(int /*cmd*/, Stream *stream)
 	srec->pid = shadow_pid;
 	srec->match = mrec;
 	mrec->shadowRec = srec;
+	recountSubmitterMatch(mrec);
 	srec->job_id = new_job_id;
 	srec->prev_job_id = prev_job_id;
 	srec->recycle_shadow_stream = stream;
@@ -17918,6 +18572,148 @@ Scheduler::finishRecycleShadow(shadow_rec *srec)
 	delete stream;
 }
 
+int
+Scheduler::MultiplexedShadowJobExit(int /*cmd*/, Stream *stream)
+{
+		// This is called by a multiplexed shadow when it is done with
+		// one of its jobs.  The exit reason is handled just like the
+		// exit code of a shadow that runs a single job.
+	int shadow_pid = 0;
+	PROC_ID job_id;
+	int exit_reason = 0;
+
+	stream->decode();
+	if( !stream->get( shadow_pid ) ||
+		!stream->get( job_id.cluster ) ||
+		!stream->get( job_id.proc ) ||
+		!stream->get( exit_reason ) ||
+		!stream->end_of_message() )
+	{
+		dprintf(D_ALWAYS,
+			"MultiplexedShadowJobExit() failed to receive job exit reason from shadow\n");
+		return FALSE;
+	}
+
+	shadow_rec *srec = FindSrecByProcID( job_id );
+	int ok = srec && srec->pid == shadow_pid && isMultiplexedShadow( shadow_pid );
+
+	stream->encode();
+	if( !stream->put( ok ) || !stream->end_of_message() ) {
+		dprintf(D_ALWAYS,
+			"MultiplexedShadowJobExit() failed to reply to shadow pid %d\n",
+			shadow_pid);
+	}
+
+	if( !ok ) {
+			// we already gave up on this job, e.g. because it was removed
+		dprintf(D_FULLDEBUG,
+			"Shadow pid %d reports exit of job %d.%d, which it is not shadowing\n",
+			shadow_pid, job_id.cluster, job_id.proc);
+		return TRUE;
+	}
+
+	dprintf(D_ALWAYS,
+		"Shadow pid %d for job %d.%d reports job exit reason %d.\n",
+		shadow_pid, job_id.cluster, job_id.proc, exit_reason);
+
+	job_handler_exit( srec, shadow_pid, exit_reason << 8 );
+	return TRUE;
+}
+
+bool
+Scheduler::handJobToMultiplexedShadow( shadow_rec* srec, const std::string & user )
+{
+		// Pick the multiplexed shadow of this job's user with the fewest
+		// jobs that still has room for this one.
+	size_t fewest_jobs = 0;
+	int shadow_pid = multiplexedShadows.pick( user, MaxJobsPerShadow,
+		[this]( int pid ) { return shadowsByPid.count( pid ); }, fewest_jobs );
+	if( !shadow_pid ) {
+		return false;
+	}
+	char const *shadow_addr = daemonCore->InfoCommandSinfulString( shadow_pid );
+	if( !shadow_addr ) {
+		multiplexedShadows.stopAccepting( shadow_pid );
+		return false;
+	}
+
+	PROC_ID job_id = srec->job_id;
+	match_rec *mrec = srec->match;
+	bool wants_reconnect = srec->is_reconnect;
+
+	srec->pid = 0;
+	add_shadow_rec( srec );
+	stats.ShadowsRunning = numShadows;
+
+	ClassAd *job_ad = GetExpandedJobAd( job_id, true );
+	if( !job_ad ) {
+		dprintf( D_ALWAYS, "ERROR: Failed to get classad for job "
+				 "%d.%d, can't hand it to a shadow, aborting\n",
+				 job_id.cluster, job_id.proc );
+		mark_job_stopped( &job_id );
+		delete_shadow_rec( srec );
+		return true;
+	}
+	std::string secret;
+	if (GetPrivateAttributeString(job_id.cluster, job_id.proc, ATTR_CLAIM_ID, secret) == 0) {
+		job_ad->Assign(ATTR_CLAIM_ID, secret);
+	}
+	if (GetPrivateAttributeString(job_id.cluster, job_id.proc, ATTR_CLAIM_IDS, secret) == 0) {
+		job_ad->Assign(ATTR_CLAIM_IDS, secret);
+	}
+
+	srec->pid = shadow_pid;
+	add_shadow_rec_pid( srec );
+
+	classy_counted_ptr<Daemon> shadow = new Daemon( DT_SHADOW, shadow_addr );
+	classy_counted_ptr<MultiplexedShadowAddJobMsg> msg =
+		new MultiplexedShadowAddJobMsg( shadow_pid, job_id, job_ad, wants_reconnect );
+	shadow->sendMsg( msg.get() );
+
+	dprintf( D_ALWAYS, "Handed job %d.%d on %s to shadow pid %d, "
+			 "now shadowing %zu jobs\n", job_id.cluster, job_id.proc,
+			 mrec->description(), shadow_pid, fewest_jobs + 1 );
+
+	if( wants_reconnect ) {
+			// see spawnShadow()
+		mrec->setStatus( M_ACTIVE );
+		mrec->cluster = job_id.cluster;
+		mrec->proc = job_id.proc;
+		SetAttributeInt( job_id.cluster, job_id.proc,
+						 ATTR_LAST_JOB_LEASE_RENEWAL, time(0) );
+	}
+	return true;
+}
+
+void
+Scheduler::multiplexedShadowRefusedJob( int pid, PROC_ID job_id )
+{
+		// Whatever the reason, don't give this shadow any more jobs.
+	multiplexedShadows.stopAccepting( pid );
+
+	shadow_rec *srec = FindSrecByProcID( job_id );
+	if( !srec || srec->pid != pid ) {
+		return;
+	}
+
+		// Undo what handJobToMultiplexedShadow() did and start the job
+		// in a shadow of its own.
+	auto range = shadowsByPid.equal_range( pid );
+	for( auto pit = range.first; pit != range.second; ++pit ) {
+		if( pit->second == srec ) {
+			shadowsByPid.erase( pit );
+			break;
+		}
+	}
+	shadowsByProcID.erase( srec->job_id );
+	numShadows -= 1;
+	srec->pid = 0;
+
+	dprintf( D_ALWAYS, "Starting a new shadow for job %d.%d\n",
+			 job_id.cluster, job_id.proc );
+	spawnShadow( srec );
+}
+
 int
 Scheduler::FindGManagerPid(PROC_ID job_id)
 {
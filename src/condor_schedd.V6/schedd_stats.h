@@ -107,6 +107,8 @@ typedef struct ScheddStatistics : public ScheddJobCounters {
 
    stats_entry_recent<int> Autoclusters;   // number of active autoclusters
    stats_entry_recent<int> ResourceRequestsSent;   // number of resource requests
+   stats_entry_recent<int> PeriodicExprEvaluated;  // number of jobs whose periodic policy was evaluated
+   stats_entry_recent<int> PeriodicExprSkipped;    // number of jobs whose periodic policy could not have changed, so was not evaluated
 
    // These track how successful the schedd was at reconnecting to
    // running jobs after the last restart.
@@ -133,6 +135,9 @@ typedef struct ScheddStatistics : public ScheddJobCounters {
    //stats_entry_recent<int> ShadowExceptions;     // number of times shadows have excepted
    stats_entry_recent<int> ShadowsReconnections; // number of times shadows have reconnected
 
+   // number of durable commits made durable by each fsync of a group commit
+   stats_entry_probe<double> JobQueueGroupCommitSize;
+
 
    // non-published values
    time_t InitTime;            // last time we init'ed the structure
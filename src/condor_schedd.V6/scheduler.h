@@ -60,6 +60,8 @@
 #include "job_transforms.h"
 #include "history_queue.h"
 #include "live_job_counters.h"
+#include "periodic_policy.h"
+#include "multiplexed_shadows.h"
 
 extern  int         STARTD_CONTACT_TIMEOUT;
 const	int			NEGOTIATOR_CONTACT_TIMEOUT = 30;
@@ -155,6 +157,31 @@ struct SubmitterFlockCounters {
   int WeightedJobsRunning{0};
   int JobsIdle{0};
   int WeightedJobsIdle{0};
+  bool operator==(const SubmitterFlockCounters &) const = default;
+};
+
+// A submitter's job counts that are kept up to date as its jobs and match records change,
+// rather than recounted by every count_jobs().  count_jobs() copies them into the SubmitterCounters
+// and per-pool flock counters that the submitter ads are made from.  Jobs are counted the way
+// count_a_job() counts them (see SubmitterJobCounters), and running jobs are counted from the
+// match records, the home pool's separately from each pool the schedd flocked to.
+struct SubmitterLiveCounters {
+  int JobsIdle{0};
+  int WeightedJobsIdle{0};
+  int DefaultFlockJobsIdle{0}; // idle of the jobs whose FlockTo includes "default"
+  int DefaultFlockWeightedJobsIdle{0};
+  int JobsHeld{0};
+  int SchedulerJobsRunning{0};
+  int SchedulerJobsIdle{0};
+  int LocalJobsRunning{0};
+  int LocalJobsIdle{0};
+  int OCUWantedJobs{0};
+  int OCURunningJobs{0};
+  int JobsRunning{0}; // matches from the home pool that are running a job
+  double WeightedJobsRunning{0};
+  // idle of the jobs that name the pool in their FlockTo, and the matches from the pool
+  std::map<std::string, SubmitterFlockCounters> flock;
+  bool operator==(const SubmitterLiveCounters &) const = default;
 };
 
 // counters within the SubmitterData struct that are cleared and re-computed by count_jobs.
@@ -204,6 +231,7 @@ struct SubmitterData {
   const char * Name() const { return name.empty() ? "" : name.c_str(); }
   bool empty() const { return name.empty(); }
   SubmitterCounters num;
+  SubmitterLiveCounters live; // job counts that are always up-to-date with the committed job state and the match records
   std::unordered_map<std::string, SubmitterFlockCounters> flock; // Per-pool flock information
   std::unordered_set<std::string> owners; // Number of unique owners observed using this submitter.
   time_t LastHitTime; // records the last time we incremented num.Hit, use to expire Owners
@@ -264,6 +292,11 @@ class match_rec
 	ClassAd * my_match_ad{nullptr};
 	ClassAd m_added_attrs;
 
+		// what this match adds to its submitter's live job counts,
+		// see Scheduler::recountSubmitterMatch()
+	struct SubmitterData * counted_submitter{nullptr};
+	double counted_weight{0};
+
 	bool is_dedicated{false}; // true if this match belongs to ded. sched.
 	bool allocated{false}; // For use by the DedicatedScheduler
 	bool scheduled{false}; // For use by the DedicatedScheduler
@@ -501,12 +534,16 @@ class Scheduler : public Service
 	int				spoolJobFilesReaper(int,int);	
 	int				transferJobFilesReaper(int,int);
 	void			PeriodicExprHandler( int timerID = -1 );
+	PeriodicPolicyTracker & PeriodicPolicy() { return periodicPolicy; }
 	void			addCronTabClassAd( JobQueueJob* );
 	void			addCronTabClusterId( int );
 	void			indexAJob(JobQueueJob* job, bool loading_job_queue=false);
 	void			removeJobFromIndexes(const JOB_ID_KEY& job_id, int job_prio=0);
 	int				RecycleShadow(int cmd, Stream *stream);
 	void			finishRecycleShadow(shadow_rec *srec);
+	int				MultiplexedShadowJobExit(int cmd, Stream *stream);
+	void			multiplexedShadowRefusedJob(int pid, PROC_ID job_id);
+	bool			isMultiplexedShadow(int pid) const { return multiplexedShadows.contains(pid); }
 	int				CmdDirectAttach(int cmd, Stream* stream);
 
 	int			FindGManagerPid(PROC_ID job_id);
@@ -553,6 +590,7 @@ class Scheduler : public Service
 	void			StartJobHandler( int timerID = -1 );
 	void			addRunnableJob( shadow_rec* );
 	void			spawnShadow( shadow_rec* );
+	bool			handJobToMultiplexedShadow( shadow_rec*, const std::string & user );
 	void			spawnLocalStarter( shadow_rec* );
 	bool			claimLocalStartd();
 	bool			isStillRunnable( int cluster, int proc, int &status );
@@ -690,6 +728,14 @@ class Scheduler : public Service
 	// live counters for running/held/idle jobs
 	LiveJobCounters liveJobCounts; // job counts that are always up-to-date with the committed job state
 
+	// keep the live job counts of each submitter (SubmitterData::live) up to date
+	void recountSubmitterJob(JobQueueJob * job);
+	void uncountSubmitterJob(JobQueueJob * job);
+	void recountSubmitterMatch(match_rec * rec);
+	void uncountSubmitterMatch(match_rec * rec);
+	int  recountSubmitterLiveCounts(bool log_wrong);
+	void countSubmitterJob(JobQueueJob * job, SubmitterJobCounters & count);
+
 	// fsync tracking by user
 	std::map<std::string, stats_entry_probe<double>> FsyncRuntimes;
 	
@@ -807,9 +853,12 @@ private:
 	// parameters controling the scheduling and starting shadow
 	Timeslice       SchedDInterval;
 	Timeslice       PeriodicExprInterval;
+	PeriodicPolicyTracker periodicPolicy;	// which jobs PeriodicExprHandler needs to evaluate
 	int             periodicid;
 	int				QueueCleanInterval;
 	int				WriteHistRecordInterval{0};
+	int				LiveJobCountsCheckInterval{0};	// how often count_jobs() checks the live job counts, 0 is never
+	time_t			LiveJobCountsCheckTime{0};
 	int             RequestClaimTimeout;
 	int				JobStartDelay;
 	int				JobStartCount;
@@ -818,6 +867,7 @@ private:
 	int             MaxNextJobDelay;
 	int				JobsThisBurst;
 	int				MaxJobsRunning;
+	int				MaxJobsPerShadow;
 	bool			AllowLateMaterialize;
 	bool			EnablePersistentOwnerInfo;
 	bool			EnablePersistentProjectInfo;
@@ -940,6 +990,10 @@ private:
 	void		sumAllSubmitterData(SubmitterData &all);
 	void		updateSubmitterAd(SubmitterData &submitterData, ClassAd &pAd, DCCollector *collector,  int flock_level, time_t time_now);
 	int			count_jobs();
+	void		checkLiveJobCounts();
+	void		countSubmitterMatch(match_rec * rec);
+	SubmitterData * submitter_of_match(match_rec * rec);
+	void		publishShadowMemory(ClassAd *ad);
 	bool		fill_submitter_ad(ClassAd & pAd, const SubmitterData & Owner, const std::string &pool_name, int flock_level);
 	int			make_ad_list(ClassAdList & ads, ClassAd * pQueryAd=NULL);
 	int			handleMachineAdsQuery( Stream * stream, ClassAd & queryAd );
@@ -962,6 +1016,7 @@ private:
 	void		remove_unused_owners();
 	bool		any_userrec_refs(JobQueueUserRec * urec); // returns true if any schedd data structures are holding this given ptr
 	void			child_exit(int, int);
+	void			job_handler_exit(shadow_rec *srec, int pid, int status);
 	// AFAICT, reapers should be be registered void to begin with.
 	int				child_exit_from_reaper(int a, int b) { child_exit(a, b); return 0; }
 	void			scheduler_univ_job_exit(int pid, int status, shadow_rec * srec);
@@ -1038,7 +1093,10 @@ private:
 
 	HashTable <std::string, match_rec *> *matches;
 	HashTable <PROC_ID, match_rec *> *matchesByJobID;
-	std::map<int, shadow_rec *> shadowsByPid;
+		// a multiplexed shadow (MAX_JOBS_PER_SHADOW) has one entry
+		// per job it is running
+	std::multimap<int, shadow_rec *> shadowsByPid;
+	MultiplexedShadows multiplexedShadows;
 	std::map<PROC_ID, shadow_rec *> shadowsByProcID;
 	std::map<int, std::vector<PROC_ID> *> spoolJobFileWorkers;
 	int				numMatches;
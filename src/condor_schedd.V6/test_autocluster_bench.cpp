@@ -0,0 +1,293 @@
+/***************************************************************
+ *
+ * Copyright (C) 2025, Condor Team, Computer Sciences Department,
+ * University of Wisconsin-Madison, WI.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you
+ * may not use this file except in compliance with the License.  You may
+ * obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ ***************************************************************/
+
+// Benchmark for the schedd's autoclusters.  A queue of synthetic jobs is
+// made whose significant attributes take a given number of distinct
+// values, and the time is measured to put every job into an autocluster
+// (as after the schedd starts or the jobs are submitted), to make a pass
+// when every job already has one (as each time the schedd rebuilds its
+// list of runnable jobs), to move some of the jobs to other autoclusters
+// after a significant attribute changes, to aggregate the queue on other
+// attributes (as condor_q -autocluster does), and to remove every job.
+// The autoclusters and their jobs are checked along the way.
+//
+// autocluster.cpp is linked by itself, so the few job queue functions
+// that it calls are defined here.
+
+#include "condor_common.h"
+#include "condor_config.h"
+#include "condor_debug.h"
+#include "condor_attributes.h"
+#include "proc.h"
+#include "autocluster.h"
+#include "qmgmt.h"
+#include "schedd_stats.h"
+
+#include <chrono>
+
+static std::vector<JobQueueJob*> jobs;
+
+double last_autocluster_runtime = 0;
+bool   last_autocluster_make_sig = false;
+int    last_autocluster_type = 0;
+
+void JobQueueBase::PopulateFromAd() {}
+void JobQueueJob::PopulateFromAd() {}
+void MarkJobQueueColumnsDirty(const JOB_ID_KEY & /*jid*/) {}
+
+void
+WalkJobQueue3( queue_job_scan_func fn, void * pv, schedd_runtime_probe & /*ftm*/ )
+{
+	for ( auto * job : jobs ) {
+		if ( fn( job, job->jid, pv ) < 0 ) {
+			break;
+		}
+	}
+}
+
+static const char * requirements =
+	"(TARGET.Arch == \"X86_64\") && (TARGET.OpSys == \"LINUX\") && (TARGET.Disk >= RequestDisk) && "
+	"(TARGET.Memory >= RequestMemory) && (TARGET.Cpus >= RequestCpus) && (TARGET.HasFileTransfer)";
+
+// jobs of the same kind have the same significant attributes.  every kind has
+// its own DiskUsage, which the significant attributes refer to through RequestDisk
+static void
+set_kind( JobQueueJob & job, int kind )
+{
+	job.Assign( ATTR_DISK_USAGE, 1000 + kind );
+}
+
+static int
+kind_of( JobQueueJob & job )
+{
+	int disk_usage = 0;
+	job.LookupInteger( ATTR_DISK_USAGE, disk_usage );
+	return disk_usage - 1000;
+}
+
+static JobQueueJob *
+make_job( int i, int num_kinds )
+{
+	JOB_ID_KEY jid( 1 + i / 100, i % 100 );
+	JobQueueJob * job = new JobQueueJob( jid );
+	int kind = i % num_kinds;
+	std::string buf;
+
+	job->Assign( ATTR_CLUSTER_ID, jid.cluster );
+	job->Assign( ATTR_PROC_ID, jid.proc );
+	formatstr( buf, "user%d", kind % 50 );
+	job->Assign( ATTR_OWNER, buf );
+	job->Assign( ATTR_JOB_STATUS, IDLE );
+	job->Assign( ATTR_JOB_UNIVERSE, CONDOR_UNIVERSE_VANILLA );
+	job->Assign( ATTR_JOB_PRIO, i % 7 );
+	job->Assign( ATTR_Q_DATE, 1700000000 + i );
+	job->Assign( ATTR_REQUEST_CPUS, 1 + (kind / 50) % 8 );
+	job->Assign( ATTR_REQUEST_MEMORY, 1024 * (1 + (kind / 400) % 8) );
+	set_kind( *job, kind );
+	job->InsertViaCache( ATTR_REQUEST_DISK, "DiskUsage" );
+	job->InsertViaCache( ATTR_REQUIREMENTS, requirements );
+	job->InsertViaCache( ATTR_RANK, "0.0" );
+	return job;
+}
+
+static void
+report( const char * label, std::chrono::steady_clock::time_point begin, size_t count, const char * what )
+{
+	double secs = std::chrono::duration<double>( std::chrono::steady_clock::now() - begin ).count();
+	printf( "%-16s %8.3f s  %10.0f %s/s\n", label, secs, secs > 0 ? count / secs : 0.0, what );
+}
+
+// put every job into an autocluster, the way the schedd does when it builds
+// the prio rec array.  returns false if the autoclusters aren't what the kinds
+// of the jobs say they should be
+static bool
+assign_all( const char * label, AutoCluster & autocluster, int * num_signatures )
+{
+	*num_signatures = 0;
+	auto begin = std::chrono::steady_clock::now();
+	for ( auto * job : jobs ) {
+		last_autocluster_make_sig = false;
+		job->autocluster_id = autocluster.getAutoClusterid( job );
+		if ( last_autocluster_make_sig ) { ++*num_signatures; }
+	}
+	report( label, begin, jobs.size(), "jobs" );
+
+	// every job of a kind should be in the same autocluster, and no two kinds should share one
+	std::map<int, int> id_of_kind;
+	std::set<int> ids;
+	for ( auto * job : jobs ) {
+		auto [it, inserted] = id_of_kind.emplace( kind_of( *job ), job->autocluster_id );
+		if ( inserted ) {
+			if ( ! ids.insert( job->autocluster_id ).second ) {
+				fprintf( stderr, "%s: two kinds of jobs share autocluster %d\n", label, job->autocluster_id );
+				return false;
+			}
+		} else if ( it->second != job->autocluster_id ) {
+			fprintf( stderr, "%s: job %d.%d is in autocluster %d, not %d\n", label,
+				job->jid.cluster, job->jid.proc, job->autocluster_id, it->second );
+			return false;
+		}
+	}
+	if ( autocluster.getNumAutoclusters() != (int)id_of_kind.size() ) {
+		fprintf( stderr, "%s: %d autoclusters for %d kinds of jobs\n", label,
+			autocluster.getNumAutoclusters(), (int)id_of_kind.size() );
+		return false;
+	}
+	return true;
+}
+
+// aggregate the jobs on the given attributes, and check that each job is counted once
+static bool
+aggregate( const char * label, AutoCluster & autocluster, const char * projection, int expected )
+{
+	auto begin = std::chrono::steady_clock::now();
+	JobAggregationResults * jar = autocluster.aggregateOn( false, projection, -1, nullptr );
+	bool ok = jar && jar->compute() && jar->rewind();
+	int results = 0;
+	long long counted = 0;
+	ClassAd * ad = nullptr;
+	while ( ok && (ad = jar->next()) ) {
+		int job_count = 0;
+		ad->LookupInteger( "JobCount", job_count );
+		counted += job_count;
+		++results;
+	}
+	delete jar;
+	report( label, begin, jobs.size(), "jobs" );
+
+	if ( results != expected || counted != (long long)jobs.size() ) {
+		fprintf( stderr, "%s: %d results counting %lld jobs, expected %d results counting %d jobs\n",
+			label, results, counted, expected, (int)jobs.size() );
+		return false;
+	}
+	return true;
+}
+
+static void
+usage( const char * self )
+{
+	fprintf( stderr, "Usage: %s [-jobs N] [-autoclusters N] [-cache]\n", self );
+	exit( 1 );
+}
+
+int
+main( int argc, const char * argv[] )
+{
+	int num_jobs = 1000000;
+	int num_kinds = 5000;
+	bool use_cache = false;
+
+	for ( int i = 1; i < argc; ++i ) {
+		if ( ! strcmp( argv[i], "-cache" ) ) {
+			use_cache = true;
+			continue;
+		}
+		if ( i + 1 >= argc ) { usage( argv[0] ); }
+		if ( ! strcmp( argv[i], "-jobs" ) ) {
+			num_jobs = atoi( argv[++i] );
+		} else if ( ! strcmp( argv[i], "-autoclusters" ) ) {
+			num_kinds = atoi( argv[++i] );
+		} else {
+			usage( argv[0] );
+		}
+	}
+	if ( num_jobs < 1 || num_kinds < 1 ) {
+		usage( argv[0] );
+	}
+
+	config();
+	if ( use_cache ) {
+		classad::ClassAdSetExpressionCaching( true );
+	}
+
+	AutoCluster autocluster;
+	classad::References basic_attrs;
+	basic_attrs.insert( ATTR_REQUIREMENTS );
+	basic_attrs.insert( ATTR_RANK );
+	autocluster.config( basic_attrs, "Requirements,Rank,RequestCpus,RequestMemory,RequestDisk,Owner" );
+
+	printf( "%d jobs of %d kinds%s\n", num_jobs, num_kinds, use_cache ? ", classad cache" : "" );
+
+	auto begin = std::chrono::steady_clock::now();
+	jobs.reserve( num_jobs );
+	for ( int i = 0; i < num_jobs; ++i ) {
+		jobs.push_back( make_job( i, num_kinds ) );
+	}
+	report( "make jobs", begin, jobs.size(), "jobs" );
+
+	int result = 0;
+	int num_signatures = 0;
+	if ( ! assign_all( "assign", autocluster, &num_signatures ) ) { result = 1; }
+	if ( num_signatures != num_jobs ) {
+		fprintf( stderr, "assign: made %d signatures for %d jobs\n", num_signatures, num_jobs );
+		result = 1;
+	}
+	printf( "%d autoclusters\n", autocluster.getNumAutoclusters() );
+
+	if ( ! assign_all( "reassign", autocluster, &num_signatures ) ) { result = 1; }
+	if ( num_signatures != 0 ) {
+		fprintf( stderr, "reassign: made %d signatures when every job had an autocluster\n", num_signatures );
+		result = 1;
+	}
+
+	// move every 10th job to a new kind of its own kind.  when the number of kinds
+	// is a multiple of 10, some of the old kinds lose all of their jobs
+	begin = std::chrono::steady_clock::now();
+	int num_moved = 0;
+	for ( int i = 0; i < num_jobs; i += 10 ) {
+		JobQueueJob & job = *jobs[i];
+		int kind = kind_of( job ) + num_kinds;
+		autocluster.preSetAttribute( job, ATTR_DISK_USAGE, std::to_string( 1000 + kind ).c_str(), 0 );
+		set_kind( job, kind );
+		++num_moved;
+	}
+	report( "change", begin, num_moved, "jobs" );
+	if ( ! assign_all( "assign changed", autocluster, &num_signatures ) ) { result = 1; }
+	if ( num_signatures != num_moved ) {
+		fprintf( stderr, "assign changed: made %d signatures for %d changed jobs\n", num_signatures, num_moved );
+		result = 1;
+	}
+
+	std::set<std::string> owners;
+	for ( auto * job : jobs ) {
+		std::string owner;
+		job->LookupString( ATTR_OWNER, owner );
+		owners.insert( owner );
+	}
+	int num_owners = (int)owners.size();
+	if ( ! aggregate( "aggregate", autocluster, ATTR_OWNER, num_owners ) ) { result = 1; }
+
+	begin = std::chrono::steady_clock::now();
+	for ( auto * job : jobs ) {
+		autocluster.removeFromAutocluster( *job );
+	}
+	report( "remove", begin, jobs.size(), "jobs" );
+	if ( autocluster.getNumAutoclusters() != 0 ) {
+		fprintf( stderr, "remove: %d autoclusters left after every job was removed\n", autocluster.getNumAutoclusters() );
+		result = 1;
+	}
+
+	for ( auto * job : jobs ) {
+		delete job;
+	}
+	jobs.clear();
+
+	printf( "%s\n", result ? "FAILED" : "OK" );
+	return result;
+}
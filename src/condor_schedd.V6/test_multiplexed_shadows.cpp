@@ -0,0 +1,127 @@
+/***************************************************************
+ *
+ * Copyright (C) 2025, Condor Team, Computer Sciences Department,
+ * University of Wisconsin-Madison, WI.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you
+ * may not use this file except in compliance with the License.  You may
+ * obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ ***************************************************************/
+
+// Test of the way the schedd gives jobs to multiplexed shadows.  Jobs of
+// two users are started the way spawnShadow() starts them, and no shadow
+// may ever be given a job of a user other than the one it was started for.
+
+#include "condor_common.h"
+#include "multiplexed_shadows.h"
+
+static MultiplexedShadows shadows;
+static std::map<int, std::vector<std::string>> jobs_of_shadow;
+static int next_pid = 100;
+
+static size_t
+num_jobs( int pid )
+{
+	return jobs_of_shadow[pid].size();
+}
+
+// start a job of the given user, in a shadow of that user that has room,
+// or else in a new shadow.  returns the shadow's pid
+static int
+start_job( const std::string & user, size_t max_jobs )
+{
+	size_t jobs = 0;
+	int pid = shadows.pick( user, max_jobs, num_jobs, jobs );
+	if ( ! pid ) {
+		pid = next_pid++;
+		shadows.add( pid, user );
+	} else if ( jobs != num_jobs( pid ) ) {
+		fprintf( stderr, "shadow %d has %zu jobs, but pick() said %zu\n", pid, num_jobs( pid ), jobs );
+	}
+	jobs_of_shadow[pid].push_back( user );
+	return pid;
+}
+
+static bool
+check( const char * label, size_t max_jobs )
+{
+	bool ok = true;
+	for ( auto & [pid, users] : jobs_of_shadow ) {
+		if ( users.size() > max_jobs ) {
+			fprintf( stderr, "%s: shadow %d has %zu jobs, more than %zu\n", label, pid, users.size(), max_jobs );
+			ok = false;
+		}
+		for ( auto & user : users ) {
+			if ( user != users.front() ) {
+				fprintf( stderr, "%s: shadow %d has jobs of %s and %s\n", label, pid,
+					users.front().c_str(), user.c_str() );
+				ok = false;
+			}
+		}
+	}
+	printf( "%-24s %s\n", label, ok ? "ok" : "FAILED" );
+	return ok;
+}
+
+int
+main( int /*argc*/, const char * /*argv*/[] )
+{
+	const size_t max_jobs = 3;
+	const std::string alice = "alice@example.com";
+	const std::string bob = "bob@example.com";
+	int result = 0;
+
+	// alternate the users, so each one's shadows are there for the other's jobs
+	for ( int i = 0; i < 12; ++i ) {
+		start_job( (i % 2) ? bob : alice, max_jobs );
+	}
+	if ( ! check( "two users", max_jobs ) ) { result = 1; }
+	if ( shadows.size() != 4 ) {
+		fprintf( stderr, "two users: %zu shadows for 6 jobs of each of 2 users, expected 4\n", shadows.size() );
+		result = 1;
+	}
+
+	// a job of a user with no shadow of their own gets a new one,
+	// even though the other user's shadows have room
+	int alice_pid = jobs_of_shadow.begin()->first;
+	jobs_of_shadow[alice_pid].pop_back();
+	int pid = start_job( bob, max_jobs );
+	if ( jobs_of_shadow[pid].size() != 1 ) {
+		fprintf( stderr, "room: bob's job went to shadow %d with %zu jobs\n", pid, jobs_of_shadow[pid].size() );
+		result = 1;
+	}
+	if ( ! check( "room for the other user", max_jobs ) ) { result = 1; }
+
+	// a shadow that won't take jobs, or has gone away, isn't picked
+	size_t jobs = 0;
+	shadows.stopAccepting( alice_pid );
+	for ( auto & [spid, users] : jobs_of_shadow ) {
+		if ( users.front() == alice && spid != alice_pid ) {
+			shadows.remove( spid );
+		}
+	}
+	if ( shadows.pick( alice, max_jobs, num_jobs, jobs ) != 0 ) {
+		fprintf( stderr, "picked a shadow of alice that doesn't take jobs\n" );
+		result = 1;
+	}
+	if ( ! shadows.contains( alice_pid ) || ! shadows.remove( alice_pid ) || shadows.remove( alice_pid ) ) {
+		fprintf( stderr, "remove: shadow %d wasn't removed exactly once\n", alice_pid );
+		result = 1;
+	}
+	if ( shadows.pick( bob, max_jobs, num_jobs, jobs ) != pid ) {
+		fprintf( stderr, "remove: bob's shadow %d with room wasn't picked\n", pid );
+		result = 1;
+	}
+
+	printf( "%s\n", result ? "FAILED" : "OK" );
+	return result;
+}
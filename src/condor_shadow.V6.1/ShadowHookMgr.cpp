@@ -56,13 +56,15 @@ std::string getCredDir()
 	return cred_dir;
 }
 
-ShadowHookMgr::ShadowHookMgr()
-	: JobHookClientMgr()
+ShadowHookMgr::ShadowHookMgr(BaseShadow *shadow)
+	: JobHookClientMgr(),
+	m_shadow(shadow)
 {}
 
 
 ShadowHookMgr::~ShadowHookMgr()
 {
+	m_shadow->makeCurrent();
 		// Always try to delete the credential directory.
 	std::string cred_dir;
 	if ((cred_dir = getCredDir()) == "") {
@@ -106,6 +108,7 @@ ShadowHookMgr::tryHookPrepareJob()
 	}
 
 	std::string hook_stdin;
+	m_shadow->makeCurrent();
 	auto job_ad = Shadow->getJobAd();
 	if (!job_ad) {
 		dprintf(D_ERROR, "Shadow does not have a copy of the job ad.\n");
@@ -113,7 +116,7 @@ ShadowHookMgr::tryHookPrepareJob()
 	}
 	sPrintAd(hook_stdin, *job_ad);
 
-	auto hook_client = new HookShadowPrepareJobClient(m_hook_prepare_job);
+	auto hook_client = new HookShadowPrepareJobClient(m_hook_prepare_job, m_shadow);
 	auto hook_name = getHookTypeString(hook_client->type());
 
 	Env env;
@@ -151,12 +154,14 @@ ShadowHookMgr::tryHookPrepareJob()
 }
 
 
-HookShadowPrepareJobClient::HookShadowPrepareJobClient(const std::string &hook_path)
-	: HookClient(HOOK_SHADOW_PREPARE_JOB, hook_path.c_str(), true)
+HookShadowPrepareJobClient::HookShadowPrepareJobClient(const std::string &hook_path, BaseShadow *shadow)
+	: HookClient(HOOK_SHADOW_PREPARE_JOB, hook_path.c_str(), true),
+	m_shadow(shadow)
 {}
 
 void
 HookShadowPrepareJobClient::hookExited(int exit_status) {
+	m_shadow->makeCurrent();
 	std::string hook_name(getHookTypeString(type()));
 	HookClient::hookExited(exit_status);
 
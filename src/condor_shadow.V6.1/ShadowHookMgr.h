@@ -23,12 +23,14 @@
 #include "HookClientMgr.h"
 #include "HookClient.h"
 
+class BaseShadow;
+
 std::string getCredDir();
 
 class ShadowHookMgr final : public JobHookClientMgr
 {
 public:
-	ShadowHookMgr();
+	ShadowHookMgr(BaseShadow *shadow);
 	virtual ~ShadowHookMgr();
 
 	virtual bool reconfig() override;
@@ -50,6 +52,8 @@ private:
 	std::string m_hook_prepare_job;
 
 	ArgList m_args;
+
+	BaseShadow *m_shadow;
 };
 
 /**
@@ -60,10 +64,13 @@ class HookShadowPrepareJobClient : public HookClient
 	friend class ShadowHookMgr;
 public:
 
-	HookShadowPrepareJobClient(const std::string &hook_path);
+	HookShadowPrepareJobClient(const std::string &hook_path, BaseShadow *shadow);
 
 	/**
 	 * Hook has exited.
 	 */
 	virtual void hookExited(int exit_status) override;
+
+private:
+	BaseShadow *m_shadow;
 };
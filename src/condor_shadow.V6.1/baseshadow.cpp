@@ -65,7 +65,9 @@ BaseShadow::BaseShadow() {
 	core_file_name = NULL;
 	scheddAddr = NULL;
 	job_updater = NULL;
-	ASSERT( !myshadow_ptr );	// make cetain we're only instantiated once
+		// make cetain we're only instantiated once, unless we're
+		// hosting many jobs
+	ASSERT( !myshadow_ptr || multiplexShadow );
 	myshadow_ptr = this;
 	exception_already_logged = false;
 	began_execution = FALSE;
@@ -82,18 +84,44 @@ BaseShadow::BaseShadow() {
 	attemptingReconnectAtStartup = false;
 	m_force_fast_starter_shutdown = false;
 	m_committed_time_finalized = false;
+	m_allowed_job_duration_tid = -1;
+	m_job_exited = false;
 }
 
 BaseShadow::~BaseShadow() {
-	myshadow_ptr = NULL;
+	if( myshadow_ptr == this ) {
+		myshadow_ptr = NULL;
+	}
 	if (jobAd) FreeJobAd(jobAd);
 	if (gjid) free(gjid);
 	if (scheddAddr) free(scheddAddr);
 	if( job_updater ) delete job_updater;
 	if (m_cleanup_retry_tid != -1) daemonCore->Cancel_Timer(m_cleanup_retry_tid);
+	if (m_allowed_job_duration_tid != -1) daemonCore->Cancel_Timer(m_allowed_job_duration_tid);
 	free( core_file_name );
 }
 
+void
+BaseShadow::exitJob( int reason )
+{
+	if( !multiplexShadow ) {
+			// does not return.
+		DC_Exit( reason );
+	}
+	if( m_job_exited ) {
+		return;
+	}
+	m_job_exited = true;
+	multiplexedJobExit( this, reason );
+}
+
+void
+BaseShadow::makeCurrent()
+{
+	Shadow = this;
+	myshadow_ptr = this;
+}
+
 void
 BaseShadow::baseInit( ClassAd *job_ad, const char* schedd_addr, const char *xfer_queue_contact_info )
 {
@@ -251,8 +279,9 @@ BaseShadow::baseInit( ClassAd *job_ad, const char* schedd_addr, const char *xfer
 		if (pending == TRUE) {
 			// If the classad of this job "thinks" that this job should be
 			// finished already, let's enact that belief.
-			// This function does not return.
+			// This function does not return, unless we're multiplexed.
 			this->terminateJob(US_TERMINATE_PENDING);
+			return;
 		}
 	}
 
@@ -307,6 +336,7 @@ BaseShadow::baseInit( ClassAd *job_ad, const char* schedd_addr, const char *xfer
 	// when we get here, the claiming is finished, successful
 	// or not
 void BaseShadow::startdClaimedCB(DCMsgCallback *) {
+	makeCurrent();
 
 	// We've claimed the startd, the following kicks off the
 	// activation of the claim, and runs the job
@@ -378,7 +408,8 @@ BaseShadow::shutDown(int reason, const char* reason_str, int reason_code, int re
 {
 		// exit now if there is no job ad
 	if ( !getJobAd() ) {
-		DC_Exit( reason );
+		exitJob( reason );
+		return;
 	}
 		//Attempt to write Job ad to epoch file
 		//If knob isn't set or there is no job ad the function will just log and return
@@ -441,8 +472,9 @@ BaseShadow::reconnectFailed( const char* reason )
 		evictJob(exit_reason, reason, CONDOR_HOLD_CODE::ReconnectFailed);
 	}
 
-	// Should never get here....
-	ASSERT(false);
+	// Only a multiplexed shadow gets here; it is done with this job
+	// and goes on with its others.
+	ASSERT( multiplexShadow );
 }
 
 std::string
@@ -583,7 +615,8 @@ BaseShadow::holdJob( const char* reason, int hold_reason_code, int hold_reason_s
 
 	if( ! jobAd ) {
 		dprintf( D_ALWAYS, "In HoldJob() for job %d.%d w/ NULL JobAd!\n", getCluster(), getProc() );
-		DC_Exit( JOB_SHOULD_HOLD );
+		exitJob( JOB_SHOULD_HOLD );
+		return;
 	}
 
 	dprintf(D_ALWAYS, "Job %d.%d going into Hold state (code %d,%d): %s\n",
@@ -620,7 +653,7 @@ BaseShadow::holdJobAndExit( const char* reason, int hold_reason_code, int hold_r
 	// here it exits later with a different error code that causes the job
 	// to be rescheduled.
 	// exitAfterEvictingJob( JOB_SHOULD_HOLD );
-	DC_Exit( JOB_SHOULD_HOLD );
+	exitJob( JOB_SHOULD_HOLD );
 }
 
 void
@@ -646,7 +679,8 @@ BaseShadow::mockTerminateJob( std::string exit_reason,
 	if( ! jobAd ) {
 		dprintf(D_ALWAYS, "BaseShadow::mockTerminateJob(): NULL JobAd! "
 			"Holding Job!");
-		DC_Exit( JOB_SHOULD_HOLD );
+		exitJob( JOB_SHOULD_HOLD );
+		return;
 	}
 
 	// Insert the various exit attributes into our job ad.
@@ -711,7 +745,8 @@ BaseShadow::retryJobCleanup()
 		        "(SHADOW_MAX_JOB_CLEANUP_RETRIES=%d) reached"
 		        "; Forcing job requeue!\n",
 		        m_max_cleanup_retries);
-		DC_Exit(JOB_SHOULD_REQUEUE);
+		exitJob(JOB_SHOULD_REQUEUE);
+		return;
 	}
 	ASSERT(m_cleanup_retry_tid == -1);
 	m_cleanup_retry_tid = daemonCore->Register_Timer(m_cleanup_retry_delay, 0,
@@ -727,6 +762,7 @@ void
 BaseShadow::retryJobCleanupHandler( int /* timerID */ )
 {
 	m_cleanup_retry_tid = -1;
+	makeCurrent();
 	dprintf(D_ALWAYS, "Retrying job cleanup, calling terminateJob()\n");
 	terminateJob();
 }
@@ -792,7 +828,8 @@ BaseShadow::terminateJob( update_style_t kind ) // has a default argument of US_
 			// email the user, but get values from jobad
 		emailTerminateEvent( reason, kind );
 
-		DC_Exit( reason );
+		exitJob( reason );
+		return;
 	}
 
 	// the default path when kind == US_NORMAL
@@ -889,8 +926,8 @@ BaseShadow::terminateJob( update_style_t kind ) // has a default argument of US_
 		return;
 	}
 
-	// does not return.
-	DC_Exit( reason );
+	// does not return, unless we're a multiplexed shadow.
+	exitJob( reason );
 }
 
 
@@ -951,7 +988,8 @@ BaseShadow::evictJob( int exit_reason, const char* reason_str, int reason_code,
 
 	if( ! jobAd ) {
 		dprintf( D_ALWAYS, "In evictJob() w/ NULL JobAd!\n" );
-		DC_Exit( exit_reason );
+		exitJob( exit_reason );
+		return;
 	}
 
 		// record details about this vacate into the job ad
@@ -1537,11 +1575,11 @@ BaseShadow::resourceBeganExecution( RemoteResource* /* rr */ )
 
 	int allowed_job_duration;
 	if( jobAd->LookupInteger( ATTR_JOB_ALLOWED_JOB_DURATION, allowed_job_duration ) ) {
-		int tid = daemonCore->Register_Timer( allowed_job_duration + 1, 0,
+		m_allowed_job_duration_tid = daemonCore->Register_Timer( allowed_job_duration + 1, 0,
 			(TimerHandlercpp)&BaseUserPolicy::checkPeriodic,
 			"check_for_allowed_job_duration",
 			& shadow_user_policy );
-		if( tid < 0 ) {
+		if( m_allowed_job_duration_tid < 0 ) {
 			dprintf( D_ALWAYS, "Failed to register timer to check for allowed job duration, jobs may run a little long.\n" );
 		}
 	}
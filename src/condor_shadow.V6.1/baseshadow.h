@@ -115,10 +115,10 @@ class BaseShadow : public Service
 		/**	Called by any part of the shadow that finally decides the
 			reconnect has completely failed, we should give up, try
 			one last time to release the claim, write a UserLog event
-			about it, and exit with a special status.
+			about it, and exit with a special status.  (A multiplexed
+			shadow returns once it is done with the job.)
 			@param reason Why we gave up (for UserLog, dprintf, etc)
 		*/
-	PREFAST_NORETURN
 	void reconnectFailed( const char* reason );
 
 	virtual bool shouldAttemptReconnect(RemoteResource *) { return true;};
@@ -127,6 +127,26 @@ class BaseShadow : public Service
 		*/
 	virtual void config();
 
+		/** We're done with this job.  A shadow running a single job
+			exits with the given reason and this does not return.  A
+			multiplexed shadow reports the reason to the schedd,
+			forgets about this job and returns to its other jobs, so
+			callers must return right away without touching the job.
+			@param reason The reason the job exited (JOB_BLAH_BLAH)
+		*/
+	void exitJob( int reason );
+
+		/// Has exitJob() been called (only possible if multiplexed)?
+	bool jobExited() const { return m_job_exited; }
+
+		/** Make this the shadow the globals (Shadow, myshadow_ptr)
+			refer to.  A multiplexed shadow hosts many jobs, and code
+			that isn't handed its shadow object, like the remote
+			system calls and the job hooks, finds it that way, so each
+			DaemonCore callback into a job calls this first.
+		*/
+	void makeCurrent();
+
 		/** Everyone should be able to shut down.<p>
 			@param reason The reason the job exited (JOB_BLAH_BLAH)
 		 */
@@ -229,7 +249,7 @@ class BaseShadow : public Service
 			some cases that means we need to wait around for the starter
 			to tell us what happened.
 		*/
-	virtual void exitAfterEvictingJob( int reason ) { DC_Exit( reason ); }
+	virtual void exitAfterEvictingJob( int reason ) { exitJob( reason ); }
 	virtual bool exitDelayed( int & /*reason*/ ) { return false; }
 
 		/** The total number of bytes sent over the network on
@@ -453,6 +473,12 @@ class BaseShadow : public Service
 	void startdClaimedCB(DCMsgCallback *cb);
 	bool m_lazy_queue_update;
 
+		/// Timer that enforces the job's allowed duration
+	int m_allowed_job_duration_tid;
+
+		/// Set by exitJob()
+	bool m_job_exited;
+
 	ClassAd m_prev_run_upload_file_stats;
 	ClassAd m_prev_run_download_file_stats;
 
@@ -516,6 +542,13 @@ extern void dumpClassad( const char*, ClassAd*, int );
 // Returns false if no new job found.
 extern bool recycleShadow(int previous_job_exit_reason);
 
+// True if this shadow process hosts many jobs (the --multiplex argument).
+extern bool multiplexShadow;
+
+// Report the exit reason of one job hosted by a multiplexed shadow to
+// the schedd and delete its shadow object once we're back in DaemonCore.
+extern void multiplexedJobExit( BaseShadow *shadow, int reason );
+
 // fix the update ad from the starter to work around starter bugs.
 extern void fix_update_ad(ClassAd & update_ad);
 
@@ -438,6 +438,7 @@ void
 RemoteResource::attemptShutdownTimeout( int /* timerID */ )
 {
 	m_attempt_shutdown_tid = -1;
+	makeCurrent();
 	attemptShutdown();
 }
 
@@ -488,6 +489,17 @@ RemoteResource::attemptShutdown()
 	shadow->shutDown( exit_reason, "" );
 }
 
+void
+RemoteResource::makeCurrent()
+{
+	shadow->makeCurrent();
+	if( multiplexShadow ) {
+			// a multiplexed shadow only hosts jobs with a single
+			// remote resource, so this must be the one
+		thisRemoteResource = this;
+	}
+}
+
 int
 RemoteResource::handleSysCalls( Stream * /* sock */ )
 {
@@ -497,6 +509,7 @@ RemoteResource::handleSysCalls( Stream * /* sock */ )
 
 	syscall_sock = claim_sock;
 	thisRemoteResource = this;
+	shadow->makeCurrent();
 
 	if (do_REMOTE_syscall() < 0) {
 		dprintf(D_SYSCALLS,"Shadow: do_REMOTE_syscall returned < 0\n");
@@ -1086,6 +1099,8 @@ RemoteResource::setJobAd( ClassAd *jA )
 void
 RemoteResource::updateFromStarterTimeout( int /* timerID */ )
 {
+	makeCurrent();
+
 	// If we landed here, then we expected to receive an update from the starter,
 	// but it didn't arrive yet.  Even if the remote syscall sock is still connected,
 	// failing to receive an update could mean that the starter is wedged or dead
@@ -2047,6 +2062,7 @@ RemoteResource::reconnect( void )
 		formatstr( reason, "Job disconnected too long: %s (%d seconds) expired",
 		           ATTR_JOB_LEASE_DURATION, lease_duration );
 		shadow->reconnectFailed( reason.c_str() );
+		return;
 	}
 	dprintf( D_ALWAYS, "%s remaining: %lld\n", ATTR_JOB_LEASE_DURATION,
 			 (long long)remaining );
@@ -2081,6 +2097,7 @@ RemoteResource::attemptReconnect( int /* timerID */ )
 		// now that the timer went off, clear out this variable so we
 		// don't get confused later.
 	next_reconnect_tid = -1;
+	makeCurrent();
 
 		// if if this attempt fails, we need to remember we tried
 	reconnect_attempts++;
@@ -2217,6 +2234,7 @@ int
 RemoteResource::transferStatusUpdateCallback(FileTransfer *transobject)
 {
 	ASSERT(jobAd);
+	makeCurrent();
 
 	const FileTransfer::FileTransferInfo& info = transobject->GetInfo();
 	dprintf(D_FULLDEBUG,"RemoteResource::transferStatusUpdateCallback(in_progress=%d)\n",info.in_progress);
@@ -2665,6 +2683,7 @@ RemoteResource::updateX509Proxy(const char * filename)
 void 
 RemoteResource::checkX509Proxy( int /* timerID */ )
 {
+	makeCurrent();
 	if( state != RR_EXECUTING ) {
 		dprintf(D_FULLDEBUG,"checkX509Proxy() doing nothing, because resource is not in EXECUTING state.\n");
 		return;
@@ -553,6 +553,10 @@ private:
 	void startCheckingProxy();
 	void attemptShutdownTimeout( int timerID = -1 );
 	void attemptShutdown();
+
+		// Point the shadow globals at our job before handling a timer
+		// or callback (see BaseShadow::makeCurrent()).
+	void makeCurrent();
 	int transferStatusUpdateCallback(FileTransfer *transobject);
 
 	bool doneInitFileTransfer {false};
@@ -45,13 +45,24 @@ UniShadow::UniShadow() : delayedExitReason( -1 ) {
 }
 
 UniShadow::~UniShadow() {
+		// the hook manager looks at our job ad as it cleans up
+	m_hook_mgr.reset();
 	if ( remRes ) delete remRes;
 	if ( commonFTO ) delete commonFTO;
 	if ( producer_keep_alive != -1 ) {
 		daemonCore->Cancel_Timer( producer_keep_alive );
 	}
 	if ( cfLock ) delete cfLock;
-	daemonCore->Cancel_Command( CREDD_GET_CRED );
+	if ( m_exit_hook_timer_tid != -1 ) {
+		daemonCore->Cancel_Timer( m_exit_hook_timer_tid );
+	}
+	if ( m_exit_lease_tid != -1 ) {
+		daemonCore->Cancel_Timer( m_exit_lease_tid );
+	}
+		// a multiplexed shadow keeps the command for its other jobs
+	if ( !multiplexShadow ) {
+		daemonCore->Cancel_Command( CREDD_GET_CRED );
+	}
 }
 
 
@@ -106,6 +117,9 @@ UniShadow::init( ClassAd* job_ad, const char* schedd_addr, const char *xfer_queu
 
 		// base init takes care of lots of stuff:
 	baseInit( job_ad, schedd_addr, xfer_queue_contact_info );
+	if( jobExited() ) {
+		return;
+	}
 
 		// we're only dealing with one host, so the rest is pretty
 		// trivial.  we can just lookup everything we need in the job
@@ -121,15 +135,20 @@ UniShadow::init( ClassAd* job_ad, const char* schedd_addr, const char *xfer_queu
 	checkInputFileTransfer();
 
 
-		// Register command which the starter uses to fetch a user's Kerberose/Afs auth credential
-	daemonCore->
-		Register_Command( CREDD_GET_CRED, "CREDD_GET_CRED",
-						  &cred_get_cred_handler,
-						  "cred_get_cred_handler", DAEMON,
-						  true /*force authentication*/ );
+		// Register command which the starter uses to fetch a user's Kerberose/Afs auth credential.
+		// A multiplexed shadow registers it once for all of its jobs.
+	static bool registered_cred_handler = false;
+	if ( !multiplexShadow || !registered_cred_handler ) {
+		daemonCore->
+			Register_Command( CREDD_GET_CRED, "CREDD_GET_CRED",
+							  &cred_get_cred_handler,
+							  "cred_get_cred_handler", DAEMON,
+							  true /*force authentication*/ );
+		registered_cred_handler = true;
+	}
 
 		// Register our job hooks
-	m_hook_mgr = std::unique_ptr<ShadowHookMgr>(new ShadowHookMgr());
+	m_hook_mgr = std::unique_ptr<ShadowHookMgr>(new ShadowHookMgr(this));
 	if (!m_hook_mgr->initialize(job_ad)) {
 		m_hook_mgr.reset();
 	}
@@ -181,6 +200,8 @@ UniShadow::spawn()
 void
 UniShadow::hookTimeout( int /* timerID */ )
 {
+	m_exit_hook_timer_tid = -1;
+	makeCurrent();
 	dprintf(D_ERROR, "Timed out waiting for a hook to exit\n");
 	BaseShadow::log_except("Submit-side job hook execution timed out");
 	shutDown(JOB_NOT_STARTED, "Shadow prepare hook timed out");
@@ -320,7 +341,7 @@ void UniShadow::removeJob( const char* reason )
 	if ( iPrevExitReason != JOB_SHOULD_REMOVE && iPrevExitReason != -1)
 	{
 		// don't wait for final update b/c there isn't one.
-		DC_Exit( JOB_SHOULD_REMOVE );
+		exitJob( JOB_SHOULD_REMOVE );
 	}
 }
 
@@ -640,11 +661,11 @@ UniShadow::exitAfterEvictingJob( int reason ) {
 	// do important-looking things between calling cleanUp() and calling
 	// DC_Exit().
 	if( remRes->gotJobDone() || remRes->getClaimSock() == NULL ) {
-		DC_Exit( reason );
+		exitJob( reason );
 	} else {
 		this->delayedExitReason = reason;
 		remRes->setExitReason( reason );
-		daemonCore->Register_Timer( 20, 0,
+		m_exit_lease_tid = daemonCore->Register_Timer( 20, 0,
 				(TimerHandlercpp)&UniShadow::exitLeaseHandler,
 				"exit lease handler", this );
 	}
@@ -660,8 +681,10 @@ UniShadow::exitDelayed( int &reason ) {
 }
 
 void
-UniShadow::exitLeaseHandler( int /* timerID */ ) const {
-	DC_Exit( delayedExitReason );
+UniShadow::exitLeaseHandler( int /* timerID */ ) {
+	m_exit_lease_tid = -1;
+	makeCurrent();
+	exitJob( delayedExitReason );
 }
 
 void
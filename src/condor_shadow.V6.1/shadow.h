@@ -205,7 +205,7 @@ class UniShadow : public BaseShadow
 	virtual void exitAfterEvictingJob( int reason );
 	virtual bool exitDelayed( int &reason );
 
-	void exitLeaseHandler( int timerID = -1 ) const;
+	void exitLeaseHandler( int timerID = -1 );
 
 	ClassAd *getJobAd() { return remRes ? remRes->getJobAd() : nullptr; };
 
@@ -239,6 +239,7 @@ class UniShadow : public BaseShadow
 	int m_exit_hook_timer_tid{-1};
 
 	int delayedExitReason;
+	int m_exit_lease_tid{-1};
 
 	void requestJobRemoval();
 };
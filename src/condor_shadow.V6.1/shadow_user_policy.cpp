@@ -63,6 +63,7 @@ ShadowUserPolicy::doAction( int action, bool is_periodic )
 	std::string reason;
 	int reason_code;
 	int reason_subcode;
+	shadow->makeCurrent();
 	this->user_policy.FiringReason(reason,reason_code,reason_subcode);
 	if ( reason.empty() ) {
 		EXCEPT( "ShadowUserPolicy: Empty FiringReason." );
@@ -62,6 +62,18 @@ static const char * xfer_queue_contact_info = NULL;
 bool sendUpdatesToSchedd = true;
 static time_t shadow_worklife_expires = 0;
 
+// A multiplexed shadow (--multiplex) runs the job it was started with
+// and then any more the schedd hands it with MULTIPLEX_SHADOW_ADD_JOB,
+// all on this one DaemonCore loop.  Shadow points at whichever of them
+// we're working on at the moment.
+bool multiplexShadow = false;
+static std::map<PROC_ID, BaseShadow *> MultiplexedShadows;
+	// set once we shouldn't take any more jobs
+static bool multiplex_draining = false;
+static int multiplex_idle_tid = -1;
+	// how long a multiplexed shadow with no jobs waits for another
+static const int MULTIPLEX_IDLE_TIMEOUT = 60;
+
 static void
 usage( int argc, char* argv[] )
 {
@@ -154,6 +166,11 @@ parseArgs( int argc, char *argv[] )
 			continue;
 		}
 
+		if (strcmp(opt, "--multiplex") == 0) {
+			multiplexShadow = true;
+			continue;
+		}
+
 			// the only other argument we understand is the
 			// filename we should read our ClassAd from, "-" for
 			// STDIN.  There's no further checking we need to do 
@@ -291,6 +308,16 @@ initShadow( ClassAd* ad )
 				 CondorUniverseName(universe) );
 		EXCEPT( "Universe not supported" );
 	}
+	if( multiplexShadow ) {
+		PROC_ID job_id;
+		job_id.cluster = cluster;
+		job_id.proc = proc;
+		MultiplexedShadows[job_id] = Shadow;
+		if( multiplex_idle_tid != -1 ) {
+			daemonCore->Cancel_Timer( multiplex_idle_tid );
+			multiplex_idle_tid = -1;
+		}
+	}
 	Shadow->init( ad, schedd_addr, xfer_queue_contact_info );
 }
 
@@ -313,6 +340,9 @@ void startShadow( ClassAd *ad )
 	}
 
 	initShadow( ad );
+	if( Shadow->jobExited() ) {
+		return;
+	}
 
 	// Process configuration for writing epoch history start ClassAd (i.e. historical SPAWN ad)
 	classad::References filter;
@@ -357,6 +387,8 @@ void startShadow( ClassAd *ad )
 			Shadow->logDataflowJobSkippedEvent(); // Must get called before Shadow->shutDown
 			dprintf(D_ALWAYS, "Job %d.%d is a dataflow job, skipping\n", cluster, proc);
 			Shadow->shutDown( JOB_EXITED, "" );
+				// only a multiplexed shadow gets here
+			return;
 		}
 		else {
 			Shadow->updateJobAttr(ATTR_DATAFLOW_JOB_SKIPPED, "false");
@@ -380,38 +412,243 @@ void startShadow( ClassAd *ad )
 }
 
 
-int handleSignals(int sig)
+static int
+signalShadow( BaseShadow *shadow, int sig )
 {
 	int iRet =0;
-	if( Shadow ) 
+	switch (sig)
 	{
-		
-		switch (sig)
-		{
-			case SIGUSR1: // remove the job
-				iRet =  Shadow->handleJobRemoval(sig);
-				break;
-			case DC_SIGSUSPEND: // send down a signal to suspend the job
-				dprintf( D_ALWAYS, "***SUSPEND THE JOB\n");
-				iRet =  Shadow->JobSuspend(sig);
-				break;
-			case DC_SIGCONTINUE: // send down a signal to continue the job
-				dprintf( D_ALWAYS, "***CONTINUE THE JOB\n");
-				iRet =  Shadow->JobResume(sig);
-				break;
-			case UPDATE_JOBAD:
-				iRet =  Shadow->handleUpdateJobAd(sig);
-				break;
-			default: 
-				break;
-				
+		case SIGUSR1: // remove the job
+			iRet =  shadow->handleJobRemoval(sig);
+			break;
+		case DC_SIGSUSPEND: // send down a signal to suspend the job
+			dprintf( D_ALWAYS, "***SUSPEND THE JOB\n");
+			iRet =  shadow->JobSuspend(sig);
+			break;
+		case DC_SIGCONTINUE: // send down a signal to continue the job
+			dprintf( D_ALWAYS, "***CONTINUE THE JOB\n");
+			iRet =  shadow->JobResume(sig);
+			break;
+		case UPDATE_JOBAD:
+			iRet =  shadow->handleUpdateJobAd(sig);
+			break;
+		default: 
+			break;
+	}
+	return iRet;
+}
+
+// A copy of the jobs a multiplexed shadow is hosting, safe to walk
+// while some of them finish.
+static std::vector<BaseShadow *>
+multiplexedShadowList()
+{
+	std::vector<BaseShadow *> shadows;
+	for( const auto &[job_id, shadow] : MultiplexedShadows ) {
+		shadows.push_back( shadow );
+	}
+	return shadows;
+}
+
+int handleSignals(int sig)
+{
+	int iRet =0;
+	if( multiplexShadow ) {
+			// a signal to the process is for all of our jobs; the
+			// schedd signals a single job with MULTIPLEX_SHADOW_SIGNAL_JOB
+		for( BaseShadow *shadow : multiplexedShadowList() ) {
+			if( !shadow->jobExited() ) {
+				shadow->makeCurrent();
+				iRet = signalShadow( shadow, sig );
+			}
 		}
-		
+	}
+	else if( Shadow ) 
+	{
+		iRet = signalShadow( Shadow, sig );
 	}
 	return iRet;
 }
 
 
+static void
+multiplexIdleTimeout( int /* timerID */ )
+{
+	multiplex_idle_tid = -1;
+	if( MultiplexedShadows.empty() ) {
+		dprintf( D_ALWAYS, "No jobs to shadow for %d seconds, exiting.\n",
+				 MULTIPLEX_IDLE_TIMEOUT );
+		DC_Exit( JOB_EXITED );
+	}
+}
+
+static void
+deleteMultiplexedShadow( BaseShadow *shadow )
+{
+	bool was_current = (Shadow == shadow);
+	delete shadow;
+	if( was_current ) {
+		Shadow = MultiplexedShadows.empty() ? NULL : MultiplexedShadows.begin()->second;
+	}
+	BaseShadow::myshadow_ptr = Shadow;
+
+	if( MultiplexedShadows.empty() ) {
+		if( multiplex_draining ) {
+			dprintf( D_ALWAYS, "Done with all jobs, exiting.\n" );
+			DC_Exit( JOB_EXITED );
+		}
+		if( multiplex_idle_tid == -1 ) {
+			multiplex_idle_tid = daemonCore->Register_Timer( MULTIPLEX_IDLE_TIMEOUT,
+				&multiplexIdleTimeout, "multiplexIdleTimeout" );
+		}
+	}
+}
+
+void
+multiplexedJobExit( BaseShadow *shadow, int reason )
+{
+	PROC_ID job_id;
+	job_id.cluster = shadow->getCluster();
+	job_id.proc = shadow->getProc();
+
+	auto it = MultiplexedShadows.find( job_id );
+	if( it == MultiplexedShadows.end() || it->second != shadow ) {
+			// the schedd already took this job back from us
+		return;
+	}
+	MultiplexedShadows.erase( it );
+
+	dprintf( D_ALWAYS, "Job %d.%d exiting with reason %d; still shadowing %zu other jobs.\n",
+			 job_id.cluster, job_id.proc, reason, MultiplexedShadows.size() );
+
+	if( sendUpdatesToSchedd ) {
+		ASSERT( schedd_addr );
+		DCSchedd schedd( schedd_addr );
+		std::string error_msg;
+		if( !schedd.multiplexedShadowJobExit( job_id, reason, error_msg ) ) {
+				// The schedd will decide what to do with this job when
+				// this process exits, so take no more jobs and exit as
+				// soon as the others are done.
+			dprintf( D_ALWAYS, "Failed to report exit of job %d.%d to the schedd: %s\n",
+					 job_id.cluster, job_id.proc, error_msg.c_str() );
+			multiplex_draining = true;
+		}
+	}
+
+		// our caller is still running code in this shadow object, so
+		// delete it once we're back in DaemonCore
+	daemonCore->Register_Timer( 0, 0,
+		[shadow]( int /* timerID */ ) { deleteMultiplexedShadow( shadow ); },
+		"deleteMultiplexedShadow" );
+}
+
+static bool
+multiplexAcceptingJobs()
+{
+	if( multiplex_draining ) {
+		return false;
+	}
+	if( shadow_worklife_expires && time(NULL) > shadow_worklife_expires ) {
+		return false;
+	}
+	return true;
+}
+
+static int
+handleMultiplexAddJob( int /* cmd */, Stream *stream )
+{
+	int reconnect = 0;
+	ClassAd *ad = new ClassAd;
+
+	stream->decode();
+	if( !stream->get( reconnect ) ||
+		!getClassAd( stream, *ad ) ||
+		!stream->end_of_message() )
+	{
+		dprintf( D_ALWAYS, "Failed to receive job ad from the schedd\n" );
+		delete ad;
+		return FALSE;
+	}
+
+	PROC_ID job_id;
+	job_id.cluster = job_id.proc = -1;
+	ad->LookupInteger( ATTR_CLUSTER_ID, job_id.cluster );
+	ad->LookupInteger( ATTR_PROC_ID, job_id.proc );
+
+		// If we say no, the schedd starts another shadow for the job.
+	int accepted = multiplexAcceptingJobs() &&
+		!MultiplexedShadows.count( job_id );
+	stream->encode();
+	if( !stream->put( accepted ) || !stream->end_of_message() ) {
+		dprintf( D_ALWAYS, "Failed to accept job %d.%d from the schedd\n",
+				 job_id.cluster, job_id.proc );
+		accepted = 0;
+	}
+	if( !accepted ) {
+		delete ad;
+		return TRUE;
+	}
+
+	cluster = job_id.cluster;
+	proc = job_id.proc;
+	is_reconnect = reconnect != 0;
+	dprintf( D_ALWAYS, "Adding job %d.%d; now shadowing %zu jobs.\n",
+			 cluster, proc, MultiplexedShadows.size() + 1 );
+
+	startShadow( ad );
+	return TRUE;
+}
+
+static int
+handleMultiplexSignalJob( int /* cmd */, Stream *stream )
+{
+	PROC_ID job_id;
+	int sig = 0;
+
+	stream->decode();
+	if( !stream->get( job_id.cluster ) ||
+		!stream->get( job_id.proc ) ||
+		!stream->get( sig ) ||
+		!stream->end_of_message() )
+	{
+		dprintf( D_ALWAYS, "Failed to receive job signal from the schedd\n" );
+		return FALSE;
+	}
+
+	auto it = MultiplexedShadows.find( job_id );
+	if( it == MultiplexedShadows.end() ) {
+		dprintf( D_ALWAYS, "Ignoring signal %d for job %d.%d, which we aren't shadowing\n",
+				 sig, job_id.cluster, job_id.proc );
+		return TRUE;
+	}
+	BaseShadow *shadow = it->second;
+	shadow->makeCurrent();
+
+	switch( sig ) {
+	case SIGKILL:
+			// The schedd has already dealt with the job, as it would
+			// for a shadow process it had killed, so just drop it.
+		dprintf( D_ALWAYS, "Schedd killed the shadow for job %d.%d\n",
+				 job_id.cluster, job_id.proc );
+		MultiplexedShadows.erase( it );
+		deleteMultiplexedShadow( shadow );
+		break;
+	case SIGTERM:
+	case DC_SIGSOFTKILL:
+		shadow->gracefulShutDown();
+		break;
+	case SIGQUIT:
+	case DC_SIGHARDKILL:
+		shadow->shutDownFast( JOB_SHOULD_REQUEUE, "User requested the job to vacate", CONDOR_HOLD_CODE::UserVacateJob, 0 );
+		break;
+	default:
+		signalShadow( shadow, sig );
+		break;
+	}
+	return TRUE;
+}
+
+
 
 void
 main_init(int argc, char *argv[])
@@ -457,6 +694,15 @@ main_init(int argc, char *argv[])
 
 	parseArgs( argc, argv );
 
+	if( multiplexShadow ) {
+		daemonCore->Register_Command( MULTIPLEX_SHADOW_ADD_JOB,
+			"MULTIPLEX_SHADOW_ADD_JOB", &handleMultiplexAddJob,
+			"handleMultiplexAddJob", DAEMON, true /*force authentication*/ );
+		daemonCore->Register_Command( MULTIPLEX_SHADOW_SIGNAL_JOB,
+			"MULTIPLEX_SHADOW_SIGNAL_JOB", &handleMultiplexSignalJob,
+			"handleMultiplexSignalJob", DAEMON, true /*force authentication*/ );
+	}
+
 	CheckSpoolVersion(SPOOL_MIN_VERSION_SHADOW_SUPPORTS,SPOOL_CUR_VERSION_SHADOW_SUPPORTS);
 
 	ClassAd* ad = readJobAd();
@@ -470,6 +716,13 @@ main_init(int argc, char *argv[])
 void
 main_config()
 {
+	if( multiplexShadow ) {
+		for( BaseShadow *shadow : multiplexedShadowList() ) {
+			shadow->makeCurrent();
+			shadow->config();
+		}
+		return;
+	}
 	Shadow->config();
 }
 
@@ -477,12 +730,38 @@ main_config()
 void
 main_shutdown_fast()
 {
+	if( multiplexShadow ) {
+		multiplex_draining = true;
+		if( MultiplexedShadows.empty() ) {
+			DC_Exit( JOB_EXITED );
+		}
+		for( BaseShadow *shadow : multiplexedShadowList() ) {
+			if( !shadow->jobExited() ) {
+				shadow->makeCurrent();
+				shadow->shutDownFast(JOB_SHOULD_REQUEUE, "User requested the job to vacate", CONDOR_HOLD_CODE::UserVacateJob, 0);
+			}
+		}
+		return;
+	}
 	Shadow->shutDownFast(JOB_SHOULD_REQUEUE, "User requested the job to vacate", CONDOR_HOLD_CODE::UserVacateJob, 0);
 }
 
 void
 main_shutdown_graceful()
 {
+	if( multiplexShadow ) {
+		multiplex_draining = true;
+		if( MultiplexedShadows.empty() ) {
+			DC_Exit( JOB_EXITED );
+		}
+		for( BaseShadow *shadow : multiplexedShadowList() ) {
+			if( !shadow->jobExited() ) {
+				shadow->makeCurrent();
+				shadow->gracefulShutDown();
+			}
+		}
+		return;
+	}
 	Shadow->gracefulShutDown();
 }
 
@@ -544,6 +823,10 @@ recycleShadow(int previous_job_exit_reason)
 	if( previous_job_exit_reason != JOB_EXITED ) {
 		return false;
 	}
+	if( multiplexShadow ) {
+			// the schedd hands a multiplexed shadow new jobs itself
+		return false;
+	}
 	if( shadow_worklife_expires && time(NULL) > shadow_worklife_expires ) {
 		return false;
 	}
@@ -29,6 +29,7 @@
 #include "credmon_interface.h"
 #include "condor_auth_passwd.h"
 #include "token_utils.h"
+#include "data_reuse.h"
 #include <algorithm>
 #include "dc_schedd.h"
 
@@ -229,6 +230,20 @@ ResMgr::~ResMgr()
 }
 
 
+void
+ResMgr::init_data_reuse( void )
+{
+	std::string reuse_dir;
+	if (param(reuse_dir, "DATA_REUSE_DIRECTORY")) {
+		if (!m_reuse_dir || (m_reuse_dir->GetDirectory() != reuse_dir)) {
+			m_reuse_dir.reset(new htcondor::DataReuseDirectory(reuse_dir, true));
+		}
+	} else {
+		m_reuse_dir.reset();
+	}
+}
+
+
 void
 ResMgr::init_config_classad( void )
 {
@@ -1720,6 +1735,8 @@ ResMgr::publish_resmgr_dynamic(ClassAd* cp, bool /* daemon_ad =false*/)
     m_hibernation_manager->publish(*cp);
 #endif
 
+	if (m_reuse_dir) { m_reuse_dir->Publish(*cp); }
+
 	if (extras_classad) { cp->Update(*extras_classad); }
 }
 
@@ -330,6 +330,7 @@ public:
 	ClassAd*	extras_classad;
 
 	void		init_config_classad( void );
+	void		init_data_reuse( void );
 	void		updateExtrasClassAd( ClassAd * cap );
 	void		publish_daemon_ad(ClassAd & ad, time_t last_heard_from=0);
 	void		final_update_daemon_ad();
@@ -620,6 +621,10 @@ private:
 	time_t max_job_retirement_time_override;
 
 	std::unique_ptr<VolumeManager> m_volume_mgr;
+
+		// Input files kept for reuse by the starters on this machine.
+		// The startd creates the directory and cleans it up on exit.
+	std::unique_ptr<htcondor::DataReuseDirectory> m_reuse_dir;
 };
 
 
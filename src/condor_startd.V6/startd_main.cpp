@@ -543,6 +543,7 @@ init_params( int first_time)
 	}
 
 	resmgr->init_config_classad();
+	resmgr->init_data_reuse();
 
 	polling_interval = param_integer( "POLLING_INTERVAL", 5 );
 
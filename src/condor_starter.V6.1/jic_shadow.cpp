@@ -2618,6 +2618,9 @@ JICShadow::beginFileTransfer( void )
 			MACHINE_AD_FILENAME);
 		filetrans->setRuntimeAds(job_ad_path, machine_ad_path);
 		dprintf(D_ALWAYS, "Set filetransfer runtime ads to %s and %s.\n", job_ad_path.c_str(), machine_ad_path.c_str());
+		if (auto *reuse_dir = starter->getDataReuseDirectory()) {
+			filetrans->setDataReuseDirectory(*reuse_dir);
+		}
 
 			// In the starter, we never want to use
 			// SpooledOutputFiles, because we are not reading the
@@ -54,9 +54,7 @@
 #include "my_username.h"
 #include "condor_regex.h"
 #include "starter_util.h"
-#ifdef HAVE_DATA_REUSE_DIR
 #include "data_reuse.h"
-#endif
 #include "authentication.h"
 #include "to_string_si_units.h"
 #include "dc_coroutines.h"
@@ -357,7 +355,6 @@ Starter::Config()
 	// Testing hack, move the working dir instead of deleting it.
 	param(m_move_working_dir_on_exit, "STARTER_MOVE_WORKING_DIR_ON_EXIT");
 
-#ifdef HAVE_DATA_REUSE_DIR
 	std::string reuse_dir;
 	if (param(reuse_dir, "DATA_REUSE_DIRECTORY")) {
 		if (!m_reuse_dir.get() || (m_reuse_dir->GetDirectory() != reuse_dir)) {
@@ -367,7 +364,6 @@ Starter::Config()
 	} else {
 		m_reuse_dir.reset();
 	}
-#endif
 
 		// Tell our JobInfoCommunicator to reconfig, too.
 	jic->config();
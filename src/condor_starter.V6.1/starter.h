@@ -42,11 +42,9 @@
 #include "profile.WINDOWS.h" // for OwnerProfile class
 #endif
 
-#if 1 //def HAVE_DATA_REUSE_DIR TOO: remove this someday
 namespace htcondor {
 class DataReuseDirectory;
 }
-#endif
 
 /** The starter class.  Basically, this class does some initialization
 	stuff and manages a set of UserProc instances, each of which 
@@ -314,6 +312,11 @@ public:
 		 */
 	int numberOfJobs( void ) { return m_job_list.size(); };
 
+		/** Returns the data reuse directory shared with the other
+			starters on this machine, or NULL if there isn't one.
+		*/
+	htcondor::DataReuseDirectory *getDataReuseDirectory() { return m_reuse_dir.get(); }
+
 	bool isGridshell( void ) const {return is_gridshell;};
 
 	bool hasEncryptedWorkingDir(void) { return has_encrypted_working_dir; }
@@ -476,6 +479,11 @@ private:
 		//
 	int deferral_tid;
 
+		//
+		// Input files kept on this machine for reuse by later jobs
+		//
+	std::unique_ptr<htcondor::DataReuseDirectory> m_reuse_dir;
+
 		//
 		// When HTCondor manages dedicated disk space, this tracks
 		// the maximum permitted disk usage and the polling timer
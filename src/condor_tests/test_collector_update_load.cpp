@@ -0,0 +1,161 @@
+// Replays startd updates to a collector over many concurrent TCP
+// connections, the way the startds of a large pool would.  Some of the
+// connections can be left stalled part-way through a message, to check
+// that a slow or lossy link doesn't hold up the updates on the others.
+//
+// usage: test_collector_update_load <collector> <connections> <rounds> [<stalled>]
+
+#include "condor_common.h"
+#include "condor_config.h"
+#include "condor_debug.h"
+#include "condor_attributes.h"
+#include "condor_commands.h"
+#include "condor_classad.h"
+#include "condor_query.h"
+
+#include "daemon.h"
+#include "reli_sock.h"
+
+#include <chrono>
+
+static void
+make_slot_ads( int index, ClassAd & public_ad, ClassAd & private_ad ) {
+	std::string name;
+	formatstr( name, "slot%d@loadgen%d.example.org", (index % 128) + 1, index / 128 );
+	std::string machine;
+	formatstr( machine, "loadgen%d.example.org", index / 128 );
+
+	SetMyTypeName( public_ad, STARTD_SLOT_ADTYPE );
+	public_ad.Assign( ATTR_NAME, name );
+	public_ad.Assign( ATTR_MACHINE, machine );
+	public_ad.Assign( ATTR_SLOT_ID, (index % 128) + 1 );
+	public_ad.Assign( ATTR_MY_ADDRESS, "<127.0.0.1:9618>" );
+	public_ad.Assign( ATTR_STATE, "Unclaimed" );
+	public_ad.Assign( ATTR_ACTIVITY, "Idle" );
+	public_ad.Assign( ATTR_CPUS, 1 );
+	public_ad.Assign( ATTR_MEMORY, 2048 );
+	public_ad.Assign( ATTR_DISK, 100000 );
+	public_ad.AssignExpr( ATTR_REQUIREMENTS, "START" );
+	public_ad.AssignExpr( ATTR_START, "TARGET.RequestMemory <= MY.Memory" );
+	public_ad.Assign( "LoadGenerator", true );
+		// Pad the ad out to roughly the size of a real slot ad.
+	for( int i = 0; i < 200; ++i ) {
+		std::string attr;
+		formatstr( attr, "LoadGenAttr%d", i );
+		public_ad.Assign( attr, "a value of about the usual size for a slot ad" );
+	}
+
+	SetMyTypeName( private_ad, STARTD_PVT_ADTYPE );
+	private_ad.Assign( ATTR_NAME, name );
+	private_ad.Assign( ATTR_MY_ADDRESS, "<127.0.0.1:9618>" );
+	private_ad.Assign( ATTR_CAPABILITY, "loadgen#capability" );
+}
+
+static bool
+send_update( Sock * sock, ClassAd & public_ad, ClassAd & private_ad ) {
+	return putClassAd( sock, public_ad ) &&
+		putClassAd( sock, private_ad ) &&
+		sock->end_of_message();
+}
+
+int main( int argc, char ** argv ) {
+	if( argc < 4 || argc > 5 ) {
+		fprintf( stderr, "usage: %s <collector> <connections> <rounds> [<stalled>]\n", argv[0] );
+		return 1;
+	}
+
+	config();
+
+	const char * pool = argv[1];
+	int connections = atoi( argv[2] );
+	int rounds = atoi( argv[3] );
+	int stalled = argc > 4 ? atoi( argv[4] ) : 0;
+	if( connections <= 0 || rounds <= 0 || stalled < 0 || stalled >= connections ) {
+		fprintf( stderr, "need 0 < connections, 0 < rounds, and 0 <= stalled < connections\n" );
+		return 1;
+	}
+
+	Daemon collector( DT_COLLECTOR, pool );
+
+	std::vector<Sock *> socks( connections, nullptr );
+	std::vector<ClassAd> public_ads( connections );
+	std::vector<ClassAd> private_ads( connections );
+
+		// Opening a connection runs the security handshake and sends
+		// the first update; the collector then keeps the socket for
+		// later updates, just as it does for a startd.
+	int failures = 0;
+	auto start = std::chrono::steady_clock::now();
+	for( int i = 0; i < connections; ++i ) {
+		make_slot_ads( i, public_ads[i], private_ads[i] );
+		public_ads[i].Assign( ATTR_UPDATE_SEQUENCE_NUMBER, 0 );
+		socks[i] = collector.startCommand( UPDATE_STARTD_AD, Stream::reli_sock, 20 );
+		if( ! socks[i] || ! send_update( socks[i], public_ads[i], private_ads[i] ) ) {
+			fprintf( stderr, "failed to open connection %d to %s\n", i, pool );
+			delete socks[i];
+			socks[i] = nullptr;
+			++failures;
+		}
+	}
+	std::chrono::duration<double> connect_time = std::chrono::steady_clock::now() - start;
+
+		// Leave the first few connections hanging in the middle of the
+		// header of their next message.
+	for( int i = 0; i < stalled; ++i ) {
+		if( socks[i] && send( socks[i]->get_file_desc(), "", 1, 0 ) != 1 ) {
+			fprintf( stderr, "failed to stall connection %d\n", i );
+		}
+	}
+
+	long long updates = 0;
+	start = std::chrono::steady_clock::now();
+	for( int round = 1; round <= rounds; ++round ) {
+		for( int i = stalled; i < connections; ++i ) {
+			if( ! socks[i] ) { continue; }
+			public_ads[i].Assign( ATTR_UPDATE_SEQUENCE_NUMBER, round );
+			socks[i]->encode();
+			if( ! socks[i]->put( UPDATE_STARTD_AD ) ||
+				! send_update( socks[i], public_ads[i], private_ads[i] ) )
+			{
+				fprintf( stderr, "failed to send update %d on connection %d\n", round, i );
+				delete socks[i];
+				socks[i] = nullptr;
+				++failures;
+				continue;
+			}
+			++updates;
+		}
+	}
+	std::chrono::duration<double> update_time = std::chrono::steady_clock::now() - start;
+
+		// Every connection that wasn't stalled should have its last
+		// update in the collector once the collector has caught up.
+	std::string constraint;
+	formatstr( constraint, "LoadGenerator && %s == %d", ATTR_UPDATE_SEQUENCE_NUMBER, rounds );
+	int expected = 0;
+	for( int i = stalled; i < connections; ++i ) {
+		if( socks[i] ) { ++expected; }
+	}
+	int found = 0;
+	for( int tries = 0; tries < 60; ++tries ) {
+		CondorQuery query( STARTD_AD );
+		query.addANDConstraint( constraint.c_str() );
+		ClassAdList ads;
+		if( query.fetchAds( ads, pool ) == Q_OK ) {
+			found = ads.Length();
+			if( found >= expected ) { break; }
+		}
+		sleep( 1 );
+	}
+
+	for( auto * sock : socks ) { delete sock; }
+
+	printf( "connections: %d (%d stalled)\n", connections, stalled );
+	printf( "connect + first update: %.3fs\n", connect_time.count() );
+	printf( "updates: %lld in %.3fs (%.0f/s)\n", updates, update_time.count(),
+		update_time.count() > 0 ? updates / update_time.count() : 0.0 );
+	printf( "failures: %d\n", failures );
+	printf( "ads with the last update: %d of %d\n", found, expected );
+
+	return (failures == 0 && found >= expected) ? 0 : 1;
+}
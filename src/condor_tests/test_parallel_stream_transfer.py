@@ -0,0 +1,86 @@
+#!/usr/bin/env pytest
+
+# Send a file that is split across several extra connections in both
+# directions, and check that it comes back intact.  The file's size isn't a
+# multiple of the number of connections, so the last piece is shorter than
+# the rest, and it runs to the end of the file.
+
+import logging
+import os
+
+from ornithology import (
+    action,
+    Condor,
+    ClusterState,
+    DaemonLog,
+    JobStatus,
+)
+
+
+logger = logging.getLogger(__name__)
+logger.setLevel(logging.DEBUG)
+
+
+NUM_STREAMS = 4
+FILE_SIZE = 3 * 1024 * 1024 + 5
+
+
+@action
+def the_condor(test_dir):
+    with Condor(
+        local_dir=test_dir / "condor",
+        config={
+            # setting this says the peers understand split files; the extra
+            # connections are only made when the main one isn't encrypted
+            "SEC_DEFAULT_ENCRYPTION":               "NEVER",
+            "FILE_TRANSFER_PARALLEL_STREAMS":       NUM_STREAMS,
+            "FILE_TRANSFER_PARALLEL_MIN_FILE_SIZE": 1024 * 1024,
+            "SHADOW_DEBUG":                         "D_FULLDEBUG",
+            "STARTER_DEBUG":                        "D_FULLDEBUG",
+        },
+    ) as condor:
+        yield condor
+
+
+@action
+def the_input(test_dir):
+    contents = os.urandom(FILE_SIZE)
+    (test_dir / "parallel.bin").write_bytes(contents)
+    return contents
+
+
+@action
+def the_job(the_condor, the_input, test_dir):
+    job = the_condor.submit(
+        {
+            "shell":                    "cp parallel.bin parallel.out",
+            "initialdir":               test_dir.as_posix(),
+            "should_transfer_files":    "YES",
+            "when_to_transfer_output":  "ON_EXIT",
+            "transfer_input_files":     "parallel.bin",
+            "transfer_output_files":    "parallel.out",
+            "log":                      (test_dir / "the_job.log").as_posix(),
+        }
+    )
+    assert job.wait(condition=ClusterState.all_terminal, timeout=120)
+    return job
+
+
+def count_split_sends(log_path):
+    log = DaemonLog(log_path).open()
+    pattern = f"over {NUM_STREAMS} connections"
+    return len([line for line in log.read() if "DoUpload: sending" in line and pattern in line])
+
+
+class TestParallelStreamTransfer:
+    def test_job_succeeds(self, the_job):
+        assert the_job.state[0] == JobStatus.COMPLETED
+
+    def test_output_matches_input(self, the_job, the_input, test_dir):
+        assert (test_dir / "parallel.out").read_bytes() == the_input
+
+    def test_input_was_split(self, the_job, the_condor):
+        assert count_split_sends(the_condor.shadow_log.path) == 1
+
+    def test_output_was_split(self, the_job, test_dir):
+        assert count_split_sends(test_dir / "condor" / "log" / "StarterLog.slot1_1") == 1
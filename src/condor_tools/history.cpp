@@ -43,10 +43,15 @@
 #include "console-utils.h"
 #include <algorithm> //for std::reverse
 #include <utility> // for std::move
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
 
 #include "classad_helpers.h"
 #include "history_utils.h"
 #include "backward_file_reader.h"
+#include "history_index.h"
 #include <fcntl.h>  // for O_BINARY
 
 void Usage(const char* name, int iExitCode=1);
@@ -120,6 +125,9 @@ static void readHistoryFromDirectory(const char* searchDirectory, const char* co
 static void readHistoryFromSingleFile(bool fileisuserlog, const char *JobHistoryFileName, const char* constraint, ExprTree *constraintExpr);
 static void readHistoryFromFileOld(const char *JobHistoryFileName, const char* constraint, ExprTree *constraintExpr);
 static void readHistoryFromFileEx(const char *JobHistoryFileName, const char* constraint, ExprTree *constraintExpr, bool read_backwards);
+static bool readHistoryFromFileIndexed(const char *JobHistoryFileName, const char* constraint, ExprTree *constraintExpr, bool read_backwards);
+static int historyScanThreads(const char* constraint, ExprTree *constraintExpr, size_t num_files);
+static void readHistoryInParallel(const std::vector<std::string> & files, const char* constraint, ExprTree *constraintExpr, int num_threads);
 static void printJobAds(ClassAdList & jobs);
 static void printJob(ClassAd & ad);
 
@@ -1204,8 +1212,13 @@ static void readHistoryFromFiles(const char* matchFileName, const char* constrai
 	//for(auto file : historyFiles) { fprintf(stdout, "%s\n",file.c_str()); }
 
 	// Read files for Ads in order
-	for(const auto &file : historyFiles) {
-		readHistoryFromFileEx(file.c_str(), constraint, constraintExpr, backwards);
+	int num_threads = historyScanThreads(constraint, constraintExpr, historyFiles.size());
+	if (num_threads > 1) {
+		readHistoryInParallel(historyFiles, constraint, constraintExpr, num_threads);
+	} else {
+		for(const auto &file : historyFiles) {
+			readHistoryFromFileEx(file.c_str(), constraint, constraintExpr, backwards);
+		}
 	}
 
 	printFooter();
@@ -1631,6 +1644,227 @@ static bool parseBanner(BannerInfo& info, std::string banner) {
 	return false;
 }
 
+// Hand the ads in a piece of a history file to printJobIfConstraint, first to last
+// or last to first. returns false if we should stop scanning.
+static bool readHistoryFromBuffer(const std::string & buf, const char* constraint, ExprTree *constraintExpr, bool read_backwards)
+{
+	// split the buffer into records, each of which is the lines of an ad followed by its banner.
+	// anything after the last banner is an ad that is still being written, so we ignore it.
+	std::vector<std::vector<std::string>> records(1);
+	size_t ix = 0;
+	while (ix < buf.size()) {
+		size_t eol = buf.find('\n', ix);
+		if (eol == std::string::npos) { break; }
+		size_t end = eol;
+		if (end > ix && buf[end-1] == '\r') { --end; }
+		records.back().emplace_back(buf, ix, end - ix);
+		if (starts_with(records.back().back().c_str(), "***")) {
+			records.emplace_back();
+		}
+		ix = eol + 1;
+	}
+	records.pop_back();
+
+	if (read_backwards) { std::reverse(records.begin(), records.end()); }
+
+	std::vector<std::string> exprs;
+	for (auto & lines : records) {
+		BannerInfo banner;
+		bool read_ad = parseBanner(banner, lines.back());
+		lines.pop_back();
+
+		// printJobIfConstraint wants the lines of the ad last to first
+		exprs.clear();
+		if (read_ad) {
+			for (auto it = lines.rbegin(); it != lines.rend(); ++it) {
+				const char * psz = it->c_str();
+				while (*psz == ' ' || *psz == '\t') ++psz;
+				if (*psz && *psz != '#') {
+					exprs.push_back(*it);
+				}
+			}
+		}
+
+		if (exprs.size() > 0) {
+			printJobIfConstraint(exprs, constraint, constraintExpr, banner);
+		} else if (read_backwards && cluster > 0 && checkMatchJobIdsFound(banner, NULL, true)) {
+			return false;
+		}
+
+		if ((specifiedMatch > 0 && matchCount >= specifiedMatch) || (maxAds > 0 && adCount >= maxAds) || abort_transfer) {
+			return false;
+		}
+	}
+	return true;
+}
+
+// read a piece of a history file into buf. exits on error, as the other readers do
+static void readHistoryPiece(int fd, const char *JobHistoryFileName, long long offset, size_t len, std::string & buf)
+{
+	buf.resize(len);
+	if (lseek(fd, (off_t)offset, SEEK_SET) != (off_t)offset ||
+		full_read(fd, &buf[0], buf.size()) != (ssize_t)buf.size()) {
+		fprintf(stderr,"Error reading history file %s: %s\n", JobHistoryFileName, strerror(errno));
+		exit(1);
+	}
+}
+
+// the offset just past the first or last complete banner line in buf, or npos if there
+// isn't one.  when buf may begin in the middle of a line, its first line is skipped.
+static size_t findBannerEnd(const std::string & buf, bool skip_first_line, bool last)
+{
+	size_t found = std::string::npos;
+	size_t ix = 0;
+	while (ix < buf.size()) {
+		size_t eol = buf.find('\n', ix);
+		if (eol == std::string::npos) { break; }
+		if ((ix > 0 || ! skip_first_line) && buf.compare(ix, 3, "***") == 0) {
+			found = eol + 1;
+			if ( ! last) { break; }
+		}
+		ix = eol + 1;
+	}
+	return found;
+}
+
+// Hand the ads in the part of a history file between begin and end to readHistoryFromBuffer
+// a chunk at a time, so that a large part that isn't indexed is never all in memory at once.
+// the part must begin with an ad. returns false if we should stop scanning.
+static bool readHistoryTail(int fd, const char *JobHistoryFileName, long long begin, long long end,
+	const char* constraint, ExprTree *constraintExpr, bool read_backwards)
+{
+	const long long chunk_size = 1024*1024;
+	std::string chunk, buf, carry;
+
+	if ( ! read_backwards) {
+		// carry is the start of an ad whose banner is in a later chunk
+		for (long long pos = begin; pos < end; ) {
+			long long len = MIN(chunk_size, end - pos);
+			readHistoryPiece(fd, JobHistoryFileName, pos, (size_t)len, chunk);
+			pos += len;
+			buf = carry + chunk;
+			size_t cut = findBannerEnd(buf, false, true);
+			if (cut == std::string::npos) {
+				carry.swap(buf);
+				continue;
+			}
+			carry.assign(buf, cut, std::string::npos);
+			buf.resize(cut);
+			if ( ! readHistoryFromBuffer(buf, constraint, constraintExpr, false)) {
+				return false;
+			}
+		}
+		// what is left is an ad that is still being written
+		return true;
+	}
+
+	// carry is the end of an ad whose start is in an earlier chunk, up to and including its banner
+	for (long long pos = end; pos > begin; ) {
+		long long len = MIN(chunk_size, pos - begin);
+		pos -= len;
+		readHistoryPiece(fd, JobHistoryFileName, pos, (size_t)len, chunk);
+		buf = chunk + carry;
+		size_t cut = 0;
+		if (pos > begin) {
+			// the chunk may begin in the middle of a line
+			cut = findBannerEnd(buf, true, false);
+			if (cut == std::string::npos) {
+				carry.swap(buf);
+				continue;
+			}
+		}
+		carry.assign(buf, 0, cut);
+		buf.erase(0, cut);
+		if ( ! readHistoryFromBuffer(buf, constraint, constraintExpr, true)) {
+			return false;
+		}
+	}
+	return true;
+}
+
+// Read the history file using its index to seek directly to the ads that might match
+// the constraint, rather than parsing every ad in the file.  returns false if there is
+// no usable index, or the constraint isn't one the index can help with, in which case
+// nothing has been read and the caller should scan the whole file.
+static bool readHistoryFromFileIndexed(const char *JobHistoryFileName, const char* constraint, ExprTree *constraintExpr, bool read_backwards)
+{
+	// when there is a -since expression, the ads that could stop the scan must be read too.
+	HistoryIndexFilter filter;
+	if ( ! constraint || ! constraint[0] || ! filter.Init(constraintExpr)) {
+		return false;
+	}
+	if (sinceExpr) {
+		HistoryIndexFilter since_filter;
+		if ( ! since_filter.Init(sinceExpr)) {
+			return false;
+		}
+		filter.Merge(since_filter);
+	}
+
+	std::vector<HistoryIndexEntry> entries;
+	long long indexed_end = 0;
+	if ( ! ReadHistoryIndex(JobHistoryFileName, entries, indexed_end)) {
+		return false;
+	}
+
+	int fd = safe_open_wrapper_follow(JobHistoryFileName, O_RDONLY | O_LARGEFILE | _O_BINARY);
+	if (fd < 0) {
+		fprintf(stderr,"Error opening history file %s: %s\n", JobHistoryFileName, strerror(errno));
+		exit(1);
+	}
+	struct stat si = {};
+	if (fstat(fd, &si) != 0) {
+		fprintf(stderr,"Error reading history file %s: %s\n", JobHistoryFileName, strerror(errno));
+		exit(1);
+	}
+
+	if (diagnostic) {
+		fprintf(stderr, "Using history index for %s: %d ads indexed, %lld bytes not indexed\n",
+			JobHistoryFileName, (int)entries.size(), (long long)si.st_size - indexed_end);
+	}
+
+	// ads appended since the schedd last wrote the index have no entry, so that
+	// part of the file (the newest part) is scanned like a file without an index.
+	bool has_tail = si.st_size > indexed_end;
+	if (read_backwards && has_tail &&
+		! readHistoryTail(fd, JobHistoryFileName, indexed_end, si.st_size, constraint, constraintExpr, true)) {
+		close(fd);
+		return true;
+	}
+
+	std::string buf;
+	size_t num_entries = entries.size();
+	bool stopped = false;
+	for (size_t ix = 0; ix < num_entries; ++ix) {
+		const HistoryIndexEntry & entry = entries[read_backwards ? num_entries - 1 - ix : ix];
+
+		if ( ! filter.Matches(entry)) {
+			// we can still know we are done from the completion date in the index
+			if (read_backwards && cluster > 0) {
+				BannerInfo banner;
+				banner.jid = JOB_ID_KEY(entry.cluster, entry.proc);
+				banner.completion = entry.completion;
+				banner.owner = entry.owner;
+				if (checkMatchJobIdsFound(banner, NULL, true)) { break; }
+			}
+			continue;
+		}
+
+		readHistoryPiece(fd, JobHistoryFileName, entry.offset, (size_t)(entry.end - entry.offset), buf);
+		if ( ! readHistoryFromBuffer(buf, constraint, constraintExpr, read_backwards)) {
+			stopped = true;
+			break;
+		}
+	}
+
+	if ( ! read_backwards && has_tail && ! stopped) {
+		readHistoryTail(fd, JobHistoryFileName, indexed_end, si.st_size, constraint, constraintExpr, false);
+	}
+
+	close(fd);
+	return true;
+}
+
 static void readHistoryFromFileEx(const char *JobHistoryFileName, const char* constraint, ExprTree *constraintExpr, bool read_backwards)
 {
 	// In case of rotated history files, check if we have already reached the number of 
@@ -1639,6 +1873,12 @@ static void readHistoryFromFileEx(const char *JobHistoryFileName, const char* co
 		return;
 	}
 
+	// if the history file has an index, and the constraint or -since expression pins down
+	// job ids, owners or completion dates, we can seek directly to the ads that might match.
+	if (readHistoryFromFileIndexed(JobHistoryFileName, constraint, constraintExpr, read_backwards)) {
+		return;
+	}
+
 	// the old function doesn't work for backwards, but it does work for forwards so go ahead and call it.
 	//
 	if ( ! read_backwards) {
@@ -1726,6 +1966,306 @@ static void readHistoryFromFileEx(const char *JobHistoryFileName, const char* co
 	reader.Close();
 }
 
+//------------------------------------------------------------------------
+// Parallel scanning of history files.  Worker threads each take the next
+// unread file, parse its ads and evaluate the constraint, and queue the
+// ads that might be printed.  The main thread takes the queued ads one file
+// at a time, in the same order the files would have been read serially,
+// and hands them to printJobIfConstraint, so the output and the -limit,
+// -scanlimit and -since handling are the same as for a serial read.
+
+// the most ads a worker will queue for a file before waiting for the main thread
+static const size_t MAX_QUEUED_HISTORY_ADS = 500;
+
+struct HistoryScanResult {
+	ClassAd * ad = nullptr;  // NULL for a malformed ad, or the end of the file
+	BannerInfo banner;
+	int skipped = 0;         // ads scanned before this one that didn't match
+	bool end = false;
+};
+
+struct HistoryFileScan {
+	std::string filename;
+	std::mutex lock;
+	std::condition_variable changed;
+	std::deque<HistoryScanResult> results;
+	int error = 0;           // errno if the file could not be opened, set before the end is queued
+};
+
+struct HistoryScanContext {
+	std::vector<std::unique_ptr<HistoryFileScan>> scans;
+	std::atomic<size_t> next_file{0};
+	std::atomic<bool> cancel{false};
+	const char * constraint = nullptr;
+	ExprTree * constraintExpr = nullptr;
+};
+
+// Queue a result for the main thread, waiting for room. returns false if the scan was cancelled.
+static bool queueHistoryScanResult(HistoryScanContext & ctx, HistoryFileScan & scan, HistoryScanResult & result)
+{
+	std::unique_lock<std::mutex> guard(scan.lock);
+	scan.changed.wait(guard, [&]{ return ctx.cancel || result.end || scan.results.size() < MAX_QUEUED_HISTORY_ADS; });
+	if (ctx.cancel) {
+		delete result.ad;
+		return false;
+	}
+	scan.results.push_back(result);
+	scan.changed.notify_all();
+	return true;
+}
+
+// Turn the lines of an ad (last to first) into a ClassAd, and queue it if it matches
+// the constraint or the -since expression. Ads that don't are only counted.
+static bool scanHistoryAd(HistoryScanContext & ctx, HistoryFileScan & scan, std::vector<std::string> & exprs, BannerInfo & banner,
+	ExprTree * constraintExpr, ExprTree * since, int & skipped)
+{
+	// ClassAd::Insert(line) goes through the ClassAd cache, which isn't thread safe,
+	// so each thread parses the values itself and inserts them directly.
+	thread_local classad::ClassAdParser parser;
+	parser.SetOldClassAd(true);
+
+	ClassAd * ad = new ClassAd();
+	ad->rehash(521);
+	std::string attr;
+	for (size_t ix = exprs.size(); ix > 0; --ix) {
+		const char * rhs = nullptr;
+		ExprTree * tree = nullptr;
+		if ( ! SplitLongFormAttrValue(exprs[ix-1].c_str(), attr, rhs) || attr[0] == '\'' ||
+			! (tree = parser.ParseExpression(rhs)) || ! ad->Insert(attr, tree)) {
+			delete ad; ad = nullptr;
+			break;
+		}
+	}
+	exprs.clear();
+
+	if (ad && ! (since && EvalExprBool(ad, since)) &&
+		ctx.constraint && ctx.constraint[0] && ! EvalExprBool(ad, constraintExpr)) {
+		delete ad;
+		++skipped;
+		return ! ctx.cancel;
+	}
+
+	HistoryScanResult result;
+	result.ad = ad;
+	result.banner = banner;
+	result.skipped = skipped;
+	skipped = 0;
+	return queueHistoryScanResult(ctx, scan, result);
+}
+
+static void scanHistoryFile(HistoryScanContext & ctx, HistoryFileScan & scan, ExprTree * constraintExpr, ExprTree * since)
+{
+	std::string line;
+	std::vector<std::string> exprs;
+	BannerInfo banner;
+	bool read_ad = false;
+	int skipped = 0;
+	bool keep_going = true;
+
+	if (backwards) {
+		BackwardFileReader reader(scan.filename, O_RDONLY);
+		if (reader.LastError()) {
+			scan.error = reader.LastError();
+		} else {
+			// skip to the banner of the last ad, then collect lines until the banner of the ad before it
+			while (reader.PrevLine(line)) {
+				if (starts_with(line.c_str(), "***")) {
+					read_ad = parseBanner(banner, line);
+					break;
+				}
+			}
+			while (keep_going && reader.PrevLine(line)) {
+				if (starts_with(line.c_str(), "***")) {
+					if (exprs.size() > 0) {
+						keep_going = scanHistoryAd(ctx, scan, exprs, banner, constraintExpr, since, skipped);
+					}
+					read_ad = parseBanner(banner, line);
+				} else if (read_ad && ! line.empty()) {
+					const char * psz = line.c_str();
+					while (*psz == ' ' || *psz == '\t') ++psz;
+					if (*psz != '#') {
+						exprs.push_back(line);
+					}
+				}
+			}
+			if (keep_going && exprs.size() > 0) {
+				keep_going = scanHistoryAd(ctx, scan, exprs, banner, constraintExpr, since, skipped);
+			}
+			reader.Close();
+		}
+	} else {
+		FILE * fp = safe_fopen_wrapper_follow(scan.filename.c_str(), "r");
+		if ( ! fp) {
+			scan.error = errno;
+		} else {
+			// the lines of an ad come before its banner, so collect them
+			// (last to first, as scanHistoryAd wants) until we reach the banner
+			std::vector<std::string> lines;
+			while (keep_going && readLine(line, fp)) {
+				chomp(line);
+				if (starts_with(line.c_str(), "***")) {
+					read_ad = parseBanner(banner, line);
+					if (read_ad) {
+						for (auto it = lines.rbegin(); it != lines.rend(); ++it) {
+							const char * psz = it->c_str();
+							while (*psz == ' ' || *psz == '\t') ++psz;
+							if (*psz && *psz != '#') {
+								exprs.push_back(*it);
+							}
+						}
+					}
+					lines.clear();
+					if (exprs.size() > 0) {
+						keep_going = scanHistoryAd(ctx, scan, exprs, banner, constraintExpr, since, skipped);
+					}
+				} else {
+					lines.push_back(line);
+				}
+			}
+			fclose(fp);
+		}
+	}
+
+	if (keep_going) {
+		HistoryScanResult result;
+		result.skipped = skipped;
+		result.end = true;
+		queueHistoryScanResult(ctx, scan, result);
+	}
+}
+
+static void historyScanWorker(HistoryScanContext * ctx)
+{
+	// evaluation caches things in the expression, so each thread needs its own copies
+	std::unique_ptr<ExprTree> constraintExpr(ctx->constraintExpr ? ctx->constraintExpr->Copy() : nullptr);
+	std::unique_ptr<ExprTree> since(sinceExpr ? sinceExpr->Copy() : nullptr);
+
+	while ( ! ctx->cancel) {
+		size_t ix = ctx->next_file++;
+		if (ix >= ctx->scans.size()) {
+			break;
+		}
+		scanHistoryFile(*ctx, *ctx->scans[ix], constraintExpr.get(), since.get());
+	}
+}
+
+// Decide how many threads to scan history files with, 0 or 1 means read them one at a time.
+static int historyScanThreads(const char* constraint, ExprTree *constraintExpr, size_t num_files)
+{
+	int num_threads = param_integer("HISTORY_SCAN_THREADS", 0, 0, 64);
+	if (num_threads <= 1 || num_files <= 1) {
+		return 0;
+	}
+	// Looking for particular jobs stops as soon as they have all been found,
+	// and with an index may not need to read most of the ads at all.
+	if (cluster > 0) {
+		return 0;
+	}
+	HistoryIndexFilter filter;
+	if (constraint && constraint[0] && filter.Init(constraintExpr)) {
+		return 0;
+	}
+	return MIN(num_threads, (int)num_files);
+}
+
+static void readHistoryInParallel(const std::vector<std::string> & files, const char* constraint, ExprTree *constraintExpr, int num_threads)
+{
+	if ((specifiedMatch > 0 && matchCount >= specifiedMatch) || (maxAds > 0 && adCount >= maxAds)) {
+		return;
+	}
+
+	HistoryScanContext ctx;
+	ctx.constraint = constraint;
+	ctx.constraintExpr = constraintExpr;
+	for (const auto & file : files) {
+		ctx.scans.emplace_back(new HistoryFileScan);
+		ctx.scans.back()->filename = file;
+	}
+
+	// the ClassAd library sets some things up the first time it evaluates, do that here
+	// rather than letting the workers race to do it.
+	{
+		ClassAd ad;
+		if (constraintExpr) { EvalExprBool(&ad, constraintExpr); }
+		if (sinceExpr) { EvalExprBool(&ad, sinceExpr); }
+	}
+
+	if (diagnostic) {
+		fprintf(stderr, "Scanning %d history files with %d threads\n", (int)files.size(), num_threads);
+	}
+
+	std::vector<std::thread> workers;
+	for (int ix = 0; ix < num_threads; ++ix) {
+		workers.emplace_back(historyScanWorker, &ctx);
+	}
+
+	const char * open_error_file = nullptr;
+	int open_error = 0;
+	bool done = false;
+	for (size_t ix = 0; ix < ctx.scans.size() && ! done; ++ix) {
+		HistoryFileScan & scan = *ctx.scans[ix];
+		while ( ! done) {
+			HistoryScanResult result;
+			{
+				std::unique_lock<std::mutex> guard(scan.lock);
+				scan.changed.wait(guard, [&]{ return ! scan.results.empty(); });
+				result = scan.results.front();
+				scan.results.pop_front();
+				scan.changed.notify_all();
+			}
+
+			// account for the ads that were scanned but not queued, they may use up the -scanlimit
+			if (maxAds > 0 && adCount + result.skipped >= maxAds) {
+				adCount = maxAds;
+				delete result.ad;
+				done = true;
+				break;
+			}
+			adCount += result.skipped;
+
+			if (result.end) {
+				if (scan.error) {
+					open_error_file = scan.filename.c_str();
+					open_error = scan.error;
+					done = true;
+				}
+				break;
+			}
+			if ( ! result.ad) {
+				printf( "\t*** Warning: Bad history file; skipping malformed ad(s)\n" );
+				continue;
+			}
+
+			printJobIfConstraint(*result.ad, constraint, constraintExpr, result.banner);
+			delete result.ad;
+
+			if ((specifiedMatch > 0 && matchCount >= specifiedMatch) || (maxAds > 0 && adCount >= maxAds) || abort_transfer) {
+				done = true;
+			}
+		}
+	}
+
+	// stop the workers, and throw away anything they queued that we didn't use
+	ctx.cancel = true;
+	for (auto & scan : ctx.scans) {
+		std::lock_guard<std::mutex> guard(scan->lock);
+		scan->changed.notify_all();
+	}
+	for (auto & worker : workers) {
+		worker.join();
+	}
+	for (auto & scan : ctx.scans) {
+		for (auto & result : scan->results) {
+			delete result.ad;
+		}
+	}
+
+	if (open_error_file) {
+		fprintf(stderr,"Error opening history file %s: %s\n", open_error_file, strerror(open_error));
+		exit(1);
+	}
+}
+
 //PRAGMA_REMIND("tj: TODO fix to handle summary print format")
 static int set_print_mask_from_stream(
 	AttrListPrintMask & print_mask,
@@ -1854,6 +2394,17 @@ static void readHistoryFromDirectory(const char* searchDirectory, const char* co
 	std::deque<std::string> recordFiles;
 	if (recordSrc == HRS_JOB_EPOCH) { findEpochDirFiles(&recordFiles,searchDirectory); }
 
+	// When we aren't deleting files as we go, we can read them all at once
+	int num_threads = delete_epoch_ads ? 0 : historyScanThreads(constraint, constraintExpr, recordFiles.size());
+	if (num_threads > 1) {
+		std::vector<std::string> paths;
+		for (const auto& file : recordFiles) {
+			dircat(searchDirectory, file.c_str(), paths.emplace_back());
+		}
+		readHistoryInParallel(paths, constraint, constraintExpr, num_threads);
+		recordFiles.clear();
+	}
+
 	//For each file found read job ads
 	for(const auto& file : recordFiles) {
 		std::string file_path;
@@ -35,6 +35,7 @@ extern const char *EMPTY_CLASSAD_TYPE_NAME; // defined in classad_log.cpp
 #include "ClassAdLogEntry.h"
 #include "ClassAdLogParser.h"
 #include "log.h"
+#include "classad/binarySource.h"
 
 /***** Prevent calling free multiple times in this code *****/
 /* This fixes bugs where we would segfault when reading in
@@ -157,6 +158,8 @@ FileOpErrCode
 ClassAdLogParser::readLogEntry(int &op_type)
 {
 	int	rval;
+	bool binary = false;
+	std::string body;
 
     // move to the current offset
     if (log_fp && fseek(log_fp, nextOffset, SEEK_SET) != 0) {
@@ -165,7 +168,14 @@ ClassAdLogParser::readLogEntry(int &op_type)
     }
 
     if(log_fp) {
-	    rval = readHeader(log_fp, op_type);
+	    int ch = fgetc(log_fp);
+	    if (ch == CondorLogBinaryMarker) {
+		    binary = true;
+		    rval = LogRecord::readBinaryEntry(log_fp, op_type, body);
+	    } else {
+		    if (ch != EOF) ungetc(ch, log_fp);
+		    rval = readHeader(log_fp, op_type);
+	    }
 	    if (rval < 0) {
 		    closeFile();
 		    return FILE_READ_EOF;
@@ -180,7 +190,13 @@ ClassAdLogParser::readLogEntry(int &op_type)
 
 
 		// read a ClassAd Log Entry Body
-	if(log_fp) {
+	if(log_fp && binary) {
+		if ( ! valid_record_optype(op_type)) {
+			closeFile();
+			return FILE_READ_ERROR;
+		}
+		rval = readBinaryBody(op_type, body);
+	} else if(log_fp) {
 		switch(op_type) {
 		    case CondorLogOp_LogHistoricalSequenceNumber:
 		    rval = readLogHistoricalSNBody(log_fp);
@@ -232,12 +248,24 @@ ClassAdLogParser::readLogEntry(int &op_type)
 			return FILE_FATAL_ERROR;
 		}
 
-		while( -1 != readline( log_fp, line ) ) {
-			int rv = sscanf( line, "%d ", &op );
-			free(line);
-			if( rv != 1 ) {
-					// no op field in line; more bad log records...
-				continue;
+		int ch;
+		while( (ch = fgetc(log_fp)) != EOF ) {
+			if (ch == CondorLogBinaryMarker) {
+				std::string skipped;
+				if (LogRecord::readBinaryEntry(log_fp, op, skipped) < 0) {
+					break;
+				}
+			} else {
+				ungetc(ch, log_fp);
+				if (-1 == readline( log_fp, line )) {
+					break;
+				}
+				int rv = sscanf( line, "%d ", &op );
+				free(line);
+				if( rv != 1 ) {
+						// no op field in line; more bad log records...
+					continue;
+				}
 			}
 			if( op == CondorLogOp_EndTransaction ) {
 					// aargh!  bad record in transaction.  abort!
@@ -526,6 +554,57 @@ ClassAdLogParser::readLogHistoricalSNBody(FILE *fp)
 }
 
 
+// The binary form of each entry is read the same way as by
+// the ReadBinaryBody method of its LogRecord in classad_log.cpp.
+// the encoded expression of a SetAttribute is ignored.
+int
+ClassAdLogParser::readBinaryBody(int op_type, const std::string & body)
+{
+	curCALogEntry.init(op_type);
+
+	const char * ptr = body.data();
+	const char * end = ptr + body.size();
+	bool ok = true;
+	switch(op_type) {
+		case CondorLogOp_LogHistoricalSequenceNumber: {
+			uint64_t seq, stamp;
+			ok = classad::ClassAdBinaryParser::ParseVarint(ptr, end, seq) &&
+				classad::ClassAdBinaryParser::ParseVarint(ptr, end, stamp);
+			if (ok) {
+				curCALogEntry.key = strdup(std::to_string(seq).c_str());
+				curCALogEntry.name = strdup("CreationTimestamp");
+				curCALogEntry.value = strdup(std::to_string(stamp).c_str());
+			}
+			break;
+		}
+		case CondorLogOp_NewClassAd:
+			ok = LogRecord::getBinary(ptr, end, curCALogEntry.key) &&
+				LogRecord::getBinary(ptr, end, curCALogEntry.mytype);
+			curCALogEntry.targettype = strdup("");
+			break;
+		case CondorLogOp_DestroyClassAd:
+			ok = LogRecord::getBinary(ptr, end, curCALogEntry.key);
+			break;
+		case CondorLogOp_SetAttribute:
+			ok = LogRecord::getBinary(ptr, end, curCALogEntry.key) &&
+				LogRecord::getBinaryName(ptr, end, curCALogEntry.name) &&
+				LogRecord::getBinary(ptr, end, curCALogEntry.value);
+			break;
+		case CondorLogOp_DeleteAttribute:
+			ok = LogRecord::getBinary(ptr, end, curCALogEntry.key) &&
+				LogRecord::getBinaryName(ptr, end, curCALogEntry.name);
+			break;
+		case CondorLogOp_EndTransaction:
+			if (ptr < end) {
+				ok = LogRecord::getBinary(ptr, end, curCALogEntry.value);
+			}
+			break;
+		default:
+			break;
+	}
+	return ok ? (int)body.size() : -1;
+}
+
 int
 ClassAdLogParser::readHeader(FILE *fp, int& op_type)
 {
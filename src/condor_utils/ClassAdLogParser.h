@@ -121,6 +121,7 @@ private:
 	int 	readDeleteAttributeBody(FILE *fp);
 	int 	readBeginTransactionBody(FILE *fp);
 	int 	readEndTransactionBody(FILE *fp);
+	int 	readBinaryBody(int op_type, const std::string & body);
 		
 		//
 		// data
@@ -51,6 +51,21 @@ public:
 		m_parent->register_iterator(this);
 	}
 
+	// this iterator stays registered with the table it points into,
+	// so move the registration if the other one is of a different table
+	HashIterator & operator=(const HashIterator &rhs) {
+		if (this != &rhs) {
+			if (m_parent != rhs.m_parent) {
+				m_parent->remove_iterator(this);
+				rhs.m_parent->register_iterator(this);
+			}
+			m_parent = rhs.m_parent;
+			m_idx = rhs.m_idx;
+			m_cur = rhs.m_cur;
+		}
+		return *this;
+	}
+
 	~HashIterator() {
 		m_parent->remove_iterator(this);
 	}
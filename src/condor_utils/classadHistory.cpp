@@ -29,13 +29,16 @@
 #include "condor_email.h"
 
 #include "classadHistory.h"
+#include "history_index.h"
 
 static FILE *HistoryFile_fp = NULL;
 static int HistoryFile_RefCount = 0;
+static FILE *HistoryIndex_fp = NULL;
 
 char* JobHistoryFileName = NULL;
 char* JobHistoryParamName = NULL;
 bool        DoHistoryRotation = true;
+static bool DoHistoryIndex = true;
 char*       PerJobHistoryDir = NULL;
 static HistoryFileRotationInfo hri;
 
@@ -47,6 +50,7 @@ static int findHistoryOffset(FILE *LogFile);
 static FILE* OpenHistoryFile();
 static void CloseJobHistoryFile();
 static void RelinquishHistoryFile(FILE *fp);
+static void AppendHistoryIndex(const HistoryIndexEntry &entry);
 
 // --------------------------------------------------------------------------
 // --------- PUBLIC FUNCTIONS (called by schedd, startd, etc) ---------------
@@ -71,6 +75,7 @@ InitJobHistoryFile(const char *history_param, const char *per_job_history_param)
     hri.DoDailyHistoryRotation = param_boolean("ROTATE_HISTORY_DAILY", false);
     hri.DoMonthlyHistoryRotation = param_boolean("ROTATE_HISTORY_MONTHLY", false);
     hri.IsStandardHistory = true;
+    DoHistoryIndex = param_boolean("ENABLE_HISTORY_INDEX", true);
 
 	long long default_history = 20 * 1024 * 1024;
 	long long history_filesize = 0;
@@ -151,6 +156,7 @@ AppendHistory(ClassAd* ad)
 	  failed = true;
   } else {
 	  int offset = findHistoryOffset(LogFile);
+	  long long ad_offset = ftell(LogFile);
 	  if (fputs(ad_string.c_str(), LogFile) == EOF) {
 		  dprintf(D_ALWAYS, 
 				  "ERROR: failed to write job class ad to history file %s\n",
@@ -176,6 +182,17 @@ AppendHistory(ClassAd* ad)
                       "*** Offset = %d ClusterId = %d ProcId = %d Owner = \"%s\" CompletionDate = %d\n",
 				  offset, cluster, proc, owner.c_str(), completion);
 		  fflush( LogFile );
+
+		  if (DoHistoryIndex && ad_offset >= 0) {
+			  HistoryIndexEntry entry;
+			  entry.offset = ad_offset;
+			  entry.end = ftell(LogFile);
+			  entry.cluster = cluster;
+			  entry.proc = proc;
+			  entry.completion = completion;
+			  if (owner != "?") { entry.owner = owner; }
+			  AppendHistoryIndex(entry);
+		  }
       }
   }
 
@@ -345,6 +362,50 @@ CloseJobHistoryFile() {
 		fclose( HistoryFile_fp );
 		HistoryFile_fp = NULL;
 	}
+	if( HistoryIndex_fp ) {
+		fclose( HistoryIndex_fp );
+		HistoryIndex_fp = NULL;
+	}
+}
+
+// Add an entry for an ad just written to the history file to the history
+// index. The first ad in a history file starts a new index, so an index
+// left behind by a history file that was removed is never extended.
+// If we fail to write an entry, later readers will find the index no
+// longer lines up with the history file and won't use it.
+static void
+AppendHistoryIndex(const HistoryIndexEntry &entry) {
+	if( entry.offset == 0 && HistoryIndex_fp ) {
+		fclose( HistoryIndex_fp );
+		HistoryIndex_fp = NULL;
+	}
+	if( !HistoryIndex_fp ) {
+		std::string index_file = HistoryIndexFileName(JobHistoryFileName);
+		int flags = O_WRONLY|O_CREAT|O_APPEND|O_LARGEFILE|_O_NOINHERIT;
+		if( entry.offset == 0 ) { flags |= O_TRUNC; }
+		int fd = safe_open_wrapper_follow(index_file.c_str(), flags, 0644);
+		if( fd < 0 ) {
+			dprintf(D_ALWAYS,"ERROR opening history index (%s): %s\n",
+					index_file.c_str(), strerror(errno));
+			return;
+		}
+		HistoryIndex_fp = fdopen(fd, "a");
+		if( !HistoryIndex_fp ) {
+			dprintf(D_ALWAYS,"ERROR opening history index fp (%s): %s\n",
+					index_file.c_str(), strerror(errno));
+			close(fd);
+			return;
+		}
+	}
+
+	std::string line;
+	FormatHistoryIndexEntry(line, entry);
+	if( fputs(line.c_str(), HistoryIndex_fp) == EOF || fflush(HistoryIndex_fp) != 0 ) {
+		dprintf(D_ALWAYS,"ERROR writing to history index for %s: %s\n",
+				JobHistoryFileName, strerror(errno));
+		fclose( HistoryIndex_fp );
+		HistoryIndex_fp = NULL;
+	}
 }
 
 // --------------------------------------------------------------------------
@@ -486,6 +547,10 @@ MaybeDeleteOneHistoryBackup(int max_backups, const char* original_filename)
 			if (!dir.Remove_Current_File()) {
 				dprintf(D_ALWAYS, "Failed to delete %s\n", oldest_history_filename);
 				num_backups = 0; // prevent looping forever
+			} else {
+				std::string oldest_path;
+				dircat(history_dir.c_str(), oldest_history_filename, oldest_path);
+				unlink(HistoryIndexFileName(oldest_path.c_str()).c_str());
 			}
 		} else {
 			dprintf(D_ALWAYS, "Failed to find/delete %s\n", oldest_history_filename);
@@ -571,6 +636,17 @@ RotateHistory(bool isHistory, const char* filename, const char* new_path)
         dprintf(D_ALWAYS, "Failed to rotate history file to %s\n",
                 rotated_history_name.c_str());
         dprintf(D_ALWAYS, "Because rotation failed, the history file may get very large.\n");
+    } else {
+        // The index (if there is one) goes along with the history file
+        std::string index_name = HistoryIndexFileName(filename);
+        std::string rotated_index_name = HistoryIndexFileName(rotated_history_name.c_str());
+        struct stat si = {};
+        if (stat(index_name.c_str(), &si) == 0 &&
+            rotate_file(index_name.c_str(), rotated_index_name.c_str())) {
+            dprintf(D_ALWAYS, "Failed to rotate history index to %s\n",
+                    rotated_index_name.c_str());
+            unlink(index_name.c_str());
+        }
     }
 
     return;
@@ -115,6 +115,9 @@ public:
 
   bool InTransaction() { return ClassAdLog<K,AD>::InTransaction(); }
 
+  /// true if there is no transaction, or it has nothing in it to commit
+  bool TransactionIsEmpty() { return ClassAdLog<K,AD>::TransactionIsEmpty(); }
+
   /** Get a list of all new keys created in this transaction
 	  @param new_keys List object to populate
    */
@@ -131,6 +134,12 @@ public:
   }
 
 
+  /** Set a function to be called with the key of each class-ad that is changed,
+      after the change is made.  See ClassAdLog::SetChangeObserver.
+  */
+  typedef typename ClassAdLog<K,AD>::ChangeObserver ChangeObserver;
+  void SetChangeObserver(ChangeObserver observer, void * context) { ClassAdLog<K,AD>::SetChangeObserver(observer, context); }
+
   int SetTransactionTriggers(int mask) { return ClassAdLog<K,AD>::SetTransactionTriggers(mask); }
   int GetTransactionTriggers() { return ClassAdLog<K,AD>::GetTransactionTriggers(); }
 
@@ -174,6 +183,15 @@ public:
   */
   bool TruncLog() { return ClassAdLog<K,AD>::TruncLog(); }
 
+  /** Truncate the log file with the new "checkpoint" written by a forked
+      child, see ClassAdLog::BeginTruncLog
+  */
+  bool BeginTruncLog() { return ClassAdLog<K,AD>::BeginTruncLog(); }
+  bool WriteTruncLogSnapshot() { return ClassAdLog<K,AD>::WriteTruncLogSnapshot(); }
+  bool FinishTruncLog(bool snapshot_written) { return ClassAdLog<K,AD>::FinishTruncLog(snapshot_written); }
+  void AbandonTruncLog() { ClassAdLog<K,AD>::AbandonTruncLog(); }
+  bool TruncLogInProgress() const { return ClassAdLog<K,AD>::TruncLogInProgress(); }
+
   /** Close the log file, discarding any changes that have not yet been written.
       On return from this function, the transaction log will be closed and
       changes to the ad collection will no longer be allowed
@@ -183,6 +201,9 @@ public:
   void SetMaxHistoricalLogs(int max) { ClassAdLog<K,AD>::SetMaxHistoricalLogs(max); }
   int GetMaxHistoricalLogs() { return ClassAdLog<K,AD>::GetMaxHistoricalLogs(); }
 
+  void SetBinaryFormat(bool binary) { ClassAdLog<K,AD>::SetBinaryFormat(binary); }
+  bool GetBinaryFormat() const { return ClassAdLog<K,AD>::GetBinaryFormat(); }
+
   time_t GetOrigLogBirthdate() { return ClassAdLog<K,AD>::GetOrigLogBirthdate(); }
 
   //@}
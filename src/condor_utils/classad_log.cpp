@@ -26,6 +26,7 @@
 #include "classad_merge.h"
 #include "condor_fsync.h"
 #include "condor_attributes.h"
+#include "classad/binarySource.h"
 
 #if defined(UNIX)
 #include "ClassAdLogPlugin.h"
@@ -70,6 +71,8 @@ FILE* LoadClassAdLog(
 	time_t & m_original_log_birthdate,
 	bool & is_clean,
 	bool & requires_successful_cleaning,
+	bool binary,
+	bool & needs_conversion,
 	std::string & errmsg)
 {
 	FILE* log_fp = NULL;
@@ -93,6 +96,7 @@ FILE* LoadClassAdLog(
 
 	is_clean = true; // was cleanly closed (until we find out otherwise)
 	requires_successful_cleaning = false;
+	needs_conversion = false;
 
 	// Read all of the log records
 	LogRecord		*log_rec;
@@ -103,6 +107,9 @@ FILE* LoadClassAdLog(
         curr_log_entry_pos = next_log_entry_pos;
 		next_log_entry_pos = ftell(log_fp);
 		count++;
+		if (log_rec->was_binary() != binary) {
+			needs_conversion = true;
+		}
 		switch (log_rec->get_op_type()) {
 		case CondorLogOp_Error:
 			// this is defensive, ought to be caught in InstantiateLogEntry()
@@ -175,7 +182,7 @@ FILE* LoadClassAdLog(
 	}
 	if(!count) {
 		log_rec = new LogHistoricalSequenceNumber( historical_sequence_number, m_original_log_birthdate );
-		if (log_rec->Write(log_fp) < 0) {
+		if (log_rec->Write(log_fp, binary) < 0) {
 			formatstr(errmsg, "write to %s failed, errno = %d\n", filename, errno);
 			fclose(log_fp); log_fp = NULL;
 		}
@@ -247,6 +254,71 @@ bool SaveHistoricalClassAdLogs(
 }
 
 
+// Move a new log that has been completely written into the place of the
+// current log, which must already be closed, and open it for appending.
+// On failure, the current log is reopened instead.
+static bool
+installClassAdLog(
+	const char * tmp_log_filename,	// in
+	const char * filename,			// in
+	FILE* &log_fp,					// out
+	std::string & errmsg)			// out
+{
+	if (rotate_file(tmp_log_filename, filename) < 0) {
+		formatstr(errmsg, "failed to rotate job queue log!\n");
+
+		unlink(tmp_log_filename);
+
+		int log_fd = safe_open_wrapper_follow(filename, O_RDWR | O_APPEND | O_LARGEFILE | _O_NOINHERIT, 0600);
+		if (log_fd < 0) {
+			formatstr(errmsg, "failed to reopen log %s, errno = %d after failing to rotate log.",filename,errno);
+		} else {
+			log_fp = fdopen(log_fd, "a+");
+			if (log_fp == NULL) {
+				formatstr(errmsg, "failed to refdopen log %s, errno = %d after failing to rotate log.",filename,errno);
+				close(log_fd);
+			}
+		}
+
+		return false;
+	}
+
+#ifndef WIN32
+	// POSIX does not provide any durability guarantees for rename().  Instead, we must
+	// open the parent directory and invoke fsync there.
+	std::string parent_dir = condor_dirname(filename);
+	int parent_fd = safe_open_wrapper_follow(parent_dir.c_str(), O_RDONLY);
+	if (parent_fd >= 0)
+	{
+		if (condor_fsync(parent_fd) == -1)
+		{
+			formatstr(errmsg, "Failed to fsync directory %s after rename. (errno=%d, msg=%s)", parent_dir.c_str(), errno, strerror(errno));
+		}
+		close(parent_fd);
+	}
+	else
+	{
+		formatstr(errmsg, "Failed to open parent directory %s for fsync after rename. (errno=%d, msg=%s)", parent_dir.c_str(), errno, strerror(errno));
+	}
+#endif
+
+	int log_fd = safe_open_wrapper_follow(filename, O_RDWR | O_APPEND | O_LARGEFILE | _O_NOINHERIT, 0600);
+	if (log_fd < 0) {
+		formatstr(errmsg, "failed to open log in append mode: "
+			"safe_open_wrapper(%s) returns %d", filename, log_fd);
+	} else {
+		log_fp = fdopen(log_fd, "a+");
+		if (log_fp == NULL) {
+			close(log_fd);
+			formatstr(errmsg, "failed to fdopen log in append mode: "
+				"fdopen(%s) returns %d", filename, log_fd);
+		}
+	}
+
+	return true;
+}
+
+
 bool TruncateClassAdLog(
 	const char * filename,	        // in
 	LoggableClassAdTable & la,      // in
@@ -254,6 +326,7 @@ bool TruncateClassAdLog(
 	FILE* &log_fp,                  // in,out
 	unsigned long & historical_sequence_number, // in,out
 	time_t & m_original_log_birthdate, // in,out
+	bool binary, // in
 	std::string & errmsg) // out
 {
 	std::string tmp_log_filename;
@@ -285,7 +358,7 @@ bool TruncateClassAdLog(
 	// with a future value for sequence number
 	bool success = WriteClassAdLogState(new_log_fp, tmp_log_filename.c_str(),
 		future_sequence_number, m_original_log_birthdate,
-		la, maker, errmsg);
+		la, maker, binary, errmsg);
 
 	fclose(log_fp);
 	log_fp = NULL;
@@ -301,61 +374,133 @@ bool TruncateClassAdLog(
 	}
 
 	fclose(new_log_fp);	// avoid sharing violation on move
-	if (rotate_file(tmp_log_filename.c_str(), filename) < 0) {
-		formatstr(errmsg, "failed to rotate job queue log!\n");
-
-		unlink(tmp_log_filename.c_str());
-
-		int log_fd = safe_open_wrapper_follow(filename, O_RDWR | O_APPEND | O_LARGEFILE | _O_NOINHERIT, 0600);
-		if (log_fd < 0) {
-			formatstr(errmsg, "failed to reopen log %s, errno = %d after failing to rotate log.",filename,errno);
-		} else {
-			log_fp = fdopen(log_fd, "a+");
-			if (log_fp == NULL) {
-				formatstr(errmsg, "failed to refdopen log %s, errno = %d after failing to rotate log.",filename,errno);
-				close(log_fd);
-			}
-		}
-
+	if ( ! installClassAdLog(tmp_log_filename.c_str(), filename, log_fp, errmsg)) {
 		return false;
 	}
 
 	// we successfully wrote and rotated, so we can update our sequence number
 	historical_sequence_number = future_sequence_number;
+	return true;
+}
 
-#ifndef WIN32
-	// POSIX does not provide any durability guarantees for rename().  Instead, we must
-	// open the parent directory and invoke fsync there.
-	std::string parent_dir = condor_dirname(filename);
-	int parent_fd = safe_open_wrapper_follow(parent_dir.c_str(), O_RDONLY);
-	if (parent_fd >= 0)
-	{
-		if (condor_fsync(parent_fd) == -1)
-		{
-			formatstr(errmsg, "Failed to fsync directory %s after rename. (errno=%d, msg=%s)", parent_dir.c_str(), errno, strerror(errno));
-		}
-		close(parent_fd);
+
+int CreateClassAdLogSnapshot(
+	const char * filename,	        // in
+	FILE* log_fp,                   // in
+	off_t & tail_offset,            // out
+	std::string & errmsg) // out
+{
+	// everything after this offset is appended once the snapshot is written,
+	// so anything still buffered must be part of it
+	if (fflush(log_fp) != 0) {
+		formatstr(errmsg, "failed to rotate log: fflush(%s) failed with errno %d (%s)\n",
+			filename, errno, strerror(errno));
+		return -1;
 	}
-	else
-	{
-		formatstr(errmsg, "Failed to open parent directory %s for fsync after rename. (errno=%d, msg=%s)", parent_dir.c_str(), errno, strerror(errno));
+	struct stat st;
+	if (fstat(fileno(log_fp), &st) < 0) {
+		formatstr(errmsg, "failed to rotate log: fstat(%s) failed with errno %d (%s)\n",
+			filename, errno, strerror(errno));
+		return -1;
 	}
-#endif
+	tail_offset = st.st_size;
 
-	int log_fd = safe_open_wrapper_follow(filename, O_RDWR | O_APPEND | O_LARGEFILE | _O_NOINHERIT, 0600);
-	if (log_fd < 0) {
-		formatstr(errmsg, "failed to open log in append mode: "
-			"safe_open_wrapper(%s) returns %d", filename, log_fd);
-	} else {
-		log_fp = fdopen(log_fd, "a+");
-		if (log_fp == NULL) {
-			close(log_fd);
-			formatstr(errmsg, "failed to fdopen log in append mode: "
-				"fdopen(%s) returns %d", filename, log_fd);
+	std::string tmp_log_filename;
+	formatstr(tmp_log_filename, "%s.tmp", filename);
+	int snapshot_fd = safe_create_replace_if_exists(tmp_log_filename.c_str(), O_RDWR | O_CREAT | O_LARGEFILE | _O_NOINHERIT, 0600);
+	if (snapshot_fd < 0) {
+		formatstr(errmsg, "failed to rotate log: safe_create_replace_if_exists(%s) failed with errno %d (%s)\n",
+			tmp_log_filename.c_str(), errno, strerror(errno));
+		return -1;
+	}
+	return snapshot_fd;
+}
+
+bool WriteClassAdLogSnapshot(
+	int snapshot_fd,                // in
+	const char * filename,          // in
+	unsigned long sequence_number,  // in
+	time_t original_log_birthdate,  // in
+	LoggableClassAdTable & la,      // in
+	const ConstructLogEntry& maker, // in
+	bool binary,                    // in
+	std::string & errmsg) // out
+{
+	int fd = dup(snapshot_fd);
+	FILE *fp = (fd < 0) ? NULL : fdopen(fd, "r+");
+	if (fp == NULL) {
+		formatstr(errmsg, "failed to rotate log: fdopen of new log for %s failed with errno %d (%s)\n",
+			filename, errno, strerror(errno));
+		if (fd >= 0) { close(fd); }
+		return false;
+	}
+	bool success = WriteClassAdLogState(fp, filename, sequence_number, original_log_birthdate,
+		la, maker, binary, errmsg);
+	if (fclose(fp) != 0) {
+		formatstr(errmsg, "failed to rotate log: close of new log for %s failed with errno %d (%s)\n",
+			filename, errno, strerror(errno));
+		success = false;
+	}
+	return success;
+}
+
+bool StitchClassAdLogSnapshot(
+	const char * filename,          // in
+	int snapshot_fd,                // in
+	off_t tail_offset,              // in
+	FILE* &log_fp,                  // in,out
+	std::string & errmsg) // out
+{
+	std::string tmp_log_filename;
+	formatstr(tmp_log_filename, "%s.tmp", filename);
+
+	// copy the records appended while the snapshot was being written onto its end.
+	// the log is only ever appended to, so these are whole records
+	int log_fd = fileno(log_fp);
+	bool success = (fflush(log_fp) == 0) &&
+		(lseek(snapshot_fd, 0, SEEK_END) >= 0) &&
+		(lseek(log_fd, tail_offset, SEEK_SET) == tail_offset);
+	char buf[64*1024];
+	off_t offset = tail_offset;
+	while (success) {
+		ssize_t cb = read(log_fd, buf, sizeof(buf));
+		if (cb <= 0) {
+			success = (cb == 0);
+			break;
+		}
+		if (full_write(snapshot_fd, buf, cb) != cb) {
+			success = false;
 		}
+		offset += cb;
+	}
+	if (success && condor_fdatasync(snapshot_fd) < 0) {
+		success = false;
+	}
+	if ( ! success) {
+		formatstr(errmsg, "failed to rotate log: copying new entries of %s to %s failed with errno %d (%s)\n",
+			filename, tmp_log_filename.c_str(), errno, strerror(errno));
+		close(snapshot_fd);
+		unlink(tmp_log_filename.c_str());
+		return false;
 	}
+	close(snapshot_fd);
 
-	return true;
+	dprintf(D_FULLDEBUG, "Copied %lld bytes of new entries to rotated log %s\n",
+		(long long)(offset - tail_offset), filename);
+
+	fclose(log_fp);
+	log_fp = NULL;
+	return installClassAdLog(tmp_log_filename.c_str(), filename, log_fp, errmsg);
+}
+
+void AbandonClassAdLogSnapshot(
+	const char * filename,          // in
+	int snapshot_fd)                // in
+{
+	std::string tmp_log_filename;
+	formatstr(tmp_log_filename, "%s.tmp", filename);
+	close(snapshot_fd);
+	unlink(tmp_log_filename.c_str());
 }
 
 
@@ -529,6 +674,7 @@ bool WriteClassAdLogState(
 	time_t m_original_log_birthdate, // in
 	LoggableClassAdTable & la,
 	const ConstructLogEntry& maker,
+	bool binary,
 	std::string & errmsg)
 {
 	LogRecord	*log=NULL;
@@ -536,7 +682,7 @@ bool WriteClassAdLogState(
 
 	// This must always be the first entry in the log.
 	log = new LogHistoricalSequenceNumber( historical_sequence_number, m_original_log_birthdate );
-	if (log->Write(fp) < 0) {
+	if (log->Write(fp, binary) < 0) {
 		formatstr(errmsg, "write to %s failed, errno = %d", filename, errno);
 		delete log;
 		return false;
@@ -549,7 +695,7 @@ bool WriteClassAdLogState(
 	la.startIterations();
 	while(la.nextIteration(key, ad)) {
 		log = new LogNewClassAd(key, GetMyTypeName(*ad), maker);
-		if (log->Write(fp) < 0) {
+		if (log->Write(fp, binary) < 0) {
 			formatstr(errmsg, "write to %s failed, errno = %d", filename, errno);
 			delete log;
 			return false;
@@ -568,7 +714,7 @@ bool WriteClassAdLogState(
 			if (expr) {
 				log = new LogSetAttribute(key, itr->first.c_str(),
 										  ExprTreeToString(expr));
-				if (log->Write(fp) < 0) {
+				if (log->Write(fp, binary) < 0) {
 					formatstr(errmsg, "write to %s failed, errno = %d", filename, errno);
 					delete log;
 					return false;
@@ -639,6 +785,27 @@ LogHistoricalSequenceNumber::WriteBody(FILE *fp)
 	return (fwrite(buf, 1, len, fp) < (unsigned)len) ? -1: len;
 }
 
+int
+LogHistoricalSequenceNumber::WriteBinaryBody(std::string & buf)
+{
+	classad::ClassAdBinaryUnParser::UnparseVarint(buf, historical_sequence_number);
+	classad::ClassAdBinaryUnParser::UnparseVarint(buf, (uint64_t)timestamp);
+	return 0;
+}
+
+int
+LogHistoricalSequenceNumber::ReadBinaryBody(const char *& ptr, const char * end)
+{
+	uint64_t seq, stamp;
+	if ( ! classad::ClassAdBinaryParser::ParseVarint(ptr, end, seq) ||
+		 ! classad::ClassAdBinaryParser::ParseVarint(ptr, end, stamp)) {
+		return -1;
+	}
+	historical_sequence_number = (unsigned long)seq;
+	timestamp = (time_t)stamp;
+	return 0;
+}
+
 LogNewClassAd::LogNewClassAd(const char *k, const char *m, const ConstructLogEntry & c) : ctor(c)
 {
 	op_type = CondorLogOp_NewClassAd;
@@ -748,6 +915,23 @@ LogNewClassAd::WriteBody(FILE* fp)
 	return rval + rval1;
 }
 
+int
+LogNewClassAd::WriteBinaryBody(std::string & buf)
+{
+	// binary entries are never read by versions of HTCondor that need a TargetType
+	putBinary(buf, key);
+	putBinary(buf, mytype);
+	return 0;
+}
+
+int
+LogNewClassAd::ReadBinaryBody(const char *& ptr, const char * end)
+{
+	free(key);
+	free(mytype);
+	return (getBinary(ptr, end, key) && getBinary(ptr, end, mytype)) ? 0 : -1;
+}
+
 LogDestroyClassAd::LogDestroyClassAd(const char *k, const ConstructLogEntry & c) : ctor(c)
 {
 	op_type = CondorLogOp_DestroyClassAd;
@@ -824,7 +1008,15 @@ LogSetAttribute::Play(void *data_structure)
 		return -1;
 
 	std::string attr(name);
-	if (ad->InsertViaCache(attr, value)) {
+	bool inserted;
+	if (read_binary && value_expr) {
+		// the expression was decoded from the log, hand it to the ad rather than parse value again
+		inserted = ad->InsertViaCache(attr, value, value_expr);
+		value_expr = NULL;
+	} else {
+		inserted = ad->InsertViaCache(attr, value);
+	}
+	if (inserted) {
 		rval = TRUE;
 	} else {
 		rval = FALSE;
@@ -920,6 +1112,57 @@ LogSetAttribute::ReadBody(FILE* fp)
 	return rval + rval1;
 }
 
+int
+LogSetAttribute::WriteBinaryBody(std::string & buf)
+{
+	// refuse newlines here too, so that any log can be rewritten as text
+	if( strchr(key, '\n') || strchr(name, '\n') || strchr(value, '\n') ) {
+		dprintf(D_ALWAYS, "Refusing attempt to add '%s' = '%s' to record '%s' as it contains a newline, which is not allowed.\n", name, value, key);
+		return -1;
+	}
+
+	putBinary(buf, key);
+	putBinaryName(buf, name);
+	putBinary(buf, value);
+	if (value_expr) {
+		size_t len = buf.size();
+		if ( ! classad::ClassAdBinaryUnParser(&binaryNames()).Unparse(buf, value_expr)) {
+			// leave it to the reader to parse value
+			buf.resize(len);
+		}
+	}
+	return 0;
+}
+
+int
+LogSetAttribute::ReadBinaryBody(const char *& ptr, const char * end)
+{
+	free(key);
+	free(name);
+	free(value);
+	if (value_expr) delete value_expr;
+	value_expr = NULL;
+
+	if ( ! getBinary(ptr, end, key) || ! getBinaryName(ptr, end, name) || ! getBinary(ptr, end, value)) {
+		return -1;
+	}
+	if (ptr < end) {
+		value_expr = classad::ClassAdBinaryParser(&binaryNames()).ParseExpression(ptr, end);
+		if ( ! value_expr) {
+			return -1;
+		}
+	} else if (ParseClassAdRvalExpr(value, value_expr)) {
+		if (value_expr) delete value_expr;
+		value_expr = NULL;
+		if (param_boolean("CLASSAD_LOG_STRICT_PARSING", true)) {
+			return -1;
+		} else {
+			dprintf(D_ALWAYS, "WARNING: strict classad parsing failed for expression: %s\n", value);
+		}
+	}
+	return 0;
+}
+
 
 LogDeleteAttribute::LogDeleteAttribute(const char *k, const char *n)
 {
@@ -1038,6 +1281,22 @@ LogEndTransaction::ReadBody( FILE* fp )
 	return( 1 );
 }
 
+int
+LogDeleteAttribute::WriteBinaryBody(std::string & buf)
+{
+	putBinary(buf, key);
+	putBinaryName(buf, name);
+	return 0;
+}
+
+int
+LogDeleteAttribute::ReadBinaryBody(const char *& ptr, const char * end)
+{
+	free(key);
+	free(name);
+	return (getBinary(ptr, end, key) && getBinaryName(ptr, end, name)) ? 0 : -1;
+}
+
 int
 LogDeleteAttribute::ReadBody(FILE* fp)
 {
@@ -1060,7 +1319,7 @@ LogDeleteAttribute::ReadBody(FILE* fp)
 #define	ATTRLIST_MAX_EXPRESSION 10240
 
 LogRecord	*
-InstantiateLogEntry(FILE *fp, unsigned long recnum, int type, const ConstructLogEntry & ctor)
+InstantiateLogEntry(FILE *fp, unsigned long recnum, int type, const ConstructLogEntry & ctor, const std::string * body)
 {
 	LogRecord	*log_rec;
 
@@ -1095,6 +1354,11 @@ InstantiateLogEntry(FILE *fp, unsigned long recnum, int type, const ConstructLog
 	}
 
 	long long pos = ftell(fp);
+	if (body) {
+		// we have already read past a binary entry, report where it started:
+		// the marker, the length and the op, which is one byte for every valid op
+		pos -= (long long)body->size() + 6;
+	}
 
 	// Check if we got a bogus record indicating a bad log file.  There are two basic
     // failure modes.  The first mode is some kind of parse failure that occurs at the
@@ -1103,7 +1367,8 @@ InstantiateLogEntry(FILE *fp, unsigned long recnum, int type, const ConstructLog
     // mode is a failure that occurs inside a complete transaction (one with an end-of-
     // transaction op).  A complete transaction with corruption is unrecoverable, and 
     // causes a fatal exception.
-	if (log_rec->ReadBody(fp) < 0  ||  log_rec->get_op_type() == CondorLogOp_Error) {
+	int rval = body ? log_rec->ReadBinary(*body) : log_rec->ReadBody(fp);
+	if (rval < 0  ||  log_rec->get_op_type() == CondorLogOp_Error) {
         dprintf(D_ALWAYS | D_ERROR, "WARNING: Encountered corrupt log record %lu (byte offset %lld)\n", recnum, pos);
 		// TODO: this ugly code attempts to reconstruct the corrupted line, fix it to just show the actual line.
 		const char *key, *name="", *value="";
@@ -1125,7 +1390,27 @@ InstantiateLogEntry(FILE *fp, unsigned long recnum, int type, const ConstructLog
         const unsigned long maxfollow = 3;
         dprintf(D_ALWAYS, "Lines following corrupt log record %lu (up to %lu):\n", recnum, maxfollow);
         unsigned long nlines = 0;
-		while( fgets( line, ATTRLIST_MAX_EXPRESSION+64, fp ) ) {
+		int ch;
+		while ((ch = fgetc(fp)) != EOF) {
+			if (ch == CondorLogBinaryMarker) {
+				// binary entries can be skipped by their length, even if their bodies are bad
+				std::string skipped;
+				if (LogRecord::readBinaryEntry(fp, op, skipped) < 0) {
+					break;
+				}
+				nlines += 1;
+				if (nlines <= maxfollow) {
+					dprintf(D_ALWAYS, "    (binary entry %d, %d bytes)\n", op, (int)skipped.size());
+				}
+				if (op == CondorLogOp_EndTransaction) {
+					EXCEPT("Error: corrupt log record %lu (byte offset %lld) occurred inside closed transaction, recovery failed", recnum, pos);
+				}
+				continue;
+			}
+			ungetc(ch, fp);
+			if ( ! fgets( line, ATTRLIST_MAX_EXPRESSION+64, fp )) {
+				break;
+			}
             nlines += 1;
             if (nlines <= maxfollow) {
                 dprintf(D_ALWAYS, "    %s", line);
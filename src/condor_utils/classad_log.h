@@ -47,6 +47,8 @@
 #include "log_transaction.h"
 #include "stopwatch.h"
 
+#include <memory>
+
 extern const char *EMPTY_CLASSAD_TYPE_NAME;
 
 // This class is used to abstract creation and destruction of 
@@ -88,6 +90,14 @@ public:
 
 	bool InitLogFile(const char *filename,int max_historical_logs=0);
 
+	// a cheap test that a filter_iterator can use to pass over ads without evaluating
+	// its requirements. an ad that is not rejected must still match the requirements.
+	class filter_prefilter {
+		public:
+			virtual ~filter_prefilter() {}
+			virtual bool Rejects(AD ad) const = 0;
+	};
+
 	// define an stl type iterator, but one that can filter based on a requirements expression
 	class filter_iterator {
 		private:
@@ -95,6 +105,7 @@ public:
 			HashIterator<K,AD> m_cur;
 			bool m_found_ad;
 			const classad::ExprTree *m_requirements;
+			std::shared_ptr<const filter_prefilter> m_prefilter;
 			int m_timeslice_ms;
 			int m_done;
 			int m_options;
@@ -109,6 +120,10 @@ public:
 				, m_done(at_end)
 				, m_options(0) {}
 
+			// callers copy and assign these (it = end;), and the user-declared destructor
+			// would otherwise make the implicit copy operations deprecated
+			filter_iterator(const filter_iterator &) = default;
+			filter_iterator & operator=(const filter_iterator &) = default;
 			~filter_iterator() {}
 			AD operator *() const {
 				if (m_done || (m_cur == m_table->end()) || !m_found_ad)
@@ -128,6 +143,7 @@ public:
 			bool operator!=(const filter_iterator &rhs) const {return !(*this == rhs);}
 			int set_options(int options) { int opts = m_options; m_options = options; return opts; }
 			int get_options() { return m_options; }
+			void set_prefilter(std::shared_ptr<const filter_prefilter> prefilter) { m_prefilter = prefilter; }
 
 			using iterator_category = std::input_iterator_tag;
 			using value_type = AD;
@@ -140,6 +156,21 @@ public:
 	void AppendLog(LogRecord *log);	// perform a log operation
 	bool TruncLog();				// clean log file on disk
 
+	// Clean the log file on disk without blocking while the table is written.
+	// BeginTruncLog saves the historical log and creates the new log file, then
+	// the caller forks and calls WriteTruncLogSnapshot in the child, whose copy
+	// of the table is frozen at the fork.  The parent goes on appending to the
+	// current log, and once the child exits calls FinishTruncLog, which copies
+	// what was appended since BeginTruncLog onto the end of the new log and
+	// rotates it into place.  A TruncLog or StopLog in the meantime abandons the
+	// background clean; the child need not be waited for, but its result must
+	// then not be passed to FinishTruncLog.
+	bool BeginTruncLog();
+	bool WriteTruncLogSnapshot();	// call this in the child
+	bool FinishTruncLog(bool snapshot_written);
+	void AbandonTruncLog();
+	bool TruncLogInProgress() const { return m_snapshot_fd >= 0; }
+
 	// close the log file and discard any unwritten transactions, disable future changes
 	void StopLog();
 
@@ -148,6 +179,7 @@ public:
 	void CommitTransaction(const char * comment = NULL);
 	void CommitNondurableTransaction(const char * comment = NULL);
 	bool InTransaction() { return active_transaction != NULL; }
+	bool TransactionIsEmpty() { return active_transaction == NULL || active_transaction->EmptyTransaction(); }
 	int SetTransactionTriggers(int mask);
 	int GetTransactionTriggers();
 
@@ -203,6 +235,15 @@ public:
 	// added into the set, false if not.
 	bool AddAttrNamesFromTransaction(const K &key, classad::References & attrs);
 
+	// optional callback that is given the key of each ad changed by AppendLog or
+	// CommitTransaction, after the change has been applied to the table.
+	// it is not called for records played while loading the log.
+	typedef void (*ChangeObserver)(const char * key, void * context);
+	void SetChangeObserver(ChangeObserver observer, void * context) {
+		change_observer = observer;
+		change_observer_context = context;
+	}
+
 	HashTable<K,AD> table;
 
 	// user-replacable helper class for creating and destroying values for the hashtable
@@ -217,6 +258,12 @@ public:
 	void SetMaxHistoricalLogs(int max) { this->max_historical_logs = max; }
 	int GetMaxHistoricalLogs() { return max_historical_logs; }
 
+	// Write log entries in binary rather than as text. This should be set before
+	// InitLogFile, which rewrites a log that holds entries in the other format.
+	// Either way, entries of both formats can be read.
+	void SetBinaryFormat(bool binary) { m_binary_format = binary; }
+	bool GetBinaryFormat() const { return m_binary_format; }
+
 	time_t GetOrigLogBirthdate() {return m_original_log_birthdate;}
 
 protected:
@@ -254,6 +301,13 @@ private:
 	unsigned long historical_sequence_number;
 	time_t m_original_log_birthdate;
 	int m_nondurable_level;
+	bool m_binary_format;
+	// the new log being written by a background TruncLog, or -1
+	int m_snapshot_fd;
+	off_t m_snapshot_tail_offset;
+	unsigned long m_snapshot_sequence_number;
+	ChangeObserver change_observer;
+	void * change_observer_context;
 
 	bool SaveHistoricalLogs();
 };
@@ -270,6 +324,8 @@ public:
 private:
 	virtual int WriteBody(FILE *fp);
 	virtual int ReadBody(FILE *fp);
+	virtual int WriteBinaryBody(std::string & buf);
+	virtual int ReadBinaryBody(const char *& ptr, const char * end);
 
 	virtual char const *get_key() {return NULL;}
 
@@ -346,6 +402,8 @@ public:
 private:
 	virtual int WriteBody(FILE *fp);
 	virtual int ReadBody(FILE* fp);
+	virtual int WriteBinaryBody(std::string & buf);
+	virtual int ReadBinaryBody(const char *& ptr, const char * end);
 
 	const ConstructLogEntry & ctor;
 	char *key;
@@ -364,6 +422,8 @@ public:
 private:
 	virtual int WriteBody(FILE* fp) { size_t r=fwrite(key, sizeof(char), strlen(key), fp); return (r < strlen(key)) ? -1 : (int)r;}
 	virtual int ReadBody(FILE* fp);
+	virtual int WriteBinaryBody(std::string & buf) { putBinary(buf, key); return 0; }
+	virtual int ReadBinaryBody(const char *& ptr, const char * end) { free(key); key = NULL; return getBinary(ptr, end, key) ? 0 : -1; }
 
 	const ConstructLogEntry & ctor;
 	char *key;
@@ -383,6 +443,9 @@ public:
 private:
 	virtual int WriteBody(FILE* fp);
 	virtual int ReadBody(FILE* fp);
+	// the binary body also holds the encoded expression, so that replaying it doesn't parse value
+	virtual int WriteBinaryBody(std::string & buf);
+	virtual int ReadBinaryBody(const char *& ptr, const char * end);
 
 	char *key;
 	char *name;
@@ -402,6 +465,8 @@ public:
 private:
 	virtual int WriteBody(FILE* fp);
 	virtual int ReadBody(FILE* fp);
+	virtual int WriteBinaryBody(std::string & buf);
+	virtual int ReadBinaryBody(const char *& ptr, const char * end);
 
 	char *key;
 	char *name;
@@ -439,6 +504,8 @@ public:
 private:
 	virtual int WriteBody(FILE* fp);
 	virtual int ReadBody(FILE* fp);
+	virtual int WriteBinaryBody(std::string & buf) { if (comment && comment[0]) putBinary(buf, comment); return 0; }
+	virtual int ReadBinaryBody(const char *& ptr, const char * end) { return (ptr < end && ! getBinary(ptr, end, comment)) ? -1 : 0; }
 
 	virtual char const *get_key() {return NULL;}
 	char * comment;
@@ -455,8 +522,38 @@ bool TruncateClassAdLog(
 	FILE* &log_fp,                  // in,out
 	unsigned long & historical_sequence_number, // in,out
 	time_t & m_original_log_birthdate, // in,out
+	bool binary,                    // in: write the new log in binary
+	std::string & errmsg);          // out
+
+// the pieces of TruncateClassAdLog for a truncation that writes the new log
+// in a child process, see ClassAdLog::BeginTruncLog
+int CreateClassAdLogSnapshot(
+	const char * filename,          // in
+	FILE* log_fp,                   // in
+	off_t & tail_offset,            // out: the end of the current log
+	std::string & errmsg);          // out
+
+bool WriteClassAdLogSnapshot(
+	int snapshot_fd,                // in
+	const char * filename,          // in: used for error messages
+	unsigned long sequence_number,  // in
+	time_t original_log_birthdate,  // in
+	LoggableClassAdTable & la,      // in
+	const ConstructLogEntry& maker, // in
+	bool binary,                    // in
+	std::string & errmsg);          // out
+
+bool StitchClassAdLogSnapshot(
+	const char * filename,          // in
+	int snapshot_fd,                // in: closed by this function
+	off_t tail_offset,              // in
+	FILE* &log_fp,                  // in,out
 	std::string & errmsg);          // out
 
+void AbandonClassAdLogSnapshot(
+	const char * filename,          // in
+	int snapshot_fd);               // in: closed by this function
+
 bool WriteClassAdLogState(
 	FILE *fp,                       // in
 	const char * filename,          // in: used for error messages
@@ -464,6 +561,7 @@ bool WriteClassAdLogState(
 	time_t original_log_birthdate,  // in
 	LoggableClassAdTable & la,      // in
 	const ConstructLogEntry& maker, // in
+	bool binary,                    // in: write entries in binary
 	std::string & errmsg);          // out
 
 FILE* LoadClassAdLog(
@@ -474,6 +572,8 @@ FILE* LoadClassAdLog(
 	time_t & m_original_log_birthdate, // in,out
 	bool & is_clean,  // out: true if log was shutdown cleanly
 	bool & requires_successful_cleaning, // out: true if log must be cleaned (i.e rotated) before it can be written to again.
+	bool binary,                    // in: write entries in binary
+	bool & needs_conversion,        // out: true if some entries are not in the format given by binary
 	std::string & errmsg);          // out, contains error or warning messages
 
 int FlushClassAdLog(FILE* fp, bool force);
@@ -506,7 +606,8 @@ LogRecord* InstantiateLogEntry(
 	FILE* fp,
 	unsigned long recnum,
 	int type,
-	const ConstructLogEntry & ctor);
+	const ConstructLogEntry & ctor,
+	const std::string * body);
 
 // Templated member functions that call the helper functions with the correct arguments.
 //
@@ -523,6 +624,7 @@ ClassAdLog<K,AD>::InitLogFile(const char *filename,int max_historical_logs_arg)
 
 	bool is_clean = true;
 	bool requires_successful_cleaning = false;
+	bool needs_conversion = false;
 	std::string errmsg;
 
 	ClassAdLogTable<K,AD> la(table); // this gives the ability to add & remove table items.
@@ -530,7 +632,8 @@ ClassAdLog<K,AD>::InitLogFile(const char *filename,int max_historical_logs_arg)
 	log_fp = LoadClassAdLog(filename,
 		la, this->GetTableEntryMaker(),
 		historical_sequence_number, m_original_log_birthdate,
-		is_clean, requires_successful_cleaning, errmsg);
+		is_clean, requires_successful_cleaning,
+		m_binary_format, needs_conversion, errmsg);
 
 	if ( ! log_fp) {
 		dprintf(D_ALWAYS, "%s", errmsg.c_str());
@@ -538,7 +641,10 @@ ClassAdLog<K,AD>::InitLogFile(const char *filename,int max_historical_logs_arg)
 	} else if ( ! errmsg.empty()) {
 		dprintf(D_ALWAYS, "ClassAdLog %s has the following issues: %s\n", filename, errmsg.c_str());
 	}
-	if( !is_clean || requires_successful_cleaning ) {
+	if (needs_conversion && ! open_read_only) {
+		dprintf(D_ALWAYS, "ClassAdLog %s will be rewritten in %s format\n", filename, m_binary_format ? "binary" : "text");
+	}
+	if( !is_clean || requires_successful_cleaning || (needs_conversion && ! open_read_only) ) {
 		if (open_read_only && requires_successful_cleaning) {
 			StopLog();
 			dprintf(D_ALWAYS, "Log %s is corrupt and needs to be cleaned before restarting HTCondor", filename);
@@ -563,6 +669,12 @@ ClassAdLog<K,AD>::ClassAdLog(const ConstructLogEntry* maker)
 	, historical_sequence_number(0)
 	, m_original_log_birthdate(0)
 	, m_nondurable_level(0)
+	, m_binary_format(false)
+	, m_snapshot_fd(-1)
+	, m_snapshot_tail_offset(0)
+	, m_snapshot_sequence_number(0)
+	, change_observer(nullptr)
+	, change_observer_context(nullptr)
 {
 }
 
@@ -603,7 +715,7 @@ ClassAdLog<K,AD>::AppendLog(LogRecord *log)
 	} else {
 			//MD: using file pointer
 		if (log_fp!=NULL) {
-			if (log->Write(log_fp) < 0) {
+			if (log->Write(log_fp, m_binary_format) < 0) {
 				EXCEPT("write to %s failed, errno = %d", logFilename(), errno);
 			}
 			if( m_nondurable_level == 0 ) {
@@ -612,6 +724,9 @@ ClassAdLog<K,AD>::AppendLog(LogRecord *log)
 		}
 		ClassAdLogTable<K,AD> la(table);
 		log->Play((void *)&la);
+		if (change_observer && log->get_key()) {
+			change_observer(log->get_key(), change_observer_context);
+		}
 		delete log;
 	}
 }
@@ -649,6 +764,8 @@ template <typename K, typename AD>
 bool
 ClassAdLog<K,AD>::TruncLog()
 {
+	AbandonTruncLog();
+
 	dprintf(D_ALWAYS,"About to rotate ClassAd log %s\n",logFilename());
 
 	if(!SaveHistoricalLogs()) {
@@ -661,7 +778,7 @@ ClassAdLog<K,AD>::TruncLog()
 	bool rotated = TruncateClassAdLog(logFilename(),
 		la, this->GetTableEntryMaker(),
 		log_fp, historical_sequence_number, m_original_log_birthdate,
-		errmsg);
+		m_binary_format, errmsg);
 	if ( ! log_fp) {
 		// if after rotation, the log is no longer open, the the failure is fatal, and we must except
 		EXCEPT("%s", errmsg.c_str());
@@ -673,10 +790,92 @@ ClassAdLog<K,AD>::TruncLog()
 	return rotated;
 }
 
+template <typename K, typename AD>
+bool
+ClassAdLog<K,AD>::BeginTruncLog()
+{
+	if (TruncLogInProgress()) {
+		return false;
+	}
+
+	dprintf(D_ALWAYS,"About to rotate ClassAd log %s in the background\n",logFilename());
+
+	if(!SaveHistoricalLogs()) {
+		dprintf(D_ALWAYS,"Skipping log rotation, because saving of historical log failed for %s.\n",logFilename());
+		return false;
+	}
+
+	std::string errmsg;
+	m_snapshot_fd = CreateClassAdLogSnapshot(logFilename(), log_fp, m_snapshot_tail_offset, errmsg);
+	if (m_snapshot_fd < 0) {
+		dprintf(D_ALWAYS, "%s", errmsg.c_str());
+		return false;
+	}
+	m_snapshot_sequence_number = historical_sequence_number + 1;
+	return true;
+}
+
+template <typename K, typename AD>
+bool
+ClassAdLog<K,AD>::WriteTruncLogSnapshot()
+{
+	std::string errmsg;
+	ClassAdLogTable<K,AD> la(table); // this gives the ability to add & remove table items.
+	bool success = WriteClassAdLogSnapshot(m_snapshot_fd, logFilename(),
+		m_snapshot_sequence_number, m_original_log_birthdate,
+		la, this->GetTableEntryMaker(),
+		m_binary_format, errmsg);
+	if ( ! success) {
+		dprintf(D_ALWAYS, "%s", errmsg.c_str());
+	}
+	return success;
+}
+
+template <typename K, typename AD>
+bool
+ClassAdLog<K,AD>::FinishTruncLog(bool snapshot_written)
+{
+	if ( ! TruncLogInProgress()) {
+		return false;
+	}
+	if ( ! snapshot_written) {
+		dprintf(D_ALWAYS, "Skipping log rotation, because writing the new log for %s failed.\n", logFilename());
+		AbandonTruncLog();
+		return false;
+	}
+
+	std::string errmsg;
+	int fd = m_snapshot_fd;
+	m_snapshot_fd = -1;
+	bool rotated = StitchClassAdLogSnapshot(logFilename(), fd, m_snapshot_tail_offset, log_fp, errmsg);
+	if ( ! log_fp) {
+		// if after rotation, the log is no longer open, the the failure is fatal, and we must except
+		EXCEPT("%s", errmsg.c_str());
+	}
+	if ( ! errmsg.empty()) {
+		dprintf(D_ALWAYS, "%s", errmsg.c_str());
+	}
+	if (rotated) {
+		historical_sequence_number = m_snapshot_sequence_number;
+	}
+	return rotated;
+}
+
+template <typename K, typename AD>
+void
+ClassAdLog<K,AD>::AbandonTruncLog()
+{
+	if (TruncLogInProgress()) {
+		AbandonClassAdLogSnapshot(logFilename(), m_snapshot_fd);
+		m_snapshot_fd = -1;
+	}
+}
+
 template <typename K, typename AD>
 void
 ClassAdLog<K,AD>::StopLog()
 {
+	AbandonTruncLog();
 	AbortTransaction();
 	if (log_fp) {
 		fclose(log_fp);
@@ -693,7 +892,7 @@ ClassAdLog<K,AD>::LogState(FILE *fp)
 	bool success = WriteClassAdLogState(fp, logFilename(),
 		historical_sequence_number, m_original_log_birthdate,
 		la, this->GetTableEntryMaker(),
-		errmsg);
+		m_binary_format, errmsg);
 	if (! success) {
 		EXCEPT("%s", errmsg.c_str());
 	}
@@ -752,7 +951,13 @@ ClassAdLog<K,AD>::CommitTransaction(const char * comment /*=NULL*/)
 		active_transaction->AppendLog(log);
 		bool nondurable = m_nondurable_level > 0;
 		ClassAdLogTable<K,AD> la(table);
-		active_transaction->Commit(log_fp, logFilename(), &la, nondurable );
+		active_transaction->Commit(log_fp, logFilename(), &la, nondurable, m_binary_format);
+		if (change_observer) {
+			for (auto & [key, lrec] : active_transaction->OrderedOpsByKey()) {
+				// keys are views of the keys of the records, so they are null terminated
+				if ( ! key.empty()) { change_observer(key.data(), change_observer_context); }
+			}
+		}
 	}
 	delete active_transaction;
 	active_transaction = NULL;
@@ -25,6 +25,8 @@
 #include "my_hostname.h"
 
 #include "classad/classad_distribution.h"
+#include "classad/classadCache.h"
+#include "classad/binarySource.h"
 #include "classad_oldnew.h"
 #include "compat_classad.h"
 
@@ -37,6 +39,24 @@ int _putClassAd(Stream *sock, const classad::ClassAd& ad, int options,
 
 static const char *SECRET_MARKER = "ZKM"; // "it's a Zecret Klassad, Mon!"
 
+// An ad in the binary encoding starts with this in place of the number of
+// "name = expr" strings, followed by the length of the encoding and the
+// encoding itself:
+//   varint  format version, which is 1
+//   varint  how many names the sender had added to the connection's list before this ad
+//   varint  the number of attributes in the encoding
+//   varint  the number of "name = expr" strings that follow the encoding
+//   the attributes, each a name and then the value as written by ClassAdBinaryUnParser
+// A name is a varint that is 0 followed by the name, 1 followed by a name
+// that is added to the end of the connection's list, or 2 + the position
+// of the name in that list.  The strings that follow the encoding hold the
+// attributes that have to be encrypted, exactly as the text form sends
+// them, and the ad ends with MyType and TargetType as usual.
+static const int BINARY_CLASSAD_MARKER = -0x42414431;
+static const size_t BINARY_CLASSAD_MAX_NAMES = 10000;
+
+static bool getClassAdBinary(Stream *sock, classad::ClassAd& ad, int options);
+
 bool getClassAd( Stream *sock, classad::ClassAd& ad )
 {
 	int 					numExprs;
@@ -49,6 +69,9 @@ bool getClassAd( Stream *sock, classad::ClassAd& ad )
 		dprintf(D_FULLDEBUG, "FAILED to get number of expressions.\n");
  		return false;
 	}
+	if (numExprs == BINARY_CLASSAD_MARKER) {
+		return getClassAdBinary(sock, ad, 0);
+	}
 
 	// at least numExprs are coming, but we may add
 	// my, target, and a couple extra right away
@@ -226,6 +249,9 @@ bool getClassAdEx( Stream *sock, classad::ClassAd& ad, int options)
 	if( !sock->code( numExprs ) ) {
 		return false;
 	}
+	if (numExprs == BINARY_CLASSAD_MARKER) {
+		return getClassAdBinary(sock, ad, options);
+	}
 
 	// at least numExprs are coming, but we may add
 	// my, target, and a couple extra right away
@@ -362,6 +388,138 @@ bool getClassAdEx( Stream *sock, classad::ClassAd& ad, int options)
 }
 
 
+// Reads the rest of an ad sent in the binary encoding, after its marker.
+// The values arrive as expression trees, so nothing is parsed unless it
+// had to be sent as text.  The ClassAd cache is keyed by the text of a
+// value, so values that go through it are unparsed, which is still much
+// cheaper than parsing them.
+static bool getClassAdBinary(Stream *sock, classad::ClassAd& ad, int options)
+{
+	bool use_cache = (options & GET_CLASSAD_NO_CACHE) == 0;
+
+	int cb = 0;
+	if ( ! sock->code(cb) || cb < 0) {
+		dprintf(D_FULLDEBUG, "getClassAd FAILED to get the size of a binary ClassAd\n");
+		return false;
+	}
+	// read in pieces, so that a bad size doesn't make us allocate
+	// far more than the peer actually sent.
+	std::string buf;
+	while (buf.size() < (size_t)cb) {
+		size_t off = buf.size();
+		size_t want = std::min((size_t)cb - off, (size_t)1024*1024);
+		buf.resize(off + want);
+		if (sock->get_bytes(&buf[off], (int)want) != (int)want) {
+			dprintf(D_FULLDEBUG, "getClassAd FAILED to get a binary ClassAd\n");
+			return false;
+		}
+	}
+
+	const char *ptr = buf.data();
+	const char *end = ptr + buf.size();
+	uint64_t format = 0, names_base = 0, num_attrs = 0, num_text = 0;
+	if ( ! classad::ClassAdBinaryParser::ParseVarint(ptr, end, format) || format != 1 ||
+		 ! classad::ClassAdBinaryParser::ParseVarint(ptr, end, names_base) ||
+		 ! classad::ClassAdBinaryParser::ParseVarint(ptr, end, num_attrs) || num_attrs > buf.size() ||
+		 ! classad::ClassAdBinaryParser::ParseVarint(ptr, end, num_text) || num_text > INT_MAX) {
+		dprintf(D_ALWAYS, "getClassAd FAILED to read the header of a binary ClassAd from %s\n",
+			sock->peer_description());
+		return false;
+	}
+
+	ClassAdWireNames *names = sock->classad_wire_names();
+	size_t known_names = names ? names->received.size() : 0;
+	if (names_base != known_names) {
+		dprintf(D_ALWAYS, "getClassAd FAILED: %s refers to %llu attribute names on this connection, but we know of %zu\n",
+			sock->peer_description(), (unsigned long long)names_base, known_names);
+		return false;
+	}
+
+	if ( ! (options & GET_CLASSAD_NO_CLEAR)) {
+		ad.rehash(num_attrs + num_text + 2 + 7);
+	}
+
+	classad::ClassAdBinaryParser parser;
+	classad::ClassAdUnParser unp;
+	unp.SetOldClassAd(true, true);
+	std::string attr, rhs;
+	for (uint64_t ii = 0; ii < num_attrs; ++ii) {
+		uint64_t ref = 0;
+		bool named = classad::ClassAdBinaryParser::ParseVarint(ptr, end, ref);
+		if (named && ref < 2) {
+			named = classad::ClassAdBinaryParser::ParseString(ptr, end, attr);
+			if (named && ref == 1) {
+				named = names && names->received.size() < BINARY_CLASSAD_MAX_NAMES;
+				if (named) { names->received.push_back(attr); }
+			}
+		} else if (named) {
+			named = names && ref - 2 < names->received.size();
+			if (named) { attr = names->received[ref - 2]; }
+		}
+		if ( ! named) {
+			dprintf(D_ALWAYS, "getClassAd FAILED to read an attribute name of a binary ClassAd from %s\n",
+				sock->peer_description());
+			return false;
+		}
+
+		classad::ExprTree *tree = parser.ParseExpression(ptr, end);
+		if ( ! tree) {
+			dprintf(D_ALWAYS, "getClassAd FAILED to read the value of %s in a binary ClassAd\n", attr.c_str());
+			return false;
+		}
+		bool inserted = false;
+		if (use_cache && classad::CachedExprEnvelope::cacheable(tree)) {
+			rhs.clear();
+			unp.Unparse(rhs, tree);
+			inserted = ad.InsertViaCache(attr, rhs, tree);
+		} else {
+			inserted = ad.Insert(attr, tree);
+		}
+		if ( ! inserted) {
+			dprintf(D_ALWAYS, "getClassAd FAILED to insert %s\n", attr.c_str());
+			return false;
+		}
+	}
+
+		// the attributes that were sent as text
+	for (uint64_t ii = 0; ii < num_text; ++ii) {
+		const char *strptr = NULL;
+		if ( ! sock->get_string_ptr(strptr, cb) || ! strptr) {
+			return false;
+		}
+		bool its_a_secret = false;
+		if (strcmp(strptr, SECRET_MARKER) == 0) {
+			its_a_secret = true;
+			if ( ! sock->get_secret(strptr, cb) || ! strptr) {
+				dprintf(D_FULLDEBUG, "getClassAd Failed to read encrypted ClassAd expression.\n");
+				return false;
+			}
+		}
+		if ( ! InsertLongFormAttrValue(ad, strptr, use_cache)) {
+			dprintf(D_ALWAYS, "getClassAd FAILED to insert%s %s\n", its_a_secret?" secret":"", strptr );
+			return false;
+		}
+	}
+
+	if (options & GET_CLASSAD_NO_TYPES) {
+		return true;
+	}
+
+		// get type info
+	const char *strptr = NULL;
+	if (!sock->get_string_ptr(strptr, cb)) {
+		dprintf(D_FULLDEBUG, "getClassAd FAILED to get MyType\n" );
+		return false;
+	}
+	if (!sock->get_string_ptr(strptr, cb)) {
+		dprintf(D_FULLDEBUG, "getClassAd FAILED to get TargetType\n" );
+		return false;
+	}
+
+	return true;
+}
+
+
 int getClassAdNonblocking( ReliSock *sock, classad::ClassAd& ad )
 {
 	int retval;
@@ -396,6 +554,9 @@ getClassAdNoTypes( Stream *sock, classad::ClassAd& ad )
 	if( !sock->code( numExprs ) ) {
  		return false;
 	}
+	if (numExprs == BINARY_CLASSAD_MARKER) {
+		return getClassAdBinary(sock, ad, GET_CLASSAD_NO_TYPES | GET_CLASSAD_NO_CACHE);
+	}
 
 		// pack exprs into classad
 	buffer = "[";
@@ -565,9 +726,151 @@ static int _putClassAdTrailingInfo(Stream *sock, const classad::ClassAd& /* ad *
 	return true;
 }
 
+static bool putClassAd_binary = false;
+static bool putClassAd_binary_names = true;
+
+void putClassAdSetWireFormat(bool binary, bool name_dictionary)
+{
+	putClassAd_binary = binary;
+	putClassAd_binary_names = name_dictionary;
+}
+
+// true if ads should go to the peer on this stream in the binary encoding.
+// Released 24.12.x peers report the same version as this one without being
+// able to read it, so we rely on the peer saying so in the security handshake.
+static bool _putClassAdBinaryWanted(Stream *sock)
+{
+	return putClassAd_binary && sock->peer_reads_binary_classads();
+}
+
+static void _putClassAdBinaryName(std::string &buf, const std::string &attr, ClassAdWireNames *names)
+{
+	if (names) {
+		auto it = names->sent.find(attr);
+		if (it != names->sent.end()) {
+			classad::ClassAdBinaryUnParser::UnparseVarint(buf, (uint64_t)it->second + 2);
+			return;
+		}
+		if (names->sent.size() < BINARY_CLASSAD_MAX_NAMES) {
+			names->sent.emplace(attr, (unsigned int)names->sent.size());
+			classad::ClassAdBinaryUnParser::UnparseVarint(buf, 1);
+			classad::ClassAdBinaryUnParser::UnparseString(buf, attr);
+			return;
+		}
+	}
+	classad::ClassAdBinaryUnParser::UnparseVarint(buf, 0);
+	classad::ClassAdBinaryUnParser::UnparseString(buf, attr);
+}
+
+// Sends an ad in the binary encoding described at the top of this file.
+// The attributes that are sent, and which of them are encrypted, are the
+// same as for the text form sent by the other _putClassAd functions.
+static int _putClassAdBinary( Stream *sock, const classad::ClassAd& ad, int options,
+	const classad::References *whitelist, const classad::References *encrypted_attrs)
+{
+	bool excludeTypes = (options & PUT_CLASSAD_NO_TYPES) == PUT_CLASSAD_NO_TYPES;
+	bool exclude_private = (options & PUT_CLASSAD_NO_PRIVATE) == PUT_CLASSAD_NO_PRIVATE;
+	bool send_server_time = (options & PUT_CLASSAD_SERVER_TIME) != 0;
+	bool crypto_is_noop = sock->prepare_crypto_for_secret_is_noop();
+
+	ClassAdWireNames *names = putClassAd_binary_names ? sock->classad_wire_names() : nullptr;
+	size_t names_base = names ? names->sent.size() : 0;
+
+	classad::ClassAdBinaryUnParser bunp;
+	classad::ClassAdUnParser unp;
+	unp.SetOldClassAd( true, true );
+
+	std::string body, value;
+	uint64_t num_attrs = 0;
+	std::vector<std::pair<bool, std::string>> text_attrs; // (encrypt it, "name = expr")
+
+	auto add_attr = [&](const std::string &attr, const classad::ExprTree *expr) {
+		if (send_server_time && strcasecmp(attr.c_str(), ATTR_SERVER_TIME) == MATCH) {
+			return;
+		}
+		bool encrypt_it = false;
+		if (exclude_private || ! crypto_is_noop) {
+			bool private_attr = ClassAdAttributeIsPrivateAny(attr) ||
+				(encrypted_attrs && (encrypted_attrs->find(attr) != encrypted_attrs->end()));
+			if (exclude_private && private_attr) {
+				return;
+			}
+			encrypt_it = private_attr && ! crypto_is_noop;
+		}
+		value.clear();
+		if ( ! encrypt_it && bunp.Unparse(value, expr)) {
+			_putClassAdBinaryName(body, attr, names);
+			body += value;
+			++num_attrs;
+		} else {
+			std::string line = attr;
+			line += " = ";
+			unp.Unparse(line, expr);
+			text_attrs.emplace_back(encrypt_it, line);
+		}
+	};
+
+	if (whitelist) {
+		for (const auto &attr : *whitelist) {
+			const classad::ExprTree *expr = ad.Lookup(attr);
+			if (expr) { add_attr(attr, expr); }
+		}
+	} else {
+		// chained attributes first, so that the ad's own attributes override them
+		const classad::ClassAd *chainedAd = ad.GetChainedParentAd();
+		if (chainedAd) {
+			for (const auto &[attr, expr] : *chainedAd) { add_attr(attr, expr); }
+		}
+		for (const auto &[attr, expr] : ad) { add_attr(attr, expr); }
+	}
+
+	if (send_server_time) {
+		// the current time from the sender's point of view, see _putClassAdTrailingInfo
+		classad::ExprTree *now = classad::Literal::MakeInteger(time(nullptr));
+		_putClassAdBinaryName(body, ATTR_SERVER_TIME, names);
+		bunp.Unparse(body, now);
+		delete now;
+		++num_attrs;
+	}
+
+	std::string buf;
+	buf.reserve(body.size() + 16);
+	classad::ClassAdBinaryUnParser::UnparseVarint(buf, 1);
+	classad::ClassAdBinaryUnParser::UnparseVarint(buf, names_base);
+	classad::ClassAdBinaryUnParser::UnparseVarint(buf, num_attrs);
+	classad::ClassAdBinaryUnParser::UnparseVarint(buf, text_attrs.size());
+	buf += body;
+	if (buf.size() > INT_MAX) {
+		return false;
+	}
+
+	int marker = BINARY_CLASSAD_MARKER;
+	int cb = (int)buf.size();
+	sock->encode( );
+	if ( ! sock->code(marker) || ! sock->code(cb) || sock->put_bytes(buf.data(), cb) != cb) {
+		return false;
+	}
+
+	for (const auto &[encrypt_it, line] : text_attrs) {
+		if (encrypt_it) {
+			if ( ! sock->put(SECRET_MARKER) || ! sock->put_secret(line.c_str())) {
+				return false;
+			}
+		} else if ( ! sock->put(line)) {
+			return false;
+		}
+	}
+
+	return _putClassAdTrailingInfo(sock, ad, false, excludeTypes);
+}
+
 int _putClassAd( Stream *sock, const classad::ClassAd& ad, int options,
 	const classad::References *encrypted_attrs)
 {
+	if (_putClassAdBinaryWanted(sock)) {
+		return _putClassAdBinary(sock, ad, options, nullptr, encrypted_attrs);
+	}
+
 	bool excludeTypes = (options & PUT_CLASSAD_NO_TYPES) == PUT_CLASSAD_NO_TYPES;
 	bool exclude_private = (options & PUT_CLASSAD_NO_PRIVATE) == PUT_CLASSAD_NO_PRIVATE;
 	auto *verinfo = sock->get_peer_version();
@@ -722,6 +1025,10 @@ int _putClassAd( Stream *sock, const classad::ClassAd& ad, int options,
 
 int _putClassAd( Stream *sock, const classad::ClassAd& ad, int options, const classad::References &whitelist, const classad::References *encrypted_attrs)
 {
+	if (_putClassAdBinaryWanted(sock)) {
+		return _putClassAdBinary(sock, ad, options, &whitelist, encrypted_attrs);
+	}
+
 	bool excludeTypes = (options & PUT_CLASSAD_NO_TYPES) == PUT_CLASSAD_NO_TYPES;
 	bool exclude_private = (options & PUT_CLASSAD_NO_PRIVATE) == PUT_CLASSAD_NO_PRIVATE;
 	auto *verinfo = sock->get_peer_version();
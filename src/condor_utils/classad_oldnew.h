@@ -78,6 +78,15 @@ int putClassAd (Stream *sock, const classad::ClassAd& ad, int options,
 #define PUT_CLASSAD_NO_EXPAND_WHITELIST 0x08 // use the whitelist argument as-is, (default is to expand internal references before using it)
 #define PUT_CLASSAD_SERVER_TIME         0x10 // add ServerTime attribute with current time value
 
+/** Choose how putClassAd sends ads to peers that can decode the binary
+ *  encoding.  getClassAd always accepts both encodings.
+ * @param binary send typed values and pre-tokenized expressions rather than
+ *  "name = expr" strings to peers of a version that can read them
+ * @param name_dictionary on TCP connections, refer to attribute names that
+ *  have already been sent on the connection by position
+ */
+void putClassAdSetWireFormat(bool binary, bool name_dictionary);
+
 // fetch the given attribute from the queryAd and convert it into a set of attributes
 //   the attribute should be a string value containing a comma and/or space separated list of attributes (like StringList)
 //   if allow_list is true, then attribute is permitted to be a classad list of strings each of which is an attribute of the projection.
@@ -67,6 +67,9 @@ void ClassAdReconfig()
 
 	classad::ClassAdSetExpressionCaching( param_boolean( "ENABLE_CLASSAD_CACHING", false ) );
 
+	putClassAdSetWireFormat( param_boolean( "ENABLE_BINARY_CLASSAD_WIRE_FORMAT", false ),
+		param_boolean( "BINARY_CLASSAD_WIRE_NAME_DICTIONARY", true ) );
+
 	char *new_libs = param( "CLASSAD_USER_LIBS" );
 	if ( new_libs ) {
 		for (const auto& new_lib: StringTokenIterator(new_libs)) {
@@ -563,6 +563,75 @@ int GetAttrRefsOfScope(classad::ExprTree * expr, classad::References &attrs, con
 	 return walk_attr_refs(expr, AccumAttrsOfScopes, &tmp);
 }
 
+// returns true if the value of the expression may change with nothing but the passage of time,
+// that is, if it calls time(), random() or eval(), uses the current time by calling absTime() or
+// splitTime() without arguments, or refers to CurrentTime. attributes that it refers to are not followed.
+bool ExprTreeMayDependOnTime(const classad::ExprTree * tree)
+{
+	if ( ! tree) return false;
+	switch (tree->GetKind()) {
+		case classad::ExprTree::ATTRREF_NODE: {
+			classad::ExprTree *expr;
+			std::string ref;
+			bool absolute;
+			((const classad::AttributeReference*)tree)->GetComponents(expr, ref, absolute);
+			if ( ! expr && strcasecmp(ref.c_str(), ATTR_CURRENT_TIME) == MATCH) {
+				return true;
+			}
+			return ExprTreeMayDependOnTime(expr);
+		}
+
+		case classad::ExprTree::OP_NODE: {
+			classad::Operation::OpKind	op;
+			classad::ExprTree *t1, *t2, *t3;
+			((const classad::Operation*)tree)->GetComponents( op, t1, t2, t3 );
+			return ExprTreeMayDependOnTime(t1) || ExprTreeMayDependOnTime(t2) || ExprTreeMayDependOnTime(t3);
+		}
+
+		case classad::ExprTree::FN_CALL_NODE: {
+			std::string fnName;
+			std::vector<classad::ExprTree*> args;
+			((const classad::FunctionCall*)tree)->GetComponents( fnName, args );
+			const char * fn = fnName.c_str();
+			if (strcasecmp(fn, "time") == MATCH || strcasecmp(fn, "random") == MATCH || strcasecmp(fn, "eval") == MATCH) {
+				return true;
+			}
+			if (args.empty() && (strcasecmp(fn, "absTime") == MATCH || strcasecmp(fn, "splitTime") == MATCH)) {
+				return true;
+			}
+			for (auto * arg : args) {
+				if (ExprTreeMayDependOnTime(arg)) return true;
+			}
+		}
+		break;
+
+		case classad::ExprTree::CLASSAD_NODE: {
+			std::vector< std::pair<std::string, classad::ExprTree*> > attrs;
+			((const classad::ClassAd*)tree)->GetComponents(attrs);
+			for (auto & it : attrs) {
+				if (ExprTreeMayDependOnTime(it.second)) return true;
+			}
+		}
+		break;
+
+		case classad::ExprTree::EXPR_LIST_NODE: {
+			std::vector<classad::ExprTree*> exprs;
+			((const classad::ExprList*)tree)->GetComponents( exprs );
+			for (auto * expr : exprs) {
+				if (ExprTreeMayDependOnTime(expr)) return true;
+			}
+		}
+		break;
+
+		case classad::ExprTree::EXPR_ENVELOPE:
+			return ExprTreeMayDependOnTime(SkipExprEnvelope(tree));
+
+		default:
+			break;
+	}
+	return false;
+}
+
 
 // edit the given expr changing attribute references as the mapping indicates
 int RewriteAttrRefs(classad::ExprTree * tree, const NOCASE_STRING_MAP & mapping)
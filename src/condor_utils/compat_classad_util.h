@@ -77,6 +77,10 @@ int RewriteAttrRefs(classad::ExprTree * expr, const NOCASE_STRING_MAP & mapping)
 // and the expression contains MY.Foo, the Foo is added to attrs.
 int GetAttrRefsOfScope(classad::ExprTree * expr, classad::References &attrs, const std::string &scope);
 
+// returns true if the expression calls time() or another function whose result can change
+// from one evaluation to the next, or refers to CurrentTime. attribute references are not followed.
+bool ExprTreeMayDependOnTime(const classad::ExprTree * tree);
+
 const classad::ExprTree * SkipExprEnvelope(const classad::ExprTree * tree);
 inline classad::ExprTree * SkipExprEnvelope(classad::ExprTree * tree) {
 	return const_cast<classad::ExprTree *>(SkipExprEnvelope(const_cast<const classad::ExprTree *>(tree)));
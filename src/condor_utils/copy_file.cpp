@@ -20,6 +20,7 @@
 
 #include "condor_common.h"
 #include "condor_debug.h"
+#include "condor_config.h"
 
 int copy_file(const char *old_filename, const char *new_filename);
 int hardlink_or_copy_file(const char *old_filename, const char *new_filename);
@@ -76,6 +77,33 @@ copy_file(const char *old_filename, const char *new_filename)
 
 	new_file_created = 1;
 
+#if defined(LINUX) && defined(__GLIBC__) && (__GLIBC__ > 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ >= 27))
+		// Let the kernel copy the data (or share the blocks, on file
+		// systems that can), so it never passes through our buffer.
+		// If it can't copy between these two files, copy_file_range()
+		// fails before copying anything, and we do it the old way.
+	if ( param_boolean( "ENABLE_ZERO_COPY_FILE_TRANSFER", true ) ) {
+		off_t copied = 0;
+		ssize_t nc;
+		while ( (nc = copy_file_range( in_fd, NULL, out_fd, NULL, 1024*1024*1024, 0 )) > 0 ) {
+			copied += nc;
+		}
+		if ( nc < 0 ) {
+			if ( copied > 0 || (errno != EXDEV && errno != EINVAL && errno != ENOSYS &&
+			                    errno != EOPNOTSUPP && errno != EBADF) ) {
+				dprintf( D_ALWAYS, "copy_file_range() from %s to %s failed with errno %d\n",
+						 old_filename, new_filename, errno );
+				goto copy_file_err;
+			}
+		} else {
+			close( in_fd );
+			close( out_fd );
+			umask( old_umask );
+			return 0;
+		}
+	}
+#endif
+
 	errno = 0;
 	rc = read( in_fd, buff, sizeof(buff) );
 	while ( rc > 0 ) {
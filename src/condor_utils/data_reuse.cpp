@@ -203,12 +203,13 @@ DataReuseDirectory::ReserveSpace(uint64_t size, uint32_t time, const std::string
 		return false;
 	}
 
-	if ((m_reserved_space + size > m_allocated_space) && !ClearSpace(size, sentry, err))
+	if ((m_reserved_space + m_stored_space + size > m_allocated_space) && !ClearSpace(size, sentry, err))
 	{
 		err.pushf("DataReuse", 1, "Unable to allocate space; %llu bytes allocated, "
-			"%llu bytes reserved, %llu additional bytes requested",
+			"%llu bytes reserved, %llu bytes stored, %llu additional bytes requested",
 			static_cast<unsigned long long>(m_allocated_space),
 			static_cast<unsigned long long>(m_reserved_space),
+			static_cast<unsigned long long>(m_stored_space),
 			static_cast<unsigned long long>(size));
 		return false;
 	}
@@ -230,41 +231,47 @@ DataReuseDirectory::ReserveSpace(uint64_t size, uint32_t time, const std::string
 }
 
 
+// Evict the least recently used files until the requested space fits.  The
+// removals are applied to our state the same way as everyone else's: by
+// reading them back from the log.
 bool
 DataReuseDirectory::ClearSpace(uint64_t size, LogSentry &sentry, CondorError &err)
 {
 	if (!sentry.acquired()) {return false;}
 
-	if (m_reserved_space + size <= m_allocated_space) {
+	uint64_t in_use = m_reserved_space + m_stored_space;
+	if (in_use + size <= m_allocated_space) {
 		return true;
 	}
-	auto it = m_contents.begin();
-	while (it != m_contents.end()) {
-		auto &file_entry = **it;
-		if (-1 == unlink(file_entry.fname().c_str())) {
+		// m_contents is sorted by last use, oldest first.
+	for (const auto &entry : m_contents) {
+		const auto &file_entry = *entry;
+		if (-1 == unlink(file_entry.fname().c_str()) && errno != ENOENT) {
 			err.pushf("DataReuse", 4, "Failed to unlink cache entry: %s", strerror(errno));
 			return false;
 		}
-		if (GetExtraDebug()) dprintf(D_FULLDEBUG, "Decreasing reserved space by %llu",
-			static_cast<unsigned long long>(file_entry.size()));
-		m_reserved_space -= file_entry.size();
+		if (GetExtraDebug()) dprintf(D_FULLDEBUG, "Evicting %llu bytes with checksum %s\n",
+			static_cast<unsigned long long>(file_entry.size()), file_entry.checksum().c_str());
 
 		FileRemovedEvent event;
 		event.setSize(file_entry.size());
 		event.setChecksumType(file_entry.checksum_type());
 		event.setChecksum(file_entry.checksum());
 		event.setTag(file_entry.tag());
-		it = m_contents.erase(it);
 		if (!m_log.writeEvent(&event)) {
 			err.push("DataReuse", 5, "Faild to write file deletion");
 			return false;
 		}
 
-		if (m_reserved_space + size <= m_allocated_space) {
-			return true;
+		in_use -= file_entry.size();
+		if (in_use + size <= m_allocated_space) {
+			break;
 		}
 	}
-	return false;
+	if (!UpdateState(sentry, err)) {
+		return false;
+	}
+	return m_reserved_space + m_stored_space + size <= m_allocated_space;
 }
 
 
@@ -348,6 +355,8 @@ DataReuseDirectory::HandleEvent(ULogEvent &event, CondorError & err)
 					resEvent.getReservedSpace()))
 			);
 			m_space_reservations.insert(std::move(value));
+				// A new reservation is made to cache a file that wasn't found.
+			m_misses++;
 			if (GetExtraDebug()) dprintf(D_FULLDEBUG, "Incrementing reserved space by %llu to %llu for UUID %s.\n",
 				static_cast<unsigned long long>(resEvent.getReservedSpace()),
 				static_cast<unsigned long long>(m_reserved_space + resEvent.getReservedSpace()),
@@ -465,6 +474,7 @@ DataReuseDirectory::HandleEvent(ULogEvent &event, CondorError & err)
 			if (GetExtraDebug()) dprintf(D_FULLDEBUG, "Updated last use for file with checksum %s(%s) to %lu\n",
 				usedEvent.getChecksum().c_str(), usedEvent.getChecksumType().c_str(), usedEvent.GetEventclock());
 			(*iter)->update_last_use(event.GetEventclock());
+			m_hits++;
 
 			auto util_iter = m_space_utilization.insert({(*iter)->tag(), SpaceUtilization()});
 			util_iter.first->second.incUsed((*iter)->size());
@@ -726,9 +736,9 @@ DataReuseDirectory::ReleaseSpace(const std::string &uuid, CondorError &err)
 		return false;
 	}
 
+		// The reservation is dropped from our state when we read this back.
 	ReleaseSpaceEvent event;
 	event.setUUID(uuid);
-	m_space_reservations.erase(iter);
 	if (GetExtraDebug()) dprintf(D_FULLDEBUG, "Releasing space reservation %s\n", uuid.c_str());
 	if (!m_log.writeEvent(&event)) {
 		err.pushf("DataReuse", 10, "Failed to write out space reservation release.");
@@ -996,6 +1006,8 @@ DataReuseDirectory::Publish(classad::ClassAd &ad)
 		static_cast<double>(m_reserved_space)/1'000'000.0);
 	retval &= ad.InsertAttr("DataReuseUsedMB",
 		static_cast<double>(m_stored_space)/1'000'000.0);
+	retval &= ad.InsertAttr("DataReuseHits", static_cast<long long>(m_hits));
+	retval &= ad.InsertAttr("DataReuseMisses", static_cast<long long>(m_misses));
 
 	std::unordered_map<std::string, SpaceUtilization> per_user_lifetime;
 	SpaceUtilization global_util;
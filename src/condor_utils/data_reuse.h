@@ -174,6 +174,11 @@ private:
 	uint64_t m_stored_space{0};
 	uint64_t m_allocated_space{0};
 
+		// Files found in the directory, and files that had to be fetched
+		// and then cached, since the state log was started.
+	uint64_t m_hits{0};
+	uint64_t m_misses{0};
+
 	std::string m_dirpath;
 	std::string m_logname;
 
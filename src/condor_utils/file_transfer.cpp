@@ -49,15 +49,22 @@
 #include "condor_sys.h"
 #include "limit_directory_access.h"
 #include "checksum.h"
+#include "data_reuse.h"
 #include "shortfile.h"
 #include "fcloser.h"
 
 #include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
 #include <numeric>
 #include <string>
 #include <unordered_set>
 #include <unordered_map>
 #include <filesystem>
+#include <thread>
 
 
 // not sure why, but enabling this leads to crashes in some tests (which are linux only...)
@@ -74,6 +81,8 @@ const char * const StderrRemapName = "_condor_stderr";
 // 4 - do an x509 credential delegation (using the socket default)
 // 5 - send a URL and have the download side fetch it
 // 6 - send a request to make a directory
+// 10 - send a bundle of small files in a single message
+// 11 - send a large file over several extra connections (socket default off)
 // 999 - send a classad telling what to do.
 //
 // 999 subcommands (999 is followed by a filename and then a ClassAd):
@@ -94,6 +103,8 @@ enum class TransferCommand {
 	XferX509 = 4,
 	DownloadUrl = 5,
 	Mkdir = 6,
+	XferBundle = 10,
+	XferParallel = 11,
 	Other = 999
 };
 
@@ -296,6 +307,513 @@ const int GO_AHEAD_UNDEFINED = 0;
 
 const int GO_AHEAD_ALWAYS = 2;  // send all files without asking again
 
+// Once both sides have given the go-ahead for all files, the upload side
+// may gather small plain files into a bundle.  A bundle is command 10
+// followed by a single message:
+//    int count
+//    count times: string filename, mode, filesize, the contents
+//    int count
+// where mode is NULL_FILE_PERMISSIONS unless permissions are being
+// transferred.  The download side queues the files and then writes each
+// of them as if it had arrived with command 1, so errors are reported
+// per file in the final ack just as they are for files sent one at a time.
+struct BundledFile {
+	std::string name;
+	condor_mode_t mode{NULL_FILE_PERMISSIONS};
+	std::string data;
+};
+
+// no bundled file may be larger than this, whatever the configuration
+const filesize_t MAX_BUNDLED_FILE_SIZE = 16 * 1024 * 1024;
+
+// Read a file that is small enough to bundle.  Returns false if the file
+// can't be read or is too big, in which case the caller should send it on
+// its own so that any error is reported the usual way.
+static bool
+read_bundled_file(const std::string & fullname, bool with_permissions, filesize_t max_size, BundledFile & file)
+{
+	if( !allow_shadow_access(fullname.c_str()) ) {
+		return false;
+	}
+	int fd = safe_open_wrapper_follow(fullname.c_str(), O_RDONLY | O_LARGEFILE | _O_BINARY, 0);
+	if( fd < 0 ) {
+		return false;
+	}
+	struct stat st = {};
+	bool ok = fstat(fd, &st) == 0 && !(st.st_mode & S_IFDIR) && st.st_size <= max_size;
+	if( ok ) {
+		file.data.resize(st.st_size);
+		ok = full_read(fd, file.data.data(), file.data.size()) == (ssize_t)file.data.size();
+	}
+	close(fd);
+
+	file.mode = NULL_FILE_PERMISSIONS;
+#ifndef WIN32
+	if( with_permissions ) {
+		file.mode = (condor_mode_t)st.st_mode;
+	}
+#else
+	(void)with_permissions;
+#endif
+	return ok;
+}
+
+static bool
+send_file_bundle(ReliSock * s, bool socket_default_crypto, std::vector<BundledFile> & bundle)
+{
+	int count = (int)bundle.size();
+	dprintf(D_FULLDEBUG, "DoUpload: sending a bundle of %d files\n", count);
+
+	s->encode();
+	if( !s->snd_int(static_cast<int>(TransferCommand::XferBundle), false) || !s->end_of_message() ) {
+		return false;
+	}
+	if( !s->set_crypto_mode(socket_default_crypto) ) {
+		dprintf(D_ERROR, "DoUpload: failed to set default crypto on file bundle\n");
+		return false;
+	}
+	if( !s->code(count) ) {
+		return false;
+	}
+	for( auto & file : bundle ) {
+		filesize_t size = file.data.size();
+		if( !s->code(file.name) || !s->code(file.mode) || !s->code(size) ) {
+			return false;
+		}
+		if( size > 0 && s->put_bytes(file.data.data(), (int)size) != (int)size ) {
+			return false;
+		}
+	}
+	if( !s->code(count) || !s->end_of_message() ) {
+		return false;
+	}
+	bundle.clear();
+	return true;
+}
+
+static bool
+receive_file_bundle(ReliSock * s, std::deque<BundledFile> & bundle)
+{
+	int count = -1;
+	int trailer = -1;
+	if( !s->code(count) || count < 0 ) {
+		return false;
+	}
+	for( int i = 0; i < count; ++i ) {
+		BundledFile file;
+		filesize_t size = -1;
+		if( !s->code(file.name) || !s->code(file.mode) || !s->code(size) ) {
+			return false;
+		}
+		if( size < 0 || size > MAX_BUNDLED_FILE_SIZE ) {
+			dprintf(D_ALWAYS, "DoDownload: bundled file %s has bad size %lld\n",
+					file.name.c_str(), (long long)size);
+			return false;
+		}
+		file.data.resize(size);
+		if( size > 0 && s->get_bytes(file.data.data(), (int)size) != (int)size ) {
+			return false;
+		}
+		bundle.emplace_back(std::move(file));
+	}
+	if( !s->code(trailer) || trailer != count || !s->end_of_message() ) {
+		dprintf(D_ALWAYS, "DoDownload: file bundle of %d files was not terminated properly\n", count);
+		return false;
+	}
+	dprintf(D_FULLDEBUG, "DoDownload: received a bundle of %d files\n", count);
+	return true;
+}
+
+// Write out a file that arrived in a bundle.  Returns the same codes as
+// ReliSock::get_file(), with errno set for the open and write failures.
+static int
+write_bundled_file(const std::string & fullname, const BundledFile & file, filesize_t max_bytes, filesize_t & bytes)
+{
+	bytes = file.data.size();
+	if( max_bytes >= 0 && bytes > max_bytes ) {
+		return GET_FILE_MAX_BYTES_EXCEEDED;
+	}
+	if( fullname == NULL_FILE ) {
+		return 0;
+	}
+	if( !allow_shadow_access(fullname.c_str()) ) {
+		errno = EACCES;
+		return GET_FILE_OPEN_FAILED;
+	}
+
+	int fd = safe_open_wrapper_follow(fullname.c_str(), O_WRONLY | O_CREAT | O_TRUNC | _O_BINARY | O_LARGEFILE, 0600);
+	if( fd < 0 ) {
+		int the_error = errno;
+		dprintf(D_ALWAYS, "DoDownload: failed to open bundled file %s, errno = %d: %s.\n",
+				fullname.c_str(), the_error, strerror(the_error));
+		errno = the_error;
+		return GET_FILE_OPEN_FAILED;
+	}
+	bool ok = full_write(fd, file.data.data(), file.data.size()) == (ssize_t)file.data.size();
+	int the_error = errno;
+	if( close(fd) != 0 && ok ) {
+		ok = false;
+		the_error = errno;
+	}
+#ifndef WIN32
+	if( ok && file.mode != NULL_FILE_PERMISSIONS && chmod(fullname.c_str(), (mode_t)file.mode) < 0 ) {
+		ok = false;
+		the_error = errno;
+	}
+#endif
+	if( !ok ) {
+		dprintf(D_ALWAYS, "DoDownload: failed to write bundled file %s, errno = %d: %s.\n",
+				fullname.c_str(), the_error, strerror(the_error));
+		errno = the_error;
+		return GET_FILE_WRITE_FAILED;
+	}
+	return 0;
+}
+
+// A large plain file may be sent over several extra connections at once,
+// each carrying one contiguous piece of the file.  This is command 11,
+// which is followed by the filename and the go-ahead handshake just like
+// command 1, and then:
+//    upload side:   mode, filesize, max streams
+//    if max streams > 0, then
+//       download side: sinful of a listen socket (empty to decline), cookie
+//       upload side:   number of streams it connected
+//    if no streams were connected, the file is sent with put_file() on the
+//    main connection; otherwise each stream carries the cookie and its
+//    index, and then its piece with put_file(), and when they are all
+//    done the download side sends an int status.
+// The extra connections are not authenticated or encrypted; the cookie
+// only ties them to this transfer.  So we only do this when the main
+// connection isn't encrypted either.
+
+// no more extra connections than this, whatever the configuration
+const int MAX_PARALLEL_STREAMS = 16;
+
+// how long to wait for an extra connection to be made or accepted
+const int PARALLEL_STREAM_CONNECT_TIMEOUT = 20;
+
+struct ParallelStream {
+	std::unique_ptr<ReliSock> sock;
+	int fd{-1};
+	filesize_t offset{0};
+	filesize_t length{0};
+	filesize_t bytes{0};
+	int rc{-1};
+	int error{0};
+};
+
+// the piece of the file that the given stream carries
+static void
+parallel_stream_range(filesize_t filesize, int nstreams, int index, filesize_t & offset, filesize_t & length)
+{
+	filesize_t piece = (filesize + nstreams - 1) / nstreams;
+	offset = MIN(filesize, piece * index);
+	length = MIN(piece, filesize - offset);
+}
+
+// Move all of the pieces, one thread per stream.  The threads only touch
+// their own socket and file descriptor; meanwhile this thread keeps the
+// main connection's transfer looking alive.
+static void
+run_parallel_streams(ReliSock * s, std::vector<ParallelStream> & streams, bool upload)
+{
+	std::mutex mtx;
+	std::condition_variable done_cv;
+	size_t done = 0;
+
+		// put_file() and get_file() dprintf from the stream threads
+	dprintf_make_thread_safe();
+
+	std::vector<std::thread> threads;
+	for( auto & st : streams ) {
+		threads.emplace_back([&st, &mtx, &done_cv, &done, upload]() {
+			if( upload ) {
+				st.rc = st.sock->put_file_range(&st.bytes, st.fd, st.offset, st.length, nullptr);
+			} else {
+				st.rc = st.sock->get_file(&st.bytes, st.fd, false, false, st.length, nullptr);
+			}
+			st.error = errno;
+			if( st.rc == 0 && (st.bytes != st.length || !st.sock->end_of_message()) ) {
+				st.rc = -1;
+			}
+			std::lock_guard<std::mutex> guard(mtx);
+			++done;
+			done_cv.notify_one();
+		});
+	}
+
+	std::unique_lock<std::mutex> lock(mtx);
+	while( done < streams.size() ) {
+		done_cv.wait_for(lock, std::chrono::seconds(1));
+		s->XferPingAliveTime();
+	}
+	lock.unlock();
+	for( auto & t : threads ) {
+		t.join();
+	}
+}
+
+static void
+close_parallel_streams(std::vector<ParallelStream> & streams)
+{
+	for( auto & st : streams ) {
+		if( st.fd >= 0 ) {
+			close(st.fd);
+			st.fd = -1;
+		}
+		if( st.sock ) {
+			st.sock->close();
+		}
+	}
+}
+
+// Send a file with command 11.  Returns the same codes as
+// ReliSock::put_file().  If no extra connection could be made to the
+// peer, connected is set to false, and the caller shouldn't bother trying
+// again for the rest of this transfer.
+static int
+send_file_parallel(ReliSock * s, const std::string & fullname, bool with_permissions, int max_streams,
+                   filesize_t max_bytes, DCTransferQueue & xfer_queue, filesize_t & bytes, bool & connected)
+{
+	bytes = 0;
+	connected = true;
+
+	condor_mode_t mode = NULL_FILE_PERMISSIONS;
+	filesize_t filesize = 0;
+	struct stat st = {};
+	if( !allow_shadow_access(fullname.c_str()) || stat(fullname.c_str(), &st) != 0 ) {
+		max_streams = 0;
+	} else {
+		filesize = st.st_size;
+#ifndef WIN32
+		if( with_permissions ) {
+			mode = (condor_mode_t)st.st_mode;
+		}
+#endif
+	}
+	if( max_bytes >= 0 && filesize > max_bytes ) {
+			// let put_file() stop at the limit the usual way
+		max_streams = 0;
+	}
+
+	s->encode();
+	if( !s->code(mode) || !s->code(filesize) || !s->code(max_streams) || !s->end_of_message() ) {
+		return -1;
+	}
+
+	std::vector<ParallelStream> streams;
+	if( max_streams > 0 ) {
+		std::string sinful, cookie;
+		s->decode();
+		if( !s->code(sinful) || !s->code(cookie) || !s->end_of_message() ) {
+			return -1;
+		}
+
+		for( int i = 0; i < max_streams && !sinful.empty(); ++i ) {
+			ParallelStream stream;
+			stream.sock = std::make_unique<ReliSock>();
+			stream.sock->timeout(PARALLEL_STREAM_CONNECT_TIMEOUT);
+			if( !stream.sock->connect(sinful.c_str(), 0, false) ) {
+				dprintf(D_ALWAYS, "DoUpload: failed to make extra connection %d to %s\n", i, sinful.c_str());
+				connected = !streams.empty();
+				break;
+			}
+			stream.sock->timeout(s->get_timeout_raw());
+			streams.emplace_back(std::move(stream));
+		}
+
+		int nstreams = (int)streams.size();
+		for( int i = 0; i < nstreams; ++i ) {
+			ParallelStream & stream = streams[i];
+			parallel_stream_range(filesize, nstreams, i, stream.offset, stream.length);
+			stream.fd = safe_open_wrapper_follow(fullname.c_str(), O_RDONLY | O_LARGEFILE | _O_BINARY, 0);
+			if( stream.fd < 0 ) {
+					// send the file the usual way, which reports the error
+				close_parallel_streams(streams);
+				streams.clear();
+				break;
+			}
+			stream.sock->encode();
+			if( !stream.sock->code(cookie) || !stream.sock->code(i) || !stream.sock->end_of_message() ) {
+				dprintf(D_ALWAYS, "DoUpload: failed to start extra connection %d\n", i);
+			}
+		}
+
+		nstreams = (int)streams.size();
+		s->encode();
+		if( !s->code(nstreams) || !s->end_of_message() ) {
+			close_parallel_streams(streams);
+			return -1;
+		}
+	}
+
+	if( streams.empty() ) {
+		return s->put_file(&bytes, fullname.c_str(), 0, max_bytes, &xfer_queue);
+	}
+
+	dprintf(D_FULLDEBUG, "DoUpload: sending %lld bytes of %s over %d connections\n",
+			(long long)filesize, fullname.c_str(), (int)streams.size());
+	run_parallel_streams(s, streams, true);
+	close_parallel_streams(streams);
+
+	int rc = 0;
+	for( auto & stream : streams ) {
+		bytes += stream.bytes;
+		if( stream.rc < 0 ) {
+			rc = -1;
+		}
+	}
+	xfer_queue.AddBytesSent(bytes);
+
+	int status = -1;
+	s->decode();
+	if( !s->code(status) || !s->end_of_message() || status != 0 ) {
+		rc = -1;
+	}
+	s->encode();
+	return rc;
+}
+
+// Receive a file sent with command 11.  Returns the same codes as
+// ReliSock::get_file().
+static int
+receive_file_parallel(ReliSock * s, const std::string & fullname, filesize_t max_bytes,
+                      DCTransferQueue & xfer_queue, filesize_t & bytes)
+{
+	bytes = 0;
+
+	condor_mode_t mode = NULL_FILE_PERMISSIONS;
+	filesize_t filesize = -1;
+	int max_streams = 0;
+	if( !s->code(mode) || !s->code(filesize) || !s->code(max_streams) || !s->end_of_message() ) {
+		return -1;
+	}
+
+	std::vector<ParallelStream> streams;
+	bool ok = true;
+	if( max_streams > 0 ) {
+			// Decline unless the file can be written, in which case
+			// get_file() below reports the problem the usual way.
+		ReliSock listener;
+		std::string sinful, cookie;
+		if( filesize > 0 && max_streams <= MAX_PARALLEL_STREAMS && fullname != NULL_FILE &&
+			(max_bytes < 0 || filesize <= max_bytes) && allow_shadow_access(fullname.c_str()) )
+		{
+			int fd = safe_open_wrapper_follow(fullname.c_str(), O_WRONLY | O_CREAT | O_TRUNC | _O_BINARY | O_LARGEFILE, 0600);
+			if( fd >= 0 && close(fd) == 0 &&
+				listener.bind(s->my_addr().get_protocol(), false, 0, false) && listener.listen() )
+			{
+				const char * addr = listener.get_sinful_public();
+				sinful = addr ? addr : "";
+				randomlyGenerateShortLivedPassword(cookie, 32);
+			}
+		}
+
+		int nstreams = 0;
+		s->encode();
+		if( !s->code(sinful) || !s->code(cookie) || !s->end_of_message() ) {
+			return -1;
+		}
+		s->decode();
+		if( !s->code(nstreams) || !s->end_of_message() ) {
+			return -1;
+		}
+		if( nstreams < 0 || nstreams > max_streams || (nstreams > 0 && sinful.empty()) ) {
+			dprintf(D_ALWAYS, "DoDownload: peer made a bad number of extra connections (%d)\n", nstreams);
+			return -1;
+		}
+
+			// Anyone can connect to the listener, so a connection without
+			// the cookie is dropped, and we keep waiting for the peer's.
+		time_t deadline = time(nullptr) + PARALLEL_STREAM_CONNECT_TIMEOUT;
+		streams.resize(nstreams);
+		for( int i = 0; i < nstreams && ok; ) {
+			int remaining = (int)(deadline - time(nullptr));
+			std::unique_ptr<ReliSock> sock;
+			if( remaining > 0 ) {
+				listener.timeout(remaining);
+				sock.reset(listener.accept());
+			}
+			if( !sock ) {
+				dprintf(D_ALWAYS, "DoDownload: failed to accept extra connection %d of %d\n", i, nstreams);
+				ok = false;
+				break;
+			}
+			std::string their_cookie;
+			int index = -1;
+			sock->timeout(remaining);
+			sock->decode();
+			if( !sock->code(their_cookie) || !sock->code(index) || !sock->end_of_message() ||
+				their_cookie != cookie || index < 0 || index >= nstreams || streams[index].sock )
+			{
+				dprintf(D_ALWAYS, "DoDownload: rejecting extra connection from %s\n", sock->peer_description());
+				continue;
+			}
+			++i;
+
+				// each stream gets a descriptor, and so a file offset, of its own
+			ParallelStream & stream = streams[index];
+			parallel_stream_range(filesize, nstreams, index, stream.offset, stream.length);
+			stream.fd = safe_open_wrapper_follow(fullname.c_str(), O_WRONLY | _O_BINARY | O_LARGEFILE, 0600);
+			if( stream.fd < 0 || lseek(stream.fd, stream.offset, SEEK_SET) != (off_t)stream.offset ) {
+				dprintf(D_ALWAYS, "DoDownload: failed to open %s for extra connection %d: %s\n",
+						fullname.c_str(), index, strerror(errno));
+				ok = false;
+			}
+			stream.sock = std::move(sock);
+			stream.sock->timeout(s->get_timeout_raw());
+		}
+		listener.close();
+	}
+
+	int rc = -1;
+	if( streams.empty() ) {
+		rc = s->get_file(&bytes, fullname.c_str(), false, false, max_bytes, &xfer_queue);
+	} else if( ok ) {
+		dprintf(D_FULLDEBUG, "DoDownload: receiving %lld bytes of %s over %d connections\n",
+				(long long)filesize, fullname.c_str(), (int)streams.size());
+		run_parallel_streams(s, streams, false);
+
+		rc = 0;
+		for( auto & stream : streams ) {
+			bytes += stream.bytes;
+			if( stream.rc == GET_FILE_WRITE_FAILED && rc == 0 ) {
+					// the rest of that piece was read and thrown away
+				rc = GET_FILE_WRITE_FAILED;
+				errno = stream.error;
+			} else if( stream.rc < 0 && stream.rc != GET_FILE_WRITE_FAILED ) {
+				rc = -1;
+			}
+		}
+		xfer_queue.AddBytesReceived(bytes);
+	}
+	int the_error = errno;
+
+	if( !streams.empty() ) {
+		close_parallel_streams(streams);
+
+		int status = (rc == -1) ? -1 : 0;
+		s->encode();
+		if( !s->code(status) || !s->end_of_message() ) {
+			rc = -1;
+		}
+		s->decode();
+		if( rc == -1 ) {
+			unlink(fullname.c_str());
+		}
+	}
+
+#ifndef WIN32
+	if( rc == 0 && mode != NULL_FILE_PERMISSIONS && fullname != NULL_FILE &&
+		chmod(fullname.c_str(), (mode_t)mode) < 0 ) {
+		the_error = errno;
+		rc = GET_FILE_WRITE_FAILED;
+	}
+#endif
+	errno = the_error;
+	return rc;
+}
+
 
 struct upload_info {
 	FileTransfer *myobj;
@@ -2323,6 +2841,24 @@ shadow_safe_mkdir( const std::string & dir, mode_t mode, priv_state priv ) {
 	return shadow_safe_mkdir_impl( path.root_path(), path.relative_path(), mode );
 }
 
+void
+FileTransfer::cacheReusableFile(const std::string &fullname, const std::string &checksum, filesize_t size)
+{
+	std::string tag = ftcb.hasUser() ? ftcb.getUser() : "";
+	std::string uuid;
+	CondorError err;
+	if (!m_reuse_dir->ReserveSpace(size, 3600, tag, uuid, err)) {
+		dprintf(D_FULLDEBUG, "DoDownload: Not keeping %s for reuse: %s\n", fullname.c_str(), err.getFullText().c_str());
+		return;
+	}
+	if (m_reuse_dir->CacheFile(fullname, checksum, "sha256", uuid, err)) {
+		dprintf(D_FULLDEBUG, "DoDownload: Kept %s for reuse.\n", fullname.c_str());
+	} else {
+		dprintf(D_FULLDEBUG, "DoDownload: Failed to keep %s for reuse: %s\n", fullname.c_str(), err.getFullText().c_str());
+	}
+	m_reuse_dir->ReleaseSpace(uuid, err);
+}
+
 /*
   Define a macro to restore our priv state (if needed) and return.  We
   do this so we don't leak priv states in functions where we need to
@@ -2372,6 +2908,7 @@ FileTransfer::DoDownload(ReliSock *s)
 
 	bool I_go_ahead_always = false;
 	bool peer_goes_ahead_always = false;
+	std::deque<BundledFile> file_bundle;
 	DCTransferQueue xfer_queue(m_xfer_queue_contact_info);
 	std::function<void(void)> f {[this] { this->ReceiveAliveMessage(); }};
 	s->SetXferAliveCallback(f);
@@ -2518,25 +3055,39 @@ FileTransfer::DoDownload(ReliSock *s)
 	bool file_transfer_plugin_timed_out   = false;
 	bool file_transfer_plugin_exec_failed = false;
 
+	// Files the peer offered for reuse that weren't in the data reuse
+	// directory, by name, with their checksum and size; once we have
+	// them, we add them to the directory for the next job.
+	std::unordered_map<std::string, std::pair<std::string, long long>> reuse_misses;
+
 	// Start the main download loop. Read reply codes + filenames off a
 	// socket wire, s, then handle downloads according to the reply code.
 	for( int rc = 0; ; ) {
 		bool log_this_transfer = true;
 
 		TransferCommand xfer_command = TransferCommand::Unknown;
-		{
+		BundledFile bundled_file;
+		bool from_bundle = !file_bundle.empty();
+		if( from_bundle ) {
+				// Files that arrived in a bundle are handled just like
+				// ones sent on their own with the socket default crypto,
+				// except that their contents are already here.
+			bundled_file = std::move(file_bundle.front());
+			file_bundle.pop_front();
+			xfer_command = TransferCommand::XferFile;
+		} else {
 			int reply;
 			if( !s->code(reply) ) {
 				dprintf(D_ERROR,"DoDownload: exiting at %d\n",__LINE__);
 				return_and_resetpriv( -1 );
 			}
 			xfer_command = static_cast<TransferCommand>(reply);
+			if( !s->end_of_message() ) {
+				dprintf(D_ERROR,"DoDownload: exiting at %d\n",__LINE__);
+				return_and_resetpriv( -1 );
+			}
+			dprintf( D_FULLDEBUG, "FILETRANSFER: incoming file_command is %i\n", static_cast<int>(xfer_command));
 		}
-		if( !s->end_of_message() ) {
-			dprintf(D_ERROR,"DoDownload: exiting at %d\n",__LINE__);
-			return_and_resetpriv( -1 );
-		}
-		dprintf( D_FULLDEBUG, "FILETRANSFER: incoming file_command is %i\n", static_cast<int>(xfer_command));
 		if( xfer_command == TransferCommand::Finished ) {
 			break;
 		}
@@ -2558,7 +3109,17 @@ FileTransfer::DoDownload(ReliSock *s)
 			}
 		}
 
-		if( !s->code(filename) ) {
+		if( xfer_command == TransferCommand::XferBundle ) {
+			if( !receive_file_bundle(s, file_bundle) ) {
+				dprintf(D_ERROR,"DoDownload: exiting at %d\n",__LINE__);
+				return_and_resetpriv( -1 );
+			}
+			continue;
+		}
+
+		if( from_bundle ) {
+			filename = bundled_file.name;
+		} else if( !s->code(filename) ) {
 			dprintf(D_ERROR,"DoDownload: exiting at %d\n",__LINE__);
 			return_and_resetpriv( -1 );
 		}
@@ -2727,7 +3288,7 @@ FileTransfer::DoDownload(ReliSock *s)
 			formatstr(fullname,"%s%c%s",TmpSpoolSpace.c_str(),DIR_DELIM_CHAR,filename.c_str());
 		}
 
-		if( PeerDoesGoAhead ) {
+		if( PeerDoesGoAhead && !from_bundle ) {
 			if( !s->end_of_message() ) {
 				dprintf(D_ERROR,"DoDownload: failed on eom before GoAhead: exiting at %d\n",__LINE__);
 				return_and_resetpriv( -1 );
@@ -2806,6 +3367,7 @@ FileTransfer::DoDownload(ReliSock *s)
 		thisFileStats.TransferProtocol = "cedar";
 		thisFileStats.TransferStartTime = condor_gettimestamp_double();
 		thisFileStats.TransferType = "download";
+		filesize_t zero_copy_start = s->get_zero_copy_bytes();
 
 		// Create a ClassAd we'll use to store stats from a file transfer
 		// plugin, if we end up using one.
@@ -2916,6 +3478,53 @@ FileTransfer::DoDownload(ReliSock *s)
 				ClassAd ad;
 				ad.InsertAttr("Result", 1);
 				rc = 0;
+				classad::Value value;
+				classad_shared_ptr<classad::ExprList> exprlist;
+				if (m_reuse_dir && file_info.EvaluateAttr("ReuseList", value) &&
+					value.IsSListValue(exprlist))
+				{
+					std::string reuse_tag = ftcb.hasUser() ? ftcb.getUser() : "";
+					classad::ExprList reused;
+					for (auto list_entry : (*exprlist)) {
+						classad::ClassAd *entry_ad = dynamic_cast<classad::ClassAd *>(list_entry);
+						std::string fname, checksum_type, checksum;
+						long long size = -1;
+						if (!entry_ad || !entry_ad->EvaluateAttrString("FileName", fname) ||
+							!entry_ad->EvaluateAttrString("ChecksumType", checksum_type) ||
+							!entry_ad->EvaluateAttrString("Checksum", checksum) ||
+							!entry_ad->EvaluateAttrInt("Size", size))
+						{
+							continue;
+						}
+							// Only plain files that land in the output directory
+							// under their own name can come out of the cache.
+						std::string remap;
+						if (fname.empty() || fname.find(DIR_DELIM_CHAR) != std::string::npos ||
+							!LegalPathInSandbox(fname.c_str(), outputDirectory.c_str()) ||
+							filename_remap_find(download_filename_remaps.c_str(), fname.c_str(), remap, 0))
+						{
+							continue;
+						}
+						std::string dest;
+						formatstr(dest, "%s%c%s", outputDirectory.c_str(), DIR_DELIM_CHAR, fname.c_str());
+						StatInfo dest_info(dest.c_str());
+						if (dest_info.Error() != SINoFile) {
+							continue;
+						}
+						CondorError err;
+						if (m_reuse_dir->RetrieveFile(dest, checksum, checksum_type, reuse_tag, err)) {
+							dprintf(D_FULLDEBUG, "DoDownload: Reused %s from the data reuse directory.\n", fname.c_str());
+							reused.push_back(classad::Literal::MakeString(fname));
+						} else {
+							dprintf(D_FULLDEBUG, "DoDownload: Not reusing %s: %s\n", fname.c_str(), err.getFullText().c_str());
+							unlink(dest.c_str());
+							if (checksum_type == "sha256") {
+								reuse_misses[fname] = std::make_pair(checksum, size);
+							}
+						}
+					}
+					ad.Insert("ReuseList", reused.Copy());
+				}
 				s->encode();
 				if (!putClassAd(s, ad) || !s->end_of_message()) {
 					dprintf(D_ERROR,"DoDownload: exiting at %d\n",__LINE__);
@@ -3191,6 +3800,10 @@ FileTransfer::DoDownload(ReliSock *s)
 						error_buf.c_str());
 				}
 			}
+		} else if ( from_bundle ) {
+			rc = write_bundled_file( fullname, bundled_file, this_file_max_bytes, bytes );
+		} else if ( xfer_command == TransferCommand::XferParallel ) {
+			rc = receive_file_parallel( s, fullname, this_file_max_bytes, xfer_queue, bytes );
 		} else if ( TransferFilePermissions ) {
 			// We could create the target's parent directories, but since
 			// we need to have sent them along as explicit transfer items
@@ -3207,6 +3820,7 @@ FileTransfer::DoDownload(ReliSock *s)
 		elapsed = time(NULL)-start;
 		thisFileStats.TransferEndTime = condor_gettimestamp_double();
 		thisFileStats.ConnectionTimeSeconds = thisFileStats.TransferEndTime - thisFileStats.TransferStartTime;
+		thisFileStats.TransferZeroCopyBytes = s->get_zero_copy_bytes() - zero_copy_start;
 
 		// Report only the first error.
 		if( rc < 0 && all_transfers_succeeded ) {
@@ -3325,7 +3939,7 @@ FileTransfer::DoDownload(ReliSock *s)
 			utime(fullname.c_str(),&timewrap);
 		}
 
-		if( !s->end_of_message() ) {
+		if( !from_bundle && !s->end_of_message() ) {
 			return_and_resetpriv( -1 );
 		}
 		total_bytes += bytes;
@@ -3333,12 +3947,25 @@ FileTransfer::DoDownload(ReliSock *s)
 		thisFileStats.TransferTotalBytes += bytes;
 
 		numFiles++;
-		if (xfer_command == TransferCommand::XferFile && rc == 0) {
+		if ((xfer_command == TransferCommand::XferFile || xfer_command == TransferCommand::XferParallel) && rc == 0) {
 			int num_cedar_files = 0;
 			Info.stats.LookupInteger("CedarFilesCount", num_cedar_files);
 			num_cedar_files++;
 			Info.stats.InsertAttr("CedarFilesCount", num_cedar_files);
 			Info.protocol_bytes["cedar"] += bytes;
+			if (thisFileStats.TransferZeroCopyBytes > 0) {
+				long long zero_copy_bytes = 0;
+				Info.stats.LookupInteger("CedarZeroCopyBytes", zero_copy_bytes);
+				Info.stats.InsertAttr("CedarZeroCopyBytes", zero_copy_bytes + thisFileStats.TransferZeroCopyBytes);
+			}
+
+			auto miss = reuse_misses.find(filename);
+			if (miss != reuse_misses.end()) {
+				if (miss->second.second == bytes) {
+					cacheReusableFile(fullname, miss->second.first, bytes);
+				}
+				reuse_misses.erase(miss);
+			}
 		}
 		bytes = 0;
 
@@ -4657,7 +5284,32 @@ FileTransfer::computeFileList(
 	}
 
 
-	if (!m_reuse_info.empty())
+		// Without a manifest, we offer the input files that are big enough
+		// to be worth it, by checksum, to any peer that can keep them.
+	std::vector<const FileTransferItem *> reuse_candidates;
+	if (PeerDoesReuseInfo && IsServer() && !m_final_transfer_flag && !simple_init) {
+		long long reuse_min_size = -1;
+		param_longlong("DATA_REUSE_MIN_FILE_SIZE", reuse_min_size, true, 1024 * 1024, true, -1);
+		for (const auto &fileitem : filelist) {
+			if (reuse_min_size < 0) break;
+			if (fileitem.isSrcUrl() || fileitem.isDestUrl() || fileitem.isDirectory() ||
+				fileitem.isDomainSocket() || !fileitem.destDir().empty() ||
+				fileitem.fileSize() < reuse_min_size)
+			{
+				continue;
+			}
+				// These are renamed or delegated rather than copied.
+			const char *src_name = fileitem.srcName().c_str();
+			if ((ExecFile && !file_strcmp(ExecFile, src_name)) ||
+				(X509UserProxy && !file_strcmp(X509UserProxy, src_name)))
+			{
+				continue;
+			}
+			reuse_candidates.push_back(&fileitem);
+		}
+	}
+
+	if (!m_reuse_info.empty() || !reuse_candidates.empty())
 	{
 		dprintf(D_FULLDEBUG, "DoUpload: Sending remote side hints about potential file reuse.\n");
 
@@ -4683,12 +5335,33 @@ FileTransfer::computeFileList(
 			return_and_resetpriv( -1 );
 		}
 
+		std::vector<ReuseInfo> reuse_info(m_reuse_info);
+		if (PeerHasDataReuse) {
+				// The peer said it keeps files for reuse; now it's worth
+				// computing the checksums.
+			for (const auto *fileitem : reuse_candidates) {
+				std::string fullname = fileitem->srcName();
+				if (!fullpath(fullname.c_str())) {
+					formatstr(fullname, "%s%c%s", Iwd, DIR_DELIM_CHAR, fileitem->srcName().c_str());
+				}
+				std::string checksum;
+				if (!compute_file_sha256_checksum(fullname, checksum)) {
+					dprintf(D_FULLDEBUG, "DoUpload: Failed to compute checksum of %s; not offering it for reuse.\n", fullname.c_str());
+					continue;
+				}
+				reuse_info.emplace_back(fileitem->srcName(), checksum, "sha256", tag, fileitem->fileSize());
+			}
+		}
+
+			// The peer names the files it reused by their basenames.
+		std::unordered_map<std::string, std::string> reuse_names;
 		ClassAd file_info;
 		auto sub = static_cast<int>(TransferSubCommand::ReuseInfo);
 		file_info.InsertAttr("SubCommand", sub);
 		file_info.InsertAttr("Tag", tag);
 		std::vector<ExprTree*> info_list;
-		for (auto &info : m_reuse_info) {
+		for (auto &info : reuse_info) {
+			reuse_names[condor_basename(info.filename().c_str())] = info.filename();
 			classad::ClassAd *ad = new classad::ClassAd();
 			ad->InsertAttr("FileName", condor_basename(info.filename().c_str()));
 			ad->InsertAttr("ChecksumType", info.checksum_type());
@@ -4725,6 +5398,11 @@ FileTransfer::computeFileList(
 				}
 				if (ExecFile && fname == "condor_exec.exe") {
 					fname = ExecFile;
+				} else {
+					auto name_iter = reuse_names.find(fname);
+					if (name_iter != reuse_names.end()) {
+						fname = name_iter->second;
+					}
 				}
 				dprintf(D_FULLDEBUG, "DoUpload: File %s was reused.\n", fname.c_str());
 				skip_files.insert(fname);
@@ -4919,6 +5597,24 @@ FileTransfer::uploadFileList(
 	int currentUploadPluginId = -1;
 	std::string currentUploadRequests;
 
+	// Small files waiting to be sent together in one bundle
+	std::vector<BundledFile> file_bundle;
+	filesize_t file_bundle_bytes = 0;
+	filesize_t bundle_max_file_size = 0;
+	filesize_t bundle_max_bytes = 0;
+	if( PeerDoesFileBundles ) {
+		bundle_max_file_size = param_integer("FILE_TRANSFER_BUNDLE_MAX_FILE_SIZE", 0, 0, MAX_BUNDLED_FILE_SIZE);
+		bundle_max_bytes = param_integer("FILE_TRANSFER_BUNDLE_MAX_BYTES", 4 * 1024 * 1024, 0);
+	}
+
+	// Large plain files may be split across several extra connections
+	int parallel_streams = 0;
+	long long parallel_min_file_size = 0;
+	if( PeerDoesParallelStreams && !protocolState.socket_default_crypto ) {
+		parallel_streams = param_integer("FILE_TRANSFER_PARALLEL_STREAMS", 0, 0, MAX_PARALLEL_STREAMS);
+		param_longlong("FILE_TRANSFER_PARALLEL_MIN_FILE_SIZE", parallel_min_file_size, true, 1024LL * 1024 * 1024, true, 0);
+	}
+
 	// use an error stack to keep track of failures when invoke plugins,
 	// perhaps more of this can be instrumented with it later.
 	CondorError errstack;
@@ -4953,6 +5649,7 @@ FileTransfer::uploadFileList(
 
 		auto &filename = fileitem.srcName();
 		auto &dest_dir = fileitem.destDir();
+		filesize_t zero_copy_start = s->get_zero_copy_bytes();
 			// Anything the remote side was able to reuse we do not send again.
 		if (skip_files.find(filename) != skip_files.end()) {
 			dprintf(D_FULLDEBUG, "Skipping file %s as it was reused.\n", filename.c_str());
@@ -5158,6 +5855,73 @@ FileTransfer::uploadFileList(
 			}
 		}
 
+		// Once neither side has to wait for a go-ahead before each file,
+		// small plain files are gathered into a bundle rather than being
+		// sent as several messages apiece.  Anything that isn't bundled
+		// sends the bundle first, so the order the peer sees is unchanged.
+		if( bundle_max_file_size > 0 && file_command == TransferCommand::XferFile &&
+			multifilePluginId < 0 && !fileitem.isDirectory() && !fileitem.isDomainSocket() &&
+			(!PeerDoesGoAhead || (protocolState.peer_goes_ahead_always && protocolState.I_go_ahead_always)) )
+		{
+			filesize_t upload_limit = MaxUploadBytes;
+			if( protocolState.peer_max_transfer_bytes >= 0 && (protocolState.peer_max_transfer_bytes < upload_limit || upload_limit < 0) ) {
+				upload_limit = protocolState.peer_max_transfer_bytes;
+			}
+
+			BundledFile bundled;
+			bundled.name = dest_filename;
+			if( read_bundled_file(fullname, TransferFilePermissions, bundle_max_file_size, bundled) &&
+				(upload_limit < 0 || total_bytes + (filesize_t)bundled.data.size() <= upload_limit) )
+			{
+				filesize_t bundled_bytes = bundled.data.size();
+				file_bundle.emplace_back(std::move(bundled));
+				file_bundle_bytes += bundled_bytes;
+				total_bytes += bundled_bytes;
+				numFiles++;
+
+				int num_cedar_files = 0;
+				Info.stats.LookupInteger("CedarFilesCount", num_cedar_files);
+				num_cedar_files++;
+				Info.stats.InsertAttr("CedarFilesCount", num_cedar_files);
+				Info.protocol_bytes["cedar"] += bundled_bytes;
+
+					// See the comment about the spooled files list below.
+				if( dest_filename.find(DIR_DELIM_CHAR) == std::string::npos &&
+					dest_filename != condor_basename(JobStdoutFile.c_str()) &&
+					dest_filename != condor_basename(JobStderrFile.c_str()) )
+				{
+					Info.addSpooledFile( dest_filename.c_str() );
+				}
+
+				if( file_bundle_bytes >= bundle_max_bytes ) {
+					if( !send_file_bundle(s, protocolState.socket_default_crypto, file_bundle) ) {
+						dprintf(D_ERROR,"DoUpload: exiting at %d\n",__LINE__);
+						return_and_resetpriv( -1 );
+					}
+					file_bundle_bytes = 0;
+				}
+				continue;
+			}
+		}
+		if( !file_bundle.empty() ) {
+			if( !send_file_bundle(s, protocolState.socket_default_crypto, file_bundle) ) {
+				dprintf(D_ERROR,"DoUpload: exiting at %d\n",__LINE__);
+				return_and_resetpriv( -1 );
+			}
+			file_bundle_bytes = 0;
+		}
+
+		// A large file that would be sent with the socket default (which
+		// is off) is split across several extra connections instead.
+		if( parallel_streams > 1 && file_command == TransferCommand::XferFile &&
+			multifilePluginId < 0 && !fileitem.isDirectory() && !fileitem.isDomainSocket() )
+		{
+			struct stat st = {};
+			if( stat(fullname.c_str(), &st) == 0 && S_ISREG(st.st_mode) && st.st_size >= parallel_min_file_size ) {
+				file_command = TransferCommand::XferParallel;
+			}
+		}
+
 		dprintf ( D_FULLDEBUG, "FILETRANSFER: outgoing file_command is %i for %s\n",
 			static_cast<int>(file_command), UrlSafePrint(filename) );
 
@@ -5477,6 +6241,15 @@ FileTransfer::uploadFileList(
 				rc = PUT_FILE_OPEN_FAILED;
 				errno = EISDIR;
 			}
+		} else if( file_command == TransferCommand::XferParallel ) {
+			bool connected = true;
+			rc = send_file_parallel( s, fullname, TransferFilePermissions, parallel_streams,
+			                         this_file_max_bytes, xfer_queue, bytes, connected );
+			if( !connected ) {
+					// the peer can't be reached this way, so don't wait
+					// on it again for the rest of the files
+				parallel_streams = 0;
+			}
 		} else if ( TransferFilePermissions ) {
 			rc = s->put_file_with_permissions( &bytes, fullname.c_str(), this_file_max_bytes, &xfer_queue );
 		} else {
@@ -5580,6 +6353,12 @@ FileTransfer::uploadFileList(
 			num_cedar_files++;
 			Info.stats.InsertAttr("CedarFilesCount", num_cedar_files);
 			Info.protocol_bytes["cedar"] += bytes;
+			filesize_t zero_copy_bytes = s->get_zero_copy_bytes() - zero_copy_start;
+			if (zero_copy_bytes > 0) {
+				long long total_zero_copy_bytes = 0;
+				Info.stats.LookupInteger("CedarZeroCopyBytes", total_zero_copy_bytes);
+				Info.stats.InsertAttr("CedarZeroCopyBytes", total_zero_copy_bytes + zero_copy_bytes);
+			}
 		}
 
 			// The spooled files list is used to generate
@@ -5601,6 +6380,12 @@ FileTransfer::uploadFileList(
 			Info.addSpooledFile( dest_filename.c_str() );
 		}
 	}
+	if( !file_bundle.empty() ) {
+		if( !send_file_bundle(s, protocolState.socket_default_crypto, file_bundle) ) {
+			dprintf(D_ERROR,"DoUpload: exiting at %d\n",__LINE__);
+			return_and_resetpriv( -1 );
+		}
+	}
 	// Release transfer queue slot if we haven't sent a protected URL for
 	// the remote side to download. Currently the remote side (likely starter)
 	// collects all passed URLs for download and then downloads post main loop
@@ -5838,6 +6623,9 @@ FileTransfer::DoObtainAndSendTransferGoAhead(DCTransferQueue &xfer_queue,bool do
 		msg.Assign(ATTR_RESULT,go_ahead); // go ahead
 		if( downloading ) {
 			msg.Assign(ATTR_MAX_TRANSFER_BYTES,MaxDownloadBytes);
+			if( m_reuse_dir ) {
+				msg.Assign("HasDataReuse", true);
+			}
 		}
 		if( go_ahead < 0 ) {
 				// tell our peer what exactly went wrong
@@ -5964,6 +6752,7 @@ FileTransfer::DoReceiveTransferGoAhead(
 		if( msg.LookupInteger(ATTR_MAX_TRANSFER_BYTES,mtb) ) {
 			peer_max_transfer_bytes = mtb;
 		}
+		msg.LookupBool("HasDataReuse", PeerHasDataReuse);
 
 		if( go_ahead == GO_AHEAD_UNDEFINED ) {
 				// This is just an "alive" message from our peer.
@@ -6319,6 +7108,11 @@ FileTransfer::setPeerVersion( const CondorVersionInfo &peer_version )
 	PeerDoesS3Urls = peer_version.built_since_version(8,9,4);
 	PeerRenamesExecutable = ! peer_version.built_since_version(10, 6, 0);
 	PeerKnowsProtectedURLs = peer_version.built_since_version(23, 1, 0);
+	// Released 24.12.x peers report the same version without understanding
+	// file bundles or parallel streams, so those are only sent when the
+	// admin turns them on, which says that every peer understands them.
+	PeerDoesFileBundles = peer_version.built_since_version(24, 12, 0);
+	PeerDoesParallelStreams = peer_version.built_since_version(24, 12, 0);
 }
 
 
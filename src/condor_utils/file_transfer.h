@@ -260,6 +260,12 @@ class FileTransfer final: public Service {
 	void setRuntimeAds(const std::string &job_ad, const std::string &machine_ad)
 	{m_job_ad = job_ad; m_machine_ad = machine_ad;}
 
+	/** @param reuse_dir A data reuse directory.  Input files that the peer
+	 *  offers for reuse are copied out of it instead of being sent, and
+	 *  the ones that are sent are added to it.
+	 */
+	void setDataReuseDirectory(htcondor::DataReuseDirectory &reuse_dir) {m_reuse_dir = &reuse_dir;}
+
 		/** Set limits on how much data will be sent/received per job
 			(i.e. per call to DoUpload() or DoDownload()).  The job is
 			put on hold if the limit is exceeded.  The files are sent
@@ -579,6 +585,9 @@ class FileTransfer final: public Service {
 		*/
 	filesize_t DoDownload(ReliSock *s);
 	filesize_t DoUpload(ReliSock *s);
+
+		// Add a file we just downloaded to the data reuse directory.
+	void cacheReusableFile(const std::string &fullname, const std::string &checksum, filesize_t size);
 	filesize_t DoCheckpointUploadFromStarter(ReliSock * s);
 	filesize_t DoCheckpointUploadFromShadow(ReliSock * s);
 	filesize_t DoNormalUpload(ReliSock * s);
@@ -648,6 +657,10 @@ class FileTransfer final: public Service {
 	bool PeerDoesS3Urls{false};
 	bool PeerRenamesExecutable{true};
 	bool PeerKnowsProtectedURLs{false};
+	bool PeerDoesFileBundles{false};
+	bool PeerDoesParallelStreams{false};
+		// set from the peer's go-ahead when it has a data reuse directory
+	bool PeerHasDataReuse{false};
 	bool TransferUserLog{false};
 	char* Iwd{nullptr};
 #ifdef WIN32
@@ -730,6 +743,7 @@ class FileTransfer final: public Service {
 	std::string m_cred_dir;
 	std::string m_job_ad;
 	std::string m_machine_ad;
+	htcondor::DataReuseDirectory *m_reuse_dir{nullptr};
 	filesize_t MaxUploadBytes{-1};  // no limit by default
 	filesize_t MaxDownloadBytes{-1};
 
@@ -35,6 +35,7 @@ void FileTransferStats::Init() {
     TransferEndTime = 0;
     TransferStartTime = 0;
     TransferFileBytes = 0;
+    TransferZeroCopyBytes = 0;
     LibcurlReturnCode = -1;
 }
 
@@ -110,6 +111,15 @@ void FileTransferStats::Publish(classad::ClassAd &ad) const {
     if (TransferTries > 0) {
         developerAd->InsertAttr("TransferTries", TransferTries);
     }
+    // How much of the file the kernel moved for us (sendfile/splice),
+    // and the rate we got, so the zero-copy path can be compared with
+    // the ordinary one.
+    if (TransferZeroCopyBytes > 0) {
+        developerAd->InsertAttr("TransferZeroCopyBytes", TransferZeroCopyBytes);
+    }
+    if (TransferFileBytes > 0 && ConnectionTimeSeconds > 0) {
+        developerAd->InsertAttr("TransferBytesPerSecond", TransferFileBytes / ConnectionTimeSeconds);
+    }
 
     if(developerAd->size() != 0) {
         ad.Insert( "DeveloperData", developerAd );
@@ -46,6 +46,7 @@ class FileTransferStats
         long TransferHTTPStatusCode;
         long long TransferTotalBytes;
         long TransferTries;
+        long long TransferZeroCopyBytes;
 
         std::string HttpCacheHitOrMiss;
         std::string HttpCacheHost;
@@ -0,0 +1,326 @@
+/***************************************************************
+ *
+ * Copyright (C) 2025, Condor Team, Computer Sciences Department,
+ * University of Wisconsin-Madison, WI.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you
+ * may not use this file except in compliance with the License.  You may
+ * obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ ***************************************************************/
+
+#include "condor_common.h"
+#include "condor_debug.h"
+#include "condor_classad.h"
+#include "condor_attributes.h"
+#include "basename.h"
+#include "stl_string_utils.h"
+#include "compat_classad_util.h"
+#include "directory_util.h"
+
+#include "history_index.h"
+#include <limits.h>
+#include <math.h>
+
+// a constraint that expands into more keys than this isn't worth the trouble
+static const size_t MAX_FILTER_KEYS = 1000;
+
+std::string
+HistoryIndexFileName(const char * history_file)
+{
+	std::string dir = condor_dirname(history_file);
+	std::string name = ".";
+	name += condor_basename(history_file);
+	name += ".idx";
+
+	std::string path;
+	dircat(dir.c_str(), name.c_str(), path);
+	return path;
+}
+
+void
+FormatHistoryIndexEntry(std::string & line, const HistoryIndexEntry & entry)
+{
+	formatstr(line, "%lld %lld %d %d %lld %s\n",
+		entry.offset, entry.end, entry.cluster, entry.proc, entry.completion,
+		entry.owner.empty() ? "?" : entry.owner.c_str());
+}
+
+static bool
+parseHistoryIndexEntry(const std::string & line, HistoryIndexEntry & entry)
+{
+	// a line without a newline is one the writer didn't finish
+	if (line.empty() || line.back() != '\n') {
+		return false;
+	}
+	int pos = 0;
+	if (sscanf(line.c_str(), "%lld %lld %d %d %lld %n",
+			&entry.offset, &entry.end, &entry.cluster, &entry.proc, &entry.completion, &pos) != 5 || pos <= 0) {
+		return false;
+	}
+	entry.owner.assign(line, pos, line.size() - pos - 1);
+	if (entry.owner == "?") {
+		entry.owner.clear();
+	}
+	return entry.offset >= 0 && entry.end > entry.offset;
+}
+
+// returns true if the line that ends at the given offset of the file is a "***" banner
+static bool
+endsWithBanner(int fd, long long end)
+{
+	char buf[1024];
+	long long start = end - (long long)sizeof(buf);
+	if (start < 0) { start = 0; }
+	if (lseek(fd, (off_t)start, SEEK_SET) != (off_t)start) {
+		return false;
+	}
+	int cb = (int)(end - start);
+	if (full_read(fd, buf, cb) != cb || buf[cb-1] != '\n') {
+		return false;
+	}
+	int ix = cb - 1;
+	while (ix > 0 && buf[ix-1] != '\n') { --ix; }
+	if (ix == 0 && start > 0) {
+		return false; // the banner is longer than we looked
+	}
+	return cb - ix > 3 && ! strncmp(buf + ix, "***", 3);
+}
+
+bool
+ReadHistoryIndex(const char * history_file, std::vector<HistoryIndexEntry> & entries, long long & indexed_end)
+{
+	entries.clear();
+	indexed_end = 0;
+
+	std::string index_file = HistoryIndexFileName(history_file);
+	FILE * fp = safe_fopen_wrapper_follow(index_file.c_str(), "r");
+	if ( ! fp) {
+		return false;
+	}
+
+	std::string line;
+	HistoryIndexEntry entry;
+	bool valid = true;
+	while (readLine(line, fp)) {
+		if ( ! parseHistoryIndexEntry(line, entry)) {
+			break;
+		}
+		// the index must describe the history file without gaps
+		if (entry.offset != indexed_end) {
+			dprintf(D_FULLDEBUG, "History index %s has a gap at offset %lld, ignoring it\n",
+				index_file.c_str(), indexed_end);
+			valid = false;
+			break;
+		}
+		indexed_end = entry.end;
+		entries.push_back(entry);
+	}
+	fclose(fp);
+
+	if (valid && ! entries.empty()) {
+		int fd = safe_open_wrapper_follow(history_file, O_RDONLY | O_LARGEFILE | _O_BINARY);
+		if (fd < 0) {
+			valid = false;
+		} else {
+			struct stat si = {};
+			if (fstat(fd, &si) != 0 || (long long)si.st_size < indexed_end || ! endsWithBanner(fd, indexed_end)) {
+				dprintf(D_FULLDEBUG, "History index %s does not match %s, ignoring it\n",
+					index_file.c_str(), history_file);
+				valid = false;
+			}
+			close(fd);
+		}
+	}
+
+	if ( ! valid || entries.empty()) {
+		entries.clear();
+		indexed_end = 0;
+		return false;
+	}
+	return true;
+}
+
+static bool
+isUnrestricted(const HistoryIndexFilter::Key & key)
+{
+	return key.cluster < 0 && key.proc < 0 && key.owner.empty() &&
+		key.min_completion == LLONG_MIN && key.max_completion == LLONG_MAX;
+}
+
+// intersect two keys, returns false if no entry can satisfy both
+static bool
+intersectKeys(const HistoryIndexFilter::Key & a, const HistoryIndexFilter::Key & b, HistoryIndexFilter::Key & out)
+{
+	if (a.cluster >= 0 && b.cluster >= 0 && a.cluster != b.cluster) return false;
+	if (a.proc >= 0 && b.proc >= 0 && a.proc != b.proc) return false;
+	if ( ! a.owner.empty() && ! b.owner.empty() && strcasecmp(a.owner.c_str(), b.owner.c_str()) != MATCH) return false;
+
+	out.cluster = (a.cluster >= 0) ? a.cluster : b.cluster;
+	out.proc = (a.proc >= 0) ? a.proc : b.proc;
+	out.owner = a.owner.empty() ? b.owner : a.owner;
+	out.min_completion = MAX(a.min_completion, b.min_completion);
+	out.max_completion = MIN(a.max_completion, b.max_completion);
+	return out.min_completion <= out.max_completion;
+}
+
+// The comparisons we know how to turn into keys are those between one of
+// the indexed attributes and a literal.  Anything else is unrestricted.
+static void
+comparisonKeys(classad::Operation::OpKind op, classad::ExprTree * left, classad::ExprTree * right, std::vector<HistoryIndexFilter::Key> & keys)
+{
+	HistoryIndexFilter::Key key;
+	keys.clear();
+
+	std::string attr;
+	classad::Value value;
+	left = SkipExprParens(left);
+	right = SkipExprParens(right);
+	if (ExprTreeIsAttrRef(right, attr) && ExprTreeIsLiteral(left, value)) {
+		// put the attribute on the left
+		switch (op) {
+		case classad::Operation::LESS_THAN_OP: op = classad::Operation::GREATER_THAN_OP; break;
+		case classad::Operation::LESS_OR_EQUAL_OP: op = classad::Operation::GREATER_OR_EQUAL_OP; break;
+		case classad::Operation::GREATER_THAN_OP: op = classad::Operation::LESS_THAN_OP; break;
+		case classad::Operation::GREATER_OR_EQUAL_OP: op = classad::Operation::LESS_OR_EQUAL_OP; break;
+		default: break;
+		}
+	} else if ( ! ExprTreeIsAttrRef(left, attr) || ! ExprTreeIsLiteral(right, value)) {
+		keys.push_back(key);
+		return;
+	}
+
+	bool is_equal = (op == classad::Operation::EQUAL_OP || op == classad::Operation::META_EQUAL_OP);
+	long long ival;
+	double rval;
+	std::string sval;
+	bool is_cluster = strcasecmp(attr.c_str(), ATTR_CLUSTER_ID) == MATCH;
+	if ((is_cluster || strcasecmp(attr.c_str(), ATTR_PROC_ID) == MATCH) &&
+		is_equal && value.IsNumber(ival) && ival >= 0 && ival <= INT_MAX) {
+		if (is_cluster) {
+			key.cluster = (int)ival;
+		} else {
+			key.proc = (int)ival;
+		}
+	} else if (strcasecmp(attr.c_str(), ATTR_OWNER) == MATCH && is_equal && value.IsStringValue(sval) && ! sval.empty()) {
+		// == on strings ignores case, so the key does too
+		key.owner = sval;
+	} else if (strcasecmp(attr.c_str(), ATTR_COMPLETION_DATE) == MATCH && value.IsNumber(rval)) {
+		// the index holds CompletionDate as an integer, so round the
+		// bounds outwards rather than worrying about strictness
+		switch (op) {
+		case classad::Operation::EQUAL_OP:
+		case classad::Operation::META_EQUAL_OP:
+			key.min_completion = (long long)floor(rval);
+			key.max_completion = (long long)ceil(rval);
+			break;
+		case classad::Operation::GREATER_THAN_OP:
+		case classad::Operation::GREATER_OR_EQUAL_OP:
+			key.min_completion = (long long)floor(rval);
+			break;
+		case classad::Operation::LESS_THAN_OP:
+		case classad::Operation::LESS_OR_EQUAL_OP:
+			key.max_completion = (long long)ceil(rval);
+			break;
+		default:
+			break;
+		}
+	}
+	keys.push_back(key);
+}
+
+// Compute keys such that any ad the expression is true for matches at least one key.
+static void
+exprKeys(classad::ExprTree * tree, std::vector<HistoryIndexFilter::Key> & keys)
+{
+	keys.clear();
+	tree = SkipExprParens(tree);
+	if ( ! tree || tree->GetKind() != classad::ExprTree::OP_NODE) {
+		keys.push_back(HistoryIndexFilter::Key());
+		return;
+	}
+
+	classad::Operation::OpKind op;
+	classad::ExprTree *t1, *t2, *t3;
+	((const classad::Operation*)tree)->GetComponents(op, t1, t2, t3);
+
+	if (op == classad::Operation::LOGICAL_AND_OP || op == classad::Operation::LOGICAL_OR_OP) {
+		std::vector<HistoryIndexFilter::Key> left, right;
+		exprKeys(t1, left);
+		exprKeys(t2, right);
+		if (op == classad::Operation::LOGICAL_OR_OP) {
+			keys = left;
+			keys.insert(keys.end(), right.begin(), right.end());
+		} else {
+			HistoryIndexFilter::Key key;
+			for (const auto & a : left) {
+				for (const auto & b : right) {
+					if (intersectKeys(a, b, key)) {
+						keys.push_back(key);
+					}
+				}
+			}
+		}
+		bool unrestricted = keys.size() > MAX_FILTER_KEYS;
+		for (const auto & key : keys) {
+			if (unrestricted) break;
+			unrestricted = isUnrestricted(key);
+		}
+		if (unrestricted) {
+			keys.clear();
+			keys.push_back(HistoryIndexFilter::Key());
+		}
+		return;
+	}
+
+	if (op >= classad::Operation::__COMPARISON_START__ && op <= classad::Operation::__COMPARISON_END__) {
+		comparisonKeys(op, t1, t2, keys);
+		return;
+	}
+
+	keys.push_back(HistoryIndexFilter::Key());
+}
+
+bool
+HistoryIndexFilter::Init(classad::ExprTree * constraint)
+{
+	keys.clear();
+	if ( ! constraint) {
+		return false;
+	}
+	exprKeys(constraint, keys);
+	for (const auto & key : keys) {
+		if (isUnrestricted(key)) {
+			keys.clear();
+			return false;
+		}
+	}
+	return true;
+}
+
+void
+HistoryIndexFilter::Merge(const HistoryIndexFilter & other)
+{
+	keys.insert(keys.end(), other.keys.begin(), other.keys.end());
+}
+
+bool
+HistoryIndexFilter::Matches(const HistoryIndexEntry & entry) const
+{
+	for (const auto & key : keys) {
+		if (key.cluster >= 0 && key.cluster != entry.cluster) continue;
+		if (key.proc >= 0 && key.proc != entry.proc) continue;
+		if ( ! key.owner.empty() && strcasecmp(key.owner.c_str(), entry.owner.c_str()) != MATCH) continue;
+		if (entry.completion < key.min_completion || entry.completion > key.max_completion) continue;
+		return true;
+	}
+	return false;
+}
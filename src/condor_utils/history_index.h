@@ -0,0 +1,91 @@
+/***************************************************************
+ *
+ * Copyright (C) 2025, Condor Team, Computer Sciences Department,
+ * University of Wisconsin-Madison, WI.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you
+ * may not use this file except in compliance with the License.  You may
+ * obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ ***************************************************************/
+
+#ifndef _HISTORY_INDEX_H_
+#define _HISTORY_INDEX_H_
+
+#include "condor_classad.h"
+#include <vector>
+#include <string>
+#include <limits.h>
+
+// A history index is a sidecar file kept next to a history file that has
+// one line per job ad in the history file, in the same order:
+//
+//    <offset> <end> <ClusterId> <ProcId> <CompletionDate> <Owner>
+//
+// where <offset> is the byte offset of the first line of the ad and <end> is
+// the offset just past its "***" banner line.  The index for
+//    /scratch/condor/spool/history.20151019T161810
+// is
+//    /scratch/condor/spool/.history.20151019T161810.idx
+// the leading dot keeps it from looking like a rotated history file.
+
+struct HistoryIndexEntry {
+	long long offset = 0;
+	long long end = 0;
+	int cluster = -1;
+	int proc = -1;
+	long long completion = -1;
+	std::string owner;
+};
+
+// returns the name of the index file for the given history file
+std::string HistoryIndexFileName(const char * history_file);
+
+// format an index line (including the trailing newline) for an ad
+void FormatHistoryIndexEntry(std::string & line, const HistoryIndexEntry & entry);
+
+// Read the index for the given history file.  Returns false if there is no
+// index, or if it does not describe the history file from its first byte
+// through to the end of every ad it lists.  On success, indexed_end is the
+// offset in the history file that the index covers up to; ads appended
+// after that (if any) are not in the index.
+bool ReadHistoryIndex(const char * history_file, std::vector<HistoryIndexEntry> & entries, long long & indexed_end);
+
+// The set of ads that can possibly match a constraint, described in terms
+// of the values that are kept in the index. This is a disjunction of keys,
+// each of which is a conjunction of a job id, an owner and a window of
+// completion dates.  Fields that are not restricted are -1, empty, or
+// the whole range of long long.
+class HistoryIndexFilter {
+public:
+	struct Key {
+		int cluster = -1;
+		int proc = -1;
+		std::string owner;
+		long long min_completion = LLONG_MIN;
+		long long max_completion = LLONG_MAX;
+	};
+
+	// Build a filter from a constraint expression.  Returns false if
+	// the constraint does not restrict any of the indexed values, in which
+	// case every ad has to be read anyway.
+	bool Init(classad::ExprTree * constraint);
+
+	// a filter that passes entries that either filter passes
+	void Merge(const HistoryIndexFilter & other);
+
+	bool Matches(const HistoryIndexEntry & entry) const;
+
+private:
+	std::vector<Key> keys;
+};
+
+#endif
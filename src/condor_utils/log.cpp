@@ -32,6 +32,58 @@
 
 #include "log.h"
 #include "stl_string_utils.h"
+#include "classad/binarySource.h"
+
+// Attribute and function names that binary log entries refer to by position.
+// Logs written with this list must stay readable, so names may only be added
+// to the end of it, and never removed or reordered.
+static const char * const binary_log_names[] = {
+	"MY", "TARGET", "MyType", "TargetType", "ClusterId", "ProcId", "Owner", "User",
+	"JobStatus", "LastJobStatus", "EnteredCurrentStatus", "QDate", "JobUniverse",
+	"Cmd", "Args", "Arguments", "Environment", "Env", "In", "Out", "Err", "Iwd",
+	"Requirements", "Rank", "RequestCpus", "RequestMemory", "RequestDisk",
+	"DiskUsage", "ImageSize", "ExecutableSize", "MemoryUsage", "ResidentSetSize",
+	"ProportionalSetSizeKb", "JobPrio", "NiceUser", "AccountingGroup",
+	"AcctGroup", "AcctGroupUser", "JobNotification", "NotifyUser", "JobLeaseDuration",
+	"OnExitHold", "OnExitRemove", "PeriodicHold", "PeriodicRelease", "PeriodicRemove",
+	"LeaveJobInQueue", "ShouldTransferFiles", "WhenToTransferOutput",
+	"TransferIn", "TransferInput", "TransferOutput", "StreamOut", "StreamErr",
+	"GlobalJobId", "NTDomain", "CondorVersion", "CondorPlatform", "JobSubmitMethod",
+	"TotalSubmitProcs", "MinHosts", "MaxHosts", "CurrentHosts", "OrigMaxHosts",
+	"AutoClusterId", "AutoClusterAttrs", "JobRunCount", "NumJobStarts",
+	"NumShadowStarts", "NumJobMatches", "NumRestarts", "NumSystemHolds", "NumCkpts",
+	"JobStartDate", "JobCurrentStartDate", "JobLastStartDate", "ShadowBday",
+	"LastMatchTime", "LastRejMatchTime", "LastRejMatchReason", "CompletionDate",
+	"RemoteHost", "LastRemoteHost", "RemoteSlotID", "StartdPrincipal", "ClaimId",
+	"PublicClaimId", "JobPid", "RemoteWallClockTime", "RemoteSysCpu", "RemoteUserCpu",
+	"CumulativeSlotTime", "CommittedSlotTime", "CommittedTime", "CommittedSuspensionTime",
+	"CumulativeSuspensionTime", "TotalSuspensions", "LastSuspensionTime",
+	"CumulativeTransferTime", "BytesSent", "BytesRecvd", "ExitCode", "ExitBySignal",
+	"ExitSignal", "ExitStatus", "JobCoreDumped", "HoldReason", "HoldReasonCode",
+	"HoldReasonSubCode", "ReleaseReason", "RemoveReason", "JobStatusOnRelease",
+	"EnteredHoldStatus", "LastHoldReason", "LastHoldReasonCode", "LastHoldReasonSubCode",
+	"LastVacateTime", "LastJobLeaseRenewal", "JobCurrentStartExecutingDate",
+	"JobCurrentStartTransferOutputDate", "JobCurrentFinishTransferOutputDate",
+	"JobCurrentStartTransferInputDate", "JobCurrentFinishTransferInputDate",
+	"OrigRequestMemory", "OrigRequestCpus", "OrigRequestDisk", "WantCheckpoint",
+	"WantRemoteSyscalls", "WantRemoteIO", "RootDir", "CoreSize", "BufferSize",
+	"BufferBlockSize", "UserLog", "UserLogUseXML", "KillSig", "JobMaxVacateTime",
+	"MachineAttrCpus0", "MachineAttrSlotWeight0", "ResizedRequestMemory",
+	"StartdIpAddr", "ShadowIpAddr", "MemoryProvisioned", "DiskProvisioned",
+	"CpusProvisioned", "LastRemoteWallClockTime", "ProcessingTime",
+	"ServerTime", "CurrentTime", "time", "ifThenElse", "isUndefined", "isError",
+	"strcat", "string", "int", "real", "min", "max", "quantize", "stringListMember",
+	"regexp", "splitUserName", "userHome", "Memory", "Cpus", "Disk", "Arch", "OpSys",
+	"OpSysAndVer", "HasFileTransfer", "FileSystemDomain", "TotalJobRuntime",
+	"x509userproxy", "x509UserProxyExpiration", "x509userproxysubject",
+};
+
+const classad::ClassAdBinaryNames &
+LogRecord::binaryNames()
+{
+	static const classad::ClassAdBinaryNames names(binary_log_names, sizeof(binary_log_names)/sizeof(binary_log_names[0]));
+	return names;
+}
 
 bool valid_record_optype(int optype) {
     switch (optype) {
@@ -161,8 +213,11 @@ LogRecord::readline(FILE *fp, char * &str)
 }
 
 int
-LogRecord::Write(FILE *fp)
+LogRecord::Write(FILE *fp, bool binary)
 {
+	if (binary) {
+		return WriteBinary(fp);
+	}
 	int rval1, rval2, rval3;
 	return( ( rval1=WriteHeader(fp) )<0 || 
 			( rval2=WriteBody(fp) )  <0 || 
@@ -217,6 +272,98 @@ LogRecord::ReadHeader(FILE *fp)
 }
 
 
+// A binary entry is built in memory and written with a single fwrite,
+// so a failed write leaves at worst one truncated entry at the end of the log.
+int
+LogRecord::WriteBinary(FILE *fp)
+{
+	std::string buf;
+	buf.reserve(128);
+	buf.append(5, '\0');
+	buf[0] = (char)CondorLogBinaryMarker;
+	classad::ClassAdBinaryUnParser::UnparseVarint(buf, (uint64_t)op_type);
+	if (WriteBinaryBody(buf) < 0) {
+		return -1;
+	}
+	size_t len = buf.size() - 5;
+	if (len > 0xFFFFFFFF) {
+		return -1;
+	}
+	for (int ix = 0; ix < 4; ++ix) {
+		buf[1 + ix] = (char)((len >> (8*ix)) & 0xFF);
+	}
+	if (fwrite(buf.data(), 1, buf.size(), fp) < buf.size()) {
+		return -1;
+	}
+	return (int)buf.size();
+}
+
+int
+LogRecord::readBinaryEntry(FILE *fp, int & op_type, std::string & body)
+{
+	unsigned char hdr[4];
+	if (fread(hdr, 1, sizeof(hdr), fp) < sizeof(hdr)) {
+		return -1;
+	}
+	size_t len = hdr[0] | (hdr[1] << 8) | (hdr[2] << 16) | ((size_t)hdr[3] << 24);
+	// read in pieces, so that a damaged length at the end of the log
+	// doesn't make us allocate far more than there is left to read.
+	body.clear();
+	while (body.size() < len) {
+		size_t off = body.size();
+		size_t want = std::min(len - off, (size_t)1024*1024);
+		body.resize(off + want);
+		if (fread(&body[off], 1, want, fp) < want) {
+			return -1;
+		}
+	}
+
+	const char * ptr = body.data();
+	uint64_t op = 0;
+	if ( ! classad::ClassAdBinaryParser::ParseVarint(ptr, body.data() + body.size(), op) || op > INT_MAX) {
+		op_type = CondorLogOp_Error;
+	} else {
+		op_type = (int)op;
+	}
+	body.erase(0, ptr - body.data());
+	return (int)(len + 5);
+}
+
+void
+LogRecord::putBinary(std::string & buf, const char * str)
+{
+	if ( ! str) str = "";
+	classad::ClassAdBinaryUnParser::UnparseString(buf, str, strlen(str));
+}
+
+bool
+LogRecord::getBinary(const char *& ptr, const char * end, char *& str)
+{
+	std::string val;
+	if ( ! classad::ClassAdBinaryParser::ParseString(ptr, end, val)) {
+		return false;
+	}
+	str = strdup(val.c_str());
+	return true;
+}
+
+void
+LogRecord::putBinaryName(std::string & buf, const char * name)
+{
+	classad::ClassAdBinaryUnParser(&binaryNames()).UnparseName(buf, name ? name : "");
+}
+
+bool
+LogRecord::getBinaryName(const char *& ptr, const char * end, char *& name)
+{
+	std::string val;
+	if ( ! classad::ClassAdBinaryParser(&binaryNames()).ParseName(ptr, end, val)) {
+		return false;
+	}
+	name = strdup(val.c_str());
+	return true;
+}
+
 // The ReadBody() function in all of our child classes consume the newline
 // at the end of every line, so we have nothing to read.
 int
@@ -226,10 +373,24 @@ LogRecord::ReadTail(FILE *  /*fp*/)
 }
 
 LogRecord *
-ReadLogEntry(FILE *fp, unsigned long recnum, LogRecord* (*InstantiateLogEntry)(FILE *fp, unsigned long recnum, int type, const ConstructLogEntry & ctor), const ConstructLogEntry & ctor)
+ReadLogEntry(FILE *fp, unsigned long recnum, InstantiateLogEntryFunc InstantiateLogEntry, const ConstructLogEntry & ctor)
 {
     char* opword = NULL;
     int opcode = CondorLogOp_Error;
+
+	int ch = fgetc(fp);
+	if (ch == EOF) return NULL;
+	if (ch == CondorLogBinaryMarker) {
+		std::string body;
+		// a truncated entry is treated the same as a truncated line
+		if (LogRecord::readBinaryEntry(fp, opcode, body) < 0) return NULL;
+		if ( ! valid_record_optype(opcode)) {
+			opcode = CondorLogOp_Error;
+		}
+		return InstantiateLogEntry(fp, recnum, opcode, ctor, &body);
+	}
+	ungetc(ch, fp);
+
 	int rval = LogRecord::readword(fp, opword);
 	if (rval < 0) return NULL;
     YourStringDeserializer lex(opword);
@@ -238,5 +399,5 @@ ReadLogEntry(FILE *fp, unsigned long recnum, LogRecord* (*InstantiateLogEntry)(F
     }
     free(opword);
 
-	return InstantiateLogEntry(fp, recnum, opcode, ctor);
+	return InstantiateLogEntry(fp, recnum, opcode, ctor, NULL);
 }
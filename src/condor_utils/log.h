@@ -34,6 +34,16 @@
    log.  The Play() method is defined to perform the operation on
    the data structure passed in as an argument.  The argument is of
    type (void *) for generality.
+
+   A log entry may instead be written in binary, as the byte
+   CondorLogBinaryMarker, the length of the rest of the entry as 4
+   bytes little endian, op_type as a varint, and a body defined by
+   WriteBinaryBody and ReadBinaryBody.  No text entry can start with
+   the marker, so a log may hold entries of both kinds.  Binary entries
+   are self contained; attribute names are written as a position in a
+   fixed list of common names (which may only ever be appended to) or
+   spelled out, so any entry can be read without reading the ones
+   before it.
 */
 
 #define CondorLogOp_NewClassAd			101
@@ -45,6 +55,10 @@
 #define CondorLogOp_LogHistoricalSequenceNumber 107
 #define CondorLogOp_Error               999
 
+#define CondorLogBinaryMarker           0xB1
+
+namespace classad { class ClassAdBinaryNames; }
+
 class LogRecord {
 public:
 	
@@ -52,26 +66,49 @@ public:
 	virtual ~LogRecord();
 	int get_op_type() const { return op_type; }
 
-	int Write(FILE *fp);
+	int Write(FILE *fp, bool binary=false);
 	int Read(FILE *fp);
 	int ReadHeader(FILE *fp);
 	virtual int ReadBody(FILE *) { return 0; }
 	int ReadTail(FILE *fp);
 
+		// read the body of a binary entry
+	int ReadBinary(const std::string & body) {
+		const char * ptr = body.data();
+		read_binary = true;
+		return ReadBinaryBody(ptr, ptr + body.size());
+	}
+	virtual int ReadBinaryBody(const char *& /*ptr*/, const char * /*end*/) { return 0; }
+		// true if the entry was read from a binary entry
+	bool was_binary() const { return read_binary; }
+
 	virtual int Play(void *) { return 0; }
 
 	static int readword(FILE*, char *&);
 	static int readline(FILE*, char *&);
 
+		// read the rest of a binary entry after its marker. returns -1 at EOF or if the entry is truncated.
+	static int readBinaryEntry(FILE*, int & op_type, std::string & body);
+		// helpers for binary bodies. strings are a varint length and the bytes,
+		// names are encoded with the list returned by binaryNames().
+	static void putBinary(std::string & buf, const char * str);
+	static bool getBinary(const char *& ptr, const char * end, char *& str);
+	static void putBinaryName(std::string & buf, const char * name);
+	static bool getBinaryName(const char *& ptr, const char * end, char *& name);
+	static const classad::ClassAdBinaryNames & binaryNames();
+
 	virtual char const *get_key() = 0;
 
 protected:
 	int op_type;	/* This is the type of operation being performed */
+	bool read_binary{false};
 
 private:
 	int WriteHeader(FILE *fp) const;
 	virtual int WriteBody(FILE *) { return 0; }
 	int WriteTail(FILE *fp);
+	int WriteBinary(FILE *fp);
+	virtual int WriteBinaryBody(std::string &) { return 0; }
 };
 
 class ConstructLogEntry
@@ -82,7 +119,10 @@ public:
 	virtual ~ConstructLogEntry() {}; // declare (superfluous) virtual constructor to get rid of g++ warning.
 };
 
-LogRecord *ReadLogEntry(FILE* fp, unsigned long recnum, LogRecord* (*InstantiateLogEntry)(FILE *fp, unsigned long recnum, int type, const ConstructLogEntry & ctor), const ConstructLogEntry & ctor);
+// body is the body of a binary entry, or NULL to read a text body from fp
+typedef LogRecord* (*InstantiateLogEntryFunc)(FILE *fp, unsigned long recnum, int type, const ConstructLogEntry & ctor, const std::string * body);
+
+LogRecord *ReadLogEntry(FILE* fp, unsigned long recnum, InstantiateLogEntryFunc InstantiateLogEntry, const ConstructLogEntry & ctor);
 
 bool valid_record_optype(int optype);
 
@@ -43,7 +43,7 @@ Transaction::~Transaction()
 }
 
 void
-Transaction::Commit(FILE* fp, const char *filename, LoggableClassAdTable *data_structure, bool nondurable)
+Transaction::Commit(FILE* fp, const char *filename, LoggableClassAdTable *data_structure, bool nondurable, bool binary)
 {
 	int fd;
 
@@ -59,7 +59,7 @@ Transaction::Commit(FILE* fp, const char *filename, LoggableClassAdTable *data_s
 
 	for( auto *log: ordered_op_log) {
 		if ( fp != nullptr ) {
-			if ( log->Write( fp ) < 0 ) {
+			if ( log->Write( fp, binary ) < 0 ) {
 				EXCEPT( "write to %s failed, errno = %d", filename, errno );
 			}
 		}
@@ -49,7 +49,7 @@ public:
 
 	Transaction();
 	~Transaction();
-	void Commit(FILE* fp, const char *filename, LoggableClassAdTable *data_structure, bool nondurable=false);
+	void Commit(FILE* fp, const char *filename, LoggableClassAdTable *data_structure, bool nondurable=false, bool binary=false);
 	void AppendLog(LogRecord *);
 	LogRecord *FirstEntry(char const *key);
 	LogRecord *NextEntry();
@@ -76,11 +76,25 @@ Selector::Selector()
 	save_write_fds = NULL;
 	save_except_fds = NULL;
 
+	m_epoll_fd = -1;
+#ifdef CONDOR_HAVE_EPOLL
+	m_ep_pass = 1;
+	m_ep_exec = 0;
+	m_ep_pid = 0;
+#endif
+
 	reset();
 }
 
 Selector::~Selector()
 {
+#ifdef CONDOR_HAVE_EPOLL
+		// Not use_epoll(false), whose reset() would write to the fd sets.
+	if ( m_epoll_fd >= 0 ) {
+		close( m_epoll_fd );
+		m_epoll_fd = -1;
+	}
+#endif
 	free( read_fds );
 }
 
@@ -126,6 +140,14 @@ Selector::reset()
 	timeout.tv_sec = timeout.tv_usec = 0;
 
 	max_fd = -1;
+#ifdef CONDOR_HAVE_EPOLL
+	if ( m_epoll_fd >= 0 ) {
+			// Keep the kernel registrations; the next execute() will
+			// drop whatever does not get added back before then.
+		if ( ++m_ep_pass == 0 ) { m_ep_pass = 1; }
+		m_ep_wanted_fds.clear();
+	}
+#endif
 	if ( save_read_fds != NULL ) {
 #if defined(WIN32)
 		FD_ZERO( save_read_fds );
@@ -230,6 +252,13 @@ Selector::add_fd( int fd, IO_FUNC interest )
 		free(fd_description);
 	}
 
+#ifdef CONDOR_HAVE_EPOLL
+	if ( m_epoll_fd >= 0 ) {
+		epoll_add_fd( fd, interest );
+		return;
+	}
+#endif
+
 	if ((m_single_shot == SINGLE_SHOT_OK) && (m_poll.fd != fd)) {
 		init_fd_sets();
 		m_single_shot = SINGLE_SHOT_SKIP;
@@ -294,13 +323,26 @@ Selector::delete_fd( int fd, IO_FUNC interest )
 	}
 #endif
 
-	init_fd_sets();
-	m_single_shot = SINGLE_SHOT_SKIP;
-
 	if (IsDebugLevel(D_DAEMONCORE)) {
 		dprintf(D_DAEMONCORE | D_VERBOSE, "selector %p deleting fd %d\n", this, fd);
 	}
 
+#ifdef CONDOR_HAVE_EPOLL
+	if ( m_epoll_fd >= 0 ) {
+		if ( fd < (int)m_ep_slots.size() && m_ep_slots[fd].wanted_pass == m_ep_pass ) {
+			switch( interest ) {
+			case IO_READ: m_ep_slots[fd].wanted &= ~EPOLLIN; break;
+			case IO_WRITE: m_ep_slots[fd].wanted &= ~EPOLLOUT; break;
+			case IO_EXCEPT: m_ep_slots[fd].wanted &= ~EPOLLPRI; break;
+			}
+		}
+		return;
+	}
+#endif
+
+	init_fd_sets();
+	m_single_shot = SINGLE_SHOT_SKIP;
+
 	switch( interest ) {
 
 	  case IO_READ:
@@ -348,7 +390,7 @@ Selector::execute()
 	struct timeval timeout_copy;
 	struct timeval	*tp;
 
-	if ( m_single_shot == SINGLE_SHOT_SKIP ) {
+	if ( m_single_shot == SINGLE_SHOT_SKIP && m_epoll_fd < 0 ) {
 		memcpy( read_fds, save_read_fds, fd_set_size * sizeof(fd_set) );
 		memcpy( write_fds, save_write_fds, fd_set_size * sizeof(fd_set) );
 		memcpy( except_fds, save_except_fds, fd_set_size * sizeof(fd_set) );
@@ -364,6 +406,11 @@ Selector::execute()
 		// select() ignores its first argument on Windows. We still track
 		// max_fd for the display() functions.
 	start_thread_safe("select");
+#ifdef CONDOR_HAVE_EPOLL
+	if ( m_epoll_fd >= 0 ) {
+		nfds = epoll_execute( tp );
+	} else
+#endif
 	if (m_single_shot == SINGLE_SHOT_VIRGIN) {
 		nfds = select( 0, NULL, NULL, NULL, tp );
 	}
@@ -428,6 +475,12 @@ Selector::fd_ready( int fd, IO_FUNC interest )
 	}
 #endif
 
+#ifdef CONDOR_HAVE_EPOLL
+	if ( m_epoll_fd >= 0 ) {
+		return epoll_fd_ready( fd, interest );
+	}
+#endif
+
 	switch( interest ) {
 
 	  case IO_READ:
@@ -479,6 +532,12 @@ Selector::display()
 	//   poll() is used to query a single fd. Currently, it's only
 	//   called in DaemonCore::Driver(), where we should always be
 	//   in select() mode.
+#ifdef CONDOR_HAVE_EPOLL
+	if ( m_epoll_fd >= 0 ) {
+		epoll_display();
+		return;
+	}
+#endif
 	init_fd_sets();
 
 	switch( state ) {
@@ -529,6 +588,272 @@ Selector::display()
 
 }
 
+bool
+Selector::use_epoll( bool enable )
+{
+#ifdef CONDOR_HAVE_EPOLL
+	if ( enable && m_epoll_fd < 0 ) {
+		m_epoll_fd = epoll_create1( EPOLL_CLOEXEC );
+		if ( m_epoll_fd < 0 ) {
+			dprintf( D_ALWAYS, "Selector: epoll_create1() failed, using select(): %s (errno=%d)\n",
+					 strerror(errno), errno );
+			return false;
+		}
+		m_ep_pid = getpid();
+		m_ep_slots.clear();
+		m_ep_registered_fds.clear();
+		m_ep_always_ready_fds.clear();
+		reset();
+	} else if ( ! enable && m_epoll_fd >= 0 ) {
+		close( m_epoll_fd );
+		m_epoll_fd = -1;
+		m_ep_slots.clear();
+		m_ep_registered_fds.clear();
+		m_ep_wanted_fds.clear();
+		m_ep_always_ready_fds.clear();
+		m_ep_events.clear();
+		reset();
+	}
+	return enable == using_epoll();
+#else
+	return ! enable;
+#endif
+}
+
+void
+Selector::forget_fd( int fd )
+{
+#ifdef CONDOR_HAVE_EPOLL
+	if ( m_epoll_fd < 0 || fd < 0 || fd >= (int)m_ep_slots.size() ) {
+		return;
+	}
+	EpollSlot &slot = m_ep_slots[fd];
+	if ( slot.registered ) {
+		if ( epoll_ctl( m_epoll_fd, EPOLL_CTL_DEL, fd, NULL ) < 0 &&
+			 errno != ENOENT && errno != EBADF )
+		{
+			dprintf( D_ALWAYS, "Selector: epoll_ctl(DEL) of fd %d failed: %s (errno=%d)\n",
+					 fd, strerror(errno), errno );
+		}
+		slot.registered = 0;
+			// m_ep_registered_fds still lists it; epoll_sync() skips
+			// entries that are no longer registered.
+	}
+	slot.wanted = 0;
+	slot.ready = 0;
+#else
+	(void)fd;
+#endif
+}
+
+#ifdef CONDOR_HAVE_EPOLL
+
+void
+Selector::epoll_add_fd( int fd, IO_FUNC interest )
+{
+	if ( fd >= (int)m_ep_slots.size() ) {
+		m_ep_slots.resize( fd + 1, EpollSlot{0, 0, 0, 0, 0} );
+	}
+	EpollSlot &slot = m_ep_slots[fd];
+	if ( slot.wanted_pass != m_ep_pass ) {
+		slot.wanted_pass = m_ep_pass;
+		slot.wanted = 0;
+		m_ep_wanted_fds.push_back( fd );
+	}
+	switch( interest ) {
+	case IO_READ: slot.wanted |= EPOLLIN; break;
+	case IO_WRITE: slot.wanted |= EPOLLOUT; break;
+	case IO_EXCEPT: slot.wanted |= EPOLLPRI; break;
+	}
+}
+
+// Push the difference between what was added since the last reset()
+// and what the kernel already has registered.  This is a walk over
+// two int vectors; epoll_ctl() is only called for fds that changed.
+void
+Selector::epoll_sync()
+{
+		// The epoll instance is shared with any child we forked without
+		// exec; never modify the parent's registrations from the child.
+	if ( m_ep_pid != getpid() ) {
+		close( m_epoll_fd );
+		m_epoll_fd = epoll_create1( EPOLL_CLOEXEC );
+		if ( m_epoll_fd < 0 ) {
+			EXCEPT( "Selector: epoll_create1() failed after fork: %s (errno=%d)",
+					strerror(errno), errno );
+		}
+		m_ep_pid = getpid();
+		for ( int fd : m_ep_registered_fds ) {
+			m_ep_slots[fd].registered = 0;
+		}
+		m_ep_registered_fds.clear();
+	}
+
+	for ( int fd : m_ep_registered_fds ) {
+		EpollSlot &slot = m_ep_slots[fd];
+		if ( slot.registered && ( slot.wanted_pass != m_ep_pass || ! slot.wanted ) ) {
+			if ( epoll_ctl( m_epoll_fd, EPOLL_CTL_DEL, fd, NULL ) < 0 &&
+				 errno != ENOENT && errno != EBADF )
+			{
+				dprintf( D_ALWAYS, "Selector: epoll_ctl(DEL) of fd %d failed: %s (errno=%d)\n",
+						 fd, strerror(errno), errno );
+			}
+			slot.registered = 0;
+		}
+	}
+	m_ep_registered_fds.clear();
+	m_ep_always_ready_fds.clear();
+
+	for ( int fd : m_ep_wanted_fds ) {
+		EpollSlot &slot = m_ep_slots[fd];
+		if ( ! slot.wanted ) {
+			continue;
+		}
+		if ( slot.registered != slot.wanted ) {
+			struct epoll_event ev;
+			memset( &ev, 0, sizeof(ev) );
+			ev.events = slot.wanted;
+			ev.data.fd = fd;
+			int op = slot.registered ? EPOLL_CTL_MOD : EPOLL_CTL_ADD;
+			int rc = epoll_ctl( m_epoll_fd, op, fd, &ev );
+			if ( rc < 0 && op == EPOLL_CTL_MOD && errno == ENOENT ) {
+					// The fd was closed and reused without forget_fd().
+				rc = epoll_ctl( m_epoll_fd, EPOLL_CTL_ADD, fd, &ev );
+			} else if ( rc < 0 && op == EPOLL_CTL_ADD && errno == EEXIST ) {
+				rc = epoll_ctl( m_epoll_fd, EPOLL_CTL_MOD, fd, &ev );
+			}
+			if ( rc < 0 ) {
+				if ( errno == EPERM ) {
+						// Regular files cannot be polled, select()
+						// always reports them ready, so do the same.
+					slot.registered = 0;
+					m_ep_always_ready_fds.push_back( fd );
+					continue;
+				}
+				EXCEPT( "Selector: epoll_ctl() of fd %d failed: %s (errno=%d)",
+						fd, strerror(errno), errno );
+			}
+			slot.registered = slot.wanted;
+		}
+		m_ep_registered_fds.push_back( fd );
+	}
+}
+
+int
+Selector::epoll_execute( struct timeval *tp )
+{
+	epoll_sync();
+
+	int timeout_ms = -1;
+	if ( ! m_ep_always_ready_fds.empty() ) {
+		timeout_ms = 0;
+	} else if ( tp ) {
+			// Anything that overflows an int is as good as forever,
+			// which is what DaemonCore means by TIMER_NEVER anyway.
+		if ( tp->tv_sec < (std::numeric_limits<int>::max() / 1000) - 1 ) {
+			timeout_ms = (int)(tp->tv_sec * 1000 + (tp->tv_usec + 999) / 1000);
+		}
+	}
+
+	size_t want_events = m_ep_registered_fds.size();
+	want_events = std::max<size_t>( 16, std::min<size_t>( want_events, 1024 ) );
+	if ( m_ep_events.size() < want_events ) {
+		m_ep_events.resize( want_events );
+	}
+
+	if ( ++m_ep_exec == 0 ) { m_ep_exec = 1; }
+
+	int nevents = epoll_wait( m_epoll_fd, m_ep_events.data(), (int)m_ep_events.size(), timeout_ms );
+	if ( nevents < 0 ) {
+		return nevents;
+	}
+
+	int nready = 0;
+	for ( int i = 0; i < nevents; ++i ) {
+		int fd = m_ep_events[i].data.fd;
+		uint32_t revents = m_ep_events[i].events;
+		if ( fd < 0 || fd >= (int)m_ep_slots.size() ) {
+			continue;
+		}
+		EpollSlot &slot = m_ep_slots[fd];
+			// Report readiness the way select() would: errors and hangups
+			// make an fd readable and writable, but only for the interests
+			// that were actually asked for.
+		uint32_t ready = 0;
+		if ( (slot.registered & EPOLLIN) && (revents & (EPOLLIN | EPOLLHUP | EPOLLERR)) ) {
+			ready |= EPOLLIN;
+		}
+		if ( (slot.registered & EPOLLOUT) && (revents & (EPOLLOUT | EPOLLHUP | EPOLLERR)) ) {
+			ready |= EPOLLOUT;
+		}
+		if ( (slot.registered & EPOLLPRI) && (revents & (EPOLLPRI | EPOLLERR)) ) {
+			ready |= EPOLLPRI;
+		}
+		if ( ready ) {
+			slot.ready = ready;
+			slot.ready_exec = m_ep_exec;
+			++nready;
+		}
+	}
+	for ( int fd : m_ep_always_ready_fds ) {
+		m_ep_slots[fd].ready = m_ep_slots[fd].wanted;
+		m_ep_slots[fd].ready_exec = m_ep_exec;
+		++nready;
+	}
+	return nready;
+}
+
+bool
+Selector::epoll_fd_ready( int fd, IO_FUNC interest ) const
+{
+	if ( fd >= (int)m_ep_slots.size() ) {
+		return false;
+	}
+	const EpollSlot &slot = m_ep_slots[fd];
+	if ( slot.ready_exec != m_ep_exec ) {
+		return false;
+	}
+	switch( interest ) {
+	case IO_READ: return (slot.ready & EPOLLIN) != 0;
+	case IO_WRITE: return (slot.ready & EPOLLOUT) != 0;
+	case IO_EXCEPT: return (slot.ready & EPOLLPRI) != 0;
+	}
+	return false;
+}
+
+void
+Selector::epoll_display() const
+{
+	static const char *state_names[] = { "VIRGIN", "FDS_READY", "TIMED_OUT", "SIGNALLED", "FAILED" };
+	dprintf( D_ALWAYS, "State = %s (epoll)\n", state_names[state] );
+	dprintf( D_ALWAYS, "Registered fds = %zu, added this pass = %zu\n",
+			 m_ep_registered_fds.size(), m_ep_wanted_fds.size() );
+
+	if ( state == FDS_READY ) {
+		dprintf( D_ALWAYS, "Ready FD's {" );
+		for ( int fd : m_ep_registered_fds ) {
+			const EpollSlot &slot = m_ep_slots[fd];
+			if ( slot.ready_exec == m_ep_exec && slot.ready ) {
+				dprintf( D_ALWAYS | D_NOHEADER, "%d%s%s%s ", fd,
+						 (slot.ready & EPOLLIN) ? "r" : "",
+						 (slot.ready & EPOLLOUT) ? "w" : "",
+						 (slot.ready & EPOLLPRI) ? "e" : "" );
+			}
+		}
+		dprintf( D_ALWAYS | D_NOHEADER, "}\n" );
+	}
+	if( timeout_wanted ) {
+		dprintf( D_ALWAYS,
+			"Timeout = %ld.%06ld seconds\n", (long) timeout.tv_sec,
+			(long) timeout.tv_usec
+		);
+	} else {
+		dprintf( D_ALWAYS, "Timeout not wanted\n" );
+	}
+}
+
+#endif /* CONDOR_HAVE_EPOLL */
+
 void
 display_fd_set( const char *msg, fd_set *set, int max, bool try_dup )
 {
@@ -36,6 +36,11 @@ struct fake_pollfd {
 };
 #endif
 
+#ifdef CONDOR_HAVE_EPOLL
+#include <sys/epoll.h>
+#endif
+#include <vector>
+
 class Selector {
 public:
 	Selector();
@@ -66,9 +71,31 @@ public:
 	bool fd_ready( int fd, IO_FUNC interest );
 	void display();
 
+		// Switch between the default select()/poll() backend and a
+		// persistent epoll backend (only where CONDOR_HAVE_EPOLL is set).
+		// In epoll mode the kernel registration outlives reset(); at
+		// execute() time only the fds whose interest changed since the
+		// previous pass cost a system call, so idle fds are nearly free.
+		// Returns true if the requested backend is now in use.
+	bool use_epoll( bool enable );
+	bool using_epoll() const { return m_epoll_fd >= 0; }
+
+		// Drop any persistent registration of this fd.  Callers that
+		// keep a selector across passes must call this before the fd is
+		// closed, otherwise a dup of the fd held elsewhere (e.g. by a
+		// child process) can keep reporting events for a reused fd number.
+	void forget_fd( int fd );
+
 private:
 
 	void init_fd_sets();
+#ifdef CONDOR_HAVE_EPOLL
+	void epoll_add_fd( int fd, IO_FUNC interest );
+	void epoll_sync();
+	int epoll_execute( struct timeval *tp );
+	bool epoll_fd_ready( int fd, IO_FUNC interest ) const;
+	void epoll_display() const;
+#endif
 
 	enum SINGLE_SHOT {
 		SINGLE_SHOT_VIRGIN, SINGLE_SHOT_OK, SINGLE_SHOT_SKIP
@@ -92,6 +119,28 @@ private:
 #else
 	struct fake_pollfd m_poll;
 #endif
+
+	int		m_epoll_fd;
+#ifdef CONDOR_HAVE_EPOLL
+		// Per-fd bookkeeping for the epoll backend, indexed by fd.
+		// wanted/ready are only meaningful when their pass/exec stamp
+		// matches the current one, so reset() and execute() are O(1).
+	struct EpollSlot {
+		uint32_t registered;	// events currently registered in the kernel
+		uint32_t wanted;		// events requested since the last reset()
+		uint32_t ready;			// events reported by the last execute()
+		unsigned int wanted_pass;
+		unsigned int ready_exec;
+	};
+	std::vector<EpollSlot> m_ep_slots;
+	std::vector<int> m_ep_registered_fds;
+	std::vector<int> m_ep_wanted_fds;
+	std::vector<int> m_ep_always_ready_fds;
+	std::vector<struct epoll_event> m_ep_events;
+	unsigned int m_ep_pass;
+	unsigned int m_ep_exec;
+	pid_t	m_ep_pid;
+#endif
 };
 
 void display_fd_set( const char *msg, fd_set *set, int max,
@@ -0,0 +1,184 @@
+/***************************************************************
+ *
+ * Copyright (C) 2025, Condor Team, Computer Sciences Department,
+ * University of Wisconsin-Madison, WI.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you
+ * may not use this file except in compliance with the License.  You may
+ * obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ ***************************************************************/
+
+// Restart benchmark for the ClassAdLog.  Writes the same set of job-like
+// ads into a text log and a binary log, one transaction per ad the way
+// the schedd does at submit time, then times how long it takes a fresh
+// ClassAdLog to replay each file, which is what dominates schedd startup
+// with a large job_queue.log.  The two replayed tables are compared to
+// make sure the formats agree.
+
+#include "condor_common.h"
+#include "condor_debug.h"
+#include "classad_log.h"
+#include "stl_string_utils.h"
+
+#include <chrono>
+
+typedef ClassAdLog<std::string, ClassAd*> BenchLog;
+
+static void
+write_log( const char * filename, bool binary, int num_ads )
+{
+	unlink( filename );
+
+	BenchLog log;
+	log.SetBinaryFormat( binary );
+	if ( ! log.InitLogFile( filename ) ) {
+		fprintf( stderr, "Failed to create %s\n", filename );
+		exit( 1 );
+	}
+
+	char key[32], buf[256];
+	for ( int i = 0; i < num_ads; ++i ) {
+		int cluster = 1 + i / 100, proc = i % 100;
+		snprintf( key, sizeof(key), "%d.%d", cluster, proc );
+
+		log.BeginTransaction();
+		log.AppendLog( new LogNewClassAd( key, "Job" ) );
+		snprintf( buf, sizeof(buf), "%d", cluster );
+		log.AppendLog( new LogSetAttribute( key, "ClusterId", buf ) );
+		snprintf( buf, sizeof(buf), "%d", proc );
+		log.AppendLog( new LogSetAttribute( key, "ProcId", buf ) );
+		snprintf( buf, sizeof(buf), "\"user%d@example.org\"", cluster % 37 );
+		log.AppendLog( new LogSetAttribute( key, "Owner", buf ) );
+		log.AppendLog( new LogSetAttribute( key, "JobStatus", "1" ) );
+		log.AppendLog( new LogSetAttribute( key, "JobUniverse", "5" ) );
+		snprintf( buf, sizeof(buf), "%d", 1700000000 + i );
+		log.AppendLog( new LogSetAttribute( key, "QDate", buf ) );
+		log.AppendLog( new LogSetAttribute( key, "Cmd", "\"/home/user/analysis/bin/run_analysis.sh\"" ) );
+		snprintf( buf, sizeof(buf), "\"--input data_%d.root --output out_%d.root --events 10000\"", i, i );
+		log.AppendLog( new LogSetAttribute( key, "Arguments", buf ) );
+		log.AppendLog( new LogSetAttribute( key, "RequestCpus", "1" ) );
+		log.AppendLog( new LogSetAttribute( key, "RequestMemory", "ifthenelse(MemoryUsage =!= undefined, MemoryUsage, 2048)" ) );
+		log.AppendLog( new LogSetAttribute( key, "RequestDisk", "DiskUsage" ) );
+		log.AppendLog( new LogSetAttribute( key, "Requirements",
+			"(TARGET.Arch == \"X86_64\") && (TARGET.OpSys == \"LINUX\") && (TARGET.Disk >= RequestDisk) && "
+			"(TARGET.Memory >= RequestMemory) && (TARGET.Cpus >= RequestCpus) && (TARGET.HasFileTransfer)" ) );
+		log.AppendLog( new LogSetAttribute( key, "PeriodicRemove", "(JobStatus == 5) && (time() - EnteredCurrentStatus > 86400 * 7)" ) );
+		log.AppendLog( new LogSetAttribute( key, "TransferInput", "\"data.tar.gz,config.json,calibration.db\"" ) );
+		log.AppendLog( new LogSetAttribute( key, "Environment", "\"OMP_NUM_THREADS=1 ANALYSIS_MODE=batch\"" ) );
+		log.AppendLog( new LogSetAttribute( key, "ImageSize", "2500000" ) );
+		log.AppendLog( new LogSetAttribute( key, "Rank", "0.0" ) );
+		log.AppendLog( new LogSetAttribute( key, "EnteredCurrentStatus", buf ) );
+		log.AppendLog( new LogSetAttribute( key, "AccountingGroup", "\"group_physics.analysis\"" ) );
+		log.CommitNondurableTransaction();
+	}
+	log.ForceLog();
+}
+
+static double
+replay_log( const char * filename, bool binary, BenchLog & log )
+{
+	log.SetBinaryFormat( binary );
+	auto begin = std::chrono::steady_clock::now();
+		// a negative history count opens the log read-only, so the
+		// replay isn't followed by a rewrite of the file
+	if ( ! log.InitLogFile( filename, -1 ) ) {
+		fprintf( stderr, "Failed to replay %s\n", filename );
+		exit( 1 );
+	}
+	auto end = std::chrono::steady_clock::now();
+	return std::chrono::duration<double, std::milli>( end - begin ).count();
+}
+
+static bool
+same_tables( BenchLog & a, BenchLog & b )
+{
+	if ( a.table.getNumElements() != b.table.getNumElements() ) {
+		fprintf( stderr, "tables have %d and %d ads\n", a.table.getNumElements(), b.table.getNumElements() );
+		return false;
+	}
+	std::string key;
+	ClassAd * ad_a = nullptr;
+	a.table.startIterations();
+	while ( a.table.iterate( key, ad_a ) ) {
+		ClassAd * ad_b = nullptr;
+		if ( b.table.lookup( key, ad_b ) < 0 ) {
+			fprintf( stderr, "ad %s is missing from the binary log\n", key.c_str() );
+			return false;
+		}
+		if ( ! ad_a->SameAs( ad_b ) ) {
+			fprintf( stderr, "ad %s differs between the logs\n", key.c_str() );
+			return false;
+		}
+	}
+	return true;
+}
+
+static long long
+file_size( const char * filename )
+{
+	struct stat st;
+	return stat( filename, &st ) == 0 ? (long long)st.st_size : -1;
+}
+
+static void
+usage( const char * self )
+{
+	fprintf( stderr, "Usage: %s [-ads N] [-dir DIR]\n", self );
+	exit( 1 );
+}
+
+int
+main( int argc, const char * argv[] )
+{
+	int num_ads = 100000;
+	std::string dir = "/tmp";
+
+	for ( int i = 1; i < argc; ++i ) {
+		if ( i + 1 >= argc ) { usage( argv[0] ); }
+		if ( ! strcmp( argv[i], "-ads" ) ) {
+			num_ads = atoi( argv[++i] );
+		} else if ( ! strcmp( argv[i], "-dir" ) ) {
+			dir = argv[++i];
+		} else {
+			usage( argv[0] );
+		}
+	}
+	if ( num_ads < 1 ) {
+		usage( argv[0] );
+	}
+
+	std::string text_file, binary_file;
+	formatstr( text_file, "%s/classad_log_bench.%d.text", dir.c_str(), (int)getpid() );
+	formatstr( binary_file, "%s/classad_log_bench.%d.binary", dir.c_str(), (int)getpid() );
+
+	write_log( text_file.c_str(), false, num_ads );
+	write_log( binary_file.c_str(), true, num_ads );
+
+	printf( "%d ads\n", num_ads );
+
+	int result = 0;
+	{
+		BenchLog text_log, binary_log;
+		double text_ms = replay_log( text_file.c_str(), false, text_log );
+		printf( "text:   %10lld bytes, replay %10.1f ms\n", file_size( text_file.c_str() ), text_ms );
+		double binary_ms = replay_log( binary_file.c_str(), true, binary_log );
+		printf( "binary: %10lld bytes, replay %10.1f ms\n", file_size( binary_file.c_str() ), binary_ms );
+
+		if ( ! same_tables( text_log, binary_log ) ) {
+			result = 1;
+		}
+	}
+
+	unlink( text_file.c_str() );
+	unlink( binary_file.c_str() );
+	return result;
+}
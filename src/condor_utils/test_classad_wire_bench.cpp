@@ -0,0 +1,203 @@
+/***************************************************************
+ *
+ * Copyright (C) 2025, Condor Team, Computer Sciences Department,
+ * University of Wisconsin-Madison, WI.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you
+ * may not use this file except in compliance with the License.  You may
+ * obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ ***************************************************************/
+
+// Streaming benchmark for the ClassAd wire encodings.  A child process
+// sends job-like ads over a loopback TCP connection, one message per ad
+// the way the schedd answers a condor_q query, and the parent reads them
+// with getClassAdEx().  This is done with the text encoding, the binary
+// encoding, and the binary encoding with the per-connection attribute
+// name list, and the CPU time of each side is reported.  Some of the
+// received ads are compared with the ads that were sent.
+
+#include "condor_common.h"
+#include "condor_config.h"
+#include "condor_debug.h"
+#include "condor_classad.h"
+#include "condor_ver_info.h"
+#include "reli_sock.h"
+
+#include <chrono>
+#include <sys/resource.h>
+#include <sys/wait.h>
+
+static void
+make_job_ad( int i, ClassAd & ad )
+{
+	int cluster = 1 + i / 100, proc = i % 100;
+	std::string buf;
+
+	ad.Assign( "ClusterId", cluster );
+	ad.Assign( "ProcId", proc );
+	formatstr( buf, "user%d@example.org", cluster % 37 );
+	ad.Assign( "Owner", buf );
+	ad.Assign( "JobStatus", 1 );
+	ad.Assign( "JobUniverse", 5 );
+	ad.Assign( "QDate", 1700000000 + i );
+	ad.Assign( "EnteredCurrentStatus", 1700000000 + i );
+	ad.Assign( "Cmd", "/home/user/analysis/bin/run_analysis.sh" );
+	formatstr( buf, "--input data_%d.root --output out_%d.root --events 10000", i, i );
+	ad.Assign( "Arguments", buf );
+	ad.Assign( "RequestCpus", 1 );
+	ad.AssignExpr( "RequestMemory", "ifthenelse(MemoryUsage =!= undefined, MemoryUsage, 2048)" );
+	ad.AssignExpr( "RequestDisk", "DiskUsage" );
+	ad.AssignExpr( "Requirements",
+		"(TARGET.Arch == \"X86_64\") && (TARGET.OpSys == \"LINUX\") && (TARGET.Disk >= RequestDisk) && "
+		"(TARGET.Memory >= RequestMemory) && (TARGET.Cpus >= RequestCpus) && (TARGET.HasFileTransfer)" );
+	ad.AssignExpr( "PeriodicRemove", "(JobStatus == 5) && (time() - EnteredCurrentStatus > 86400 * 7)" );
+	ad.Assign( "TransferInput", "data.tar.gz,config.json,calibration.db" );
+	ad.Assign( "Environment", "OMP_NUM_THREADS=1 ANALYSIS_MODE=batch" );
+	ad.Assign( "ImageSize", 2500000 );
+	ad.Assign( "DiskUsage", 1500 + (i % 1000) );
+	ad.Assign( "Rank", 0.0 );
+	ad.Assign( "AccountingGroup", "group_physics.analysis" );
+	ad.Assign( "WantRemoteIO", true );
+	formatstr( buf, "submit.example.org#%d.%d#1700000000", cluster, proc );
+	ad.Assign( "GlobalJobId", buf );
+}
+
+static double
+cpu_seconds( int who )
+{
+	struct rusage ru;
+	getrusage( who, &ru );
+	return ru.ru_utime.tv_sec + ru.ru_stime.tv_sec +
+		(ru.ru_utime.tv_usec + ru.ru_stime.tv_usec) / 1e6;
+}
+
+static void
+send_ads( int port, int num_ads, bool binary, bool names )
+{
+	putClassAdSetWireFormat( binary, names );
+
+	ReliSock sock;
+	if ( ! sock.connect( "127.0.0.1", port ) ) {
+		fprintf( stderr, "sender: failed to connect to port %d\n", port );
+		_exit( 1 );
+	}
+		// as if the security handshake had told us the peer reads binary ads
+	sock.set_peer_reads_binary_classads( true );
+
+	for ( int i = 0; i < num_ads; ++i ) {
+		ClassAd ad;
+		make_job_ad( i, ad );
+		if ( ! putClassAd( &sock, ad ) || ! sock.end_of_message() ) {
+			fprintf( stderr, "sender: failed to send ad %d\n", i );
+			_exit( 1 );
+		}
+	}
+	_exit( 0 );
+}
+
+// returns false if the ads didn't all arrive intact
+static bool
+run_encoding( const char * label, int num_ads, bool binary, bool names )
+{
+	ReliSock listener;
+	if ( ! listener.bind( CP_IPV4, false, 0, true ) || ! listener.listen() ) {
+		fprintf( stderr, "failed to listen on a loopback port\n" );
+		return false;
+	}
+
+	double child_cpu_before = cpu_seconds( RUSAGE_CHILDREN );
+	pid_t pid = fork();
+	if ( pid < 0 ) {
+		fprintf( stderr, "fork() failed: %s\n", strerror(errno) );
+		return false;
+	}
+	if ( pid == 0 ) {
+		send_ads( listener.get_port(), num_ads, binary, names );
+	}
+
+	bool ok = true;
+	double cpu_before = cpu_seconds( RUSAGE_SELF );
+	auto begin = std::chrono::steady_clock::now();
+	ReliSock * sock = listener.accept();
+	if ( ! sock ) {
+		fprintf( stderr, "failed to accept the sender's connection\n" );
+		ok = false;
+	}
+	int received = 0;
+	for ( ; ok && received < num_ads; ++received ) {
+		ClassAd ad;
+		if ( ! getClassAdEx( sock, ad, GET_CLASSAD_FAST ) || ! sock->end_of_message() ) {
+			fprintf( stderr, "%s: failed to receive ad %d\n", label, received );
+			ok = false;
+			break;
+		}
+		if ( received % 997 == 0 ) {
+			ClassAd expected;
+			make_job_ad( received, expected );
+			if ( ! ad.SameAs( &expected ) ) {
+				fprintf( stderr, "%s: ad %d differs from the ad that was sent\n", label, received );
+				ok = false;
+			}
+		}
+	}
+	auto end = std::chrono::steady_clock::now();
+	double cpu_after = cpu_seconds( RUSAGE_SELF );
+	delete sock;
+
+	int status = 0;
+	waitpid( pid, &status, 0 );
+	if ( ! WIFEXITED(status) || WEXITSTATUS(status) != 0 ) {
+		ok = false;
+	}
+	double child_cpu = cpu_seconds( RUSAGE_CHILDREN ) - child_cpu_before;
+
+	double secs = std::chrono::duration<double>( end - begin ).count();
+	printf( "%-14s %8.2f s  %9.0f ads/s  receiver cpu %7.2f s  sender cpu %7.2f s%s\n",
+			label, secs, secs > 0 ? received / secs : 0.0,
+			cpu_after - cpu_before, child_cpu, ok ? "" : "  FAILED" );
+	return ok;
+}
+
+static void
+usage( const char * self )
+{
+	fprintf( stderr, "Usage: %s [-ads N]\n", self );
+	exit( 1 );
+}
+
+int
+main( int argc, const char * argv[] )
+{
+	int num_ads = 1000000;
+
+	for ( int i = 1; i < argc; ++i ) {
+		if ( i + 1 >= argc ) { usage( argv[0] ); }
+		if ( ! strcmp( argv[i], "-ads" ) ) {
+			num_ads = atoi( argv[++i] );
+		} else {
+			usage( argv[0] );
+		}
+	}
+	if ( num_ads < 1 ) {
+		usage( argv[0] );
+	}
+
+	config();
+
+	printf( "%d ads\n", num_ads );
+
+	int result = 0;
+	if ( ! run_encoding( "text", num_ads, false, false ) ) { result = 1; }
+	if ( ! run_encoding( "binary", num_ads, true, false ) ) { result = 1; }
+	if ( ! run_encoding( "binary+names", num_ads, true, true ) ) { result = 1; }
+	return result;
+}
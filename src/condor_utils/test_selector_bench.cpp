@@ -0,0 +1,174 @@
+/***************************************************************
+ *
+ * Copyright (C) 2025, Condor Team, Computer Sciences Department,
+ * University of Wisconsin-Madison, WI.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you
+ * may not use this file except in compliance with the License.  You may
+ * obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ ***************************************************************/
+
+// Microbenchmark for the Selector backends.  Each iteration mimics one
+// pass of DaemonCore::Driver(): rebuild the interest set from scratch,
+// wait, then ask fd_ready() about every registered fd.  Most fds are
+// idle socketpairs; a handful have a byte written to them each pass.
+
+#include "condor_common.h"
+#include "condor_debug.h"
+#include "selector.h"
+
+#include <chrono>
+#include <vector>
+#include <sys/resource.h>
+#include <sys/socket.h>
+
+struct bench_fds {
+	std::vector<int> watched;	// the end the selector watches
+	std::vector<int> peer;		// the end we write into to make it active
+};
+
+static bool
+make_fds( int count, bench_fds & fds )
+{
+	for ( int i = 0; i < count; ++i ) {
+		int sv[2];
+		if ( socketpair( AF_UNIX, SOCK_STREAM, 0, sv ) < 0 ) {
+			fprintf( stderr, "socketpair() failed after %d pairs: %s\n", i, strerror(errno) );
+			return false;
+		}
+		fcntl( sv[0], F_SETFL, O_NONBLOCK );
+		fds.watched.push_back( sv[0] );
+		fds.peer.push_back( sv[1] );
+	}
+	return true;
+}
+
+static double
+run_backend( bool epoll, const bench_fds & idle, const bench_fds & active, int iterations )
+{
+	Selector selector;
+	if ( epoll && ! selector.use_epoll( true ) ) {
+		return -1.0;
+	}
+
+	char buf[16];
+	long long ready_total = 0;
+	auto begin = std::chrono::steady_clock::now();
+	for ( int iter = 0; iter < iterations; ++iter ) {
+		for ( int fd : active.peer ) {
+			if ( write( fd, "x", 1 ) != 1 ) {
+				fprintf( stderr, "write() failed: %s\n", strerror(errno) );
+			}
+		}
+
+		selector.reset();
+		for ( int fd : idle.watched ) {
+			selector.add_fd( fd, Selector::IO_READ );
+		}
+		for ( int fd : active.watched ) {
+			selector.add_fd( fd, Selector::IO_READ );
+		}
+		selector.set_timeout( 1 );
+		selector.execute();
+		if ( selector.failed() ) {
+			fprintf( stderr, "selector failed: %s\n", strerror(selector.select_errno()) );
+			return -1.0;
+		}
+
+		for ( int fd : idle.watched ) {
+			if ( selector.fd_ready( fd, Selector::IO_READ ) ) {
+				++ready_total;
+			}
+		}
+		for ( int fd : active.watched ) {
+			if ( selector.fd_ready( fd, Selector::IO_READ ) ) {
+				++ready_total;
+				while ( read( fd, buf, sizeof(buf) ) > 0 ) { }
+			}
+		}
+	}
+	auto end = std::chrono::steady_clock::now();
+
+	if ( ready_total != (long long)iterations * (long long)active.watched.size() ) {
+		fprintf( stderr, "%s: expected %lld ready fds, saw %lld\n", epoll ? "epoll" : "select",
+				 (long long)iterations * (long long)active.watched.size(), ready_total );
+	}
+
+	double usec = std::chrono::duration<double, std::micro>( end - begin ).count();
+	return usec / iterations;
+}
+
+static void
+usage( const char * self )
+{
+	fprintf( stderr, "Usage: %s [-idle N] [-active N] [-iterations N]\n", self );
+	exit( 1 );
+}
+
+int
+main( int argc, const char * argv[] )
+{
+	int num_idle = 50000;
+	int num_active = 8;
+	int iterations = 200;
+
+	for ( int i = 1; i < argc; ++i ) {
+		if ( i + 1 >= argc ) { usage( argv[0] ); }
+		if ( ! strcmp( argv[i], "-idle" ) ) {
+			num_idle = atoi( argv[++i] );
+		} else if ( ! strcmp( argv[i], "-active" ) ) {
+			num_active = atoi( argv[++i] );
+		} else if ( ! strcmp( argv[i], "-iterations" ) ) {
+			iterations = atoi( argv[++i] );
+		} else {
+			usage( argv[0] );
+		}
+	}
+	if ( num_idle < 0 || num_active < 1 || iterations < 1 ) {
+		usage( argv[0] );
+	}
+
+		// Two fds per socketpair; this must happen before the first
+		// Selector is built, since it caches the descriptor table size.
+	struct rlimit rl;
+	getrlimit( RLIMIT_NOFILE, &rl );
+	rlim_t need = 2 * (rlim_t)( num_idle + num_active ) + 64;
+	if ( rl.rlim_cur < need ) {
+		rl.rlim_cur = std::min( need, rl.rlim_max );
+		setrlimit( RLIMIT_NOFILE, &rl );
+		getrlimit( RLIMIT_NOFILE, &rl );
+		if ( rl.rlim_cur < need ) {
+			num_idle = (int)( ( rl.rlim_cur - 64 ) / 2 ) - num_active;
+			fprintf( stderr, "File descriptor limit is %llu, reducing to %d idle sockets\n",
+					 (unsigned long long)rl.rlim_cur, num_idle );
+		}
+	}
+
+	bench_fds idle, active;
+	if ( ! make_fds( num_idle, idle ) || ! make_fds( num_active, active ) ) {
+		return 1;
+	}
+
+	printf( "%d idle + %d active sockets, %d iterations\n", num_idle, num_active, iterations );
+
+	double select_usec = run_backend( false, idle, active, iterations );
+	printf( "select: %10.1f usec/iteration\n", select_usec );
+
+	double epoll_usec = run_backend( true, idle, active, iterations );
+	if ( epoll_usec < 0 ) {
+		printf( "epoll:  not available on this platform\n" );
+	} else {
+		printf( "epoll:  %10.1f usec/iteration\n", epoll_usec );
+	}
+
+	return 0;
+}
@@ -203,6 +203,22 @@ void UserPolicy::Config()
 
 }
 
+void UserPolicy::GetSystemPeriodicExprs(std::vector<ExprTree*> & exprs) const
+{
+#ifdef ENABLE_JOB_POLICY_LISTS
+	for (const auto * list : { &m_sys_periodic_holds, &m_sys_periodic_releases, &m_sys_periodic_removes, &m_sys_periodic_vacates }) {
+		for (const auto & item : *list) {
+			ExprTree * expr = item.Expr();
+			if (expr) { exprs.push_back(expr); }
+		}
+	}
+#else
+	for (ExprTree * expr : { m_sys_periodic_hold, m_sys_periodic_release, m_sys_periodic_remove }) {
+		if (expr) { exprs.push_back(expr); }
+	}
+#endif
+}
+
 void UserPolicy::ResetTriggers()
 {
 	m_fire_expr_val = -1;
@@ -533,7 +549,11 @@ bool UserPolicy::AnalyzeSinglePeriodicPolicy(ClassAd & ad, const char * attrname
 #endif
 		long long ival = 0;
 		classad::Value val;
+	#ifdef ENABLE_JOB_POLICY_LISTS // multi policy
+		if (policy.Evaluate(ad, val) && val.IsNumber(ival) && ival != 0) {
+	#else
 		if (ad.EvaluateExpr(expr, val) && val.IsNumber(ival) && ival != 0) {
+	#endif
 			m_fire_expr_val = 1;
 			m_fire_expr = policy_name;
 			m_fire_source = FS_SystemMacro;
@@ -202,8 +202,14 @@ class JobPolicyExpr
 {
 public:
 	JobPolicyExpr(const char * _name="") : name(_name) {}
+	JobPolicyExpr(const JobPolicyExpr & that) : ch(that.ch), name(that.name) {}
+	JobPolicyExpr & operator=(const JobPolicyExpr & that) {
+		if (this != &that) { ch = that.ch; name = that.name; compiled.reset(); }
+		return *this;
+	}
 
-	void set_from_config(const char * knob) { ch.set(param(knob)); }
+	// the compiled form points into the old expression, so it is compiled again on the next Evaluate
+	void set_from_config(const char * knob) { ch.set(param(knob)); compiled.reset(); }
 
 	ExprTree * Expr(int * error=NULL) const { return ch.Expr(error); }
 	const char * Str() const { return ch.Str(); }
@@ -216,6 +222,17 @@ public:
 		}
 		return knob.c_str();
 	}
+	// evaluate against a job ad.  the same expression is evaluated against
+	// every job in the queue, so it is compiled the first time through
+	bool Evaluate(ClassAd & ad, classad::Value & val) const {
+		ExprTree * expr = Expr();
+		if ( ! expr) return false;
+		if ( ! compiled) {
+			compiled.reset(new classad::CompiledExpr);
+			compiled->Compile(expr);
+		}
+		return compiled->Evaluate(ad, val);
+	}
 	bool is_trivial(bool trivial_value=false) const {
 		if (!empty()) {
 			bool value = trivial_value;
@@ -229,6 +246,7 @@ public:
 protected:
 	ConstraintHolder ch;
 	std::string name;
+	mutable std::unique_ptr<classad::CompiledExpr> compiled; // points into ch, so never copied
 };
 
 #endif
@@ -283,6 +301,10 @@ class UserPolicy
 		   occurred, then false is returned. */
 		bool FiringReason(std::string & reason, int & reason_code, int & reason_subcode);
 
+		/* Append the SYSTEM_PERIODIC_* expressions loaded by Init() to exprs.
+		   The expressions are owned by this object. */
+		void GetSystemPeriodicExprs(std::vector<ExprTree*> & exprs) const;
+
 	private: /* functions */
 		/* This function inserts six of the seven (all but TimerRemove) user
 			job policy expressions with default values into the classad if they
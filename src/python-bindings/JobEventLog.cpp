@@ -275,7 +275,7 @@ JobEvent::Py_Keys() {
 	boost::python::list l;
 	auto i = ad->begin();
 	for( ; i != ad->end(); ++i ) {
-		l.append( i->first );
+		l.append( i->first.str() );
 	}
 
 	return l;
@@ -328,9 +328,9 @@ JobEvent::Py_Items() {
 		classad::ClassAd * ca = NULL;
 		if( e->isClassad(&ca) ) {
 			v.SetClassAdValue(ca);
-			l.append( boost::python::make_tuple( i->first, convert_value_to_python( v ) ) );
+			l.append( boost::python::make_tuple( i->first.str(), convert_value_to_python( v ) ) );
 		} else if( e->Evaluate(v) ) {
-			l.append( boost::python::make_tuple( i->first, convert_value_to_python( v ) ) );
+			l.append( boost::python::make_tuple( i->first.str(), convert_value_to_python( v ) ) );
 		} else {
 			// All the values in an event's ClassAd should be constants.
 			THROW_EX( HTCondorInternalError, "Unable to evaluate expression" );